@@ -20,8 +20,10 @@
 #include "Core/EventLogger.hpp"
 #include "Core/MessageLogger.hpp"
 #include "Core/Runner.hpp"
+#include "Core/Tracer.hpp"
 #include "Util/FileUtil.hpp"
 #include "generated/SettingsHelper.hpp"
+#include <QCryptographicHash>
 #include <QFile>
 #include <QTemporaryDir>
 
@@ -107,6 +109,7 @@ void Checker::prepare()
 
     delete compiler;
     compiler = new Compiler();
+    compiler->setTraceContext(traceTab, "check");
     connect(compiler, &Compiler::compilationStarted, this, &Checker::onCompilationStarted);
     connect(compiler, &Compiler::compilationFinished, this, &Checker::onCompilationFinished);
     connect(compiler, &Compiler::compilationErrorOccurred, this, &Checker::onCompilationErrorOccurred);
@@ -115,8 +118,9 @@ void Checker::prepare()
     compiler->start(checkerTmpPath, "", SettingsHelper::getCppCompileCommand(), "C++");
 }
 
-void Checker::reqeustCheck(int index, const QString &input, const QString &output, const QString &expected)
+void Checker::reqeustCheck(int index, const TestData &input, const QString &output, const TestData &expected)
 {
+    Tracer::begin("check", "Check", traceTab, index);
     recompileIfChanged();
     LOG_INFO(BOOL_INFO_OF(compiled));
     if (compiled)
@@ -132,7 +136,10 @@ void Checker::onCompilationStarted()
 
 void Checker::clearTasks()
 {
+    for (auto const &t : pendingTasks)
+        Tracer::end("check", "Check", traceTab, t.index);
     pendingTasks.clear();
+    runningTasks.clear();
     for (auto &t : runners)
     {
         delete t;
@@ -172,9 +179,14 @@ void Checker::onCompilationKilled()
 void Checker::onRunFinished(int index, const QString & /*unused*/, const QString &err, int exitCode, int /*unused*/,
                             bool tle)
 {
+    Tracer::end("check", "Check", traceTab, index);
+
     if (tle)
         log->warn(head(index), tr("Time Limit Exceeded"));
 
+    const bool hasTask = runningTasks.contains(index);
+    const auto task = runningTasks.take(index);
+
     switch (TResult(exitCode))
     {
     case _ok:
@@ -194,6 +206,12 @@ void Checker::onRunFinished(int index, const QString & /*unused*/, const QString
             log->error(head(index), tr("Checker exited with exit code %1").arg(exitCode));
         else
             log->error(head(index), err);
+        if (hasTask)
+        {
+            const auto mismatch = findFirstMismatch(task.output, task.expected);
+            if (mismatch.found)
+                emit firstMismatchFound(index, mismatch);
+        }
         emit checkFinished(index, Widgets::TestCase::WA);
         return;
 
@@ -209,6 +227,8 @@ void Checker::onRunFinished(int index, const QString & /*unused*/, const QString
 
 void Checker::onFailedToStartRun(int index, const QString &error)
 {
+    Tracer::end("check", "Check", traceTab, index);
+    runningTasks.remove(index);
     log->error(head(index), error, false);
 }
 
@@ -227,96 +247,107 @@ void Checker::onRunOutputLimitExceeded(int index, const QString &type)
 
 void Checker::onRunKilled(int index)
 {
+    Tracer::end("check", "Check", traceTab, index);
+    runningTasks.remove(index);
     log->error(head(index), tr("The checker is killed"));
 }
 
-bool Checker::checkIgnoreTrailingSpaces(const QString &output, const QString &expected)
+Mismatch Checker::findFirstMismatch(const QString &output, const TestData &expected) const
 {
-    // first, replace \r\n and \r by \n
-    auto out = output;
-    out.replace("\r\n", "\n").replace("\r", "\n");
-    auto ans = expected;
-    ans.replace("\r\n", "\n").replace("\r", "\n");
-
-    // split output and answer into lines
-    auto outputLines = out.split('\n');
-    auto answerLines = ans.split('\n');
-
-    // remove trailing empty lines
-    while (!outputLines.isEmpty() && outputLines.back().trimmed().isEmpty())
-        outputLines.pop_back();
-    while (!answerLines.isEmpty() && answerLines.back().trimmed().isEmpty())
-        answerLines.pop_back();
-
-    // if they are considered the same, they must have the same number of lines after removing trailing empty lines
-    if (outputLines.size() != answerLines.size())
-        return false;
+    auto compare = [&output, &expected](OutputComparator::Mode mode, double epsilon = 0) {
+        // a mapped expected output is compared in place, instead of being decoded into a huge QString
+        if (expected.isMapped())
+            return OutputComparator::compare(mode, output, expected.toUtf8(), epsilon);
+        return OutputComparator::compare(mode, output, expected.toString(), epsilon);
+    };
 
-    for (int i = 0; i < outputLines.size(); ++i)
+    switch (checkerType)
     {
-        auto outputLine = outputLines[i];
-        auto answerLine = answerLines[i];
-
-        // remove trailing spaces at the end of the current line
-        while (!outputLine.isEmpty() && outputLine.back().isSpace())
-            outputLine.chop(1);
-        while (!answerLine.isEmpty() && answerLine.back().isSpace())
-            answerLine.chop(1);
-
-        // if they are considered the same, the current line should be exactly the same after removing trailing spaces
-        if (outputLine != answerLine)
-            return false;
+    case IgnoreTrailingSpaces:
+        return compare(OutputComparator::IgnoreTrailingSpaces);
+    case Strict:
+        return compare(OutputComparator::Strict);
+    case Ncmp:
+        return compare(OutputComparator::Integers);
+    case Rcmp4:
+        return compare(OutputComparator::Reals, 1E-4);
+    case Rcmp6:
+        return compare(OutputComparator::Reals, 1E-6);
+    case Rcmp9:
+        return compare(OutputComparator::Reals, 1E-9);
+    case Nyesno:
+        return compare(OutputComparator::CaseInsensitiveTokens);
+    case Wcmp:
+    case Custom:
+        return compare(OutputComparator::Tokens);
     }
-
-    // all tests are passed, this output is accepted
-    return true;
-}
-
-bool Checker::checkStrict(const QString &output, const QString &expected)
-{
-    auto a = output;
-    auto b = expected;
-    // replace \r\n and \r with \n, then directly compare them
-    return a.replace("\r\n", "\n").replace("\r", "\n") == b.replace("\r\n", "\n").replace("\r", "\n");
+    Q_UNREACHABLE();
+    return Mismatch();
 }
 
-void Checker::check(int index, const QString &input, const QString &output, const QString &expected)
+void Checker::check(int index, const TestData &input, const QString &output, const TestData &expected)
 {
     LOG_INFO(INFO_OF(index));
     switch (checkerType)
     {
     // check directly if it's a built-in checker
     case IgnoreTrailingSpaces:
-        emit checkFinished(index,
-                           checkIgnoreTrailingSpaces(output, expected) ? Widgets::TestCase::AC : Widgets::TestCase::WA);
-        break;
     case Strict:
-        emit checkFinished(index, checkStrict(output, expected) ? Widgets::TestCase::AC : Widgets::TestCase::WA);
+    {
+        const auto mismatch = findFirstMismatch(output, expected);
+        if (mismatch.found)
+            emit firstMismatchFound(index, mismatch);
+        Tracer::end("check", "Check", traceTab, index);
+        emit checkFinished(index, mismatch.found ? Widgets::TestCase::WA : Widgets::TestCase::AC);
         break;
+    }
     default:
         // if it's a testlib checker, save the input, output and expected files first
-        auto inputPath = tmpDir->filePath(QString::number(index) + ".in");
+        // mapped test data is already in files, so the checker reads them directly
+        auto inputPath = input.isMapped() ? input.filePath() : tmpDir->filePath(QString::number(index) + ".in");
         auto outputPath = tmpDir->filePath(QString::number(index) + ".out");
-        auto expectedPath = tmpDir->filePath(QString::number(index) + ".ans");
-        if (Util::saveFile(inputPath, input, tr("Checker"), false, log) &&
+        auto expectedPath =
+            expected.isMapped() ? expected.filePath() : tmpDir->filePath(QString::number(index) + ".ans");
+        if ((input.isMapped() || input.save(inputPath, tr("Checker"), false, log)) &&
             Util::saveFile(outputPath, output, tr("Checker"), false, log) &&
-            Util::saveFile(expectedPath, expected, tr("Checker"), false, log))
+            (expected.isMapped() || expected.save(expectedPath, tr("Checker"), false, log)))
         {
             // if files are successfully saved, run the checker
             auto *tmp = new Runner(index);
+            tmp->setTraceContext(traceTab, "check");
             runners.push_back(tmp); // save the checkers in a list, so we can delete them when destructing the checker
+            runningTasks[index] = {index, input, output, expected};
             connect(tmp, &Runner::runFinished, this, &Checker::onRunFinished);
             connect(tmp, &Runner::failedToStartRun, this, &Checker::onFailedToStartRun);
             connect(tmp, &Runner::runOutputLimitExceeded, this, &Checker::onRunOutputLimitExceeded);
             connect(tmp, &Runner::runKilled, this, &Checker::onRunKilled);
             tmp->run(checkerTmpPath, "", "C++", "",
-                     "\"" + inputPath + "\" \"" + outputPath + "\" \"" + expectedPath + "\"", "",
+                     "\"" + inputPath + "\" \"" + outputPath + "\" \"" + expectedPath + "\"", TestData(),
                      SettingsHelper::getDefaultTimeLimit());
         }
+        else
+        {
+            Tracer::end("check", "Check", traceTab, index);
+        }
         break;
     }
 }
 
+QString Checker::identity() const
+{
+    if (checkerType != Custom)
+        return QString::number(checkerType);
+    QFile file(checkerOriginalPath);
+    if (!file.open(QIODevice::ReadOnly))
+        return QString();
+    return checkerOriginalPath + ':' + QCryptographicHash::hash(file.readAll(), QCryptographicHash::Sha1).toHex();
+}
+
+void Checker::setTraceTab(quint64 tab)
+{
+    traceTab = tab;
+}
+
 QString Checker::head(int index)
 {
     return tr("Checker[%1]").arg(index + 1);
@@ -28,7 +28,10 @@
 #ifndef CHECKER_HPP
 #define CHECKER_HPP
 
+#include "Core/OutputComparator.hpp"
+#include "Core/TestData.hpp"
 #include "Widgets/TestCase.hpp"
+#include <QMap>
 
 class QTemporaryDir;
 class MessageLogger;
@@ -99,13 +102,25 @@ class Checker : public QObject
      * @note This function doesn't return anything, it request the checker to check,
      *       and the checker emits a signal when it's done
      */
-    void reqeustCheck(int index, const QString &input, const QString &output, const QString &expected);
+    void reqeustCheck(int index, const TestData &input, const QString &output, const TestData &expected);
 
     /**
      * @brief clear the pending tasks and kill executing tasks
      */
     void clearTasks();
 
+    /**
+     * @returns a string that changes iff the checker may give different verdicts, i.e. the type of the checker, and the
+     *          path and the hash of the source code for a custom checker
+     */
+    QString identity() const;
+
+    /**
+     * @brief set the tab in which the checks are shown in the trace, see Core::Tracer
+     * @note This should be called before prepare(), so the compilation of the checker is traced as well.
+     */
+    void setTraceTab(quint64 tab);
+
   signals:
     /**
      * @brief return the check result
@@ -114,6 +129,14 @@ class Checker : public QObject
      */
     void checkFinished(int index, Widgets::TestCase::Verdict verdict);
 
+    /**
+     * @brief report where a rejected output first differs from the expected output
+     * @param index the index of the checked testcase
+     * @param mismatch the first difference
+     * @note This is emitted before checkFinished, and only if the difference can be located.
+     */
+    void firstMismatchFound(int index, const Core::Mismatch &mismatch);
+
   private slots:
     void onCompilationStarted();
 
@@ -135,20 +158,12 @@ class Checker : public QObject
 
   private:
     /**
-     * @brief check the output against the expected output in IgnoreTrailingSpaces mode
-     * @param output the output to check
-     * @param expected the expected output to check the output against
-     * @return whether this output is accepted or not
-     */
-    static bool checkIgnoreTrailingSpaces(const QString &output, const QString &expected);
-
-    /**
-     * @brief check the output against the expected output in Strict mode
+     * @brief find the first difference in the way closest to this checker
      * @param output the output to check
-     * @param expected the expected output to check the output against
-     * @return whether this output is accepted or not
+     * @param expected the expected output to check the output against, it's compared in UTF-8 if it's mapped
+     * @return the first difference, the output is accepted by a built-in checker iff it's not found
      */
-    static bool checkStrict(const QString &output, const QString &expected);
+    Mismatch findFirstMismatch(const QString &output, const TestData &expected) const;
 
     /**
      * @brief check a testcase
@@ -157,7 +172,7 @@ class Checker : public QObject
      * @param expected the expected output of the testcase
      * @note this should only be called when the checker is compiled
      */
-    void check(int index, const QString &input, const QString &output, const QString &expected);
+    void check(int index, const TestData &input, const QString &output, const TestData &expected);
 
     /**
      * @param index the index of the testcase
@@ -174,7 +189,9 @@ class Checker : public QObject
     struct Task
     {
         int index;
-        QString input, output, expected;
+        TestData input;
+        QString output;
+        TestData expected;
     };
 
     // copied from testlib.h, see #746 for why not include testlib.h
@@ -200,8 +217,10 @@ class Checker : public QObject
     Compiler *compiler = nullptr;    // the compiler used to compile the checker
     QVector<Runner *> runners;       // the runners used to run the check processes
     QVector<Task> pendingTasks;      // the unsolved check requests
+    QMap<int, Task> runningTasks;    // the tasks being checked by the testlib checker, used to locate the difference
     std::atomic<bool> compiled;      // whether the testlib checker is compiled or not
                                      // It should be true for built-in checkers.
+    quint64 traceTab = 0;            // the tab in which the checks are shown in the trace
 };
 
 } // namespace Core
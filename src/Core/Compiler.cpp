@@ -17,6 +17,7 @@
 
 #include "Core/Compiler.hpp"
 #include "Core/EventLogger.hpp"
+#include "Core/Tracer.hpp"
 #include "Settings/SettingsManager.hpp"
 #include "Util/FileUtil.hpp"
 #include "generated/SettingsHelper.hpp"
@@ -46,6 +47,7 @@ Compiler::~Compiler()
             // kill the compilation process if it's still running when the Compiler is being destructed
             LOG_WARN("Compiler process was running and is being forcefully killed");
             compileProcess->kill();
+            Tracer::end(traceCategory, "Compile", traceTab);
             emit compilationKilled();
         }
         delete compileProcess;
@@ -102,6 +104,7 @@ void Compiler::start(const QString &tmpFilePath, const QString &sourceFilePath,
     compileProcess->setWorkingDirectory(
         QFileInfo(QFile::exists(sourceFilePath) ? sourceFilePath : tmpFilePath).canonicalPath());
 
+    Tracer::begin(traceCategory, "Compile", traceTab);
     compileProcess->start(program, args);
 }
 
@@ -144,8 +147,15 @@ QString Compiler::outputFilePath(const QString &tmpFilePath, const QString &sour
     return path;
 }
 
+void Compiler::setTraceContext(quint64 tab, const char *category)
+{
+    traceTab = tab;
+    traceCategory = category;
+}
+
 void Compiler::onProcessFinished(int exitCode, QProcess::ExitStatus e)
 {
+    Tracer::end(traceCategory, "Compile", traceTab);
     QString codecName = "UTF-8";
     if (lang == "C++")
         codecName = SettingsHelper::getCppCompilerOutputCodec();
@@ -167,6 +177,7 @@ void Compiler::onProcessErrorOccurred(QProcess::ProcessError error)
     LOG_WARN(INFO_OF(error));
     if (error == QProcess::FailedToStart)
     {
+        Tracer::end(traceCategory, "Compile", traceTab);
         emit compilationFailed(
             tr("Failed to start the compiler. Please check %1 or add the compiler in the PATH environment variable.")
                 .arg(SettingsManager::getPathText(lang + "/Compile Command")));
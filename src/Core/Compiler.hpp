@@ -78,6 +78,13 @@ class Compiler : public QObject
     static QString outputFilePath(const QString &tmpFilePath, const QString &sourceFilePath, const QString &lang,
                                   bool createDirectory = true);
 
+    /**
+     * @brief set where the compilation is shown in the trace, see Core::Tracer
+     * @param tab the ID of the tab
+     * @param category the category of the span, a string literal
+     */
+    void setTraceContext(quint64 tab, const char *category);
+
   signals:
     /**
      * @brief the compilation has just started
@@ -120,6 +127,8 @@ class Compiler : public QObject
   private:
     QProcess *compileProcess = nullptr; // the compilation process
     QString lang;
+    quint64 traceTab = 0;
+    const char *traceCategory = "compile";
 };
 
 } // namespace Core
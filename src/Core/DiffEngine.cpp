@@ -0,0 +1,363 @@
+/*
+ * Copyright (C) 2019-2021 Ashar Khan <ashar786khan@gmail.com>
+ *
+ * This file is part of CP Editor.
+ *
+ * CP Editor is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * I will not be responsible if CP Editor behaves in unexpected way and
+ * causes your ratings to go down and or lose any important contest.
+ *
+ * Believe Software is "Software" and it isn't immune to bugs.
+ *
+ */
+
+#include "Core/DiffEngine.hpp"
+#include "third_party/diff_match_patch/diff_match_patch.h"
+#include <QHash>
+#include <algorithm>
+
+namespace Core
+{
+namespace
+{
+// When the texts have more differences than this, the rest is reported as a single changed hunk,
+// so that comparing two completely different outputs doesn't take quadratic time and memory.
+const int MAX_EDIT_DISTANCE = 1024;
+
+// Lines longer than this are not refined to characters.
+const int MAX_REFINE_LENGTH = 10000;
+
+// a sequence of lines in a text, with the hashes of the lines in the range being diffed
+struct LineSequence
+{
+    const QString *text;
+    const QVector<int> *starts;
+    int hashBase = 0;
+    QVector<uint> hashes;
+
+    int count() const
+    {
+        return starts->size() - 1;
+    }
+
+    int lineEnd(int index) const
+    {
+        return starts->at(index + 1) - 1;
+    }
+
+    QStringRef line(int index) const
+    {
+        return QStringRef(text, starts->at(index), lineEnd(index) - starts->at(index));
+    }
+
+    bool hasNewline(int index) const
+    {
+        return lineEnd(index) < text->size();
+    }
+
+    void hash(int begin, int end)
+    {
+        hashBase = begin;
+        hashes.resize(end - begin);
+        for (int i = begin; i < end; ++i)
+            hashes[i - begin] = qHash(line(i)) ^ (hasNewline(i) ? 0x9e3779b9U : 0U);
+    }
+};
+
+// a run of equal lines, starting at line x on the left and line y on the right
+struct Snake
+{
+    int x, y, length;
+};
+
+bool sameText(const LineSequence &a, int i, const LineSequence &b, int j)
+{
+    return a.hasNewline(i) == b.hasNewline(j) && a.line(i) == b.line(j);
+}
+
+bool sameLine(const LineSequence &a, int i, const LineSequence &b, int j)
+{
+    return a.hashes[i - a.hashBase] == b.hashes[j - b.hashBase] && sameText(a, i, b, j);
+}
+
+/*
+ * Split the text into lines, the result contains the start offsets of the lines and a sentinel,
+ * the sentinel is chosen so that the length of line i is always starts[i + 1] - 1 - starts[i].
+ * A trailing new line character doesn't start a new line.
+ */
+int splitLines(const QString &text, QVector<int> *starts)
+{
+    const int n = text.size();
+    const QChar *data = text.constData();
+    int maxLength = 0;
+    starts->clear();
+    starts->push_back(0);
+    for (int i = 0; i < n; ++i)
+    {
+        if (data[i] == '\n')
+        {
+            maxLength = qMax(maxLength, i - starts->last());
+            starts->push_back(i + 1);
+        }
+    }
+    if (starts->last() == n)
+        starts->pop_back();
+    else
+        maxLength = qMax(maxLength, n - starts->last());
+    starts->push_back(n > 0 && data[n - 1] == '\n' ? n : n + 1);
+    return maxLength;
+}
+
+void backtrack(const QVector<QVector<int>> &trace, int n, int m, int aBegin, int bBegin, QVector<Snake> *snakes)
+{
+    int x = n, y = m;
+    for (int d = trace.size() - 1; d > 0; --d)
+    {
+        // trace[d - 1] stores the furthest reaching x of diagonals -(d - 1) ... d - 1
+        const QVector<int> &prev = trace[d - 1];
+        const int k = x - y;
+        int prevK;
+        if (k == -d || (k != d && prev[k - 1 + d - 1] < prev[k + 1 + d - 1]))
+            prevK = k + 1;
+        else
+            prevK = k - 1;
+        const int prevX = prev[prevK + d - 1];
+        const int prevY = prevX - prevK;
+        const int snakeX = prevK == k + 1 ? prevX : prevX + 1;
+        if (x > snakeX)
+            snakes->push_back({aBegin + snakeX, bBegin + snakeX - k, x - snakeX});
+        x = prevX;
+        y = prevY;
+    }
+    if (x > 0)
+        snakes->push_back({aBegin, bBegin, x});
+    std::reverse(snakes->begin(), snakes->end());
+}
+
+bool isCancelled(const std::atomic<bool> *cancelled)
+{
+    return cancelled != nullptr && cancelled->load(std::memory_order_relaxed);
+}
+
+/*
+ * The greedy Myers algorithm on the hashes of the lines in [aBegin, aEnd) and [bBegin, bEnd).
+ * Returns false if the edit distance is larger than MAX_EDIT_DISTANCE.
+ */
+bool myers(const LineSequence &a, int aBegin, int aEnd, const LineSequence &b, int bBegin, int bEnd,
+           QVector<Snake> *snakes, const std::atomic<bool> *cancelled)
+{
+    const int n = aEnd - aBegin;
+    const int m = bEnd - bBegin;
+    const int maxD = qMin(n + m, MAX_EDIT_DISTANCE);
+    const int offset = maxD + 1;
+    QVector<int> v(2 * maxD + 3, 0);
+    QVector<QVector<int>> trace;
+
+    for (int d = 0; d <= maxD; ++d)
+    {
+        if (isCancelled(cancelled))
+            return false;
+        for (int k = -d; k <= d; k += 2)
+        {
+            int x;
+            if (k == -d || (k != d && v[offset + k - 1] < v[offset + k + 1]))
+                x = v[offset + k + 1];
+            else
+                x = v[offset + k - 1] + 1;
+            int y = x - k;
+            while (x < n && y < m && sameLine(a, aBegin + x, b, bBegin + y))
+                ++x, ++y;
+            v[offset + k] = x;
+            if (x >= n && y >= m)
+            {
+                trace.push_back(v.mid(offset - d, 2 * d + 1));
+                backtrack(trace, n, m, aBegin, bBegin, snakes);
+                return true;
+            }
+        }
+        trace.push_back(v.mid(offset - d, 2 * d + 1));
+    }
+    return false;
+}
+
+void appendHunk(DiffResult *result, bool changed, int leftStart, int leftCount, int rightStart, int rightCount)
+{
+    if (leftCount == 0 && rightCount == 0)
+        return;
+    if (!result->hunks.isEmpty() && result->hunks.last().changed == changed)
+    {
+        result->hunks.last().leftCount += leftCount;
+        result->hunks.last().rightCount += rightCount;
+        return;
+    }
+    result->hunks.push_back({changed, leftStart, leftCount, rightStart, rightCount, 0});
+}
+} // namespace
+
+int DiffResult::Hunk::rowCount() const
+{
+    return changed ? qMax(leftCount, rightCount) : leftCount;
+}
+
+int DiffResult::lineCount(Side side) const
+{
+    return qMax(0, (side == Left ? leftLineStarts : rightLineStarts).size() - 1);
+}
+
+QStringRef DiffResult::line(Side side, int index) const
+{
+    const QVector<int> &starts = side == Left ? leftLineStarts : rightLineStarts;
+    return QStringRef(side == Left ? &left : &right, starts[index], starts[index + 1] - 1 - starts[index]);
+}
+
+bool DiffResult::hasNewline(Side side, int index) const
+{
+    const QVector<int> &starts = side == Left ? leftLineStarts : rightLineStarts;
+    return starts[index + 1] <= (side == Left ? left : right).size();
+}
+
+int DiffResult::hunkIndexOfRow(int row) const
+{
+    auto it = std::upper_bound(hunks.cbegin(), hunks.cend(), row,
+                               [](int r, const Hunk &hunk) { return r < hunk.rowStart; });
+    return int(it - hunks.cbegin()) - 1;
+}
+
+int DiffResult::lineOfRow(Side side, int row) const
+{
+    const int index = hunkIndexOfRow(row);
+    if (index < 0)
+        return -1;
+    const Hunk &hunk = hunks[index];
+    const int offset = row - hunk.rowStart;
+    if (side == Left)
+        return offset < hunk.leftCount ? hunk.leftStart + offset : -1;
+    return offset < hunk.rightCount ? hunk.rightStart + offset : -1;
+}
+
+bool DiffResult::isChangedRow(int row) const
+{
+    const int index = hunkIndexOfRow(row);
+    return index >= 0 && hunks[index].changed;
+}
+
+int DiffResult::rowOfLine(Side side, int line) const
+{
+    auto it = std::upper_bound(hunks.cbegin(), hunks.cend(), line, [side](int l, const Hunk &hunk) {
+        return l < (side == Left ? hunk.leftStart : hunk.rightStart);
+    });
+    if (it == hunks.cbegin())
+        return 0;
+    --it;
+    const int start = side == Left ? it->leftStart : it->rightStart;
+    return qBound(0, it->rowStart + line - start, qMax(0, rowCount - 1));
+}
+
+DiffResult DiffEngine::diff(const QString &left, const QString &right, const std::atomic<bool> *cancelled)
+{
+    DiffResult result;
+    result.left = left;
+    result.right = right;
+    result.maxLineLength =
+        qMax(splitLines(result.left, &result.leftLineStarts), splitLines(result.right, &result.rightLineStarts));
+
+    LineSequence a{&result.left, &result.leftLineStarts};
+    LineSequence b{&result.right, &result.rightLineStarts};
+    const int n = a.count();
+    const int m = b.count();
+    if (isCancelled(cancelled))
+        return result;
+
+    // Outputs usually differ in a few places, so the common prefix and suffix are skipped without hashing.
+    int prefix = 0;
+    while (prefix < n && prefix < m && sameText(a, prefix, b, prefix))
+        ++prefix;
+    int suffix = 0;
+    while (suffix < n - prefix && suffix < m - prefix && sameText(a, n - 1 - suffix, b, m - 1 - suffix))
+        ++suffix;
+    const int aEnd = n - suffix;
+    const int bEnd = m - suffix;
+
+    appendHunk(&result, false, 0, prefix, 0, prefix);
+
+    a.hash(prefix, aEnd);
+    b.hash(prefix, bEnd);
+    QVector<Snake> snakes;
+    if (isCancelled(cancelled))
+        return result;
+    if (myers(a, prefix, aEnd, b, prefix, bEnd, &snakes, cancelled))
+    {
+        int x = prefix, y = prefix;
+        for (const auto &snake : snakes)
+        {
+            appendHunk(&result, true, x, snake.x - x, y, snake.y - y);
+            appendHunk(&result, false, snake.x, snake.length, snake.y, snake.length);
+            x = snake.x + snake.length;
+            y = snake.y + snake.length;
+        }
+        appendHunk(&result, true, x, aEnd - x, y, bEnd - y);
+    }
+    else
+    {
+        appendHunk(&result, true, prefix, aEnd - prefix, prefix, bEnd - prefix);
+    }
+
+    appendHunk(&result, false, aEnd, suffix, bEnd, suffix);
+
+    for (auto &hunk : result.hunks)
+    {
+        hunk.rowStart = result.rowCount;
+        result.rowCount += hunk.rowCount();
+        if (hunk.changed)
+            ++result.changedHunkCount;
+    }
+
+    return result;
+}
+
+void DiffEngine::refine(const QString &left, const QString &right, QVector<Range> *leftRanges,
+                        QVector<Range> *rightRanges)
+{
+    if (left == right)
+        return;
+
+    if (left.isEmpty() || right.isEmpty() || left.size() > MAX_REFINE_LENGTH || right.size() > MAX_REFINE_LENGTH)
+    {
+        if (!left.isEmpty())
+            leftRanges->push_back({0, left.size()});
+        if (!right.isEmpty())
+            rightRanges->push_back({0, right.size()});
+        return;
+    }
+
+    diff_match_patch differ;
+    differ.Diff_Timeout = 0.1F;
+    auto diffs = differ.diff_main(left, right);
+    differ.diff_cleanupSemantic(diffs);
+
+    int leftPos = 0, rightPos = 0;
+    for (auto const &diff : diffs)
+    {
+        const int length = diff.text.length();
+        switch (diff.operation)
+        {
+        case EQUAL:
+            leftPos += length;
+            rightPos += length;
+            break;
+        case DELETE:
+            leftRanges->push_back({leftPos, length});
+            leftPos += length;
+            break;
+        case INSERT:
+            rightRanges->push_back({rightPos, length});
+            rightPos += length;
+            break;
+        }
+    }
+}
+} // namespace Core
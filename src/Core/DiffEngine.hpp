@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2019-2021 Ashar Khan <ashar786khan@gmail.com>
+ *
+ * This file is part of CP Editor.
+ *
+ * CP Editor is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * I will not be responsible if CP Editor behaves in unexpected way and
+ * causes your ratings to go down and or lose any important contest.
+ *
+ * Believe Software is "Software" and it isn't immune to bugs.
+ *
+ */
+
+/*
+ * The diff engine compares two texts line by line.
+ * Lines are hashed first and the Myers algorithm runs on the hashes, so the cost depends on the number of lines and
+ * the number of differences instead of the number of characters. The character-level differences are only computed
+ * for a pair of changed lines when they are requested, which is when the line is about to be painted.
+ * The result only stores offsets into the original texts, so it's cheap enough for outputs with millions of lines.
+ */
+
+#ifndef DIFFENGINE_HPP
+#define DIFFENGINE_HPP
+
+#include <QPair>
+#include <QString>
+#include <QVector>
+#include <atomic>
+
+namespace Core
+{
+struct DiffResult
+{
+    enum Side
+    {
+        Left, // the output
+        Right // the expected output
+    };
+
+    // a run of lines which are either the same on both sides or changed
+    struct Hunk
+    {
+        bool changed;   // whether the lines in this hunk are different on the two sides
+        int leftStart;  // the index of the first line on the left side
+        int leftCount;  // the number of lines on the left side
+        int rightStart; // the index of the first line on the right side
+        int rightCount; // the number of lines on the right side
+        int rowStart;   // the index of the first row of this hunk in the side-by-side view
+
+        int rowCount() const;
+    };
+
+    QString left, right;                          // the texts being compared
+    QVector<int> leftLineStarts, rightLineStarts; // the start offsets of the lines, with a sentinel at the end
+    QVector<Hunk> hunks;                          // the hunks in order, covering all lines of both sides
+    int rowCount = 0;                             // the number of rows in the side-by-side view
+    int maxLineLength = 0;                        // the length of the longest line on either side
+    int changedHunkCount = 0;                     // the number of changed hunks
+
+    /**
+     * @param side the side of the line
+     * @returns the number of lines on the given side
+     */
+    int lineCount(Side side) const;
+
+    /**
+     * @param side the side of the line
+     * @param index the index of the line
+     * @returns the content of the line, without the trailing new line character
+     */
+    QStringRef line(Side side, int index) const;
+
+    /**
+     * @param side the side of the line
+     * @param index the index of the line
+     * @returns whether the line is terminated by a new line character
+     */
+    bool hasNewline(Side side, int index) const;
+
+    /**
+     * @param row the index of a row in the side-by-side view
+     * @returns the index of the hunk containing the row
+     */
+    int hunkIndexOfRow(int row) const;
+
+    /**
+     * @param side the side to look up
+     * @param row the index of a row in the side-by-side view
+     * @returns the index of the line shown in the row, or -1 if the row is a filler on this side
+     */
+    int lineOfRow(Side side, int row) const;
+
+    /**
+     * @param row the index of a row in the side-by-side view
+     * @returns whether the row is in a changed hunk
+     */
+    bool isChangedRow(int row) const;
+
+    /**
+     * @param side the side of the line
+     * @param line the index of a line
+     * @returns the index of the row showing the given line
+     */
+    int rowOfLine(Side side, int line) const;
+};
+
+class DiffEngine
+{
+  public:
+    // a range of changed characters in a line, as (start, length)
+    using Range = QPair<int, int>;
+
+    /**
+     * @brief compare two texts line by line
+     * @param left the output
+     * @param right the expected output
+     * @param cancelled it's checked during the comparison, and an incomplete result is returned once it becomes true
+     * @note This could be slow for huge texts, it's safe to be called in a worker thread.
+     */
+    static DiffResult diff(const QString &left, const QString &right, const std::atomic<bool> *cancelled = nullptr);
+
+    /**
+     * @brief find the changed characters in a pair of changed lines
+     * @param left the line on the left side
+     * @param right the line on the right side
+     * @param leftRanges the changed ranges of the left line are appended to it
+     * @param rightRanges the changed ranges of the right line are appended to it
+     * @note Lines longer than a fixed limit are reported as changed as a whole.
+     */
+    static void refine(const QString &left, const QString &right, QVector<Range> *leftRanges,
+                       QVector<Range> *rightRanges);
+};
+} // namespace Core
+
+#endif // DIFFENGINE_HPP
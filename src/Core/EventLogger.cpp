@@ -27,13 +27,387 @@
 #include <QProcess>
 #include <QStandardPaths>
 #include <QSysInfo>
+#include <QThread>
 #include <QUrl>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 
 namespace Core
 {
+namespace
+{
+// the number of records in the ring buffer, a power of two, the records are dropped when it's full
+const size_t BUFFER_SIZE = 8192;
+
+// the maximum number of records formatted before writing them
+const size_t BATCH_SIZE = 256;
+
+// the writer thread sleeps for this time in milliseconds when there are no records
+const int IDLE_INTERVAL = 20;
+
+const char *const LEVEL_NAMES[] = {"INFO ", "WARN ", "ERROR", " WTF "};
+
+qint64 monotonicTime()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// the wall clock time at a monotonic time, to convert the timestamps of the records
+struct ClockOrigin
+{
+    qint64 monotonic = monotonicTime();
+    qint64 wall = QDateTime::currentMSecsSinceEpoch();
+};
+
+const ClockOrigin &clockOrigin()
+{
+    static const ClockOrigin origin;
+    return origin;
+}
+
+struct Record
+{
+    qint64 time;
+    Log::Level level;
+    const Log::Site *site;
+    QByteArray message; // UTF-8
+};
+
+/*
+ * A bounded multi-producer queue, see http://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
+ * A slot is written by the producer which claimed it, and is published by setting its sequence to its position + 1.
+ * It's read by the only consumer and is released by setting its sequence to its position + BUFFER_SIZE.
+ */
+class RingBuffer
+{
+  public:
+    RingBuffer()
+    {
+        for (size_t i = 0; i < BUFFER_SIZE; ++i)
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    bool push(Record &&record)
+    {
+        auto position = enqueuePosition.load(std::memory_order_relaxed);
+        Slot *slot = nullptr;
+        while (true)
+        {
+            slot = &slots[position % BUFFER_SIZE];
+            const auto sequence = slot->sequence.load(std::memory_order_acquire);
+            const auto difference = qint64(sequence) - qint64(position);
+            if (difference == 0)
+            {
+                if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (difference < 0)
+            {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            else
+            {
+                position = enqueuePosition.load(std::memory_order_relaxed);
+            }
+        }
+        slot->record = std::move(record);
+        slot->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @returns the published record at the offset from the first unreleased one, nullptr if it's not published yet
+     * @note Only the consumer calls this.
+     */
+    const Record *peek(size_t offset) const
+    {
+        const auto position = dequeuePosition.load(std::memory_order_relaxed) + offset;
+        const auto &slot = slots[position % BUFFER_SIZE];
+        if (slot.sequence.load(std::memory_order_acquire) != position + 1)
+            return nullptr;
+        return &slot.record;
+    }
+
+    /**
+     * @brief release the first records, so that the producers can reuse their slots
+     * @note dequeuePosition is advanced first, so that the crash handler doesn't read the released records, and the
+     *       messages are freed after all the slots are released, in case the crash handler is reading one of them.
+     */
+    void release(size_t count)
+    {
+        const auto position = dequeuePosition.load(std::memory_order_relaxed);
+        dequeuePosition.store(position + count, std::memory_order_release);
+        for (size_t i = 0; i < count; ++i)
+        {
+            auto &slot = slots[(position + i) % BUFFER_SIZE];
+            releasedMessages.push_back(std::move(slot.record.message));
+            slot.sequence.store(position + i + BUFFER_SIZE, std::memory_order_release);
+        }
+        releasedMessages.clear();
+    }
+
+    std::atomic<size_t> dropped{0};
+
+  private:
+    struct Slot
+    {
+        std::atomic<size_t> sequence;
+        Record record;
+    };
+
+    Slot slots[BUFFER_SIZE];
+    std::atomic<size_t> enqueuePosition{0};
+    std::atomic<size_t> dequeuePosition{0};
+    std::vector<QByteArray> releasedMessages; // only used by release(), kept to reuse its memory
+
+    friend void dumpRingBuffer(const RingBuffer &buffer, int fd);
+};
+
+RingBuffer &ringBuffer()
+{
+    static RingBuffer buffer;
+    return buffer;
+}
+
+// the file descriptor of the log file, used when crashing
+std::atomic<int> logDescriptor{2};
+
+void writeToDescriptor(int fd, const char *data, size_t size)
+{
+#ifdef Q_OS_WIN
+    _write(fd, data, unsigned(size));
+#else
+    while (size > 0)
+    {
+        const auto written = ::write(fd, data, size);
+        if (written <= 0)
+            return;
+        data += written;
+        size -= size_t(written);
+    }
+#endif
+}
+
+void writeToDescriptor(int fd, const char *text)
+{
+    writeToDescriptor(fd, text, std::strlen(text));
+}
+
+void writeToDescriptor(int fd, qint64 number)
+{
+    char digits[24];
+    int length = 0;
+    const bool negative = number < 0;
+    auto value = negative ? quint64(-(number + 1)) + 1 : quint64(number);
+    do
+    {
+        digits[sizeof(digits) - 1 - length++] = char('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+    if (negative)
+        digits[sizeof(digits) - 1 - length++] = '-';
+    writeToDescriptor(fd, digits + sizeof(digits) - length, size_t(length));
+}
+
+// only uses the async-signal-safe functions, the records being written by the writer thread may be written twice
+void dumpRingBuffer(const RingBuffer &buffer, int fd)
+{
+    const auto begin = buffer.dequeuePosition.load(std::memory_order_acquire);
+    const auto end = buffer.enqueuePosition.load(std::memory_order_acquire);
+    for (auto position = begin; position != end && position - begin < BUFFER_SIZE; ++position)
+    {
+        const auto &slot = buffer.slots[position % BUFFER_SIZE];
+        if (slot.sequence.load(std::memory_order_acquire) != position + 1)
+            continue;
+        const auto &record = slot.record;
+        writeToDescriptor(fd, "[+");
+        writeToDescriptor(fd, (record.time - clockOrigin().monotonic) / 1000000);
+        writeToDescriptor(fd, "ms][");
+        writeToDescriptor(fd, LEVEL_NAMES[record.level]);
+        writeToDescriptor(fd, "][");
+        writeToDescriptor(fd, record.site->function);
+        writeToDescriptor(fd, "][");
+        writeToDescriptor(fd, record.site->file);
+        writeToDescriptor(fd, "](");
+        writeToDescriptor(fd, qint64(record.site->line));
+        writeToDescriptor(fd, ")::");
+        writeToDescriptor(fd, record.message.constData(), size_t(record.message.size()));
+        writeToDescriptor(fd, "\n");
+    }
+}
+
+QByteArray centered(QByteArray text, int width)
+{
+    if (text.size() > width)
+        text = text.right(width);
+    const int padding = width - text.size();
+    return QByteArray(padding / 2, ' ') + text + QByteArray(padding - padding / 2, ' ');
+}
+
+QByteArray fileNameOf(const char *path)
+{
+    const char *name = path;
+    for (const char *c = path; *c != '\0'; ++c)
+    {
+        if (*c == '/' || *c == '\\')
+            name = c + 1;
+    }
+    return QByteArray(name);
+}
+} // namespace
+
+// formats the records in the ring buffer and writes them to the log file in a background thread
+class LogWriter
+{
+  public:
+    ~LogWriter()
+    {
+        stop();
+    }
+
+    void start()
+    {
+        running.store(true);
+        thread = QThread::create([this] {
+            while (running.load())
+            {
+                if (!writeBatch())
+                    QThread::msleep(IDLE_INTERVAL);
+            }
+            while (writeBatch())
+                ;
+        });
+        thread->start(QThread::LowPriority);
+    }
+
+    /**
+     * @brief write the pending records and wait for the thread to finish
+     */
+    void stop()
+    {
+        if (thread == nullptr)
+            return;
+        running.store(false);
+        thread->wait();
+        delete thread;
+        thread = nullptr;
+    }
+
+  private:
+    bool writeBatch()
+    {
+        auto &buffer = ringBuffer();
+        QByteArray out;
+
+        const auto dropped = buffer.dropped.exchange(0, std::memory_order_relaxed);
+        if (dropped > 0)
+            out += QByteArray("[") + LEVEL_NAMES[Log::Warning] + "]" + QByteArray::number(qulonglong(dropped)) +
+                   " logs are dropped because the buffer is full\n";
+
+        size_t count = 0;
+        while (count < BATCH_SIZE)
+        {
+            const auto *record = buffer.peek(count);
+            if (record == nullptr)
+                break;
+            format(*record, out);
+            ++count;
+        }
+
+        if (out.isEmpty())
+            return false;
+
+        Log::logFile.write(out);
+        buffer.release(count);
+        return count > 0;
+    }
+
+    static void format(const Record &record, QByteArray &out)
+    {
+        const auto time = clockOrigin().wall + (record.time - clockOrigin().monotonic) / 1000000;
+        out += '[';
+        out += QDateTime::fromMSecsSinceEpoch(time).toString(Qt::ISODateWithMs).toUtf8();
+        out += "][";
+        out += LEVEL_NAMES[record.level];
+        out += "][";
+        out += centered(record.site->function, Log::MAXIMUM_FUNCTION_NAME_SIZE);
+        out += "][";
+        out += centered(fileNameOf(record.site->file), Log::MAXIMUM_FILE_NAME_SIZE);
+        out += "](";
+        out += QByteArray::number(record.site->line);
+        out += ")::";
+        out += record.message;
+        out += '\n';
+    }
+
+    QThread *thread = nullptr;
+    std::atomic<bool> running{false};
+};
+
+namespace
+{
+// It's constructed in Log::init() after the ring buffer and the clock origin, and Log::logFile is constructed before
+// main(), so if Log::shutdown() is not called, the writer is still destroyed before the objects it uses.
+LogWriter &logWriter()
+{
+    static LogWriter writer;
+    return writer;
+}
+} // namespace
+
+struct Log::Message::Buffer
+{
+    QString text;
+    QTextStream stream;
+    bool inUse = false;
+};
+
+namespace
+{
+thread_local Log::Message::Buffer threadBuffer;
+} // namespace
+
+Log::Message::Message(Level level, const Site *site) : level(level), site(site), time(monotonicTime())
+{
+    if (threadBuffer.inUse)
+    {
+        // a message is logged while formatting another message in the same thread
+        ownBuffer.reset(new Buffer());
+        buffer = ownBuffer.get();
+    }
+    else
+    {
+        buffer = &threadBuffer;
+    }
+    buffer->inUse = true;
+    buffer->text.resize(0);
+    buffer->stream.setString(&buffer->text); // this also resets the format of the stream
+}
+
+Log::Message::~Message()
+{
+    buffer->stream.flush();
+    ringBuffer().push({time, level, site, buffer->text.toUtf8()});
+    buffer->inUse = false;
+}
+
+QTextStream &Log::Message::out()
+{
+    return buffer->stream;
+}
 
 QFile Log::logFile;
-QTextStream Log::logStream;
+std::atomic<int> Log::minimumLevel{Log::Info};
 
 const int Log::NUMBER_OF_LOGS_TO_KEEP = 50;
 const int Log::MAXIMUM_FUNCTION_NAME_SIZE = 30;
@@ -43,7 +417,9 @@ const QString Log::LOG_FILE_NAME = "cpeditor";
 
 void Log::init(unsigned int instance, bool dumptoStderr)
 {
-    logStream.setDevice(&logFile);
+    clockOrigin();
+    ringBuffer();
+
     if (!dumptoStderr)
     {
         // get the path to the log file
@@ -59,12 +435,12 @@ void Log::init(unsigned int instance, bool dumptoStderr)
             for (int i = NUMBER_OF_LOGS_TO_KEEP; i < entries.length(); ++i)
                 dir.remove(entries[i]);
 
-            // open the log file
+            // open the log file, each batch is written at once, so it's unbuffered and is complete when crashing
             logFile.setFileName(dir.filePath(QString("%1-%2-%3.log")
                                                  .arg(LOG_FILE_NAME)
                                                  .arg(QDateTime::currentDateTime().toString("yyyy-MM-dd-hh-mm-ss-zzz"))
                                                  .arg(instance)));
-            logFile.open(QIODevice::WriteOnly | QFile::Text);
+            logFile.open(QIODevice::WriteOnly | QIODevice::Unbuffered);
             LOG_ERR_IF(!logFile.isOpen() || !logFile.isWritable(), "Failed to open file" << logFile.fileName());
         }
         else
@@ -72,17 +448,39 @@ void Log::init(unsigned int instance, bool dumptoStderr)
             LOG_ERR("Failed to open directory" << dir.filePath(LOG_DIR_NAME));
         }
     }
-    else
-    {
-        logFile.open(stderr, QIODevice::WriteOnly);
-    }
+
+    if (!logFile.isOpen() || !logFile.isWritable())
+        logFile.open(fileno(stderr), QIODevice::WriteOnly | QIODevice::Unbuffered); // dump to stderr if failed
+
+    logDescriptor.store(logFile.handle());
+    logWriter().start();
+
     LOG_INFO("Event logger has been initialized successfully");
     platformInformation();
 }
 
-QString Log::dateTimeStamp()
+void Log::shutdown()
+{
+    LOG_INFO("Shutting down the event logger");
+    minimumLevel.store(Wtf + 1, std::memory_order_relaxed);
+    logWriter().stop();
+    logDescriptor.store(2);
+    logFile.close();
+}
+
+void Log::setMinimumLevel(Level level)
+{
+    LOG_INFO(INFO_OF(level));
+    minimumLevel.store(level, std::memory_order_relaxed);
+}
+
+void Log::dumpPendingLogs(int signal)
 {
-    return "[" + QDateTime::currentDateTime().toString(Qt::ISODateWithMs) + "]";
+    const int fd = logDescriptor.load();
+    writeToDescriptor(fd, "---- Crashed with signal ");
+    writeToDescriptor(fd, qint64(signal));
+    writeToDescriptor(fd, ", the logs not written yet are following ----\n");
+    dumpRingBuffer(ringBuffer(), fd);
 }
 
 void Log::platformInformation()
@@ -116,25 +514,6 @@ void Log::platformInformation()
     LOG_INFO(INFO_OF(__TIME__));
 }
 
-QTextStream &Log::log(const QString &priority, QString funcName, int line, QString fileName)
-{
-    if (!logFile.isOpen() || !logFile.isWritable())
-        logFile.open(stderr, QIODevice::WriteOnly); // dump to stderr if failed to open log file
-    if (funcName.size() > MAXIMUM_FUNCTION_NAME_SIZE)
-        funcName = funcName.right(MAXIMUM_FUNCTION_NAME_SIZE);
-
-    QFileInfo info(fileName);
-    fileName = info.fileName();
-
-    if (fileName.size() > MAXIMUM_FILE_NAME_SIZE)
-        fileName = fileName.right(MAXIMUM_FILE_NAME_SIZE);
-
-    return logStream << dateTimeStamp() << Qt::center << "[" << priority << "]["
-                     << qSetFieldWidth(MAXIMUM_FUNCTION_NAME_SIZE) << funcName << qSetFieldWidth(0) << "]["
-                     << qSetFieldWidth(MAXIMUM_FILE_NAME_SIZE) << fileName << qSetFieldWidth(0) << Qt::left << "]"
-                     << "(" << line << ")::";
-}
-
 void Log::revealInFileManager()
 {
     Util::revealInFileManager(logFile.fileName()).first();
@@ -18,6 +18,9 @@
 /*
  * The event logger is used for logging events of the editor.
  * The logs can helps the maintainers find the bug.
+ * A log call only formats its message and puts a record into a lock-free ring buffer, the records are formatted and
+ * written to the log file by a background thread. The messages below the minimum level are not even formatted. The
+ * records not written yet are dumped to the log file if the application crashes.
  */
 
 #ifndef EVENTLOGGER_HPP
@@ -27,6 +30,8 @@
 #include <QDebug>
 #endif
 #include <QTextStream>
+#include <atomic>
+#include <memory>
 
 class QFile;
 
@@ -43,10 +48,20 @@ class QFile;
  * pure string replacement, we cannot put braces, and hence the no lint.
  */
 
-#define LOG_INFO(stream) Core::Log::log("INFO ", __func__, __LINE__, __FILE__) << stream << Qt::endl; // NOLINT
-#define LOG_WARN(stream) Core::Log::log("WARN ", __func__, __LINE__, __FILE__) << stream << Qt::endl; // NOLINT
-#define LOG_ERR(stream) Core::Log::log("ERROR", __func__, __LINE__, __FILE__) << stream << Qt::endl;  // NOLINT
-#define LOG_WTF(stream) Core::Log::log(" WTF ", __func__, __LINE__, __FILE__) << stream << Qt::endl;  // NOLINT
+#define LOG_AT(level, stream)                                                                                          \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        if (Core::Log::isEnabled(level))                                                                               \
+        {                                                                                                              \
+            static const Core::Log::Site logSite = {__FILE__, __func__, __LINE__};                                     \
+            Core::Log::Message(level, &logSite).out() << stream; /* NOLINT */                                          \
+        }                                                                                                              \
+    } while (false);
+
+#define LOG_INFO(stream) LOG_AT(Core::Log::Info, stream)   // NOLINT
+#define LOG_WARN(stream) LOG_AT(Core::Log::Warning, stream) // NOLINT
+#define LOG_ERR(stream) LOG_AT(Core::Log::Error, stream)    // NOLINT
+#define LOG_WTF(stream) LOG_AT(Core::Log::Wtf, stream)      // NOLINT
 
 #define LOG_INFO_IF(cond, stream)                                                                                      \
     if (cond)                                                                                                          \
@@ -91,14 +106,56 @@ namespace Core
 class Log
 {
   public:
+    enum Level
+    {
+        Info,
+        Warning,
+        Error,
+        Wtf
+    };
+
+    // the place of a log call, each call has a static one
+    struct Site
+    {
+        const char *file;
+        const char *function;
+        int line;
+    };
+
+    // a message being formatted, it's put into the buffer when it's destroyed
+    class Message
+    {
+      public:
+        Message(Level level, const Site *site);
+        ~Message();
+
+        QTextStream &out();
+
+      private:
+        struct Buffer; // the formatted text, reused by the messages in the same thread
+
+        Level level;
+        const Site *site;
+        qint64 time; // the monotonic time in nanoseconds
+        Buffer *buffer;
+        std::unique_ptr<Buffer> ownBuffer; // used if the buffer of the thread is used by an outer message
+    };
+
     /**
-     * @brief initialize the event logger
+     * @brief initialize the event logger and start writing the logs
      * @param instance the instance ID provided by SingleApplication, to distinct processes from each other
      * @param dumptoStderr whether to print the logs into stderr or not
-     * @note this should be called only once before logging anything
+     * @note this should be called only once, the logs before it are kept in the buffer
      */
     static void init(unsigned int instance, bool dumptoStderr = false);
 
+    /**
+     * @brief write the pending logs, stop the writer thread and close the log file, nothing is logged after this
+     * @note This should be called before returning from main(), so the writer thread is stopped before the static
+     *       objects are destroyed.
+     */
+    static void shutdown();
+
     /**
      * @brief clear old logs
      * @note this clears all logs except the current one
@@ -110,14 +167,28 @@ class Log
      */
     static void revealInFileManager();
 
-    static QTextStream &log(const QString &priority, QString funcName, int line, QString fileName);
+    /**
+     * @brief set the minimum level of the logs, the messages of the logs below it are not formatted
+     */
+    static void setMinimumLevel(Level level);
+
+    static bool isEnabled(Level level)
+    {
+        return level >= minimumLevel.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief write the records not written yet to the log file
+     * @param signal the signal which causes the crash
+     * @note This is async-signal-safe, it's called by the crash handler.
+     */
+    static void dumpPendingLogs(int signal);
 
   private:
-    static QString dateTimeStamp();
     static void platformInformation();
 
-    static QTextStream logStream; // the text stream for logging, writes to logFile
-    static QFile logFile;         // the device for logging, a file or stderr
+    static std::atomic<int> minimumLevel;
+    static QFile logFile; // the device for logging, a file or stderr, only used by the writer thread after init()
 
     const static int NUMBER_OF_LOGS_TO_KEEP; // Number of log files to keep in Temporary directory
     const static QString LOG_FILE_NAME;      // Base Name of the log file
@@ -125,6 +196,8 @@ class Log
     const static int
         MAXIMUM_FUNCTION_NAME_SIZE; // Maximum size of function name, it is used to determine spacing in log file
     const static int MAXIMUM_FILE_NAME_SIZE; // Maximum size of file name, it is used to determine spacing in log file
+
+    friend class LogWriter;
 };
 
 } // namespace Core
@@ -0,0 +1,269 @@
+/*
+ * Copyright (C) 2019-2021 Ashar Khan <ashar786khan@gmail.com>
+ *
+ * This file is part of CP Editor.
+ *
+ * CP Editor is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * I will not be responsible if CP Editor behaves in unexpected way and
+ * causes your ratings to go down and or lose any important contest.
+ *
+ * Believe Software is "Software" and it isn't immune to bugs.
+ *
+ */
+
+#include "Core/FileWriter.hpp"
+#include "Core/EventLogger.hpp"
+#include "Core/MessageLogger.hpp"
+#include "Util/FileUtil.hpp"
+#include "generated/SettingsHelper.hpp"
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QRunnable>
+#include <QSet>
+#include <QThreadPool>
+#include <functional>
+#include <vector>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#else
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace Core
+{
+struct FileWriter::Write
+{
+    QString path;
+    QString content;
+    bool safe = false;            // true if any of the coalesced writes is safe
+    bool createDirectory = false; // true if any of the coalesced writes creates the directory
+    std::promise<bool> promise;
+    std::shared_future<bool> future;
+};
+
+namespace
+{
+class WriteTask : public QRunnable
+{
+  public:
+    explicit WriteTask(std::function<void()> work) : work(std::move(work))
+    {
+    }
+
+    void run() override
+    {
+        work();
+    }
+
+  private:
+    std::function<void()> work;
+};
+
+// the files are written by a single thread, so that the writes are done in the order they are requested
+QThreadPool *writingThreadPool()
+{
+    static QThreadPool *pool = [] {
+        // the pool is destroyed with the application, which waits for the pending writes
+        auto *pool = new QThreadPool(QCoreApplication::instance());
+        pool->setMaxThreadCount(1);
+        return pool;
+    }();
+    return pool;
+}
+
+// replace the file at *to* by the file at *from*, *to* is never missing or partially written
+bool replaceFile(const QString &from, const QString &to)
+{
+#ifdef Q_OS_WIN
+    return MoveFileExW(reinterpret_cast<LPCWSTR>(QDir::toNativeSeparators(from).utf16()),
+                       reinterpret_cast<LPCWSTR>(QDir::toNativeSeparators(to).utf16()),
+                       MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    return ::rename(QFile::encodeName(from).constData(), QFile::encodeName(to).constData()) == 0;
+#endif
+}
+
+// make sure that the renames in a directory are written to the disk
+void syncDirectory(const QString &path)
+{
+#ifdef Q_OS_WIN
+    Q_UNUSED(path); // MoveFileExW writes through
+#else
+    const int fd = ::open(QFile::encodeName(path).constData(), O_RDONLY);
+    if (fd == -1)
+        return;
+    fsync(fd);
+    ::close(fd);
+#endif
+}
+} // namespace
+
+std::shared_future<bool> FileWriter::write(const QString &path, const QString &content, const QString &head, bool safe,
+                                           MessageLogger *log, bool createDirectory)
+{
+    reporters[path] = {head, log};
+    safe = safe && !SettingsHelper::isSaveFaster();
+
+    QMutexLocker locker(&mutex);
+
+    auto &write = pendingWrites[path];
+    if (write == nullptr)
+    {
+        write = std::make_shared<Write>();
+        write->path = path;
+        write->future = write->promise.get_future().share();
+        pendingPaths.push_back(path);
+    }
+    else
+    {
+        LOG_INFO("Coalesced with the pending write " << INFO_OF(path));
+    }
+
+    write->content = content;
+    write->safe = write->safe || safe;
+    write->createDirectory = write->createDirectory || createDirectory;
+
+    if (!isScheduled)
+    {
+        isScheduled = true;
+        writingThreadPool()->start(new WriteTask([this] { writePending(); }));
+    }
+
+    return write->future;
+}
+
+void FileWriter::waitForDone()
+{
+    writingThreadPool()->waitForDone();
+}
+
+void FileWriter::writePending()
+{
+    QList<std::shared_ptr<Write>> batch;
+    {
+        QMutexLocker locker(&mutex);
+        for (auto const &path : qAsConst(pendingPaths))
+            batch.push_back(pendingWrites.take(path));
+        pendingPaths.clear();
+        isScheduled = false;
+    }
+
+    // a safe write whose content is in the temporary file and waiting to be renamed
+    struct Staged
+    {
+        std::shared_ptr<Write> write;
+        QString target;
+        std::unique_ptr<QFile> file;
+    };
+
+    QList<QPair<std::shared_ptr<Write>, bool>> finished;
+    std::vector<Staged> staged;
+
+    for (auto const &write : batch)
+    {
+        if (write->createDirectory)
+            QDir().mkpath(QFileInfo(write->path).absolutePath());
+
+        const auto data = write->content.toUtf8();
+
+        if (!write->safe)
+        {
+            QFile file(write->path);
+            finished.push_back({write, file.open(QIODevice::WriteOnly | QIODevice::Text) && file.write(data) != -1});
+            continue;
+        }
+
+        // write to the target of a symbolic link instead of replacing the link, the same as QSaveFile
+        const QFileInfo info(write->path);
+        const auto target = info.isSymLink() ? info.symLinkTarget() : write->path;
+
+        auto file = std::make_unique<QFile>(QString("%1.%2.tmp").arg(target).arg(QCoreApplication::applicationPid()));
+        if (!file->open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text) || file->write(data) == -1)
+        {
+            file->remove();
+            finished.push_back({write, false});
+            continue;
+        }
+        if (QFileInfo::exists(target))
+            file->setPermissions(QFile::permissions(target));
+
+        staged.push_back({write, target, std::move(file)});
+    }
+
+    // all temporary files are synced before any of them is renamed, so that they are written to the disk together
+    QList<bool> synced;
+    for (auto &item : staged)
+    {
+        synced.push_back(Util::syncFile(*item.file));
+        item.file->close();
+    }
+
+    QSet<QString> directories;
+    for (int i = 0; i < int(staged.size()); ++i)
+    {
+        const auto &item = staged[i];
+        const bool ok = synced[i] && replaceFile(item.file->fileName(), item.target);
+        if (ok)
+            directories.insert(QFileInfo(item.target).absolutePath());
+        else
+            item.file->remove();
+        finished.push_back({item.write, ok});
+    }
+
+    for (auto const &directory : directories)
+        syncDirectory(directory);
+
+    QList<QPair<QString, bool>> results;
+    for (auto const &result : finished)
+    {
+        result.first->promise.set_value(result.second);
+        results.push_back({result.first->path, result.second});
+    }
+
+    QMetaObject::invokeMethod(
+        this, [this, results] { onBatchWritten(results); }, Qt::QueuedConnection);
+}
+
+void FileWriter::onBatchWritten(const QList<QPair<QString, bool>> &results)
+{
+    for (auto const &result : results)
+    {
+        const auto &path = result.first;
+        const auto reporter = reporters.value(path);
+
+        if (result.second)
+        {
+            LOG_INFO("Successfully saved to [" << path << "]");
+        }
+        else
+        {
+            if (reporter.log != nullptr)
+            {
+                reporter.log->error(reporter.head,
+                                    QCoreApplication::translate("Util::FileUtil",
+                                                                "Failed to save to [%1]. Do I have write permission?")
+                                        .arg(path));
+            }
+            LOG_ERR("Failed to save to [" << path << "]");
+        }
+
+        {
+            // keep the reporter of the next write to this path
+            QMutexLocker locker(&mutex);
+            if (!pendingWrites.contains(path))
+                reporters.remove(path);
+        }
+
+        emit fileWritten(path, result.second);
+    }
+}
+} // namespace Core
@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2019-2021 Ashar Khan <ashar786khan@gmail.com>
+ *
+ * This file is part of CP Editor.
+ *
+ * CP Editor is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * I will not be responsible if CP Editor behaves in unexpected way and
+ * causes your ratings to go down and or lose any important contest.
+ *
+ * Believe Software is "Software" and it isn't immune to bugs.
+ *
+ */
+
+/*
+ * The files written in the background, so that saving a file doesn't block the GUI thread.
+ * The pending writes to the same path are coalesced, only the latest content is written. The files are written by a
+ * single thread in batches. In a batch, the contents of the safe writes are written to temporary files and synced
+ * together, then the temporary files are renamed to the target paths, so a file is either the old one or the new one.
+ */
+
+#ifndef FILEWRITER_HPP
+#define FILEWRITER_HPP
+
+#include "Util/Singleton.hpp"
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QPointer>
+#include <future>
+#include <memory>
+
+class MessageLogger;
+
+namespace Core
+{
+class FileWriter : public QObject, public Util::Singleton<FileWriter>
+{
+    Q_OBJECT
+
+  public:
+    struct Write; // a pending write, used in the background thread
+
+    /**
+     * @brief write a file in the background
+     * @param path the path to the file
+     * @param content the content of the file, it's encoded in UTF-8 in the background
+     * @param head the head of the error message
+     * @param safe whether to replace the file atomically, see Util::saveFile
+     * @param log the MessageLogger to show the error, the error is not shown if it's deleted before the write finishes
+     * @param createDirectory whether to create the parent directory if it doesn't exist
+     * @returns the future of whether the file is written, it's shared by the writes coalesced with this one
+     * @note This should be called in the GUI thread. Don't wait for the future in a function called by the writer.
+     */
+    std::shared_future<bool> write(const QString &path, const QString &content, const QString &head, bool safe,
+                                   MessageLogger *log, bool createDirectory = false);
+
+    /**
+     * @brief wait for all pending writes
+     */
+    void waitForDone();
+
+  signals:
+    /**
+     * @brief a file is written or failed to be written, emitted in the GUI thread
+     */
+    void fileWritten(const QString &path, bool ok);
+
+  private:
+    friend class Util::Singleton<FileWriter>;
+
+    FileWriter() = default;
+
+    /**
+     * @brief write all pending files, called in the background thread
+     */
+    void writePending();
+
+    /**
+     * @brief report the results of a batch, called in the GUI thread
+     */
+    void onBatchWritten(const QList<QPair<QString, bool>> &results);
+
+    struct Reporter
+    {
+        QString head;
+        QPointer<MessageLogger> log;
+    };
+
+    // guards pendingPaths, pendingWrites and isScheduled
+    QMutex mutex;
+    // the paths of the pending writes, in the order they are requested
+    QStringList pendingPaths;
+    // the pending writes, keyed by the paths
+    QHash<QString, std::shared_ptr<Write>> pendingWrites;
+    // whether writePending() is going to be called for the pending writes
+    bool isScheduled = false;
+
+    // how to report the errors, keyed by the paths, it's only accessed in the GUI thread
+    QHash<QString, Reporter> reporters;
+};
+} // namespace Core
+
+#endif // FILEWRITER_HPP
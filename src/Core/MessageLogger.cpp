@@ -19,13 +19,249 @@
 #include "Core/EventLogger.hpp"
 #include "Settings/PreferencesWindow.hpp"
 #include "generated/SettingsHelper.hpp"
+#include <QAbstractTextDocumentLayout>
+#include <QApplication>
+#include <QClipboard>
 #include <QDateTime>
+#include <QDesktopServices>
+#include <QKeyEvent>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QScrollBar>
+#include <QStyledItemDelegate>
+#include <QTextDocument>
+#include <QTimer>
+#include <QUrl>
+#include <QtMath>
+#include <algorithm>
+
+namespace
+{
+// the pending messages are added to the view at most once in this time
+const int FLUSH_INTERVAL = 50;
+} // namespace
+
+class MessageLogger::Model : public QAbstractListModel
+{
+  public:
+    struct Entry
+    {
+        QString time;
+        QString head;  // HTML
+        QString body;  // HTML
+        QString color; // empty for the default color
+        int count = 1; // the number of times it's repeated
+
+        mutable int width = -1; // the width used to calculate the height, -1 if the height is not calculated
+        mutable int height = 0;
+
+        bool isRepeatOf(const Entry &other) const
+        {
+            return head == other.head && body == other.body && color == other.color;
+        }
+
+        QString html() const
+        {
+            // use monospace for the message body, it's important for compilation errors
+            // "monospace" might not work on Windows, but "Consolas,Courier,monospace" works
+            QString res = QString("<b>[%1] [%2] </b><span style=\"").arg(time, head);
+            if (!color.isEmpty())
+                res += "color:" + color;
+            res += "\">[";
+            if (body.contains('\n'))
+                res += "<br>" + QString(body).replace("\n", "<br>");
+            else
+                res += body;
+            res += "]</span>";
+            if (count > 1)
+                res += QString(" <i>(&times;%1)</i>").arg(count);
+            return res;
+        }
+    };
+
+    using QAbstractListModel::QAbstractListModel;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override
+    {
+        return parent.isValid() ? 0 : entries.size();
+    }
+
+    QVariant data(const QModelIndex &index, int role) const override
+    {
+        if (!index.isValid() || index.row() >= entries.size() || role != Qt::DisplayRole)
+            return QVariant();
+        return entries[index.row()].html();
+    }
+
+    const Entry &entryAt(int row) const
+    {
+        return entries[row];
+    }
+
+    /**
+     * @brief add an entry in the next flush, it's merged into the last one if it's a repeat
+     */
+    void append(const Entry &entry)
+    {
+        if (!pending.isEmpty() && entry.isRepeatOf(pending.last()))
+        {
+            pending.last().count += entry.count;
+            pending.last().time = entry.time;
+        }
+        else if (pending.isEmpty() && !entries.isEmpty() && entry.isRepeatOf(entries.last()))
+        {
+            entries.last().count += entry.count;
+            entries.last().time = entry.time;
+            entries.last().width = -1;
+            lastChanged = true;
+        }
+        else
+        {
+            pending.push_back(entry);
+        }
+    }
+
+    bool hasPending() const
+    {
+        return lastChanged || !pending.isEmpty();
+    }
+
+    /**
+     * @brief add the pending entries, and remove the oldest entries if there are more than the capacity
+     */
+    void flush(int capacity)
+    {
+        if (lastChanged)
+        {
+            lastChanged = false;
+            emit dataChanged(index(entries.size() - 1), index(entries.size() - 1));
+        }
+
+        // the pending entries which would be removed at once are not added at all
+        if (pending.size() > capacity)
+            pending.erase(pending.begin(), pending.end() - capacity);
+
+        const int removed = qMin(entries.size(), entries.size() + pending.size() - capacity);
+        if (removed > 0)
+        {
+            beginRemoveRows(QModelIndex(), 0, removed - 1);
+            entries.erase(entries.begin(), entries.begin() + removed);
+            endRemoveRows();
+        }
+
+        if (!pending.isEmpty())
+        {
+            beginInsertRows(QModelIndex(), entries.size(), entries.size() + pending.size() - 1);
+            entries += pending;
+            endInsertRows();
+            pending.clear();
+        }
+    }
+
+    /**
+     * @brief forget the calculated heights, they are calculated again when they are needed, e.g. after a font change
+     */
+    void invalidateHeights()
+    {
+        for (auto const &entry : entries)
+            entry.width = -1;
+    }
+
+    void clear()
+    {
+        beginResetModel();
+        entries.clear();
+        pending.clear();
+        lastChanged = false;
+        endResetModel();
+    }
+
+  private:
+    QList<Entry> entries;
+    QList<Entry> pending;     // the entries not added to the model yet
+    bool lastChanged = false; // whether the last entry is repeated since the last flush
+};
+
+// renders the HTML of the messages, the heights are cached in the entries
+class MessageLogger::Delegate : public QStyledItemDelegate
+{
+  public:
+    Delegate(Model *model, QListView *view) : QStyledItemDelegate(view), model(model), view(view)
+    {
+    }
+
+    void paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const override
+    {
+        QStyleOptionViewItem opt = option;
+        initStyleOption(&opt, index);
+        opt.text.clear();
+        auto *style = opt.widget != nullptr ? opt.widget->style() : QApplication::style();
+        style->drawControl(QStyle::CE_ItemViewItem, &opt, painter, opt.widget);
+
+        QTextDocument document;
+        prepare(document, option.font, index.row(), option.rect.width());
+
+        QAbstractTextDocumentLayout::PaintContext context;
+        context.palette = option.palette;
+        if (option.state & QStyle::State_Selected)
+            context.palette.setColor(QPalette::Text, option.palette.color(QPalette::HighlightedText));
+
+        painter->save();
+        painter->translate(option.rect.topLeft());
+        painter->setClipRect(option.rect.translated(-option.rect.topLeft()));
+        document.documentLayout()->draw(painter, context);
+        painter->restore();
+    }
+
+    QSize sizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const override
+    {
+        const int width = view->viewport()->width();
+        const auto &entry = model->entryAt(index.row());
+        if (entry.width != width)
+        {
+            QTextDocument document;
+            prepare(document, option.font, index.row(), width);
+            entry.width = width;
+            entry.height = qCeil(document.size().height());
+        }
+        return QSize(width, entry.height);
+    }
+
+    /**
+     * @brief set up a document to lay out a message
+     */
+    void prepare(QTextDocument &document, const QFont &font, int row, int width) const
+    {
+        document.setDefaultFont(font);
+        document.setDocumentMargin(1);
+        document.setHtml(model->entryAt(row).html());
+        document.setTextWidth(width);
+    }
+
+  private:
+    Model *model;
+    QListView *view;
+};
 
 MessageLogger::MessageLogger(PreferencesWindow *preferences, QWidget *parent)
-    : QTextBrowser(parent), preferencesWindow(preferences)
+    : QListView(parent), preferencesWindow(preferences)
 {
-    connect(this, &MessageLogger::anchorClicked, this, &MessageLogger::onAnchorClicked);
-    setOpenExternalLinks(true);
+    model = new Model(this);
+    delegate = new Delegate(model, this);
+    setModel(model);
+    setItemDelegate(delegate);
+
+    setSelectionMode(QAbstractItemView::ExtendedSelection);
+    setVerticalScrollMode(QAbstractItemView::ScrollPerPixel);
+    setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+    setResizeMode(QListView::Adjust); // the heights depend on the width
+    setWordWrap(true);
+    setMouseTracking(true);
+
+    flushTimer = new QTimer(this);
+    flushTimer->setSingleShot(true);
+    flushTimer->setInterval(FLUSH_INTERVAL);
+    connect(flushTimer, &QTimer::timeout, this, &MessageLogger::flushPendingMessages);
 }
 
 void MessageLogger::message(const QString &head, const QString &body, const QString &color, bool htmlEscaped)
@@ -33,38 +269,29 @@ void MessageLogger::message(const QString &head, const QString &body, const QStr
     LOG_WARN_IF(body.contains("<a href") && htmlEscaped,
                 "The message contains \"<a href\", but htmlEscaped is enabled.");
 
-    QString newHead;
-    QString newBody;
+    Model::Entry entry;
     if (htmlEscaped)
     {
         // replace spaces by "&nbsp;" to avoid multiple spaces becoming one, important for compilation errors
-        newHead = head.toHtmlEscaped().replace(" ", "&nbsp;");
-        newBody = body.toHtmlEscaped().replace(" ", "&nbsp;");
+        entry.head = head.toHtmlEscaped().replace(" ", "&nbsp;");
+        entry.body = body.toHtmlEscaped().replace(" ", "&nbsp;");
     }
     else
     {
-        newHead = head;
-        newBody = body;
+        entry.head = head;
+        entry.body = body;
     }
 
     // don't display too long messages, otherwise the application may stuck
-    if (newBody.length() > SettingsHelper::getMessageLengthLimit())
-        newBody = newBody.left(SettingsHelper::getMessageLengthLimit()) + tr("\n... The message is too long");
-
-    // get the HTML of the message
-    // use monospace for the message body, it's important for compilation errors
-    // "monospace" might not work on Windows, but "Consolas,Courier,monospace" works
-    QString res = QString("<b>[%1] [%2] </b><span style=\"").arg(QTime::currentTime().toString(), newHead);
-    if (!color.isEmpty())
-        res += "color:" + color;
-    res += "\">[";
-    if (newBody.contains('\n'))
-        res += "<br>" + newBody.replace("\n", "<br>");
-    else
-        res += newBody;
-    res += "]</span>";
+    if (entry.body.length() > SettingsHelper::getMessageLengthLimit())
+        entry.body = entry.body.left(SettingsHelper::getMessageLengthLimit()) + tr("\n... The message is too long");
+
+    entry.time = QTime::currentTime().toString();
+    entry.color = color;
 
-    append(res);
+    model->append(entry);
+    if (!flushTimer->isActive())
+        flushTimer->start();
 }
 
 void MessageLogger::info(const QString &head, const QString &body, bool htmlEscaped)
@@ -85,10 +312,91 @@ void MessageLogger::error(const QString &head, const QString &body, bool htmlEsc
     message(head, body, "red", htmlEscaped);
 }
 
-void MessageLogger::onAnchorClicked(const QUrl &link)
+void MessageLogger::clear()
+{
+    flushTimer->stop();
+    model->clear();
+}
+
+void MessageLogger::flushPendingMessages()
+{
+    if (!model->hasPending())
+        return;
+
+    // keep showing the latest messages, unless the user has scrolled up to read the old ones
+    const bool atBottom = verticalScrollBar()->value() == verticalScrollBar()->maximum();
+
+    model->flush(SettingsHelper::getMessageLoggerCapacity());
+
+    // the height of a repeated message may be changed by the number of repetitions
+    scheduleDelayedItemsLayout();
+
+    if (atBottom)
+        scrollToBottom();
+}
+
+void MessageLogger::changeEvent(QEvent *event)
+{
+    QListView::changeEvent(event);
+    if (event->type() == QEvent::FontChange)
+    {
+        // the heights are cached by the width, but they depend on the font as well
+        model->invalidateHeights();
+        scheduleDelayedItemsLayout();
+    }
+}
+
+void MessageLogger::mouseMoveEvent(QMouseEvent *event)
+{
+    viewport()->setCursor(anchorAt(event->pos()).isEmpty() ? Qt::ArrowCursor : Qt::PointingHandCursor);
+    QListView::mouseMoveEvent(event);
+}
+
+void MessageLogger::mouseReleaseEvent(QMouseEvent *event)
+{
+    const auto anchor = event->button() == Qt::LeftButton ? anchorAt(event->pos()) : QString();
+    QListView::mouseReleaseEvent(event);
+    if (!anchor.isEmpty())
+        onAnchorClicked(anchor);
+}
+
+void MessageLogger::keyPressEvent(QKeyEvent *event)
+{
+    if (event->matches(QKeySequence::Copy))
+    {
+        auto indexes = selectionModel()->selectedIndexes();
+        std::sort(indexes.begin(), indexes.end(),
+                  [](const QModelIndex &a, const QModelIndex &b) { return a.row() < b.row(); });
+        QStringList lines;
+        for (auto const &index : indexes)
+        {
+            QTextDocument document;
+            document.setHtml(index.data().toString());
+            lines.push_back(document.toPlainText());
+        }
+        QApplication::clipboard()->setText(lines.join('\n'));
+        return;
+    }
+    QListView::keyPressEvent(event);
+}
+
+QString MessageLogger::anchorAt(const QPoint &pos) const
 {
-    auto url = link.toString();
-    LOG_INFO(INFO_OF(url));
-    if (url.startsWith("#Preferences/"))
-        preferencesWindow->open(url.mid(13));
+    const auto index = indexAt(pos);
+    if (!index.isValid())
+        return QString();
+
+    const auto rect = visualRect(index);
+    QTextDocument document;
+    delegate->prepare(document, font(), index.row(), rect.width());
+    return document.documentLayout()->anchorAt(pos - rect.topLeft());
+}
+
+void MessageLogger::onAnchorClicked(const QString &link)
+{
+    LOG_INFO(INFO_OF(link));
+    if (link.startsWith("#Preferences/"))
+        preferencesWindow->open(link.mid(13));
+    else
+        QDesktopServices::openUrl(QUrl(link));
 }
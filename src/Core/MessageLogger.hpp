@@ -17,16 +17,20 @@
 
 /*
  * The MessageLogger is used to send messages to the user directly in the GUI.
+ * The messages are kept in a model with a bounded capacity, the oldest ones are removed when it's full, and only the
+ * visible ones are rendered. The messages are added in batches, and a message same as the previous one is shown once
+ * with the number of times it's repeated, so logging many messages costs the same for each message.
  */
 
 #ifndef MESSAGELOGGER_HPP
 #define MESSAGELOGGER_HPP
 
-#include <QTextBrowser>
+#include <QListView>
 
 class PreferencesWindow;
+class QTimer;
 
-class MessageLogger : public QTextBrowser
+class MessageLogger : public QListView
 {
     Q_OBJECT
 
@@ -39,6 +43,7 @@ class MessageLogger : public QTextBrowser
      * @param body the main part of the message
      * @param color the color of the message, use the default color if this parameter is empty
      * @param htmlEscaped convert the message to the HTML escaped format to avoid hidden "<>" and wrong spaces
+     * @note the message is shown in the next batch
      */
     void message(const QString &head, const QString &body, const QString &color, bool htmlEscaped = true);
 
@@ -69,11 +74,35 @@ class MessageLogger : public QTextBrowser
      */
     void error(const QString &head, const QString &body, bool htmlEscaped = true);
 
+    /**
+     * @brief remove all messages, including the ones not shown yet
+     */
+    void clear();
+
+  protected:
+    void changeEvent(QEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
+    void keyPressEvent(QKeyEvent *event) override;
+
   private slots:
-    void onAnchorClicked(const QUrl &link);
+    void flushPendingMessages();
 
   private:
+    class Model;
+    class Delegate;
+
+    /**
+     * @returns the link at a position in the viewport, empty if there's no link
+     */
+    QString anchorAt(const QPoint &pos) const;
+
+    void onAnchorClicked(const QString &link);
+
     PreferencesWindow *preferencesWindow = nullptr;
+    Model *model = nullptr;
+    Delegate *delegate = nullptr;
+    QTimer *flushTimer = nullptr; // adds the pending messages in a batch
 };
 
 #endif // MESSAGELOGGER_HPP
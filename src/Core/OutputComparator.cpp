@@ -0,0 +1,471 @@
+/*
+ * Copyright (C) 2019-2021 Ashar Khan <ashar786khan@gmail.com>
+ *
+ * This file is part of CP Editor.
+ *
+ * CP Editor is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * I will not be responsible if CP Editor behaves in unexpected way and
+ * causes your ratings to go down and or lose any important contest.
+ *
+ * Believe Software is "Software" and it isn't immune to bugs.
+ *
+ */
+
+#include "Core/OutputComparator.hpp"
+#include <QLocale>
+
+namespace Core
+{
+namespace
+{
+const int CONTEXT_LINES = 2;        // the number of lines shown before and after the different line
+const int MAX_CONTEXT_LENGTH = 100; // the max number of characters shown in a line of the context
+const int MAX_TOKEN_LENGTH = 64;    // the max number of characters shown in a token
+
+// the code of an invalid UTF-8 byte, which is different from all Unicode characters
+const int INVALID_BYTE = 0x110000;
+
+inline int code(QChar c)
+{
+    return c.unicode();
+}
+
+inline int code(char c)
+{
+    return uchar(c);
+}
+
+inline bool isBlank(QChar c)
+{
+    return c.isSpace();
+}
+
+// UTF-8 text, only ASCII blank characters are blank
+inline bool isBlank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+}
+
+// the Unicode character at pos, a surrogate pair is a single character
+inline int decode(const QChar *data, int size, int pos, int *length)
+{
+    if (data[pos].isHighSurrogate() && pos + 1 < size && data[pos + 1].isLowSurrogate())
+    {
+        *length = 2;
+        return int(QChar::surrogateToUcs4(data[pos], data[pos + 1]));
+    }
+    *length = 1;
+    return data[pos].unicode();
+}
+
+// the Unicode character at pos in UTF-8, an invalid byte is a single character different from all the others
+inline int decode(const char *data, int size, int pos, int *length)
+{
+    const uchar lead = uchar(data[pos]);
+    *length = 1;
+    if (lead < 0x80)
+        return lead;
+
+    int extra = 0;
+    int result = 0;
+    if (lead >= 0xC0 && lead < 0xE0)
+    {
+        extra = 1;
+        result = lead & 0x1F;
+    }
+    else if (lead >= 0xE0 && lead < 0xF0)
+    {
+        extra = 2;
+        result = lead & 0x0F;
+    }
+    else if (lead >= 0xF0 && lead < 0xF8)
+    {
+        extra = 3;
+        result = lead & 0x07;
+    }
+    if (extra == 0 || pos + extra >= size)
+        return INVALID_BYTE + lead;
+    for (int i = 1; i <= extra; ++i)
+    {
+        const uchar c = uchar(data[pos + i]);
+        if ((c & 0xC0) != 0x80)
+            return INVALID_BYTE + lead;
+        result = result << 6 | (c & 0x3F);
+    }
+    *length = extra + 1;
+    return result;
+}
+
+inline int toLower(int c)
+{
+    return c < INVALID_BYTE ? int(QChar::toLower(uint(c))) : c;
+}
+
+inline QString toString(const QChar *data, int length)
+{
+    return QString(data, length);
+}
+
+inline QString toString(const char *data, int length)
+{
+    return QString::fromUtf8(data, length);
+}
+
+inline bool isNewline(int c)
+{
+    return c == '\n' || c == '\r';
+}
+
+// a text being scanned, positions are in code units, i.e. QChars or UTF-8 bytes
+template <typename Char> struct Text
+{
+    const Char *data;
+    int size;
+
+    int at(int pos) const
+    {
+        return code(data[pos]);
+    }
+
+    bool blankAt(int pos) const
+    {
+        return isBlank(data[pos]);
+    }
+
+    // the Unicode character at pos, so that a QString can be compared with a UTF-8 text
+    int charAt(int pos, int *length) const
+    {
+        return decode(data, size, pos, length);
+    }
+
+    // the length of the line break at pos, 2 for \r\n, 1 for \n or \r, 0 if it's not a line break
+    int breakLength(int pos) const
+    {
+        if (pos >= size || !isNewline(at(pos)))
+            return 0;
+        return at(pos) == '\r' && pos + 1 < size && at(pos + 1) == '\n' ? 2 : 1;
+    }
+
+    // the number of QChars between two positions, which is the column shown in the editors
+    int columns(int start, int end) const
+    {
+        return toString(data + start, end - start).size();
+    }
+};
+
+// a position in a text
+struct Position
+{
+    int pos = 0;
+    int line = 0;
+    int lineStart = 0;
+};
+
+template <typename Char> QString token(const Text<Char> &text, int pos, bool midToken)
+{
+    int start = pos;
+    if (midToken)
+    {
+        while (start > 0 && !text.blankAt(start - 1))
+            --start;
+    }
+    int end = pos;
+    while (end < text.size && !text.blankAt(end))
+        ++end;
+    if (end - start > MAX_TOKEN_LENGTH)
+        return toString(text.data + start, MAX_TOKEN_LENGTH) + "...";
+    return toString(text.data + start, end - start);
+}
+
+template <typename Char> QString context(const Text<Char> &text, const Position &position)
+{
+    // move back to the start of the first line in the context
+    int start = position.lineStart;
+    int firstLine = position.line;
+    while (start > 0 && firstLine > position.line - CONTEXT_LINES)
+    {
+        --start;
+        if (start > 0 && text.at(start) == '\n' && text.at(start - 1) == '\r')
+            --start;
+        while (start > 0 && !isNewline(text.at(start - 1)))
+            --start;
+        --firstLine;
+    }
+
+    QString result;
+    int pos = start;
+    for (int line = firstLine; line <= position.line + CONTEXT_LINES && pos < text.size; ++line)
+    {
+        int end = pos;
+        while (end < text.size && !isNewline(text.at(end)))
+            ++end;
+        result += QString("%1%2: ").arg(line == position.line ? "> " : "  ").arg(line + 1);
+        result += toString(text.data + pos, qMin(end - pos, MAX_CONTEXT_LENGTH));
+        if (end - pos > MAX_CONTEXT_LENGTH)
+            result += "...";
+        result += '\n';
+        pos = end + text.breakLength(end);
+    }
+    result.chop(1);
+    return result;
+}
+
+template <typename OChar, typename EChar>
+Mismatch makeMismatch(const Text<OChar> &output, const Position &o, const Text<EChar> &expected, const Position &e,
+                      int tokenIndex, bool midToken)
+{
+    Mismatch result;
+    result.found = true;
+    result.outputLine = o.line;
+    result.outputColumn = output.columns(o.lineStart, o.pos);
+    result.expectedLine = e.line;
+    result.expectedColumn = expected.columns(e.lineStart, e.pos);
+    result.tokenIndex = tokenIndex;
+    result.outputToken = token(output, o.pos, midToken);
+    result.expectedToken = token(expected, e.pos, midToken);
+    result.outputEnded = o.pos >= output.size;
+    result.expectedEnded = e.pos >= expected.size;
+    result.outputContext = context(output, o);
+    result.expectedContext = context(expected, e);
+    return result;
+}
+
+// move to the next character of the given length, where \r\n is a single character
+template <typename Char> void advance(const Text<Char> &text, Position *position, int length = 1)
+{
+    const int breakLength = text.breakLength(position->pos);
+    if (breakLength > 0)
+    {
+        position->pos += breakLength;
+        ++position->line;
+        position->lineStart = position->pos;
+    }
+    else
+    {
+        position->pos += length;
+    }
+}
+
+template <typename OChar, typename EChar>
+Mismatch compareStrict(const Text<OChar> &output, const Text<EChar> &expected)
+{
+    Position o, e;
+    int tokens = 0;
+    bool inToken = false;
+
+    while (o.pos < output.size && e.pos < expected.size)
+    {
+        int oLength, eLength;
+        const int oc = output.charAt(o.pos, &oLength);
+        const int ec = expected.charAt(e.pos, &eLength);
+        // \r\n, \r and \n are the same line break, and advance() skips \r\n as a whole
+        if (oc != ec && !(isNewline(oc) && isNewline(ec)))
+            break;
+        const bool blank = expected.blankAt(e.pos);
+        if (!blank && !inToken)
+            ++tokens;
+        inToken = !blank;
+        advance(output, &o, oLength);
+        advance(expected, &e, eLength);
+    }
+
+    if (o.pos >= output.size && e.pos >= expected.size)
+        return Mismatch();
+
+    const bool midToken = inToken && ((o.pos < output.size && !output.blankAt(o.pos)) ||
+                                      (e.pos < expected.size && !expected.blankAt(e.pos)));
+    return makeMismatch(output, o, expected, e, midToken ? tokens - 1 : tokens, midToken);
+}
+
+// returns the end of the current line without trailing blank characters
+template <typename Char> int readLine(const Text<Char> &text, Position *position)
+{
+    int end = position->pos;
+    while (end < text.size && !isNewline(text.at(end)))
+        ++end;
+    int trimmedEnd = end;
+    while (trimmedEnd > position->pos && text.blankAt(trimmedEnd - 1))
+        --trimmedEnd;
+    return trimmedEnd;
+}
+
+// move to the start of the next line
+template <typename Char> void nextLine(const Text<Char> &text, Position *position)
+{
+    while (position->pos < text.size && !isNewline(text.at(position->pos)))
+        ++position->pos;
+    if (position->pos < text.size)
+        advance(text, position);
+}
+
+// returns whether the remaining lines are blank, otherwise the position is moved to the first non-blank character
+template <typename Char> bool skipBlankLines(const Text<Char> &text, Position *position)
+{
+    while (position->pos < text.size)
+    {
+        if (readLine(text, position) > position->pos)
+        {
+            while (text.blankAt(position->pos))
+                ++position->pos;
+            return false;
+        }
+        nextLine(text, position);
+    }
+    return true;
+}
+
+template <typename OChar, typename EChar>
+Mismatch compareIgnoreTrailingSpaces(const Text<OChar> &output, const Text<EChar> &expected)
+{
+    Position o, e;
+    int tokens = 0;
+
+    while (o.pos < output.size && e.pos < expected.size)
+    {
+        const int oEnd = readLine(output, &o);
+        const int eEnd = readLine(expected, &e);
+        bool inToken = false;
+        while (o.pos < oEnd && e.pos < eEnd)
+        {
+            int oLength, eLength;
+            if (output.charAt(o.pos, &oLength) != expected.charAt(e.pos, &eLength))
+                break;
+            const bool blank = expected.blankAt(e.pos);
+            if (!blank && !inToken)
+                ++tokens;
+            inToken = !blank;
+            o.pos += oLength;
+            e.pos += eLength;
+        }
+        if (o.pos < oEnd || e.pos < eEnd)
+        {
+            const bool midToken =
+                inToken && ((o.pos < oEnd && !output.blankAt(o.pos)) || (e.pos < eEnd && !expected.blankAt(e.pos)));
+            return makeMismatch(output, o, expected, e, midToken ? tokens - 1 : tokens, midToken);
+        }
+        nextLine(output, &o);
+        nextLine(expected, &e);
+    }
+
+    // one of them has ended, the remaining lines of the other one should be blank
+    const bool blank = o.pos < output.size ? skipBlankLines(output, &o) : skipBlankLines(expected, &e);
+    return blank ? Mismatch() : makeMismatch(output, o, expected, e, tokens, false);
+}
+
+template <typename Char> void skipBlanks(const Text<Char> &text, Position *position)
+{
+    while (position->pos < text.size && text.blankAt(position->pos))
+        advance(text, position);
+}
+
+template <typename Char> int tokenEnd(const Text<Char> &text, int pos)
+{
+    while (pos < text.size && !text.blankAt(pos))
+        ++pos;
+    return pos;
+}
+
+template <typename OChar, typename EChar>
+bool sameToken(OutputComparator::Mode mode, double epsilon, const Text<OChar> &output, int oStart, int oEnd,
+               const Text<EChar> &expected, int eStart, int eEnd)
+{
+    int o = oStart, e = eStart;
+    while (o < oEnd && e < eEnd)
+    {
+        int oLength, eLength;
+        int oc = output.charAt(o, &oLength);
+        int ec = expected.charAt(e, &eLength);
+        if (mode == OutputComparator::CaseInsensitiveTokens)
+        {
+            oc = toLower(oc);
+            ec = toLower(ec);
+        }
+        if (oc != ec)
+            break;
+        o += oLength;
+        e += eLength;
+    }
+    if (o == oEnd && e == eEnd)
+        return true;
+
+    // the texts are different, but they may still be the same number
+    if (mode != OutputComparator::Integers && mode != OutputComparator::Reals)
+        return false;
+
+    const auto outputToken = toString(output.data + oStart, oEnd - oStart);
+    const auto expectedToken = toString(expected.data + eStart, eEnd - eStart);
+    bool outputOk = false, expectedOk = false;
+
+    if (mode == OutputComparator::Integers)
+    {
+        const auto outputValue = outputToken.toLongLong(&outputOk);
+        const auto expectedValue = expectedToken.toLongLong(&expectedOk);
+        return outputOk && expectedOk && outputValue == expectedValue;
+    }
+
+    const auto outputValue = QLocale::c().toDouble(outputToken, &outputOk);
+    const auto expectedValue = QLocale::c().toDouble(expectedToken, &expectedOk);
+    if (!outputOk || !expectedOk)
+        return false;
+    const double error = qAbs(outputValue - expectedValue);
+    return error <= epsilon + 1E-15 || error <= epsilon * qAbs(expectedValue) + 1E-15;
+}
+
+template <typename OChar, typename EChar>
+Mismatch compareTokens(OutputComparator::Mode mode, double epsilon, const Text<OChar> &output,
+                       const Text<EChar> &expected)
+{
+    Position o, e;
+    for (int tokens = 0;; ++tokens)
+    {
+        skipBlanks(output, &o);
+        skipBlanks(expected, &e);
+        if (o.pos >= output.size && e.pos >= expected.size)
+            return Mismatch();
+        const int oEnd = tokenEnd(output, o.pos);
+        const int eEnd = tokenEnd(expected, e.pos);
+        if (o.pos >= output.size || e.pos >= expected.size ||
+            !sameToken(mode, epsilon, output, o.pos, oEnd, expected, e.pos, eEnd))
+            return makeMismatch(output, o, expected, e, tokens, false);
+        o.pos = oEnd;
+        e.pos = eEnd;
+    }
+}
+
+template <typename OChar, typename EChar>
+Mismatch compareTexts(OutputComparator::Mode mode, double epsilon, const Text<OChar> &output,
+                      const Text<EChar> &expected)
+{
+    switch (mode)
+    {
+    case OutputComparator::Strict:
+        return compareStrict(output, expected);
+    case OutputComparator::IgnoreTrailingSpaces:
+        return compareIgnoreTrailingSpaces(output, expected);
+    case OutputComparator::Tokens:
+    case OutputComparator::Integers:
+    case OutputComparator::Reals:
+    case OutputComparator::CaseInsensitiveTokens:
+        return compareTokens(mode, epsilon, output, expected);
+    }
+    Q_UNREACHABLE();
+    return Mismatch();
+}
+} // namespace
+
+Mismatch OutputComparator::compare(Mode mode, const QString &output, const QString &expected, double epsilon)
+{
+    return compareTexts(mode, epsilon, Text<QChar>{output.constData(), output.size()},
+                        Text<QChar>{expected.constData(), expected.size()});
+}
+
+Mismatch OutputComparator::compare(Mode mode, const QString &output, const QByteArray &expected, double epsilon)
+{
+    return compareTexts(mode, epsilon, Text<QChar>{output.constData(), output.size()},
+                        Text<char>{expected.constData(), expected.size()});
+}
+} // namespace Core
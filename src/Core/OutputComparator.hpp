@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2019-2021 Ashar Khan <ashar786khan@gmail.com>
+ *
+ * This file is part of CP Editor.
+ *
+ * CP Editor is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * I will not be responsible if CP Editor behaves in unexpected way and
+ * causes your ratings to go down and or lose any important contest.
+ *
+ * Believe Software is "Software" and it isn't immune to bugs.
+ *
+ */
+
+/*
+ * The output comparator finds the first difference between an output and the expected output.
+ * It scans both texts once without copying or splitting them, and only extracts the tokens and the context around
+ * the difference after it's found, so it's suitable for outputs with millions of lines.
+ * The texts are compared character by character, so an output can be compared with a UTF-8 expected output without
+ * decoding either of them.
+ * The built-in checkers use it to decide the verdict, and the other checkers use it to locate the difference when
+ * the output is rejected.
+ */
+
+#ifndef OUTPUTCOMPARATOR_HPP
+#define OUTPUTCOMPARATOR_HPP
+
+#include <QString>
+
+namespace Core
+{
+// the first difference between an output and the expected output, the columns are in QChars as in the editors
+struct Mismatch
+{
+    bool found = false;                            // whether there is a difference
+    int outputLine = 0, outputColumn = 0;          // the 0-based position of the difference in the output
+    int expectedLine = 0, expectedColumn = 0;      // the 0-based position of the difference in the expected output
+    int tokenIndex = 0;                            // the 0-based index of the different token
+    QString outputToken, expectedToken;            // the different tokens, empty if there's no token at the position
+    bool outputEnded = false, expectedEnded = false; // whether the difference is at the end of the text
+    QString outputContext, expectedContext;        // a few lines around the difference, with line numbers
+};
+
+class OutputComparator
+{
+  public:
+    enum Mode
+    {
+        Strict,                // the texts should be the same, except the differences between \n, \r and \r\n
+        IgnoreTrailingSpaces,  // ignore blank characters at the end of lines and blank lines at the end
+        Tokens,                // compare blank-separated tokens
+        Integers,              // compare blank-separated tokens, as integers if possible
+        Reals,                 // compare blank-separated tokens, as real numbers with an error if possible
+        CaseInsensitiveTokens, // compare blank-separated tokens, case-insensitively
+    };
+
+    /**
+     * @brief find the first difference between the output and the expected output
+     * @param mode the way to compare the texts
+     * @param output the output to check
+     * @param expected the expected output
+     * @param epsilon the max absolute or relative error in the Reals mode
+     * @returns the first difference, or a Mismatch with found == false if they are considered the same
+     */
+    static Mismatch compare(Mode mode, const QString &output, const QString &expected, double epsilon = 0);
+
+    /**
+     * @brief find the first difference between the output and a UTF-8 expected output
+     * @note It's used for mapped test data to avoid decoding them. Only ASCII characters are treated as blank
+     *       characters in the expected output.
+     */
+    static Mismatch compare(Mode mode, const QString &output, const QByteArray &expected, double epsilon = 0);
+};
+} // namespace Core
+
+#endif // OUTPUTCOMPARATOR_HPP
@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) 2019-2021 Ashar Khan <ashar786khan@gmail.com>
+ *
+ * This file is part of CP Editor.
+ *
+ * CP Editor is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * I will not be responsible if CP Editor behaves in unexpected way and
+ * causes your ratings to go down and or lose any important contest.
+ *
+ * Believe Software is "Software" and it isn't immune to bugs.
+ *
+ */
+
+#include "Core/RunResultCache.hpp"
+#include "Core/Compiler.hpp"
+#include "generated/SettingsHelper.hpp"
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+namespace Core
+{
+namespace
+{
+bool addFile(QCryptographicHash &hash, const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+    hash.addData(QFileInfo(path).fileName().toUtf8());
+    return hash.addData(&file);
+}
+
+// the estimated memory used by a result besides its outputs, e.g. the key, the mismatch and the cache node
+const int RESULT_OVERHEAD = 1024;
+
+// the results with larger outputs are not cached, so that a few of them don't evict all the others
+const int MAX_RESULT_COST = 4 * 1024 * 1024;
+} // namespace
+
+RunResultCache::RunResultCache(int maxMemory) : results(maxMemory)
+{
+}
+
+QString RunResultCache::programKey(const QString &tmpFilePath, const QString &sourceFilePath, const QString &lang,
+                                   const QString &runCommand, const QString &checker, int timeLimit)
+{
+    if (checker.isEmpty())
+        return QString();
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    const auto path = Compiler::outputFilePath(tmpFilePath, sourceFilePath, lang, false);
+
+    if (lang == "Java")
+    {
+        // the nested classes are compiled into separate files, all of them are a part of the program
+        const auto classes = QFileInfo(path).dir().entryInfoList({"*.class"}, QDir::Files, QDir::Name);
+        if (classes.isEmpty())
+            return QString();
+        for (auto const &file : classes)
+        {
+            if (!addFile(hash, file.filePath()))
+                return QString();
+        }
+    }
+    else if (!addFile(hash, path))
+    {
+        return QString();
+    }
+
+    // the settings that change the verdicts are a part of the key too
+    for (auto const &part : {lang, runCommand, checker, QString::number(timeLimit),
+                             QString::number(SettingsHelper::getOutputLengthLimit()),
+                             QString::number(SettingsHelper::isCheckOnTestcasesWithEmptyOutput())})
+    {
+        hash.addData(part.toUtf8());
+        hash.addData("\0", 1);
+    }
+
+    return hash.result().toHex();
+}
+
+QString RunResultCache::key(const QString &programKey, const QString &testKey)
+{
+    return programKey + ':' + testKey;
+}
+
+bool RunResultCache::find(const QString &key, Result &result) const
+{
+    auto *cached = results.object(key);
+    if (cached == nullptr)
+        return false;
+    result = *cached;
+    return true;
+}
+
+void RunResultCache::startRun(int index, const QString &key)
+{
+    if (key.isEmpty())
+        runningResults.remove(index);
+    else
+        runningResults[index] = {key, Result()};
+}
+
+void RunResultCache::setExecutionResult(int index, const QString &output, const QString &error, int exitCode,
+                                        qint64 timeUsed, bool tle)
+{
+    auto it = runningResults.find(index);
+    if (it == runningResults.end())
+        return;
+    auto &result = it->second;
+    result.output = output;
+    result.error = error;
+    result.exitCode = exitCode;
+    result.timeUsed = timeUsed;
+    result.tle = tle;
+}
+
+void RunResultCache::setMismatch(int index, const Mismatch &mismatch)
+{
+    auto it = runningResults.find(index);
+    if (it != runningResults.end())
+        it->second.mismatch = mismatch;
+}
+
+void RunResultCache::finishRun(int index, Widgets::TestCase::Verdict verdict)
+{
+    auto it = runningResults.find(index);
+    if (it == runningResults.end())
+        return;
+    it->second.verdict = verdict;
+    const auto &result = it->second;
+    const qint64 cost = (qint64(result.output.size()) + result.error.size() + result.mismatch.outputContext.size() +
+                         result.mismatch.expectedContext.size()) *
+                            qint64(sizeof(QChar)) +
+                        RESULT_OVERHEAD;
+    if (verdict != Widgets::TestCase::TLE && !result.tle && cost <= MAX_RESULT_COST)
+        results.insert(it->first, new Result(result), int(cost));
+    runningResults.erase(it);
+}
+
+void RunResultCache::discardRun(int index)
+{
+    runningResults.remove(index);
+}
+
+void RunResultCache::cancelRuns()
+{
+    runningResults.clear();
+}
+
+} // namespace Core
@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2019-2021 Ashar Khan <ashar786khan@gmail.com>
+ *
+ * This file is part of CP Editor.
+ *
+ * CP Editor is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * I will not be responsible if CP Editor behaves in unexpected way and
+ * causes your ratings to go down and or lose any important contest.
+ *
+ * Believe Software is "Software" and it isn't immune to bugs.
+ *
+ */
+
+/*
+ * The results of the previous runs of the test cases in a tab.
+ * A result is keyed by everything that decides it: the compiled program, the run command, the input, the expected
+ * output, the checker and the limits. So when a run has the same key, its result can be reused instead of running
+ * the program again, e.g. after editing the comments or adding a new test case.
+ * The results are weighted by the sizes of their outputs, so the cache is bounded in memory rather than in count.
+ */
+
+#ifndef RUNRESULTCACHE_HPP
+#define RUNRESULTCACHE_HPP
+
+#include "Core/OutputComparator.hpp"
+#include "Widgets/TestCase.hpp"
+#include <QCache>
+#include <QMap>
+
+namespace Core
+{
+class RunResultCache
+{
+  public:
+    struct Result
+    {
+        QString output;
+        QString error; // the stderr
+        int exitCode = 0;
+        qint64 timeUsed = 0;
+        bool tle = false;
+        Widgets::TestCase::Verdict verdict = Widgets::TestCase::UNKNOWN;
+        Mismatch mismatch;
+    };
+
+    /**
+     * @param maxMemory the max number of bytes used by the outputs of the cached results, the least recently used
+     *        results are removed when it's exceeded
+     */
+    explicit RunResultCache(int maxMemory = 64 * 1024 * 1024);
+
+    /**
+     * @brief get the key of a program, i.e. the part of the keys shared by the test cases in a run
+     * @param tmpFilePath the path to the temporary file which is compiled
+     * @param sourceFilePath the path to the original source file
+     * @param lang the language to run, one of "C++", "Java" and "Python"
+     * @param runCommand the command for running a program, including the arguments
+     * @param checker the identity of the checker, see Core::Checker::identity
+     * @param timeLimit the time limit in milliseconds
+     * @returns the key, or an empty string if the program can't be read, then the results shouldn't be cached
+     */
+    static QString programKey(const QString &tmpFilePath, const QString &sourceFilePath, const QString &lang,
+                              const QString &runCommand, const QString &checker, int timeLimit);
+
+    /**
+     * @returns the key of a test case run by the program of programKey
+     * @param testKey the key of the test case, see Core::RunScheduler::testKey, so each test case is hashed once
+     */
+    static QString key(const QString &programKey, const QString &testKey);
+
+    /**
+     * @brief find a cached result
+     * @returns whether the result is found
+     */
+    bool find(const QString &key, Result &result) const;
+
+    /**
+     * @brief start recording the result of a run, it's cached when the verdict is known
+     * @param index the index of the test case
+     * @param key the key of the run, the result is not cached if it's empty
+     */
+    void startRun(int index, const QString &key);
+
+    /**
+     * @brief record the result of the execution of a started run
+     */
+    void setExecutionResult(int index, const QString &output, const QString &error, int exitCode, qint64 timeUsed,
+                            bool tle);
+
+    /**
+     * @brief record the first difference of a started run
+     */
+    void setMismatch(int index, const Mismatch &mismatch);
+
+    /**
+     * @brief cache the result of a started run
+     * @param verdict the verdict of the run, UNKNOWN if it's not checked
+     * @note The result is not cached if the time limit is exceeded or the run is discarded, because it depends on the
+     *       load of the machine rather than on the program. It's not cached either if the output is too large.
+     */
+    void finishRun(int index, Widgets::TestCase::Verdict verdict);
+
+    /**
+     * @brief don't cache the result of a started run, e.g. when the process is killed
+     */
+    void discardRun(int index);
+
+    /**
+     * @brief forget the started runs, e.g. when they are killed
+     */
+    void cancelRuns();
+
+  private:
+    QCache<QString, Result> results;
+    QMap<int, QPair<QString, Result>> runningResults; // the keys and the results of the started runs
+};
+} // namespace Core
+
+#endif // RUNRESULTCACHE_HPP
@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2019-2021 Ashar Khan <ashar786khan@gmail.com>
+ *
+ * This file is part of CP Editor.
+ *
+ * CP Editor is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * I will not be responsible if CP Editor behaves in unexpected way and
+ * causes your ratings to go down and or lose any important contest.
+ *
+ * Believe Software is "Software" and it isn't immune to bugs.
+ *
+ */
+
+#include "Core/RunScheduler.hpp"
+#include <QHash>
+#include <algorithm>
+#include <limits>
+
+namespace Core
+{
+RunScheduler::RunScheduler(int capacity) : histories(capacity)
+{
+}
+
+QString RunScheduler::testKey(const TestData &input, const TestData &expected)
+{
+    return input.hash() + ':' + expected.hash();
+}
+
+void RunScheduler::schedule(const QList<Run> &runs)
+{
+    struct Priority
+    {
+        bool failed;
+        qint64 timeUsed;
+    };
+
+    QHash<QString, Priority> priorities;
+    for (auto const &run : runs)
+    {
+        auto *record = histories.object(run.testKey);
+        // a test case never run is likely the one being worked on, so it's treated as the slowest
+        priorities[run.testKey] = {record != nullptr && isFailure(record->verdict),
+                                   record == nullptr || record->timeUsed < 0 ? std::numeric_limits<qint64>::max()
+                                                                             : record->timeUsed};
+    }
+
+    pendingRuns = runs;
+    std::stable_sort(pendingRuns.begin(), pendingRuns.end(), [&priorities](const Run &a, const Run &b) {
+        const auto &pa = priorities[a.testKey];
+        const auto &pb = priorities[b.testKey];
+        if (pa.failed != pb.failed)
+            return pa.failed;
+        return pa.timeUsed > pb.timeUsed;
+    });
+}
+
+bool RunScheduler::hasPending() const
+{
+    return !pendingRuns.isEmpty();
+}
+
+int RunScheduler::pendingCount() const
+{
+    return pendingRuns.size();
+}
+
+RunScheduler::Run RunScheduler::takeNext()
+{
+    auto run = pendingRuns.takeFirst();
+    startedTests[run.index] = run.testKey;
+    return run;
+}
+
+void RunScheduler::clearPending()
+{
+    pendingRuns.clear();
+}
+
+void RunScheduler::recordTime(int index, qint64 timeUsed)
+{
+    if (auto *record = history(index))
+        record->timeUsed = timeUsed;
+}
+
+void RunScheduler::recordVerdict(int index, Widgets::TestCase::Verdict verdict)
+{
+    if (auto *record = history(index))
+        record->verdict = verdict;
+}
+
+bool RunScheduler::isFailure(Widgets::TestCase::Verdict verdict)
+{
+    return verdict == Widgets::TestCase::WA || verdict == Widgets::TestCase::TLE || verdict == Widgets::TestCase::RE;
+}
+
+RunScheduler::History *RunScheduler::history(int index)
+{
+    if (!startedTests.contains(index))
+        return nullptr;
+    const auto &key = startedTests[index];
+    auto *record = histories.object(key);
+    if (record == nullptr)
+    {
+        record = new History();
+        histories.insert(key, record);
+    }
+    return record;
+}
+} // namespace Core
@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2019-2021 Ashar Khan <ashar786khan@gmail.com>
+ *
+ * This file is part of CP Editor.
+ *
+ * CP Editor is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * I will not be responsible if CP Editor behaves in unexpected way and
+ * causes your ratings to go down and or lose any important contest.
+ *
+ * Believe Software is "Software" and it isn't immune to bugs.
+ *
+ */
+
+/*
+ * The queue of the test cases waiting to be run in a tab.
+ * The verdict and the time of the last run of each test case are remembered, keyed by the input and the expected
+ * output. The test cases failed last time are run first, so a failure is found as soon as possible, and the others
+ * are run from the slowest to the fastest, so the slow ones don't start last and keep the others waiting.
+ */
+
+#ifndef RUNSCHEDULER_HPP
+#define RUNSCHEDULER_HPP
+
+#include "Core/TestData.hpp"
+#include "Widgets/TestCase.hpp"
+#include <QCache>
+#include <QMap>
+
+namespace Core
+{
+class RunScheduler
+{
+  public:
+    struct Run
+    {
+        int index;        // the index of the test case
+        QString testKey;  // see testKey()
+        QString cacheKey; // the key in Core::RunResultCache, can be empty
+    };
+
+    explicit RunScheduler(int capacity = 1000);
+
+    /**
+     * @returns the key of a test case in the history
+     */
+    static QString testKey(const TestData &input, const TestData &expected);
+
+    /**
+     * @brief replace the waiting runs, they are ordered by the history
+     */
+    void schedule(const QList<Run> &runs);
+
+    bool hasPending() const;
+    int pendingCount() const;
+
+    /**
+     * @brief take the next run from the queue, its result can be recorded by the index from now on
+     */
+    Run takeNext();
+
+    /**
+     * @brief remove the waiting runs
+     */
+    void clearPending();
+
+    /**
+     * @brief record the time used by a started run
+     */
+    void recordTime(int index, qint64 timeUsed);
+
+    /**
+     * @brief record the verdict of a started run
+     */
+    void recordVerdict(int index, Widgets::TestCase::Verdict verdict);
+
+    /**
+     * @returns whether the verdict is a failure, i.e. WA, TLE or RE
+     */
+    static bool isFailure(Widgets::TestCase::Verdict verdict);
+
+  private:
+    struct History
+    {
+        qint64 timeUsed = -1; // -1 if it's not known
+        Widgets::TestCase::Verdict verdict = Widgets::TestCase::UNKNOWN;
+    };
+
+    History *history(int index);
+
+    QList<Run> pendingRuns;
+    QMap<int, QString> startedTests; // the test keys of the started runs, keyed by the indices
+    QCache<QString, History> histories;
+};
+} // namespace Core
+
+#endif // RUNSCHEDULER_HPP
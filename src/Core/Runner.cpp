@@ -18,7 +18,7 @@
 #include "Core/Runner.hpp"
 #include "Core/Compiler.hpp"
 #include "Core/EventLogger.hpp"
-#include "Util/FileUtil.hpp"
+#include "Core/Tracer.hpp"
 #include <QElapsedTimer>
 #include <QFileInfo>
 #include <QTemporaryFile>
@@ -28,6 +28,17 @@
 namespace Core
 {
 
+namespace
+{
+// about the refresh rate of the screen, there's no need to publish the output more frequently
+const int UPDATE_INTERVAL = 16;
+
+const int TIME_UPDATE_INTERVAL = 100;
+
+// only the end of the output is shown while the program is running
+const int OUTPUT_TAIL_LENGTH = 8192;
+} // namespace
+
 Runner::Runner(int index) : runnerIndex(index)
 {
     runProcess = new QProcess();
@@ -40,6 +51,7 @@ Runner::~Runner()
     // The order of destructions is important, runTimer is used when emitting signals
 
     delete killTimer;
+    delete updateTimer;
 
     if (runProcess != nullptr)
     {
@@ -53,11 +65,13 @@ Runner::~Runner()
         delete runProcess;
     }
 
+    endSpan();
+
     delete runTimer;
 }
 
 void Runner::run(const QString &tmpFilePath, const QString &sourceFilePath, const QString &lang,
-                 const QString &runCommand, const QString &args, const QString &input, int timeLimit)
+                 const QString &runCommand, const QString &args, const Core::TestData &input, int timeLimit)
 {
     LOG_INFO(INFO_OF(tmpFilePath) << INFO_OF(sourceFilePath) << INFO_OF(lang) << INFO_OF(runCommand) << INFO_OF(args)
                                   << INFO_OF(timeLimit));
@@ -88,24 +102,38 @@ void Runner::run(const QString &tmpFilePath, const QString &sourceFilePath, cons
 
     setWorkingDirectory(tmpFilePath, sourceFilePath, lang);
 
-    inputFile = new QTemporaryFile(this);
-    if (!inputFile->open())
+    inputData = input;
+    if (input.isMapped())
     {
-        emit failedToStartRun(runnerIndex, tr("Failed to create temporary file."));
-        return;
+        runProcess->setStandardInputFile(input.filePath());
+    }
+    else
+    {
+        inputFile = new QTemporaryFile(this);
+        if (!inputFile->open())
+        {
+            emit failedToStartRun(runnerIndex, tr("Failed to create temporary file."));
+            return;
+        }
+        input.save(inputFile->fileName(), "Runner Input", false);
+        runProcess->setStandardInputFile(inputFile->fileName());
     }
-    Util::saveFile(inputFile->fileName(), input, "Runner Input", false);
-    runProcess->setStandardInputFile(inputFile->fileName());
 
     killTimer = new QTimer(runProcess);
     killTimer->setSingleShot(true);
     killTimer->setInterval(timeLimit);
     connect(killTimer, &QTimer::timeout, this, &Runner::onTimeout);
 
+    updateTimer = new QTimer(runProcess);
+    updateTimer->setInterval(UPDATE_INTERVAL);
+    connect(updateTimer, &QTimer::timeout, this, &Runner::onUpdateTimeout);
+
     runTimer = new QElapsedTimer();
 
     killTimer->start();
 
+    // the time to start the process is measured separately, it's large with some antivirus software
+    beginSpan("Spawn");
     runProcess->start(program, command);
 }
 
@@ -151,7 +179,10 @@ void Runner::runDetached(const QString &tmpFilePath, const QString &sourceFilePa
 
 void Runner::onFinished(int exitCode, QProcess::ExitStatus exitStatus)
 {
+    if (updateTimer != nullptr)
+        updateTimer->stop();
     const auto timeUsed = runTimer->isValid() ? runTimer->elapsed() : 0;
+    endSpan();
     emit runFinished(runnerIndex, processStdout + runProcess->readAllStandardOutput(),
                      processStderr + runProcess->readAllStandardError(), exitCode, timeUsed, timeLimitExceeded);
 }
@@ -159,10 +190,34 @@ void Runner::onFinished(int exitCode, QProcess::ExitStatus exitStatus)
 void Runner::onStarted()
 {
     if (!isDetachedRun)
+    {
         runTimer->start();
+        updateTimer->start();
+        beginSpan("Run");
+    }
     emit runStarted(runnerIndex);
 }
 
+void Runner::onUpdateTimeout()
+{
+    if (outputUpdated)
+    {
+        outputUpdated = false;
+        int begin = qMax(0, processStdout.size() - OUTPUT_TAIL_LENGTH);
+        // don't start in the middle of a UTF-8 character
+        while (begin < processStdout.size() && (processStdout[begin] & 0xC0) == 0x80)
+            ++begin;
+        emit runOutputUpdated(runnerIndex, QString::fromUtf8(processStdout.mid(begin)));
+    }
+
+    const auto timeUsed = runTimer->elapsed();
+    if (timeUsed - lastTimeUpdate >= TIME_UPDATE_INTERVAL)
+    {
+        lastTimeUpdate = timeUsed;
+        emit runTimeUpdated(runnerIndex, timeUsed, killTimer->interval());
+    }
+}
+
 void Runner::onTimeout()
 {
     if (runProcess->state() == QProcess::Running)
@@ -176,6 +231,7 @@ void Runner::onTimeout()
 void Runner::onReadyReadStandardOutput()
 {
     processStdout.append(runProcess->readAllStandardOutput().replace('\0', ""));
+    outputUpdated = true;
     if (!outputLimitExceededEmitted && processStdout.length() > SettingsHelper::getOutputLengthLimit())
     {
         outputLimitExceededEmitted = true;
@@ -210,11 +266,48 @@ void Runner::onErrorOccurred(QProcess::ProcessError error)
         }
         else
         {
+            endSpan();
             emit failedToStartRun(runnerIndex, tr("Failed to start running. Please compile first."));
         }
     }
 }
 
+void Runner::beginSpan(const char *name)
+{
+    endSpan();
+    // the span is only ended if its beginning is recorded
+    if (Tracer::isEnabled())
+    {
+        Tracer::begin(traceCategory, name, traceTab, runnerIndex);
+        openSpan = name;
+    }
+}
+
+void Runner::endSpan()
+{
+    if (openSpan != nullptr)
+    {
+        Tracer::end(traceCategory, openSpan, traceTab, runnerIndex);
+        openSpan = nullptr;
+    }
+}
+
+void Runner::setTraceContext(quint64 tab, const char *category)
+{
+    traceTab = tab;
+    traceCategory = category;
+}
+
+int Runner::index() const
+{
+    return runnerIndex;
+}
+
+bool Runner::isRunning() const
+{
+    return runProcess != nullptr && runProcess->state() != QProcess::NotRunning;
+}
+
 QString Runner::getCommand(const QString &tmpFilePath, const QString &sourceFilePath, const QString &lang,
                            const QString &runCommand, const QString &args)
 {
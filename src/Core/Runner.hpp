@@ -25,6 +25,7 @@
 #ifndef RUNNER_HPP
 #define RUNNER_HPP
 
+#include "Core/TestData.hpp"
 #include <QProcess>
 
 class QElapsedTimer;
@@ -58,12 +59,12 @@ class Runner : public QObject
      * @param lang the language to run, one of "C++", "Java" and "Python"
      * @param runCommand the command for running a program
      * @param args the command line arguments added at the back to start the program
-     * @param input the input to the program
+     * @param input the input to the program, a mapped input is redirected from its file directly
      * @param timeLimit the maximum time for the program to run, in milliseconds
      * @note This should be called only once. Please create multiple Runners for multiple runs.
      */
     void run(const QString &tmpFilePath, const QString &sourceFilePath, const QString &lang, const QString &runCommand,
-             const QString &args, const QString &input, int timeLimit);
+             const QString &args, const Core::TestData &input, int timeLimit);
 
     /**
      * @brief run a program in a pop-up terminal
@@ -77,6 +78,24 @@ class Runner : public QObject
     void runDetached(const QString &tmpFilePath, const QString &sourceFilePath, const QString &lang,
                      const QString &runCommand, const QString &args);
 
+    /**
+     * @brief set where the execution is shown in the trace, see Core::Tracer
+     * @param tab the ID of the tab
+     * @param category the category of the spans, a string literal
+     * @note The detached executions are not traced.
+     */
+    void setTraceContext(quint64 tab, const char *category);
+
+    /**
+     * @returns the index of the testcase
+     */
+    int index() const;
+
+    /**
+     * @returns whether the process is starting or running, i.e. whether it's killed if the Runner is destructed
+     */
+    bool isRunning() const;
+
   signals:
     /**
      * @brief the execution has just started
@@ -95,6 +114,22 @@ class Runner : public QObject
      */
     void runFinished(int index, const QString &out, const QString &err, int exitCode, qint64 timeUsed, bool tle);
 
+    /**
+     * @brief the program has printed more to stdout while it's running
+     * @param index the index of the testcase
+     * @param outputTail the end of the stdout printed so far
+     * @note This is emitted at most about 60 times per second, the chunks printed in between are coalesced.
+     */
+    void runOutputUpdated(int index, const QString &outputTail);
+
+    /**
+     * @brief report how long the program has been running, about 10 times per second
+     * @param index the index of the testcase
+     * @param timeUsed the time since the execution started, in milliseconds
+     * @param timeLimit the time limit, in milliseconds
+     */
+    void runTimeUpdated(int index, qint64 timeUsed, int timeLimit);
+
     /**
      * @brief failed to start the execution
      * @param index the index of the testcase
@@ -130,6 +165,11 @@ class Runner : public QObject
      */
     void onStarted();
 
+    /**
+     * @brief publish the new output and the time used
+     */
+    void onUpdateTimeout();
+
     /**
      * @brief the time limit is reached
      * @note this will kill the process if it's still running and emit runTimeout
@@ -172,16 +212,33 @@ class Runner : public QObject
      */
     void setWorkingDirectory(const QString &tmpFilePath, const QString &sourceFilePath, const QString &lang);
 
+    /**
+     * @brief end the open span in the trace if there is one, and begin a new span
+     */
+    void beginSpan(const char *name);
+
+    /**
+     * @brief end the open span in the trace if there is one
+     */
+    void endSpan();
+
     const int runnerIndex;                   // the index of the testcase
     QProcess *runProcess = nullptr;          // the process to run the program
-    QTemporaryFile *inputFile = nullptr;     // redirect stdin to this file
+    QTemporaryFile *inputFile = nullptr;     // redirect stdin to this file if the input is not mapped
+    Core::TestData inputData;                // keep the mapped input file while the process is running
     QTimer *killTimer = nullptr;             // the timer used to kill the process when the time limit is reached
     QElapsedTimer *runTimer = nullptr;       // the timer used to measure how much time did the execution use
+    QTimer *updateTimer = nullptr;           // the timer used to publish the output while the process is running
+    bool outputUpdated = false;              // whether stdout has changed since runOutputUpdated was emitted
+    qint64 lastTimeUpdate = 0;               // the time used when runTimeUpdated was emitted
     QByteArray processStdout;                // the stdout of the process
     QByteArray processStderr;                // the stderr of the process
     bool outputLimitExceededEmitted = false; // whether runOutputLimitExceeded is emitted or not
     bool timeLimitExceeded = false;
     bool isDetachedRun = false;
+    quint64 traceTab = 0;
+    const char *traceCategory = "run";
+    const char *openSpan = nullptr; // the span begun in the trace and not ended yet, "Spawn" or "Run"
 };
 
 } // namespace Core
@@ -0,0 +1,714 @@
+/*
+ * Copyright (C) 2019-2021 Ashar Khan <ashar786khan@gmail.com>
+ *
+ * This file is part of CP Editor.
+ *
+ * CP Editor is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * I will not be responsible if CP Editor behaves in unexpected way and
+ * causes your ratings to go down and or lose any important contest.
+ *
+ * Believe Software is "Software" and it isn't immune to bugs.
+ *
+ */
+
+#include "Core/SearchIndex.hpp"
+#include "Core/EventLogger.hpp"
+#include "Util/FileUtil.hpp"
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QHash>
+#include <QReadWriteLock>
+#include <QRegularExpression>
+#include <QRunnable>
+#include <QSet>
+#include <QTimer>
+#include <algorithm>
+#include <functional>
+#include <iterator>
+
+namespace Core
+{
+namespace
+{
+const qint64 MAX_FILE_SIZE = 1024 * 1024; // the larger files and buffers are not indexed
+const int MAX_FILES = 20000;              // the maximum number of files found in the directories
+const int MAX_WATCHED_DIRECTORIES = 1000;
+const int MAX_MATCHES = 5000;
+const int MAX_LINE_TEXT_LENGTH = 300;
+const int REFRESH_DELAY = 500;
+
+const quint64 TRIGRAM_MASK = (quint64(1) << 48) - 1; // three UTF-16 code units
+
+class Task : public QRunnable
+{
+  public:
+    explicit Task(std::function<void()> func) : func(std::move(func))
+    {
+    }
+
+    void run() override
+    {
+        func();
+    }
+
+  private:
+    std::function<void()> func;
+};
+
+bool isSourceFile(const QFileInfo &info)
+{
+    const auto suffix = info.suffix();
+    return Util::cppSuffix.contains(suffix) || Util::javaSuffix.contains(suffix) ||
+           Util::pythonSuffix.contains(suffix);
+}
+} // namespace
+
+struct SearchIndex::State
+{
+    struct Document
+    {
+        QString key;
+        QString title;
+        QString text;
+        bool isBuffer = false;
+        qint64 size = -1;          // the size of the file when it's read
+        QDateTime lastModified;    // the modification time of the file when it's read
+        QVector<quint64> trigrams; // see SearchIndex::trigrams()
+    };
+
+    // the documents are only changed in the index thread, and read in the search thread
+    QReadWriteLock lock;
+    QHash<QString, int> ids;               // the IDs of the documents, keyed by the keys
+    QHash<int, Document> documents;        // keyed by the IDs
+    QHash<quint64, QVector<int>> postings; // the sorted IDs of the documents containing each trigram
+    int nextId = 0;
+
+    QAtomicInt latestSearch; // the ID of the latest search, the earlier ones are cancelled
+
+    QSet<QString> files; // the files found in the last refresh, only accessed in the index thread
+
+    /**
+     * @brief add or replace a document, only the changed trigrams of a replaced document are updated in the postings
+     */
+    void update(Document document)
+    {
+        QWriteLocker locker(&lock);
+
+        const auto it = ids.constFind(document.key);
+        if (it == ids.constEnd())
+        {
+            // a new ID is larger than all others, so it's appended to keep the postings sorted
+            const int id = nextId++;
+            for (auto trigram : document.trigrams)
+                postings[trigram].push_back(id);
+            ids.insert(document.key, id);
+            documents.insert(id, std::move(document));
+            return;
+        }
+
+        const int id = it.value();
+        auto &old = documents[id];
+
+        QVector<quint64> removed;
+        std::set_difference(old.trigrams.begin(), old.trigrams.end(), document.trigrams.begin(),
+                            document.trigrams.end(), std::back_inserter(removed));
+        for (auto trigram : removed)
+            removePosting(trigram, id);
+
+        QVector<quint64> added;
+        std::set_difference(document.trigrams.begin(), document.trigrams.end(), old.trigrams.begin(),
+                            old.trigrams.end(), std::back_inserter(added));
+        for (auto trigram : added)
+        {
+            auto &posting = postings[trigram];
+            posting.insert(std::lower_bound(posting.begin(), posting.end(), id), id);
+        }
+
+        old = std::move(document);
+    }
+
+    void remove(const QString &key)
+    {
+        QWriteLocker locker(&lock);
+
+        const auto it = ids.find(key);
+        if (it == ids.end())
+            return;
+        const int id = it.value();
+        ids.erase(it);
+        const auto document = documents.take(id);
+        for (auto trigram : document.trigrams)
+            removePosting(trigram, id);
+    }
+
+    void removePosting(quint64 trigram, int id)
+    {
+        const auto it = postings.find(trigram);
+        if (it == postings.end())
+            return;
+        auto &posting = it.value();
+        const auto pos = std::lower_bound(posting.begin(), posting.end(), id);
+        if (pos != posting.end() && *pos == id)
+            posting.erase(pos);
+        if (posting.isEmpty())
+            postings.erase(it);
+    }
+
+    /**
+     * @returns whether the document is a buffer, or a file with the same size and modification time
+     */
+    bool isUpToDate(const QString &key, const QFileInfo &info)
+    {
+        QReadLocker locker(&lock);
+        const auto it = ids.constFind(key);
+        if (it == ids.constEnd())
+            return false;
+        const auto &document = documents[it.value()];
+        return document.isBuffer || (document.size == info.size() && document.lastModified == info.lastModified());
+    }
+
+    bool isBuffer(const QString &key)
+    {
+        QReadLocker locker(&lock);
+        const auto it = ids.constFind(key);
+        return it != ids.constEnd() && documents[it.value()].isBuffer;
+    }
+
+    /**
+     * @returns whether the index is changed
+     */
+    bool indexFile(const QString &key, const QFileInfo &info)
+    {
+        if (isUpToDate(key, info))
+            return false;
+
+        if (info.size() > MAX_FILE_SIZE)
+        {
+            remove(key);
+            return true;
+        }
+
+        QFile file(key);
+        if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        {
+            LOG_WARN("Failed to open " << INFO_OF(key));
+            remove(key);
+            return true;
+        }
+
+        Document document;
+        document.key = key;
+        document.title = QDir::toNativeSeparators(key);
+        document.text = QString::fromUtf8(file.readAll());
+        document.size = info.size();
+        document.lastModified = info.lastModified();
+        document.trigrams = trigrams(document.text);
+        update(std::move(document));
+        return true;
+    }
+
+    /**
+     * @brief find the files in the directories, and index the new and the changed ones
+     * @returns the directories and the files to watch
+     */
+    QStringList refresh(const QStringList &directories, const QStringList &singleFiles, bool &changed)
+    {
+        QHash<QString, QFileInfo> found;
+        QStringList watched;
+        QStringList pendingDirectories;
+        QSet<QString> visitedDirectories;
+
+        for (auto const &directory : directories)
+        {
+            if (!directory.isEmpty() && QFileInfo(directory).isDir())
+                pendingDirectories.push_back(QDir(directory).absolutePath());
+        }
+
+        while (!pendingDirectories.isEmpty() && found.size() < MAX_FILES)
+        {
+            const auto directory = pendingDirectories.takeFirst();
+            if (visitedDirectories.contains(directory))
+                continue;
+            visitedDirectories.insert(directory);
+            if (watched.size() < MAX_WATCHED_DIRECTORIES)
+                watched.push_back(directory);
+
+            // the hidden entries, e.g. .git, are not listed
+            for (auto const &entry : QDir(directory).entryInfoList(QDir::Dirs | QDir::Files | QDir::NoDotAndDotDot))
+            {
+                if (entry.isDir())
+                {
+                    if (!entry.isSymLink())
+                        pendingDirectories.push_back(entry.absoluteFilePath());
+                }
+                else if (isSourceFile(entry) && found.size() < MAX_FILES)
+                {
+                    found.insert(entry.absoluteFilePath(), entry);
+                }
+            }
+        }
+
+        for (auto const &path : singleFiles)
+        {
+            QFileInfo info(path);
+            if (info.isFile() && !found.contains(info.absoluteFilePath()))
+            {
+                found.insert(info.absoluteFilePath(), info);
+                watched.push_back(info.absoluteFilePath());
+            }
+        }
+
+        changed = false;
+
+        for (auto const &key : qAsConst(files))
+        {
+            if (!found.contains(key) && !isBuffer(key))
+            {
+                remove(key);
+                changed = true;
+            }
+        }
+
+        files.clear();
+        for (auto it = found.constBegin(); it != found.constEnd(); ++it)
+        {
+            files.insert(it.key());
+            if (indexFile(it.key(), it.value()))
+                changed = true;
+        }
+
+        LOG_INFO(INFO_OF(files.size()) << INFO_OF(visitedDirectories.size()) << BOOL_INFO_OF(changed));
+
+        return watched;
+    }
+
+    void setBuffer(const QString &key, const QString &title, const QString &text)
+    {
+        if (text.size() > MAX_FILE_SIZE)
+        {
+            remove(key);
+            return;
+        }
+
+        Document document;
+        document.key = key;
+        document.title = title;
+        document.text = text;
+        document.isBuffer = true;
+        document.trigrams = trigrams(text);
+        update(std::move(document));
+    }
+
+    void removeBuffer(const QString &key)
+    {
+        if (!isBuffer(key))
+            return;
+        remove(key);
+        if (files.contains(key))
+            indexFile(key, QFileInfo(key));
+    }
+
+    /**
+     * @returns false if the search is cancelled
+     */
+    bool search(const QString &query, bool regex, bool caseSensitive, Result &result)
+    {
+        QElapsedTimer timer;
+        timer.start();
+
+        if (query.isEmpty())
+            return true;
+
+        QRegularExpression expression;
+        QVector<quint64> required;
+
+        if (regex)
+        {
+            expression.setPattern(query);
+            expression.setPatternOptions(caseSensitive ? QRegularExpression::MultilineOption
+                                                       : QRegularExpression::MultilineOption |
+                                                             QRegularExpression::CaseInsensitiveOption);
+            if (!expression.isValid())
+            {
+                result.error = expression.errorString();
+                return true;
+            }
+            expression.optimize();
+
+            for (auto const &literal : requiredLiterals(query))
+                required += trigrams(literal);
+            std::sort(required.begin(), required.end());
+            required.erase(std::unique(required.begin(), required.end()), required.end());
+        }
+        else
+        {
+            required = trigrams(query);
+        }
+
+        struct Candidate
+        {
+            QString key, title, text;
+            bool isBuffer;
+        };
+        QVector<Candidate> candidates;
+
+        {
+            QReadLocker locker(&lock);
+
+            result.totalDocuments = documents.size();
+
+            QVector<int> candidateIds;
+            if (required.isEmpty())
+            {
+                candidateIds = documents.keys().toVector();
+            }
+            else
+            {
+                QVector<const QVector<int> *> lists;
+                for (auto trigram : required)
+                {
+                    const auto it = postings.constFind(trigram);
+                    if (it == postings.constEnd())
+                    {
+                        lists.clear();
+                        break;
+                    }
+                    lists.push_back(&it.value());
+                }
+
+                if (!lists.isEmpty())
+                {
+                    // intersect from the shortest list, so the intermediate results are small
+                    std::sort(lists.begin(), lists.end(), [](const QVector<int> *lhs, const QVector<int> *rhs) {
+                        return lhs->size() < rhs->size();
+                    });
+                    candidateIds = *lists.front();
+                    for (int i = 1; i < lists.size() && !candidateIds.isEmpty(); ++i)
+                    {
+                        QVector<int> intersection;
+                        std::set_intersection(candidateIds.begin(), candidateIds.end(), lists[i]->begin(),
+                                              lists[i]->end(), std::back_inserter(intersection));
+                        candidateIds.swap(intersection);
+                    }
+                }
+            }
+
+            // the texts are implicitly shared, so they are matched after the lock is released
+            candidates.reserve(candidateIds.size());
+            for (auto id : candidateIds)
+            {
+                const auto &document = documents[id];
+                candidates.push_back({document.key, document.title, document.text, document.isBuffer});
+            }
+        }
+
+        std::sort(candidates.begin(), candidates.end(), [](const Candidate &lhs, const Candidate &rhs) {
+            if (lhs.isBuffer != rhs.isBuffer)
+                return lhs.isBuffer;
+            return lhs.title < rhs.title;
+        });
+
+        result.searchedDocuments = candidates.size();
+
+        for (auto const &candidate : candidates)
+        {
+            if (latestSearch.loadAcquire() != result.id)
+                return false;
+
+            const auto &text = candidate.text;
+            int line = 0;
+            int lineStart = 0;
+
+            auto addMatch = [&](int position, int length) {
+                for (int next = text.indexOf('\n', lineStart); next != -1 && next < position;
+                     next = text.indexOf('\n', lineStart))
+                {
+                    lineStart = next + 1;
+                    ++line;
+                }
+                int lineEnd = text.indexOf('\n', lineStart);
+                if (lineEnd == -1)
+                    lineEnd = text.size();
+                result.matches.push_back({candidate.key, candidate.title, line, position - lineStart, length,
+                                          text.mid(lineStart, qMin(lineEnd - lineStart, MAX_LINE_TEXT_LENGTH))});
+                return result.matches.size() < MAX_MATCHES;
+            };
+
+            bool more = true;
+            if (regex)
+            {
+                auto it = expression.globalMatch(text);
+                while (more && it.hasNext())
+                {
+                    const auto match = it.next();
+                    if (match.capturedLength() > 0)
+                        more = addMatch(match.capturedStart(), match.capturedLength());
+                }
+            }
+            else
+            {
+                const auto sensitivity = caseSensitive ? Qt::CaseSensitive : Qt::CaseInsensitive;
+                for (int pos = text.indexOf(query, 0, sensitivity); more && pos != -1;
+                     pos = text.indexOf(query, pos + query.size(), sensitivity))
+                {
+                    more = addMatch(pos, query.size());
+                }
+            }
+
+            if (!more)
+            {
+                result.truncated = true;
+                break;
+            }
+        }
+
+        result.elapsed = timer.elapsed();
+        return true;
+    }
+};
+
+SearchIndex::SearchIndex(QObject *parent) : QObject(parent), state(std::make_shared<State>())
+{
+    indexPool.setMaxThreadCount(1);
+    searchPool.setMaxThreadCount(1);
+
+    watcher = new QFileSystemWatcher(this);
+    connect(watcher, &QFileSystemWatcher::fileChanged, this, &SearchIndex::onWatchedPathChanged);
+    connect(watcher, &QFileSystemWatcher::directoryChanged, this, &SearchIndex::onWatchedPathChanged);
+
+    refreshTimer = new QTimer(this);
+    refreshTimer->setSingleShot(true);
+    refreshTimer->setInterval(REFRESH_DELAY);
+    connect(refreshTimer, &QTimer::timeout, this, &SearchIndex::refresh);
+}
+
+SearchIndex::~SearchIndex()
+{
+    state->latestSearch.fetchAndAddOrdered(1);
+    indexPool.clear();
+    searchPool.clear();
+    indexPool.waitForDone();
+    searchPool.waitForDone();
+}
+
+void SearchIndex::setFiles(const QStringList &directories, const QStringList &files)
+{
+    this->directories = directories;
+    this->files = files;
+    refreshTimer->start();
+}
+
+void SearchIndex::setBuffer(const QString &key, const QString &title, const QString &text)
+{
+    auto state = this->state;
+    indexPool.start(new Task([this, state, key, title, text] {
+        state->setBuffer(key, title, text);
+        QMetaObject::invokeMethod(
+            this, [this] { emit indexUpdated(); }, Qt::QueuedConnection);
+    }));
+}
+
+void SearchIndex::removeBuffer(const QString &key)
+{
+    auto state = this->state;
+    indexPool.start(new Task([this, state, key] {
+        state->removeBuffer(key);
+        QMetaObject::invokeMethod(
+            this, [this] { emit indexUpdated(); }, Qt::QueuedConnection);
+    }));
+}
+
+int SearchIndex::search(const QString &query, bool regex, bool caseSensitive)
+{
+    const int id = state->latestSearch.fetchAndAddOrdered(1) + 1;
+    auto state = this->state;
+    searchPool.start(new Task([this, state, id, query, regex, caseSensitive] {
+        Result result;
+        result.id = id;
+        if (!state->search(query, regex, caseSensitive, result))
+            return;
+        QMetaObject::invokeMethod(
+            this, [this, result] { emit searchFinished(result); }, Qt::QueuedConnection);
+    }));
+    return id;
+}
+
+QVector<quint64> SearchIndex::trigrams(const QString &text)
+{
+    QVector<quint64> result;
+    if (text.size() < 3)
+        return result;
+
+    result.reserve(text.size() - 2);
+    quint64 window = 0;
+    for (int i = 0; i < text.size(); ++i)
+    {
+        window = ((window << 16) | text[i].toCaseFolded().unicode()) & TRIGRAM_MASK;
+        if (i >= 2)
+            result.push_back(window);
+    }
+
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+QStringList SearchIndex::requiredLiterals(const QString &pattern)
+{
+    // the extended mode ignores the spaces in the pattern, so the literals can't be read from it
+    if (pattern.contains(QRegularExpression(R"(\(\?[a-zA-Z^-]*x)")))
+        return {};
+
+    QStringList literals;
+    QString current;
+    int depth = 0; // the literals in the groups are ignored, because a group can be optional or an alternative
+
+    auto flush = [&] {
+        if (current.size() >= 3)
+            literals.push_back(current);
+        current.clear();
+    };
+
+    const int length = pattern.size();
+    for (int i = 0; i < length; ++i)
+    {
+        const auto c = pattern[i];
+
+        if (c == '\\')
+        {
+            if (i + 1 < length && !pattern[i + 1].isLetterOrNumber())
+            {
+                ++i;
+                if (depth == 0)
+                    current += pattern[i];
+                continue;
+            }
+            // a character type, an assertion or a reference, the characters after it are skipped to be safe
+            flush();
+            ++i;
+            while (i + 1 < length &&
+                   (pattern[i + 1].isLetterOrNumber() || QStringLiteral("{}<>'_-").contains(pattern[i + 1])))
+                ++i;
+            continue;
+        }
+
+        if (c == '[')
+        {
+            flush();
+            ++i;
+            if (i < length && pattern[i] == '^')
+                ++i;
+            if (i < length && pattern[i] == ']') // a ']' at the beginning is a literal
+                ++i;
+            while (i < length && pattern[i] != ']')
+            {
+                if (pattern[i] == '\\')
+                    ++i;
+                else if (pattern.midRef(i, 2) == "[:" && pattern.indexOf(":]", i + 2) != -1)
+                    i = pattern.indexOf(":]", i + 2) + 1;
+                ++i;
+            }
+            continue;
+        }
+
+        switch (c.unicode())
+        {
+        case '(':
+            flush();
+            ++depth;
+            break;
+        case ')':
+            flush();
+            depth = qMax(0, depth - 1);
+            break;
+        case '|':
+            // an alternative at the top level can match without any of the literals
+            if (depth == 0)
+                return {};
+            break;
+        case '*':
+        case '?':
+        case '{':
+            // the previous character is optional or repeated
+            if (!current.isEmpty())
+                current.chop(1);
+            flush();
+            if (c == '{' && pattern.indexOf('}', i) != -1)
+                i = pattern.indexOf('}', i);
+            break;
+        case '+':
+        case '.':
+        case '^':
+        case '$':
+            flush();
+            break;
+        default:
+            if (depth == 0)
+                current += c;
+        }
+    }
+
+    flush();
+    return literals;
+}
+
+void SearchIndex::onWatchedPathChanged()
+{
+    refreshTimer->start();
+}
+
+void SearchIndex::refresh()
+{
+    auto state = this->state;
+    const auto directories = this->directories;
+    const auto files = this->files;
+    indexPool.start(new Task([this, state, directories, files] {
+        bool changed = false;
+        const auto watchedPaths = state->refresh(directories, files, changed);
+        QMetaObject::invokeMethod(
+            this,
+            [this, watchedPaths, changed] {
+                onRefreshed(watchedPaths);
+                if (changed)
+                    emit indexUpdated();
+            },
+            Qt::QueuedConnection);
+    }));
+}
+
+void SearchIndex::onRefreshed(const QStringList &watchedPaths)
+{
+    QSet<QString> oldPaths;
+    for (auto const &path : watcher->files() + watcher->directories())
+        oldPaths.insert(path);
+
+    QSet<QString> newPaths;
+    QStringList addedPaths;
+    for (auto const &path : watchedPaths)
+    {
+        newPaths.insert(path);
+        if (!oldPaths.contains(path))
+            addedPaths.push_back(path);
+    }
+
+    QStringList removedPaths;
+    for (auto const &path : oldPaths)
+    {
+        if (!newPaths.contains(path))
+            removedPaths.push_back(path);
+    }
+
+    if (!removedPaths.isEmpty())
+        watcher->removePaths(removedPaths);
+    if (!addedPaths.isEmpty())
+        watcher->addPaths(addedPaths);
+}
+} // namespace Core
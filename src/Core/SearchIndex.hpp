@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2019-2021 Ashar Khan <ashar786khan@gmail.com>
+ *
+ * This file is part of CP Editor.
+ *
+ * CP Editor is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * I will not be responsible if CP Editor behaves in unexpected way and
+ * causes your ratings to go down and or lose any important contest.
+ *
+ * Believe Software is "Software" and it isn't immune to bugs.
+ *
+ */
+
+/*
+ * The index for searching in the workspace, i.e. the open tabs, the contest directory and the recent files.
+ * Each document is split into the trigrams of its case-folded text, and each trigram is mapped to the sorted IDs of
+ * the documents containing it. A query is only matched against the documents containing all trigrams it requires, so
+ * a search over thousands of files only reads a few of them. The files are read and indexed in a background thread,
+ * and when the watched directories or files change, only the files with a new modification time are read again.
+ */
+
+#ifndef SEARCHINDEX_HPP
+#define SEARCHINDEX_HPP
+
+#include <QObject>
+#include <QThreadPool>
+#include <QVector>
+#include <memory>
+
+class QFileSystemWatcher;
+class QTimer;
+
+namespace Core
+{
+class SearchIndex : public QObject
+{
+    Q_OBJECT
+
+  public:
+    struct State; // the documents and the trigrams, shared with the background threads
+
+    struct Match
+    {
+        QString key;      // the key of the document, see setBuffer()
+        QString title;    // the name of the document shown to the user
+        int line;         // 0-based
+        int column;       // 0-based, in the line
+        int length;       // the length of the matched text
+        QString lineText; // the line containing the match, truncated if it's too long
+    };
+
+    struct Result
+    {
+        int id = 0;                // the ID returned by search()
+        QVector<Match> matches;    // ordered by the documents, the open tabs first
+        int searchedDocuments = 0; // the number of documents matched against the query
+        int totalDocuments = 0;    // the number of documents in the index
+        bool truncated = false;    // whether there are more matches than the returned ones
+        qint64 elapsed = 0;        // in milliseconds
+        QString error;             // the error of an invalid regular expression
+    };
+
+    explicit SearchIndex(QObject *parent = nullptr);
+
+    /**
+     * @note This waits for the running tasks.
+     */
+    ~SearchIndex() override;
+
+    /**
+     * @brief set the files to index, they are watched and indexed again when they are changed
+     * @param directories the directories to index recursively, only the C++, Java and Python files are indexed
+     * @param files the files to index, e.g. the recent files
+     */
+    void setFiles(const QStringList &directories, const QStringList &files);
+
+    /**
+     * @brief index the text in an editor
+     * @param key the absolute path of the file if the text is a file, or any other unique key
+     * @param title the name of the document shown to the user
+     * @param text the text in the editor, the file of the same key is ignored until the buffer is removed
+     */
+    void setBuffer(const QString &key, const QString &title, const QString &text);
+
+    /**
+     * @brief remove the text in an editor, the file of the same key is indexed again if it's still in the files
+     */
+    void removeBuffer(const QString &key);
+
+    /**
+     * @brief search in the background, the result is reported by searchFinished()
+     * @param query the substring or the regular expression to search
+     * @returns the ID of this search, the earlier searches still running are cancelled
+     */
+    int search(const QString &query, bool regex, bool caseSensitive);
+
+    /**
+     * @returns the trigrams of a text, case-folded, sorted and unique
+     */
+    static QVector<quint64> trigrams(const QString &text);
+
+    /**
+     * @returns the literal strings every match of a regular expression contains, an empty list if it's not known
+     */
+    static QStringList requiredLiterals(const QString &pattern);
+
+  signals:
+    /**
+     * @brief a search is finished, emitted in the GUI thread, the cancelled searches are not reported
+     */
+    void searchFinished(const Core::SearchIndex::Result &result);
+
+    /**
+     * @brief some documents are added, changed or removed, emitted in the GUI thread
+     */
+    void indexUpdated();
+
+  private slots:
+    void onWatchedPathChanged();
+
+    void refresh();
+
+    void onRefreshed(const QStringList &watchedPaths);
+
+  private:
+    std::shared_ptr<State> state;
+    QThreadPool indexPool;  // reads and indexes the files, one task at a time
+    QThreadPool searchPool; // runs the searches, one at a time
+    QFileSystemWatcher *watcher = nullptr;
+    QTimer *refreshTimer = nullptr; // coalesces the changes of the watched paths
+    QStringList directories;
+    QStringList files;
+};
+} // namespace Core
+
+#endif // SEARCHINDEX_HPP
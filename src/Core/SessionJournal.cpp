@@ -0,0 +1,266 @@
+/*
+ * Copyright (C) 2019-2021 Ashar Khan <ashar786khan@gmail.com>
+ *
+ * This file is part of CP Editor.
+ *
+ * CP Editor is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * I will not be responsible if CP Editor behaves in unexpected way and
+ * causes your ratings to go down and or lose any important contest.
+ *
+ * Believe Software is "Software" and it isn't immune to bugs.
+ *
+ */
+
+#include "Core/SessionJournal.hpp"
+#include "Core/EventLogger.hpp"
+#include "Util/FileUtil.hpp"
+#include <QCborArray>
+#include <QCborMap>
+#include <QCborStreamReader>
+#include <QCborValue>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMap>
+#include <QRunnable>
+#include <QSaveFile>
+
+namespace Core
+{
+namespace
+{
+// a new snapshot is written when the journal is larger than this or has this number of records
+const qint64 MAX_JOURNAL_SIZE = 4 * 1024 * 1024;
+const int MAX_JOURNAL_RECORDS = 256;
+
+QCborMap makeRecord(qint64 generation, const QVector<quint64> &order, int currentIndex, const QCborMap &tabs)
+{
+    QCborArray ids;
+    for (auto id : order)
+        ids.append(qint64(id));
+
+    QCborMap record;
+    record.insert(QStringLiteral("generation"), generation);
+    record.insert(QStringLiteral("currentIndex"), currentIndex);
+    record.insert(QStringLiteral("order"), ids);
+    record.insert(QStringLiteral("tabs"), tabs);
+    return record;
+}
+} // namespace
+
+struct SessionJournal::State
+{
+    QString snapshotPath;
+    QString journalPath;
+
+    qint64 generation = 0; // the generation of the snapshot, 0 if it's not written by this instance yet
+    qint64 journalSize = 0;
+    int journalRecords = 0;
+
+    // the whole session, so that a new snapshot can be written without the tabs
+    QVector<quint64> order;
+    int currentIndex = 0;
+    QMap<quint64, QCborMap> tabs;
+
+    void write(const QVector<quint64> &newOrder, int newCurrentIndex, const QHash<quint64, QVariantMap> &changedTabs)
+    {
+        order = newOrder;
+        currentIndex = newCurrentIndex;
+
+        QCborMap changed;
+        for (auto it = changedTabs.begin(); it != changedTabs.end(); ++it)
+        {
+            auto status = QCborMap::fromVariantMap(it.value());
+            tabs[it.key()] = status;
+            changed.insert(qint64(it.key()), status);
+        }
+
+        // forget the closed tabs
+        for (auto it = tabs.begin(); it != tabs.end();)
+        {
+            if (order.contains(it.key()))
+                ++it;
+            else
+                it = tabs.erase(it);
+        }
+
+        if (generation == 0 || journalSize > MAX_JOURNAL_SIZE || journalRecords >= MAX_JOURNAL_RECORDS ||
+            !appendRecord(changed))
+        {
+            writeSnapshot();
+        }
+    }
+
+    bool appendRecord(const QCborMap &changed)
+    {
+        QFile file(journalPath);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Append))
+        {
+            LOG_WARN("Failed to open the session journal " << INFO_OF(journalPath));
+            return false;
+        }
+
+        const auto data = QCborValue(makeRecord(generation, order, currentIndex, changed)).toCbor();
+        if (file.write(data) != data.size() || !Util::syncFile(file))
+        {
+            LOG_WARN("Failed to append to the session journal " << INFO_OF(journalPath));
+            return false;
+        }
+
+        journalSize += data.size();
+        ++journalRecords;
+        return true;
+    }
+
+    void writeSnapshot()
+    {
+        // the generation is never reused, even after a restart, so the old records are never applied to it
+        const auto newGeneration = qMax(generation + 1, QDateTime::currentMSecsSinceEpoch());
+
+        QCborMap allTabs;
+        for (auto it = tabs.begin(); it != tabs.end(); ++it)
+            allTabs.insert(qint64(it.key()), it.value());
+
+        QDir().mkpath(QFileInfo(snapshotPath).absolutePath());
+        QSaveFile file(snapshotPath);
+        if (!file.open(QIODevice::WriteOnly))
+        {
+            LOG_ERR("Failed to open the session snapshot " << INFO_OF(snapshotPath));
+            return;
+        }
+        file.write(QCborValue(makeRecord(newGeneration, order, currentIndex, allTabs)).toCbor());
+        if (!file.commit())
+        {
+            LOG_ERR("Failed to write the session snapshot " << INFO_OF(snapshotPath));
+            return;
+        }
+
+        generation = newGeneration;
+
+        QFile journal(journalPath);
+        if (!journal.open(QIODevice::WriteOnly | QIODevice::Truncate))
+            LOG_WARN("Failed to clear the session journal " << INFO_OF(journalPath));
+        journalSize = 0;
+        journalRecords = 0;
+
+        LOG_INFO("Session snapshot written " << INFO_OF(generation) << INFO_OF(tabs.size()));
+    }
+};
+
+namespace
+{
+class WriteTask : public QRunnable
+{
+  public:
+    std::shared_ptr<SessionJournal::State> state;
+    QVector<quint64> order;
+    int currentIndex = 0;
+    QHash<quint64, QVariantMap> changedTabs;
+
+    void run() override
+    {
+        state->write(order, currentIndex, changedTabs);
+    }
+};
+} // namespace
+
+SessionJournal::SessionJournal(const QString &snapshotPath) : state(std::make_shared<State>())
+{
+    state->snapshotPath = snapshotPath;
+    state->journalPath = journalPath(snapshotPath);
+    // the records are written by a single thread, so that they are written in order
+    pool.setMaxThreadCount(1);
+}
+
+SessionJournal::~SessionJournal()
+{
+    waitForDone();
+}
+
+void SessionJournal::append(const QVector<quint64> &order, int currentIndex,
+                            const QHash<quint64, QVariantMap> &changedTabs)
+{
+    auto *task = new WriteTask();
+    task->state = state;
+    task->order = order;
+    task->currentIndex = currentIndex;
+    task->changedTabs = changedTabs;
+    pool.start(task);
+}
+
+void SessionJournal::waitForDone()
+{
+    pool.waitForDone();
+}
+
+bool SessionJournal::read(const QString &snapshotPath, int &currentIndex, QList<QVariantMap> &tabs)
+{
+    QFile snapshotFile(snapshotPath);
+    if (!snapshotFile.open(QIODevice::ReadOnly))
+        return false;
+
+    const auto snapshot = QCborValue::fromCbor(snapshotFile.readAll()).toMap();
+    if (!snapshot.contains(QStringLiteral("generation")))
+    {
+        LOG_ERR("Invalid session snapshot " << INFO_OF(snapshotPath));
+        return false;
+    }
+
+    const auto generation = snapshot.value(QStringLiteral("generation")).toInteger();
+    QVector<quint64> order;
+    QHash<quint64, QVariantMap> statuses;
+
+    auto apply = [&](const QCborMap &record) {
+        order.clear();
+        for (auto const &id : record.value(QStringLiteral("order")).toArray())
+            order.push_back(quint64(id.toInteger()));
+        currentIndex = int(record.value(QStringLiteral("currentIndex")).toInteger());
+        const auto changed = record.value(QStringLiteral("tabs")).toMap();
+        for (auto it = changed.begin(); it != changed.end(); ++it)
+            statuses[quint64(it.key().toInteger())] = it.value().toMap().toVariantMap();
+    };
+
+    apply(snapshot);
+
+    QFile journalFile(journalPath(snapshotPath));
+    if (journalFile.open(QIODevice::ReadOnly))
+    {
+        QCborStreamReader reader(journalFile.readAll());
+        int records = 0;
+        while (reader.isValid())
+        {
+            const auto record = QCborValue::fromCbor(reader);
+            // the last record may be broken if the application was killed while writing it
+            if (reader.lastError() != QCborError::NoError)
+            {
+                LOG_WARN("Broken record in the session journal " << INFO_OF(records));
+                break;
+            }
+            const auto map = record.toMap();
+            if (map.value(QStringLiteral("generation")).toInteger() != generation)
+                continue;
+            apply(map);
+            ++records;
+        }
+        LOG_INFO(INFO_OF(records));
+    }
+
+    tabs.clear();
+    for (auto id : order)
+    {
+        if (statuses.contains(id))
+            tabs.push_back(statuses[id]);
+    }
+    return true;
+}
+
+QString SessionJournal::journalPath(const QString &snapshotPath)
+{
+    return snapshotPath + ".journal";
+}
+} // namespace Core
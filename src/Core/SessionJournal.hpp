@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2019-2021 Ashar Khan <ashar786khan@gmail.com>
+ *
+ * This file is part of CP Editor.
+ *
+ * CP Editor is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * I will not be responsible if CP Editor behaves in unexpected way and
+ * causes your ratings to go down and or lose any important contest.
+ *
+ * Believe Software is "Software" and it isn't immune to bugs.
+ *
+ */
+
+/*
+ * The session saved for Hot Exit, as a CBOR snapshot and an append-only CBOR journal next to it.
+ * Each record in the journal has the order of the tabs, the current index and the statuses of the tabs changed since
+ * the previous record, so an update doesn't write the unchanged tabs again. When the journal grows large, all tabs are
+ * written to a new snapshot and the journal is cleared. Both files are encoded and synced in a background thread.
+ * The snapshot and the records have a generation number, the records left from an older snapshot are ignored.
+ */
+
+#ifndef SESSIONJOURNAL_HPP
+#define SESSIONJOURNAL_HPP
+
+#include <QHash>
+#include <QThreadPool>
+#include <QVariantMap>
+#include <QVector>
+#include <memory>
+
+namespace Core
+{
+class SessionJournal
+{
+  public:
+    struct State; // the session and the files, used in the background thread
+
+    /**
+     * @param snapshotPath the path to the snapshot, the journal is written to snapshotPath + ".journal"
+     */
+    explicit SessionJournal(const QString &snapshotPath);
+
+    /**
+     * @note This waits for the pending writes.
+     */
+    ~SessionJournal();
+
+    /**
+     * @brief record the session in the background
+     * @param order the IDs of all tabs in the session
+     * @param currentIndex the index of the current tab
+     * @param changedTabs the statuses of the tabs changed since the last record, keyed by the IDs
+     * @note The first record after the construction is written as a snapshot, so it should include all tabs.
+     */
+    void append(const QVector<quint64> &order, int currentIndex, const QHash<quint64, QVariantMap> &changedTabs);
+
+    /**
+     * @brief wait for the pending writes
+     */
+    void waitForDone();
+
+    /**
+     * @brief read a session from a snapshot and its journal
+     * @param snapshotPath the path to the snapshot
+     * @param currentIndex the index of the current tab
+     * @param tabs the statuses of the tabs, in order
+     * @returns whether the snapshot is read, the records after a broken record in the journal are ignored
+     */
+    static bool read(const QString &snapshotPath, int &currentIndex, QList<QVariantMap> &tabs);
+
+    /**
+     * @returns the path to the journal of a snapshot
+     */
+    static QString journalPath(const QString &snapshotPath);
+
+  private:
+    std::shared_ptr<State> state; // only accessed in the thread of the pool, except for the paths
+    QThreadPool pool;
+};
+} // namespace Core
+
+#endif // SESSIONJOURNAL_HPP
@@ -18,11 +18,15 @@
 #include "Core/SessionManager.hpp"
 #include "../../ui/ui_appwindow.h"
 #include "Core/EventLogger.hpp"
+#include "Core/FileWriter.hpp"
+#include "Core/SessionJournal.hpp"
+#include "Core/TestData.hpp"
 #include "Util/FileUtil.hpp"
 #include "appwindow.hpp"
 #include "generated/portable.hpp"
 #include "mainwindow.hpp"
 #include <QFile>
+#include <QFileInfo>
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
@@ -37,32 +41,64 @@ const static QStringList sessionFileLocations = {
 #endif
     "$APPCONFIG/cp_editor_session.json"};
 
+const static QStringList sessionSnapshotLocations = {
+#ifdef PORTABLE_VERSION
+    "$BINARY/cp_editor_session.cbor",
+#endif
+    "$APPCONFIG/cp_editor_session.cbor"};
+
 SessionManager::SessionManager(AppWindow *appwindow) : QObject(appwindow), app(appwindow)
 {
+    journal = new SessionJournal(Util::configFilePath(sessionSnapshotLocations[0]));
+
     timer = new QTimer(this);
 
     timer->setInterval(10000);
     connect(timer, &QTimer::timeout, this, &SessionManager::updateSession, Qt::DirectConnection);
 }
 
+SessionManager::~SessionManager()
+{
+    delete journal; // this waits for the pending writes
+}
+
 void SessionManager::restoreSession(const QString &path)
 {
     LOG_INFO(INFO_OF(path));
 
-    auto text = Util::readFile(path);
+    int currentIndex = 0;
+    QList<QVariantMap> tabs;
 
-    if (text.isNull())
+    if (QFileInfo(path).suffix() == "cbor")
     {
-        LOG_ERR(QString("Failed to load session from [%1]").arg(path));
-        return;
+        if (!SessionJournal::read(path, currentIndex, tabs))
+        {
+            LOG_ERR(QString("Failed to load session from [%1]").arg(path));
+            return;
+        }
     }
-
-    auto document = QJsonDocument::fromJson(text.toUtf8());
-
-    if (document.isNull())
+    else
     {
-        LOG_ERR("Invalid session JSON: " << text);
-        return;
+        auto text = Util::readFile(path);
+
+        if (text.isNull())
+        {
+            LOG_ERR(QString("Failed to load session from [%1]").arg(path));
+            return;
+        }
+
+        auto document = QJsonDocument::fromJson(text.toUtf8());
+
+        if (document.isNull())
+        {
+            LOG_ERR("Invalid session JSON: " << text);
+            return;
+        }
+
+        QJsonObject object = document.object();
+        currentIndex = object["currentIndex"].toInt();
+        for (auto &&tab : object["tabs"].toArray())
+            tabs.push_back(tab.toObject().toVariantMap());
     }
 
     while (app->ui->tabWidget->count() > 0)
@@ -72,11 +108,6 @@ void SessionManager::restoreSession(const QString &path)
         delete tmp;
     }
 
-    QJsonObject object = document.object();
-
-    const int currentIndex = object["currentIndex"].toInt();
-    auto tabs = object["tabs"].toArray();
-
     QProgressDialog progressDialog(app);
     progressDialog.setWindowModality(Qt::WindowModal);
     progressDialog.setWindowTitle(tr("Restoring Last Session"));
@@ -87,13 +118,15 @@ void SessionManager::restoreSession(const QString &path)
     auto oldSize = app->size();
     app->setUpdatesEnabled(false);
 
-    for (auto &&tab : tabs)
+    // the tabs are restored as placeholders, and they are loaded when they are activated or in the background
+    MainWindow *last = nullptr;
+    for (auto const &tab : tabs)
     {
         if (progressDialog.wasCanceled())
             break;
-        auto status = MainWindow::EditorStatus(tab.toObject().toVariantMap());
-        app->openTab(status);
-        progressDialog.setLabelText(QString(tr("Restoring: [%1]")).arg(app->currentWindow()->getTabTitle(true, false)));
+        auto status = MainWindow::EditorStatus(tab);
+        last = app->openTab(status, false, last, false);
+        progressDialog.setLabelText(QString(tr("Restoring: [%1]")).arg(last->getTabTitle(true, false)));
         progressDialog.setValue(progressDialog.value() + 1);
     }
 
@@ -126,7 +159,9 @@ QString SessionManager::currentSessionText()
     QJsonArray arr;
     for (int t = 0; t < app->ui->tabWidget->count(); t++)
     {
-        arr.push_back(QJsonDocument::fromVariant(app->windowAt(t)->toStatus().toMap()).object());
+        auto status = app->windowAt(t)->toStatus();
+        status.embedTestData();
+        arr.push_back(QJsonDocument::fromVariant(status.toMap()).object());
     }
 
     json.insert("tabs", arr);
@@ -136,16 +171,59 @@ QString SessionManager::currentSessionText()
 
 QString SessionManager::lastSessionPath()
 {
+    auto snapshotPath = Util::firstExistingConfigPath(sessionSnapshotLocations);
+    if (!snapshotPath.isEmpty())
+        return snapshotPath;
     return Util::firstExistingConfigPath(sessionFileLocations);
 }
 
 void SessionManager::saveSession(const QString &sessionText)
 {
-    Util::saveFile(Util::configFilePath(sessionFileLocations[0]), sessionText, "Save Session", true, nullptr, true);
+    const auto path = Util::configFilePath(sessionFileLocations[0]);
+    FileWriter::instance().write(path, sessionText, "Save Session", true, nullptr, true);
 }
 
 void SessionManager::updateSession()
 {
-    saveSession(currentSessionText());
+    QVector<quint64> order;
+    QHash<quint64, quint64> revisions;
+    QHash<quint64, QVariantMap> changedTabs;
+
+    for (int t = 0; t < app->ui->tabWidget->count(); t++)
+    {
+        auto *window = app->windowAt(t);
+        const auto id = window->getSessionId();
+        order.push_back(id);
+        auto it = writtenRevisions.find(id);
+        if (it == writtenRevisions.end() || it.value() != window->getStatusRevision())
+            changedTabs[id] = window->toStatus().toMap();
+        revisions[id] = window->getStatusRevision();
+    }
+
+    const int currentIndex = app->ui->tabWidget->currentIndex();
+
+    if (changedTabs.isEmpty() && order == writtenOrder && currentIndex == writtenCurrentIndex)
+        return;
+
+    LOG_INFO(INFO_OF(order.size()) << INFO_OF(changedTabs.size()));
+
+    journal->append(order, currentIndex, changedTabs);
+
+    // the first record has all tabs, and it replaces the session saved last time
+    if (!unreferencedTestDataRemoved)
+    {
+        unreferencedTestDataRemoved = true;
+        QSet<QString> referenced;
+        for (auto const &tab : changedTabs)
+        {
+            for (auto const &path : tab.value("inputFiles").toStringList() + tab.value("expectedFiles").toStringList())
+                referenced.insert(path);
+        }
+        TestData::removeUnreferenced(referenced);
+    }
+
+    writtenRevisions = revisions;
+    writtenOrder = order;
+    writtenCurrentIndex = currentIndex;
 }
 } // namespace Core
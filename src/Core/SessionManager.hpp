@@ -18,38 +18,63 @@
 #ifndef SESSION_MANAGER_HPP
 #define SESSION_MANAGER_HPP
 
+#include <QHash>
 #include <QObject>
+#include <QVector>
 
 class AppWindow;
 class QTimer;
 
 namespace Core
 {
+class SessionJournal;
+
 class SessionManager : public QObject
 {
     Q_OBJECT
 
   public:
     explicit SessionManager(AppWindow *appwindow);
+    ~SessionManager() override;
 
+    /**
+     * @brief replace the tabs with a session
+     * @param path the path to a JSON session file, or to the snapshot of the session journal
+     */
     void restoreSession(const QString &path);
 
     void setAutoUpdateSession(bool shouldAutoUpdate);
 
     void setAutoUpdateDuration(int duration);
 
+    /**
+     * @returns the current session in JSON, e.g. for exporting it
+     */
     QString currentSessionText();
 
+    /**
+     * @returns the path to the snapshot of the session journal, or to the JSON session file saved by older versions,
+     * or an empty string if there's no saved session
+     */
     static QString lastSessionPath();
 
     static void saveSession(const QString &sessionText);
 
   public slots:
+    /**
+     * @brief record the tabs changed since the last update in the session journal
+     */
     void updateSession();
 
   private:
     QTimer *timer = nullptr;
     AppWindow *app = nullptr;
+
+    SessionJournal *journal = nullptr;
+    QHash<quint64, quint64> writtenRevisions; // the status revisions of the tabs in the journal, keyed by the IDs
+    QVector<quint64> writtenOrder;
+    int writtenCurrentIndex = -1;
+    bool unreferencedTestDataRemoved = false; // the stored test data is cleaned once the session is written
 };
 } // namespace Core
 
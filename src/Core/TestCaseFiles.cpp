@@ -0,0 +1,312 @@
+/*
+ * Copyright (C) 2019-2021 Ashar Khan <ashar786khan@gmail.com>
+ *
+ * This file is part of CP Editor.
+ *
+ * CP Editor is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * I will not be responsible if CP Editor behaves in unexpected way and
+ * causes your ratings to go down and or lose any important contest.
+ *
+ * Believe Software is "Software" and it isn't immune to bugs.
+ *
+ */
+
+#include "Core/TestCaseFiles.hpp"
+#include "Core/EventLogger.hpp"
+#include "Core/MessageLogger.hpp"
+#include "generated/SettingsHelper.hpp"
+#include <QCoreApplication>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QPointer>
+#include <QRegularExpression>
+#include <QRunnable>
+#include <QSaveFile>
+#include <QSet>
+#include <QThreadPool>
+#include <functional>
+
+namespace Core
+{
+namespace
+{
+// when the index is in the directory of a rule, stop looking for the files after this number of missing indices
+const int MAX_PROBED_GAP = 100;
+
+const QRegularExpression INDEX_PLACEHOLDER(R"(\$\{([01])-index\})");
+
+// a rule applied to a source file, the index of a saved file can be found from its name
+struct FilePattern
+{
+    QString directory;
+    QRegularExpression fileName; // captures the number in the file name
+    int offset = 0;              // the number in the file name minus the index
+    bool isValid = false;        // false if the directory depends on the index, then the files can't be listed
+};
+
+QString applyNames(QString rule, const QString &sourcePath)
+{
+    QFileInfo fileInfo(sourcePath);
+    return fileInfo.dir().filePath(
+        rule.replace("${filename}", fileInfo.fileName()).replace("${basename}", fileInfo.completeBaseName()));
+}
+
+FilePattern filePattern(const QString &rule, const QString &sourcePath)
+{
+    FilePattern pattern;
+    const QFileInfo path(applyNames(rule, sourcePath));
+    const auto name = path.fileName();
+    if (path.path().contains(INDEX_PLACEHOLDER) || !name.contains(INDEX_PLACEHOLDER))
+        return pattern;
+
+    QString regex = "^";
+    int last = 0;
+    bool captured = false;
+    auto it = INDEX_PLACEHOLDER.globalMatch(name);
+    while (it.hasNext())
+    {
+        auto match = it.next();
+        regex += QRegularExpression::escape(name.mid(last, match.capturedStart() - last));
+        // only the first number is captured, the others are checked by generating the name from the index
+        if (!captured)
+        {
+            captured = true;
+            regex += R"((\d+))";
+            pattern.offset = match.captured(1).toInt();
+        }
+        else
+        {
+            regex += R"(\d+)";
+        }
+        last = match.capturedEnd();
+    }
+    regex += QRegularExpression::escape(name.mid(last)) + "$";
+
+    pattern.directory = path.path();
+    pattern.fileName.setPattern(regex);
+    pattern.isValid = true;
+    return pattern;
+}
+
+bool writeFile(const QString &path, const TestData &data, bool safe)
+{
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    // inline data is written as text, the same as Util::saveFile, while mapped data is written as it is
+    QIODevice::OpenMode mode = QIODevice::WriteOnly;
+    if (!data.isMapped())
+        mode |= QIODevice::Text;
+    const auto content = data.toUtf8();
+    if (safe)
+    {
+        QSaveFile file(path);
+        return file.open(mode) && file.write(content) != -1 && file.commit();
+    }
+    QFile file(path);
+    return file.open(mode) && file.write(content) != -1;
+}
+
+// writes and removes the files of a save in the saving thread
+// it only writes to the event logger, which is thread-safe, the failures are shown in the GUI thread by finished
+class SaveTask : public QRunnable
+{
+  public:
+    QString sourcePath;
+    QStringList rules;                                 // the save path rules of the files to be removed
+    QSet<QString> keptPaths;                           // the files of non-empty test cases, which are not removed
+    QList<QPair<QString, TestData>> writes;            // the files to be written
+    bool safe = true;                                  // whether to write the files by QSaveFile
+    std::function<void(const QStringList &)> finished; // called with the paths failed to be written
+
+    void run() override
+    {
+        QStringList failedPaths;
+        for (auto const &write : writes)
+        {
+            if (!writeFile(write.first, write.second, safe))
+            {
+                LOG_ERR("Failed to write " << write.first);
+                failedPaths.push_back(write.first);
+            }
+        }
+        for (auto const &rule : rules)
+        {
+            for (auto const &path : TestCaseFiles::savedFiles(rule, sourcePath))
+            {
+                if (!keptPaths.contains(path) && !QFile::remove(path))
+                    LOG_WARN("Failed to remove " << path);
+            }
+        }
+        finished(failedPaths);
+    }
+};
+
+// the files are written by a single thread, so that the saves are done in the order they are requested
+QThreadPool *savingThreadPool()
+{
+    static QThreadPool *pool = [] {
+        // the pool is destroyed with the application, which waits for the pending saves
+        auto *pool = new QThreadPool(QCoreApplication::instance());
+        pool->setMaxThreadCount(1);
+        return pool;
+    }();
+    return pool;
+}
+} // namespace
+
+TestCaseFiles::TestCaseFiles(MessageLogger *logger, QObject *parent) : QObject(parent), log(logger)
+{
+}
+
+void TestCaseFiles::load(const QString &sourcePath, QList<TestData> &inputs, QList<TestData> &expecteds)
+{
+    // make sure that the files are not being written
+    savingThreadPool()->waitForDone();
+
+    this->sourcePath = sourcePath;
+    hashes.clear();
+    inputs.clear();
+    expecteds.clear();
+
+    const auto inputFiles = savedFiles(SettingsHelper::getInputFileSavePath(), sourcePath);
+    const auto answerFiles = savedFiles(SettingsHelper::getAnswerFileSavePath(), sourcePath);
+    const int number = qMax(inputFiles.isEmpty() ? 0 : inputFiles.lastKey() + 1,
+                            answerFiles.isEmpty() ? 0 : answerFiles.lastKey() + 1);
+
+    LOG_INFO(INFO_OF(sourcePath) << INFO_OF(inputFiles.size()) << INFO_OF(answerFiles.size()) << INFO_OF(number));
+
+    auto loadFile = [this](const QMap<int, QString> &files, int index, const QString &head) {
+        if (!files.contains(index))
+            return TestData(QString());
+        auto data = TestData::fromFile(files[index], head, log, true);
+        if (!data.isNull())
+            hashes[files[index]] = data.hash();
+        return data;
+    };
+
+    for (int i = 0; i < number; ++i)
+    {
+        inputs.push_back(loadFile(inputFiles, i, tr("Load Input #%1").arg(i + 1)));
+        expecteds.push_back(loadFile(answerFiles, i, tr("Load Expected #%1").arg(i + 1)));
+    }
+}
+
+void TestCaseFiles::save(const QString &sourcePath, const QList<TestData> &inputs, const QList<TestData> &expecteds,
+                         bool safe)
+{
+    if (sourcePath != this->sourcePath)
+    {
+        this->sourcePath = sourcePath;
+        hashes.clear();
+    }
+
+    auto *task = new SaveTask();
+    task->sourcePath = sourcePath;
+    task->rules = {SettingsHelper::getInputFileSavePath(), SettingsHelper::getAnswerFileSavePath()};
+    task->safe = safe && !SettingsHelper::isSaveFaster();
+
+    auto addFile = [this, task](const QString &path, const TestData &data) {
+        if (data.isEmpty())
+            return;
+        task->keptPaths.insert(path);
+        const auto hash = data.hash();
+        if (hashes.value(path) != hash)
+        {
+            task->writes.push_back({path, data});
+            hashes[path] = hash;
+        }
+    };
+
+    for (int i = 0; i < inputs.size() && i < expecteds.size(); ++i)
+    {
+        addFile(filePath(task->rules.front(), sourcePath, i), inputs[i]);
+        addFile(filePath(task->rules.back(), sourcePath, i), expecteds[i]);
+    }
+
+    // forget the files to be removed, and the files of other rules, they are written again if they are needed
+    for (auto it = hashes.begin(); it != hashes.end();)
+    {
+        if (task->keptPaths.contains(it.key()))
+            ++it;
+        else
+            it = hashes.erase(it);
+    }
+
+    LOG_INFO(INFO_OF(sourcePath) << INFO_OF(inputs.size()) << INFO_OF(task->writes.size()));
+
+    QPointer<TestCaseFiles> guard(this);
+    task->finished = [guard](const QStringList &failedPaths) {
+        if (failedPaths.isEmpty())
+            return;
+        QMetaObject::invokeMethod(
+            QCoreApplication::instance(),
+            [guard, failedPaths] {
+                if (guard)
+                    guard->onSaveFinished(failedPaths);
+            },
+            Qt::QueuedConnection);
+    };
+
+    savingThreadPool()->start(task);
+}
+
+QMap<int, QString> TestCaseFiles::savedFiles(const QString &rule, const QString &sourcePath)
+{
+    QMap<int, QString> files;
+    const auto pattern = filePattern(rule, sourcePath);
+
+    if (!pattern.isValid)
+    {
+        for (int i = 0, missing = 0; missing < MAX_PROBED_GAP; ++i)
+        {
+            const auto path = filePath(rule, sourcePath, i);
+            if (QFile::exists(path))
+            {
+                files[i] = path;
+                missing = 0;
+            }
+            else
+            {
+                ++missing;
+            }
+        }
+        return files;
+    }
+
+    QDirIterator it(pattern.directory, QDir::Files | QDir::Hidden);
+    while (it.hasNext())
+    {
+        const auto path = QDir::cleanPath(it.next());
+        const auto match = pattern.fileName.match(it.fileName());
+        if (!match.hasMatch())
+            continue;
+        const int index = match.captured(1).toInt() - pattern.offset;
+        // skip the names not generated by the rule, e.g. the numbers with leading zeros
+        if (index >= 0 && filePath(rule, sourcePath, index) == path)
+            files[index] = path;
+    }
+    return files;
+}
+
+QString TestCaseFiles::filePath(const QString &rule, const QString &sourcePath, int index)
+{
+    return QDir::cleanPath(applyNames(rule, sourcePath)
+                               .replace("${0-index}", QString::number(index))
+                               .replace("${1-index}", QString::number(index + 1)));
+}
+
+void TestCaseFiles::onSaveFinished(const QStringList &failedPaths)
+{
+    for (auto const &path : failedPaths)
+    {
+        // write it again in the next save
+        hashes.remove(path);
+        log->error(tr("Save Test Cases"), tr("Failed to save to [%1]. Do I have write permission?").arg(path));
+        LOG_ERR("Failed to save to [" << path << "]");
+    }
+}
+} // namespace Core
@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2019-2021 Ashar Khan <ashar786khan@gmail.com>
+ *
+ * This file is part of CP Editor.
+ *
+ * CP Editor is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * I will not be responsible if CP Editor behaves in unexpected way and
+ * causes your ratings to go down and or lose any important contest.
+ *
+ * Believe Software is "Software" and it isn't immune to bugs.
+ *
+ */
+
+/*
+ * The files where the test cases of a source file are saved, named by the "Input File Save Path" and the
+ * "Answer File Save Path" settings.
+ * The hash of the content of each saved file is remembered, so a save only writes the test cases changed since the
+ * last load or save. The files are written and removed in a background thread, one save after another.
+ * The saved files are found by listing the directory once, instead of checking whether each index exists.
+ */
+
+#ifndef TESTCASEFILES_HPP
+#define TESTCASEFILES_HPP
+
+#include "Core/TestData.hpp"
+#include <QHash>
+#include <QMap>
+#include <QObject>
+
+class MessageLogger;
+
+namespace Core
+{
+class TestCaseFiles : public QObject
+{
+    Q_OBJECT
+
+  public:
+    explicit TestCaseFiles(MessageLogger *logger, QObject *parent = nullptr);
+
+    /**
+     * @brief load the test cases saved for a source file
+     * @param sourcePath the path to the source file
+     * @param inputs the loaded inputs
+     * @param expecteds the loaded expected outputs, it has the same size as inputs
+     * @note The indices are kept, so the test cases without files before a saved one are empty.
+     */
+    void load(const QString &sourcePath, QList<TestData> &inputs, QList<TestData> &expecteds);
+
+    /**
+     * @brief save the test cases of a source file in the background
+     * @param sourcePath the path to the source file
+     * @param inputs the inputs of all test cases
+     * @param expecteds the expected outputs of all test cases, it should have the same size as inputs
+     * @param safe whether to write the files safely, see Util::saveFile
+     * @note The saved files of empty test cases and of the indices after the last test case are removed.
+     */
+    void save(const QString &sourcePath, const QList<TestData> &inputs, const QList<TestData> &expecteds, bool safe);
+
+    /**
+     * @brief find the files saved by a save path rule
+     * @param rule the value of "Input File Save Path" or "Answer File Save Path"
+     * @param sourcePath the path to the source file
+     * @returns the paths to the saved files, keyed by the indices of the test cases
+     */
+    static QMap<int, QString> savedFiles(const QString &rule, const QString &sourcePath);
+
+    /**
+     * @returns the path to the file of the test case at the given index, by a save path rule
+     */
+    static QString filePath(const QString &rule, const QString &sourcePath, int index);
+
+  private:
+    void onSaveFinished(const QStringList &failedPaths);
+
+    MessageLogger *log;
+    QString sourcePath;             // the source file of the hashes
+    QHash<QString, QString> hashes; // the hashes of the contents of the saved files, keyed by the paths
+};
+} // namespace Core
+
+#endif // TESTCASEFILES_HPP
@@ -28,8 +28,8 @@ void TestCasesCopyPaster::copy(Widgets::TestCases *testcases)
     {
         if (testcases->isChecked(i))
         {
-            inputs.append(testcases->input(i));
-            expecteds.append(testcases->expected(i));
+            inputs.append(testcases->inputData(i));
+            expecteds.append(testcases->expectedData(i));
         }
     }
 }
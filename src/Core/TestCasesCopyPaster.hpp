@@ -18,8 +18,9 @@
 #ifndef TESTCASESCOPYPASTER_HPP
 #define TESTCASESCOPYPASTER_HPP
 
+#include "Core/TestData.hpp"
 #include "Util/Singleton.hpp"
-#include <QStringList>
+#include <QList>
 
 namespace Widgets
 {
@@ -42,7 +43,7 @@ class TestCasesCopyPaster : public Util::Singleton<TestCasesCopyPaster>
     void paste(Widgets::TestCases *testcases) const;
 
   private:
-    QStringList inputs, expecteds;
+    QList<Core::TestData> inputs, expecteds;
 };
 
 #endif // TESTCASESCOPYPASTER_HPP
@@ -0,0 +1,359 @@
+/*
+ * Copyright (C) 2019-2021 Ashar Khan <ashar786khan@gmail.com>
+ *
+ * This file is part of CP Editor.
+ *
+ * CP Editor is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * I will not be responsible if CP Editor behaves in unexpected way and
+ * causes your ratings to go down and or lose any important contest.
+ *
+ * Believe Software is "Software" and it isn't immune to bugs.
+ *
+ */
+
+#include "Core/TestCasesImporter.hpp"
+#include "Core/EventLogger.hpp"
+#include "Util/ArchiveReader.hpp"
+#include <QCollator>
+#include <QDir>
+#include <QFileInfo>
+#include <QHash>
+#include <QRegularExpression>
+#include <QThread>
+#include <QTimer>
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+namespace Core
+{
+namespace
+{
+// the progress is polled by the GUI thread, instead of sending a signal for each chunk
+const int PROGRESS_INTERVAL = 100;
+
+const qint64 READ_CHUNK_SIZE = 1 << 16;
+
+// at most this number of unmatched files are listed in the warning
+const int MAX_LISTED_UNMATCHED_FILES = 10;
+
+// in the tests directory of a Polygon package, the answer of the test "01" is "01.a"
+const QStringList POLYGON_RULE = {R"((\d+))", R"(\1.a)"};
+
+const QStringList ARCHIVE_SUFFIXES = {"zip", "tar"};
+
+struct Item
+{
+    QString directory;  // the directory on the disk or in an archive, files are paired only in the same directory
+    QString name;       // the file name
+    QString path;       // the path on the disk, or the path in the archive
+    int archive = -1;   // the index of the archive, or -1 if it's on the disk
+    qint64 size = 0;    // the size in bytes
+    Util::ArchiveReader::Entry entry;
+
+    QString key() const
+    {
+        return directory + '/' + name;
+    }
+};
+} // namespace
+
+struct TestCasesImporter::State
+{
+    QStringList paths;
+    QVariantList rules;
+
+    std::atomic_bool canceled{false};
+    std::atomic<int> progress{0};
+
+    // the results, they are read by the GUI thread after the worker thread finishes
+    QList<TestData> inputs;
+    QList<TestData> expecteds;
+    QStringList unmatchedFiles;
+    int unmatchedCount = 0;
+    QString error;
+};
+
+TestCasesImporter::TestCasesImporter(const QStringList &paths, const QVariantList &rules, QObject *parent)
+    : QObject(parent), state(std::make_shared<State>())
+{
+    state->paths = paths;
+    state->rules = rules;
+}
+
+TestCasesImporter::~TestCasesImporter()
+{
+    // the worker thread stops soon, and it deletes itself
+    cancel();
+}
+
+void TestCasesImporter::start()
+{
+    LOG_INFO(INFO_OF(state->paths.join(", ")));
+
+    progressTimer = new QTimer(this);
+    progressTimer->setInterval(PROGRESS_INTERVAL);
+    connect(progressTimer, &QTimer::timeout, this, [this] { emit progressChanged(state->progress); });
+    progressTimer->start();
+
+    auto currentState = state;
+    auto *thread = QThread::create([currentState] { run(*currentState); });
+    connect(thread, &QThread::finished, this, [this] {
+        progressTimer->stop();
+        LOG_INFO(INFO_OF(state->inputs.size()) << INFO_OF(state->unmatchedCount) << INFO_OF(state->error)
+                                               << INFO_OF(isCanceled()));
+        emit finished();
+    });
+    connect(thread, &QThread::finished, thread, &QObject::deleteLater);
+    thread->start(QThread::LowPriority);
+}
+
+void TestCasesImporter::cancel()
+{
+    state->canceled = true;
+}
+
+bool TestCasesImporter::isCanceled() const
+{
+    return state->canceled;
+}
+
+QList<TestData> TestCasesImporter::inputs() const
+{
+    return state->inputs;
+}
+
+QList<TestData> TestCasesImporter::expecteds() const
+{
+    return state->expecteds;
+}
+
+QStringList TestCasesImporter::unmatchedFiles() const
+{
+    return state->unmatchedFiles;
+}
+
+int TestCasesImporter::unmatchedCount() const
+{
+    return state->unmatchedCount;
+}
+
+QString TestCasesImporter::errorString() const
+{
+    return state->error;
+}
+
+void TestCasesImporter::run(State &state)
+{
+    // list the files, the contents are not read until they are matched
+
+    std::vector<std::unique_ptr<Util::ArchiveReader>> archives;
+    QStringList archivePaths;
+    std::vector<Item> items;
+
+    for (auto const &path : state.paths)
+    {
+        const QFileInfo info(path);
+        if (info.isDir())
+        {
+            QDir dir(path);
+            if (dir.exists("tests"))
+                dir.cd("tests");
+            for (auto const &file : dir.entryInfoList(QDir::Files | QDir::Hidden))
+            {
+                Item item;
+                item.directory = file.absolutePath();
+                item.name = file.fileName();
+                item.path = file.absoluteFilePath();
+                item.size = file.size();
+                items.push_back(item);
+            }
+            continue;
+        }
+
+        if (ARCHIVE_SUFFIXES.contains(info.suffix(), Qt::CaseInsensitive))
+        {
+            std::unique_ptr<Util::ArchiveReader> reader(new Util::ArchiveReader(path));
+            if (!reader->open())
+            {
+                state.error = reader->errorString();
+                return;
+            }
+            const int archive = int(archives.size());
+            for (auto const &entry : reader->entries())
+            {
+                Item item;
+                const int slash = entry.path.lastIndexOf('/');
+                // archives are told apart by their indices, so the same directory in two archives are different
+                item.directory = QString("%1:%2").arg(archive).arg(entry.path.left(qMax(slash, 0)));
+                item.name = entry.path.mid(slash + 1);
+                item.path = entry.path;
+                item.archive = archive;
+                item.size = entry.size;
+                item.entry = entry;
+                items.push_back(item);
+            }
+            archives.push_back(std::move(reader));
+            archivePaths.push_back(path);
+            continue;
+        }
+
+        Item item;
+        item.directory = info.absolutePath();
+        item.name = info.fileName();
+        item.path = info.absoluteFilePath();
+        item.size = info.size();
+        items.push_back(item);
+    }
+
+    // sort the files like "2" < "10", so the test cases are added in the natural order
+
+    QCollator collator;
+    collator.setNumericMode(true);
+    std::stable_sort(items.begin(), items.end(),
+                     [&collator](const Item &a, const Item &b) { return collator.compare(a.key(), b.key()) < 0; });
+
+    QHash<QString, int> indexOfKey;
+    for (int i = 0; i < int(items.size()); ++i)
+        indexOfKey[items[i].key()] = i;
+
+    // pair the files by the rules, then add the remaining inputs without answers
+
+    QList<QPair<QRegularExpression, QString>> rules;
+    for (auto const &rule : state.rules)
+    {
+        const auto list = rule.toStringList();
+        if (list.size() == 2)
+            rules.push_back({QRegularExpression("^" + list.front() + "$"), list.back()});
+    }
+    rules.push_back({QRegularExpression("^" + POLYGON_RULE.front() + "$"), POLYGON_RULE.back()});
+
+    std::vector<bool> used(items.size(), false);
+    std::vector<std::pair<int, int>> pairs; // the indices of the input and the answer, -1 if there's no answer
+
+    for (auto const &rule : rules)
+    {
+        for (int i = 0; i < int(items.size()); ++i)
+        {
+            if (used[i] || !rule.first.match(items[i].name).hasMatch())
+                continue;
+            auto answerName = items[i].name;
+            answerName.replace(rule.first, rule.second);
+            const int j = indexOfKey.value(items[i].directory + '/' + answerName, -1);
+            if (j == -1 || j == i || used[j])
+                continue;
+            used[i] = used[j] = true;
+            pairs.push_back({i, j});
+        }
+    }
+
+    for (auto const &rule : rules)
+    {
+        for (int i = 0; i < int(items.size()); ++i)
+        {
+            if (!used[i] && rule.first.match(items[i].name).hasMatch())
+            {
+                used[i] = true;
+                pairs.push_back({i, -1});
+            }
+        }
+    }
+
+    std::sort(pairs.begin(), pairs.end());
+
+    for (int i = 0; i < int(items.size()); ++i)
+    {
+        if (used[i])
+            continue;
+        if (state.unmatchedCount++ < MAX_LISTED_UNMATCHED_FILES)
+        {
+            const auto &item = items[i];
+            state.unmatchedFiles.push_back(item.archive == -1 ? item.path
+                                                              : archivePaths[item.archive] + '/' + item.path);
+        }
+    }
+
+    // read the matched files
+
+    qint64 totalSize = 0;
+    qint64 doneSize = 0;
+    for (auto const &pair : pairs)
+        totalSize += items[pair.first].size + (pair.second == -1 ? 0 : items[pair.second].size);
+
+    auto extract = [&](const Item &item) {
+        TestData::Builder builder;
+        bool writeFailed = false;
+        auto sink = [&](const char *data, qint64 size) {
+            if (state.canceled)
+                return false;
+            if (!builder.append(data, size))
+            {
+                writeFailed = true;
+                return false;
+            }
+            doneSize += size;
+            state.progress = totalSize == 0 ? 100 : int(doneSize * 100 / totalSize);
+            return true;
+        };
+
+        bool success = true;
+        if (item.archive != -1)
+        {
+            success = archives[item.archive]->extract(item.entry, sink);
+            if (!success && !writeFailed)
+                state.error = archives[item.archive]->errorString();
+        }
+        else
+        {
+            QFile file(item.path);
+            if (!file.open(QIODevice::ReadOnly))
+            {
+                state.error = tr("Failed to open [%1]: %2").arg(item.path).arg(file.errorString());
+                return TestData();
+            }
+            QByteArray chunk(READ_CHUNK_SIZE, Qt::Uninitialized);
+            while (success && !file.atEnd())
+            {
+                const auto size = file.read(chunk.data(), chunk.size());
+                if (size < 0)
+                {
+                    state.error = tr("Failed to read [%1]: %2").arg(item.path).arg(file.errorString());
+                    return TestData();
+                }
+                success = sink(chunk.constData(), size);
+            }
+        }
+
+        if (!success || state.canceled)
+        {
+            if (writeFailed)
+                state.error = tr("Failed to store the test case [%1] in the data directory").arg(item.name);
+            return TestData();
+        }
+        auto data = builder.finish();
+        if (data.isNull())
+            state.error = tr("Failed to store the test case [%1] in the data directory").arg(item.name);
+        return data;
+    };
+
+    for (auto const &pair : pairs)
+    {
+        const auto input = extract(items[pair.first]);
+        const auto expected = pair.second == -1 ? TestData(QString()) : extract(items[pair.second]);
+        if (input.isNull() || expected.isNull())
+        {
+            // a half-imported archive is hard to deal with, so either all of the test cases are imported or none
+            state.inputs.clear();
+            state.expecteds.clear();
+            return;
+        }
+        state.inputs.push_back(input);
+        state.expecteds.push_back(expected);
+    }
+    state.progress = 100;
+}
+} // namespace Core
@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2019-2021 Ashar Khan <ashar786khan@gmail.com>
+ *
+ * This file is part of CP Editor.
+ *
+ * CP Editor is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * I will not be responsible if CP Editor behaves in unexpected way and
+ * causes your ratings to go down and or lose any important contest.
+ *
+ * Believe Software is "Software" and it isn't immune to bugs.
+ *
+ */
+
+/*
+ * Imports test cases from files, zip or tar archives, and directories such as Polygon packages.
+ * The files are paired by their names with the "Testcases Matching Rules", and "NN" is paired with "NN.a" as in the
+ * tests directories of Polygon packages. Only the paired files are read, in a worker thread, and large ones are
+ * stored by Core::TestData in files instead of memory.
+ */
+
+#ifndef TESTCASESIMPORTER_HPP
+#define TESTCASESIMPORTER_HPP
+
+#include "Core/TestData.hpp"
+#include <QObject>
+#include <QVariantList>
+#include <memory>
+
+class QTimer;
+
+namespace Core
+{
+class TestCasesImporter : public QObject
+{
+    Q_OBJECT
+
+  public:
+    /**
+     * @param paths the files, archives and directories to import, only the "tests" subdirectory of a directory is
+     *        imported if it exists
+     * @param rules the matching rules, in the format of the "Testcases Matching Rules" setting
+     */
+    explicit TestCasesImporter(const QStringList &paths, const QVariantList &rules, QObject *parent = nullptr);
+    ~TestCasesImporter() override;
+
+    /**
+     * @brief start importing in a worker thread, finished() is emitted when it's done
+     */
+    void start();
+
+    /**
+     * @brief stop importing, finished() is still emitted, with no test cases imported
+     */
+    void cancel();
+
+    bool isCanceled() const;
+
+    /**
+     * @returns the imported inputs, ordered by the names of the files
+     */
+    QList<TestData> inputs() const;
+
+    /**
+     * @returns the imported expected outputs, empty for the inputs without answers
+     */
+    QList<TestData> expecteds() const;
+
+    /**
+     * @returns the files that are not matched by any rule, at most a few of them are kept
+     */
+    QStringList unmatchedFiles() const;
+
+    /**
+     * @returns the number of the files that are not matched by any rule
+     */
+    int unmatchedCount() const;
+
+    /**
+     * @returns the error if it fails, or an empty string if it succeeds
+     */
+    QString errorString() const;
+
+  signals:
+    /**
+     * @param percent the percentage of the bytes extracted
+     */
+    void progressChanged(int percent);
+
+    void finished();
+
+  private:
+    struct State;
+
+    static void run(State &state);
+
+    std::shared_ptr<State> state; // shared with the worker thread, which may outlive this object if it's canceled
+    QTimer *progressTimer = nullptr;
+};
+} // namespace Core
+
+#endif // TESTCASESIMPORTER_HPP
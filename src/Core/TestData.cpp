@@ -0,0 +1,566 @@
+/*
+ * Copyright (C) 2019-2021 Ashar Khan <ashar786khan@gmail.com>
+ *
+ * This file is part of CP Editor.
+ *
+ * CP Editor is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * I will not be responsible if CP Editor behaves in unexpected way and
+ * causes your ratings to go down and or lose any important contest.
+ *
+ * Believe Software is "Software" and it isn't immune to bugs.
+ *
+ */
+
+#include "Core/TestData.hpp"
+#include "Core/EventLogger.hpp"
+#include "Core/MessageLogger.hpp"
+#include "Util/FileUtil.hpp"
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QTemporaryFile>
+#include <limits>
+#include <mutex>
+
+namespace Core
+{
+namespace
+{
+const qint64 MAP_THRESHOLD = 1 << 20; // data larger than this number of bytes is stored in a file
+const int MAX_UNUSED_DAYS = 30;      // the unreferenced files not used for this number of days are removed
+// the mapped data is passed to QByteArray and QString, whose sizes are int, so larger data is rejected
+const qint64 MAX_SIZE = std::numeric_limits<int>::max();
+const qint64 HASH_CHUNK_SIZE = 1 << 24;
+
+// the bytes of a UTF-8 character except the first one are 10xxxxxx
+inline bool isContinuationByte(char c)
+{
+    return (uchar(c) & 0xC0) == 0x80;
+}
+
+inline bool isBlankByte(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+}
+
+// the size is at most MAX_SIZE, since larger data is never mapped
+QString decode(const char *data, qint64 size)
+{
+    return QString::fromUtf8(data, int(size)).replace("\r\n", "\n");
+}
+
+// QCryptographicHash::addData() takes an int size, so large data is hashed in chunks
+void addData(QCryptographicHash &hash, const char *data, qint64 size)
+{
+    for (qint64 pos = 0; pos < size; pos += HASH_CHUNK_SIZE)
+        hash.addData(data + pos, int(qMin(HASH_CHUNK_SIZE, size - pos)));
+}
+} // namespace
+
+struct TestData::MappedFile
+{
+    QString hash;
+    QFile file;
+    const char *data = nullptr;
+    qint64 size = 0;
+
+    ~MappedFile()
+    {
+        if (data != nullptr)
+            file.unmap(reinterpret_cast<uchar *>(const_cast<char *>(data)));
+    }
+};
+
+// the hash of an inline text, computed once even if the copies are hashed in different threads
+struct TestData::TextHash
+{
+    std::once_flag once;
+    QString value;
+};
+
+// the files that are mapped now, so that each file is mapped only once
+struct TestData::Registry
+{
+    QMutex mutex;
+    QHash<QString, std::weak_ptr<const MappedFile>> files;
+};
+
+TestData::Builder::Builder() : hash(QCryptographicHash::Sha1)
+{
+}
+
+TestData::Builder::~Builder() = default;
+
+bool TestData::Builder::append(const char *data, qint64 size)
+{
+    if (failed)
+        return false;
+
+    if ((file ? file->size() : buffer.size()) + size > MAX_SIZE)
+    {
+        LOG_ERR("The test data is too large " << INFO_OF(size) << INFO_OF(MAX_SIZE));
+        failed = true;
+        return false;
+    }
+
+    addData(hash, data, size);
+
+    if (!file && buffer.size() + size < MAP_THRESHOLD)
+    {
+        buffer.append(data, int(size));
+        return true;
+    }
+
+    if (!file)
+    {
+        QDir().mkpath(storageDirectory());
+        file.reset(new QTemporaryFile(QDir(storageDirectory()).filePath("building-XXXXXX")));
+        failed = !file->open() || file->write(buffer) != buffer.size();
+        buffer.clear();
+    }
+    failed = failed || file->write(data, size) != size;
+    return !failed;
+}
+
+TestData TestData::Builder::finish()
+{
+    if (failed)
+        return TestData();
+    if (!file)
+        return TestData(decode(buffer.constData(), buffer.size()));
+
+    const QString hex = hash.result().toHex();
+    {
+        auto &reg = registry();
+        QMutexLocker locker(&reg.mutex);
+        const auto path = QDir(storageDirectory()).filePath(hex);
+        // the temporary file is removed if the same data is already stored
+        if (!QFile::exists(path))
+        {
+            if (!file->rename(path))
+                return TestData();
+            file->setAutoRemove(false);
+        }
+    }
+    file.reset();
+
+    TestData result;
+    result.file = mapStoredFile(hex, nullptr);
+    return result.file ? result : TestData();
+}
+
+TestData::TestData(const QString &text) : text(text), textHash(std::make_shared<TextHash>())
+{
+}
+
+TestData TestData::fromString(const QString &text)
+{
+    if (text.size() * qint64(sizeof(QChar)) < MAP_THRESHOLD)
+        return TestData(text);
+
+    const auto utf8 = text.toUtf8();
+    const auto hash = storeFile(utf8.constData(), utf8.size(), nullptr);
+    TestData result;
+    if (!hash.isEmpty())
+        result.file = mapStoredFile(hash, nullptr);
+    if (!result.file)
+        return TestData(text); // keep it inline if it can't be stored
+    return result;
+}
+
+TestData TestData::fromFile(const QString &path, const QString &head, MessageLogger *log, bool notExistWarning)
+{
+    const QFileInfo info(path);
+    if (!info.exists() || info.size() < MAP_THRESHOLD)
+        return TestData(Util::readFile(path, head, log, notExistWarning));
+
+    if (info.size() > MAX_SIZE)
+    {
+        if (log != nullptr)
+            log->error(head,
+                       QCoreApplication::translate("Core::TestData", "[%1] is larger than 2 GiB, it can't be loaded.")
+                           .arg(path));
+        LOG_ERR("The test case is too large " << INFO_OF(path) << INFO_OF(info.size()));
+        return TestData();
+    }
+
+    LOG_INFO("Storing a large test case " << INFO_OF(path) << INFO_OF(info.size()));
+
+    // files in the data directory are already named by their hashes
+    if (info.absolutePath() == QDir(storageDirectory()).absolutePath())
+    {
+        TestData result;
+        result.file = mapStoredFile(info.fileName(), log);
+        return result.file ? result : TestData();
+    }
+
+    QFile source(path);
+    if (!source.open(QIODevice::ReadOnly))
+    {
+        if (log != nullptr)
+            log->error(head, QCoreApplication::translate("Core::TestData",
+                                                         "Failed to open [%1]. Do I have read permission?")
+                                 .arg(path));
+        LOG_ERR(QString("Failed to open [%1]").arg(path));
+        return TestData();
+    }
+
+    auto *data = source.map(0, source.size());
+    if (data == nullptr)
+    {
+        LOG_WARN("Failed to map " << INFO_OF(path) << ", reading it instead");
+        return TestData(Util::readFile(path, head, log, notExistWarning));
+    }
+    const auto hash = storeFile(reinterpret_cast<const char *>(data), source.size(), log);
+    source.unmap(data);
+
+    TestData result;
+    if (!hash.isEmpty())
+        result.file = mapStoredFile(hash, log);
+    return result.file ? result : TestData();
+}
+
+bool TestData::isNull() const
+{
+    return !file && text.isNull();
+}
+
+bool TestData::isEmpty() const
+{
+    return size() == 0;
+}
+
+bool TestData::isBlank() const
+{
+    if (!file)
+        return text.trimmed().isEmpty();
+    for (qint64 i = 0; i < file->size; ++i)
+    {
+        if (!isBlankByte(file->data[i]))
+            return false;
+    }
+    return true;
+}
+
+bool TestData::isMapped() const
+{
+    return file != nullptr;
+}
+
+qint64 TestData::size() const
+{
+    return file ? file->size : text.size();
+}
+
+QString TestData::filePath() const
+{
+    return file ? file->file.fileName() : QString();
+}
+
+QString TestData::hash() const
+{
+    if (file)
+        return file->hash;
+    auto compute = [this] {
+        return QString(QCryptographicHash::hash(text.toUtf8(), QCryptographicHash::Sha1).toHex());
+    };
+    if (!textHash)
+        return compute();
+    std::call_once(textHash->once, [this, &compute] { textHash->value = compute(); });
+    return textHash->value;
+}
+
+QString TestData::toString() const
+{
+    return file ? decode(file->data, file->size) : text;
+}
+
+QByteArray TestData::toUtf8() const
+{
+    return file ? QByteArray::fromRawData(file->data, int(file->size)) : text.toUtf8();
+}
+
+int TestData::pageCount(int pageSize) const
+{
+    if (pageSize <= 0)
+        return 1;
+    return int(qMax(qint64(1), (size() + pageSize - 1) / pageSize));
+}
+
+QString TestData::page(int index, int pageSize) const
+{
+    if (!file)
+        return text.mid(index * pageSize, pageSize);
+
+    // move the boundaries to the start of characters
+    auto boundary = [this](qint64 pos) {
+        pos = qMin(pos, file->size);
+        while (pos < file->size && isContinuationByte(file->data[pos]))
+            ++pos;
+        return pos;
+    };
+    const auto start = boundary(qint64(index) * pageSize);
+    const auto end = boundary(start + pageSize);
+    return decode(file->data + start, end - start);
+}
+
+int TestData::findInPages(int line, int column, int pageSize, int *pageLine, int *pageColumn) const
+{
+    // the offsets are in characters for inline data and in bytes for mapped data, the same as the pages
+    const qint64 length = size();
+    auto at = [this](qint64 i) { return file ? ushort(uchar(file->data[i])) : text[int(i)].unicode(); };
+
+    qint64 lineStart = 0;
+    for (int current = 0; current < line && lineStart < length; ++lineStart)
+    {
+        if (at(lineStart) == '\n')
+            ++current;
+    }
+
+    qint64 offset = lineStart;
+    for (int current = 0; current < column && offset < length && at(offset) != '\n'; ++current)
+    {
+        if (!file)
+        {
+            ++offset;
+            continue;
+        }
+        // a UTF-8 character of four bytes is a surrogate pair of two QChars
+        const uchar lead = uchar(file->data[offset]);
+        const int bytes = lead >= 0xF0 ? 4 : (lead >= 0xE0 ? 3 : (lead >= 0xC0 ? 2 : 1));
+        if (bytes == 4)
+            ++current;
+        offset = qMin(offset + bytes, length);
+    }
+
+    if (pageSize <= 0)
+    {
+        *pageLine = line;
+        *pageColumn = column;
+        return 0;
+    }
+
+    const int index = int(qMin(offset / pageSize, qint64(pageCount(pageSize) - 1)));
+    qint64 pageStart = qint64(index) * pageSize;
+    if (file)
+    {
+        while (pageStart < length && isContinuationByte(file->data[pageStart]))
+            ++pageStart;
+    }
+
+    if (lineStart >= pageStart)
+    {
+        *pageLine = 0;
+        for (qint64 i = pageStart; i < lineStart; ++i)
+        {
+            if (at(i) == '\n')
+                ++*pageLine;
+        }
+        *pageColumn = column;
+    }
+    else
+    {
+        // the line starts in a previous page
+        *pageLine = 0;
+        *pageColumn = file ? decode(file->data + pageStart, offset - pageStart).size() : int(offset - pageStart);
+    }
+    return index;
+}
+
+int TestData::lineCount(int maxLines) const
+{
+    int lines = 1;
+    const qint64 length = size();
+    for (qint64 i = 0; i < length && lines < maxLines; ++i)
+    {
+        if ((file ? file->data[i] : text[int(i)].unicode()) == '\n')
+            ++lines;
+    }
+    return lines;
+}
+
+bool TestData::save(const QString &path, const QString &head, bool safe, MessageLogger *log,
+                    bool createDirectory) const
+{
+    if (!file)
+        return Util::saveFile(path, text, head, safe, log, createDirectory);
+
+    if (createDirectory)
+    {
+        auto dirPath = QFileInfo(path).absolutePath();
+        LOG_ERR_IF(!QDir().mkpath(dirPath), QString("Failed to create the directory [%1]").arg(dirPath));
+    }
+
+    bool ok = false;
+    if (safe)
+    {
+        QSaveFile target(path);
+        ok = target.open(QIODevice::WriteOnly) && target.write(file->data, file->size) == file->size &&
+             target.commit();
+    }
+    else
+    {
+        QFile target(path);
+        ok = target.open(QIODevice::WriteOnly) && target.write(file->data, file->size) == file->size;
+    }
+
+    if (!ok)
+    {
+        if (log != nullptr)
+            log->error(head, QCoreApplication::translate("Core::TestData",
+                                                         "Failed to save to [%1]. Do I have write permission?")
+                                 .arg(path));
+        LOG_ERR("Failed to save to [" << path << "]");
+        return false;
+    }
+    return true;
+}
+
+bool TestData::operator==(const TestData &other) const
+{
+    if (file && other.file)
+        return file->hash == other.file->hash;
+    if (!file && !other.file)
+        return text == other.text;
+    return false;
+}
+
+bool TestData::operator!=(const TestData &other) const
+{
+    return !(*this == other);
+}
+
+TestData::Registry &TestData::registry()
+{
+    static Registry instance;
+    return instance;
+}
+
+std::shared_ptr<const TestData::MappedFile> TestData::mapStoredFile(const QString &hash, MessageLogger *log)
+{
+    auto &reg = registry();
+    QMutexLocker locker(&reg.mutex);
+
+    if (auto existing = reg.files.value(hash).lock())
+        return existing;
+
+    auto mapped = std::make_shared<MappedFile>();
+    mapped->hash = hash;
+    mapped->file.setFileName(QDir(storageDirectory()).filePath(hash));
+    if (!mapped->file.open(QIODevice::ReadOnly))
+    {
+        if (log != nullptr)
+            log->error(QCoreApplication::translate("Core::TestData", "Test Data"),
+                       QCoreApplication::translate("Core::TestData", "Failed to open the stored test data [%1].")
+                           .arg(mapped->file.fileName()));
+        LOG_ERR("Failed to open " << mapped->file.fileName());
+        return nullptr;
+    }
+    mapped->size = mapped->file.size();
+    if (mapped->size > MAX_SIZE)
+    {
+        LOG_ERR("The stored test data is too large " << INFO_OF(mapped->file.fileName()) << INFO_OF(mapped->size));
+        return nullptr;
+    }
+    mapped->data = reinterpret_cast<const char *>(mapped->file.map(0, mapped->size));
+    if (mapped->data == nullptr)
+    {
+        LOG_ERR("Failed to map " << mapped->file.fileName() << ": " << mapped->file.errorString());
+        return nullptr;
+    }
+
+    // the modification time is used as the last used time when removing the unreferenced files
+    // it's set through another handle, since setting the time needs write access on Windows
+    QFile touched(mapped->file.fileName());
+    if (!touched.open(QIODevice::Append) ||
+        !touched.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime))
+    {
+        LOG_WARN("Failed to update the modification time of " << touched.fileName() << ": " << touched.errorString());
+    }
+
+    reg.files.insert(hash, mapped);
+    return mapped;
+}
+
+QString TestData::storeFile(const char *data, qint64 size, MessageLogger *log)
+{
+    if (size > MAX_SIZE)
+    {
+        LOG_ERR("The test data is too large to be stored " << INFO_OF(size));
+        return QString();
+    }
+
+    QCryptographicHash hasher(QCryptographicHash::Sha1);
+    addData(hasher, data, size);
+    const QString hash = hasher.result().toHex();
+    const QString directory = storageDirectory();
+    const QString path = QDir(directory).filePath(hash);
+
+    auto &reg = registry();
+    QMutexLocker locker(&reg.mutex);
+
+    if (QFile::exists(path))
+        return hash;
+
+    QSaveFile target(path);
+    if (!QDir().mkpath(directory) || !target.open(QIODevice::WriteOnly) || target.write(data, size) != size ||
+        !target.commit())
+    {
+        if (log != nullptr)
+            log->error(QCoreApplication::translate("Core::TestData", "Test Data"),
+                       QCoreApplication::translate("Core::TestData", "Failed to store the test data to [%1].")
+                           .arg(path));
+        LOG_ERR("Failed to store test data to " << path);
+        return QString();
+    }
+    return hash;
+}
+
+void TestData::removeUnreferenced(const QSet<QString> &referencedPaths)
+{
+    const QDir directory(storageDirectory());
+
+    QSet<QString> referenced;
+    for (auto const &path : referencedPaths)
+    {
+        const QFileInfo info(path);
+        if (QDir(info.absolutePath()) == directory)
+            referenced.insert(info.fileName());
+    }
+
+    auto &reg = registry();
+    QMutexLocker locker(&reg.mutex);
+
+    const auto expired = QDateTime::currentDateTime().addDays(-MAX_UNUSED_DAYS);
+    int removed = 0;
+    QDirIterator it(directory.path(), QDir::Files);
+    while (it.hasNext())
+    {
+        it.next();
+        if (referenced.contains(it.fileName()) || reg.files.value(it.fileName()).lock() ||
+            it.fileInfo().lastModified() >= expired)
+            continue;
+        if (QFile::remove(it.filePath()))
+            ++removed;
+    }
+
+    LOG_INFO(INFO_OF(referenced.size()) << INFO_OF(removed));
+}
+
+QString TestData::storageDirectory()
+{
+    return QDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)).filePath("testdata");
+}
+} // namespace Core
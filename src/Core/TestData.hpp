@@ -0,0 +1,195 @@
+/*
+ * Copyright (C) 2019-2021 Ashar Khan <ashar786khan@gmail.com>
+ *
+ * This file is part of CP Editor.
+ *
+ * CP Editor is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * I will not be responsible if CP Editor behaves in unexpected way and
+ * causes your ratings to go down and or lose any important contest.
+ *
+ * Believe Software is "Software" and it isn't immune to bugs.
+ *
+ */
+
+/*
+ * The data of a test case, i.e. an input or an expected output.
+ * Small data is kept inline in a QString. Large data is stored in a file in the data directory, named by the hash of
+ * its content, and the file is memory-mapped read-only. So a large test takes no memory until it's read, the same
+ * data is stored only once, and it can be passed to other processes by the path of the file.
+ * The saved session refers to the stored files, so they are kept in the persistent data directory instead of the cache,
+ * and only the files not referenced by the session are removed, see removeUnreferenced().
+ * TestData is implicitly shared, copying it is cheap. The hash of inline data is computed once and shared by the
+ * copies, so an unchanged test case is not hashed again.
+ */
+
+#ifndef TESTDATA_HPP
+#define TESTDATA_HPP
+
+#include <QCryptographicHash>
+#include <QSet>
+#include <QString>
+#include <memory>
+
+class MessageLogger;
+class QTemporaryFile;
+
+namespace Core
+{
+class TestData
+{
+  public:
+    /**
+     * Builds a test data from chunks, e.g. when it's extracted from an archive.
+     * Once the data becomes large, the chunks are written to the data directory as they come, so the whole data is
+     * never held in memory. It doesn't show messages, so it can be used in worker threads.
+     */
+    class Builder
+    {
+      public:
+        Builder();
+        ~Builder();
+
+        /**
+         * @returns whether the chunk is written successfully
+         */
+        bool append(const char *data, qint64 size);
+
+        /**
+         * @returns the built test data, or a null test data if it fails to be stored
+         */
+        TestData finish();
+
+      private:
+        QByteArray buffer; // the data before it's stored in a file
+        QCryptographicHash hash;
+        std::unique_ptr<QTemporaryFile> file;
+        bool failed = false;
+    };
+
+    TestData() = default;
+
+    /**
+     * @brief construct an inline test data, which is never stored in a file
+     */
+    explicit TestData(const QString &text);
+
+    /**
+     * @brief construct a test data from a text, it's stored in a file if it's large
+     */
+    static TestData fromString(const QString &text);
+
+    /**
+     * @brief load a test data from a file, it's copied into the data directory and memory-mapped if it's large
+     * @param path the path to the file
+     * @param head the head of the messages if it fails
+     * @param log the message logger to show the errors
+     * @param notExistWarning whether to show a warning if the file doesn't exist
+     * @returns the loaded test data, or a null test data if it fails
+     */
+    static TestData fromFile(const QString &path, const QString &head = "Read File", MessageLogger *log = nullptr,
+                             bool notExistWarning = false);
+
+    bool isNull() const;
+    bool isEmpty() const;
+
+    /**
+     * @returns whether it contains only blank characters
+     */
+    bool isBlank() const;
+
+    /**
+     * @returns whether it's stored in a memory-mapped file
+     */
+    bool isMapped() const;
+
+    /**
+     * @returns the size, in characters if it's inline, or in bytes if it's mapped
+     */
+    qint64 size() const;
+
+    /**
+     * @returns the path to the file that stores the data, or an empty string if it's inline
+     */
+    QString filePath() const;
+
+    /**
+     * @returns the SHA-1 of the data in hex, it's computed from the UTF-8 text for inline data at the first call
+     */
+    QString hash() const;
+
+    /**
+     * @brief decode the whole data
+     * @note This takes a lot of memory for large data, use the other methods if possible.
+     */
+    QString toString() const;
+
+    /**
+     * @returns the data in UTF-8
+     * @note For mapped data, the returned array refers to the mapped memory without copying, so this TestData should
+     *       outlive the returned array.
+     */
+    QByteArray toUtf8() const;
+
+    /**
+     * @returns the number of pages of the given size, at least one
+     */
+    int pageCount(int pageSize) const;
+
+    /**
+     * @returns the text of a page, the size is in characters for inline data and in bytes for mapped data
+     */
+    QString page(int index, int pageSize) const;
+
+    /**
+     * @brief find the page containing a position
+     * @param line the 0-based line of the position
+     * @param column the 0-based column of the position, in QChars
+     * @param pageSize the size of a page, the same as in page()
+     * @param pageLine returns the 0-based line of the position in the page
+     * @param pageColumn returns the 0-based column of the position in the page
+     * @returns the index of the page
+     */
+    int findInPages(int line, int column, int pageSize, int *pageLine, int *pageColumn) const;
+
+    /**
+     * @returns the number of lines, only the first maxLines lines are counted
+     */
+    int lineCount(int maxLines) const;
+
+    /**
+     * @brief save the data to a file, the same as Util::saveFile, but mapped data is written without decoding
+     */
+    bool save(const QString &path, const QString &head = "Save File", bool safe = true, MessageLogger *log = nullptr,
+              bool createDirectory = false) const;
+
+    bool operator==(const TestData &other) const;
+    bool operator!=(const TestData &other) const;
+
+    /**
+     * @brief remove the stored files that are neither referenced nor used recently
+     * @param referencedPaths the paths to the stored files that are still referenced, e.g. by the saved session
+     * @note The files mapped in this process are never removed.
+     */
+    static void removeUnreferenced(const QSet<QString> &referencedPaths);
+
+  private:
+    struct MappedFile;
+    struct Registry;
+    struct TextHash;
+
+    static Registry &registry();
+    static std::shared_ptr<const MappedFile> mapStoredFile(const QString &hash, MessageLogger *log);
+    static QString storeFile(const char *data, qint64 size, MessageLogger *log);
+    static QString storageDirectory();
+
+    QString text;
+    std::shared_ptr<TextHash> textHash; // the hash of the inline text, shared by the copies
+    std::shared_ptr<const MappedFile> file;
+};
+} // namespace Core
+
+#endif // TESTDATA_HPP
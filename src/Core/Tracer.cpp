@@ -0,0 +1,153 @@
+/*
+ * Copyright (C) 2019-2021 Ashar Khan <ashar786khan@gmail.com>
+ *
+ * This file is part of CP Editor.
+ *
+ * CP Editor is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * I will not be responsible if CP Editor behaves in unexpected way and
+ * causes your ratings to go down and or lose any important contest.
+ *
+ * Believe Software is "Software" and it isn't immune to bugs.
+ *
+ */
+
+#include "Core/Tracer.hpp"
+#include "Core/EventLogger.hpp"
+#include <QCoreApplication>
+#include <QMutex>
+#include <QSaveFile>
+#include <QThread>
+#include <QVector>
+#include <chrono>
+
+namespace Core
+{
+namespace
+{
+// about 48 MiB, the events after it are dropped instead of growing without limit
+const int MAX_EVENTS = 1 << 20;
+
+// the number of events formatted and written at a time when exporting
+const int EXPORT_BATCH = 4096;
+
+struct Event
+{
+    const char *category;
+    const char *name;
+    char phase;
+    qint64 timestamp; // in microseconds
+    quintptr thread;
+    quint64 tab;
+    int test;
+};
+
+QMutex eventsMutex;
+QVector<Event> events;
+int droppedEvents = 0;
+
+qint64 now()
+{
+    using namespace std::chrono;
+    static const auto start = steady_clock::now();
+    return duration_cast<microseconds>(steady_clock::now() - start).count();
+}
+
+QByteArray quoted(const char *text)
+{
+    return '"' + QByteArray(text).replace('\\', "\\\\").replace('"', "\\\"") + '"';
+}
+
+void appendEvent(QByteArray *json, const Event &event, const QByteArray &pid)
+{
+    *json += ",\n{\"name\":" + quoted(event.name) + ",\"cat\":" + quoted(event.category) + ",\"ph\":\"" +
+             event.phase + "\",\"ts\":" + QByteArray::number(event.timestamp) + ",\"pid\":" + pid +
+             ",\"tid\":" + QByteArray::number(quint64(event.thread));
+    // the asynchronous spans with the same category and ID are shown in the same track
+    if (event.phase == 'b' || event.phase == 'e')
+        *json += ",\"id\":\"" + QByteArray::number(event.tab) + '/' + QByteArray::number(event.test) + '"';
+    *json += ",\"args\":{\"tab\":" + QByteArray::number(event.tab);
+    if (event.test != -1)
+        *json += ",\"test\":" + QByteArray::number(event.test + 1);
+    *json += "}}";
+}
+} // namespace
+
+std::atomic<bool> Tracer::enabled(false);
+
+void Tracer::setEnabled(bool enable)
+{
+    if (enable == isEnabled())
+        return;
+    LOG_INFO(BOOL_INFO_OF(enable));
+    if (enable)
+    {
+        QMutexLocker locker(&eventsMutex);
+        events.clear();
+        droppedEvents = 0;
+    }
+    enabled.store(enable, std::memory_order_relaxed);
+}
+
+void Tracer::record(const char *category, const char *name, char phase, quint64 tab, int test)
+{
+    const Event event{category, name, phase, now(), quintptr(QThread::currentThreadId()), tab, test};
+    QMutexLocker locker(&eventsMutex);
+    if (events.size() >= MAX_EVENTS)
+    {
+        ++droppedEvents;
+        return;
+    }
+    if (events.isEmpty())
+        events.reserve(4096);
+    events.push_back(event);
+}
+
+bool Tracer::exportTo(const QString &path)
+{
+    int count = 0;
+    int dropped = 0;
+    {
+        QMutexLocker locker(&eventsMutex);
+        count = events.size();
+        dropped = droppedEvents;
+    }
+
+    LOG_INFO(INFO_OF(path) << INFO_OF(count) << INFO_OF(dropped));
+    LOG_WARN_IF(dropped > 0, "Some trace events are dropped " << INFO_OF(dropped));
+
+    const auto pid = QByteArray::number(QCoreApplication::applicationPid());
+
+    QSaveFile file(path);
+    bool ok = file.open(QIODevice::WriteOnly);
+
+    QByteArray json = R"({"displayTimeUnit":"ms","traceEvents":[)";
+    json += R"({"name":"process_name","ph":"M","pid":)" + pid + R"(,"tid":0,"args":{"name":"CP Editor"}})";
+
+    // the events are written in batches, so neither a copy of the events nor the whole JSON is held in memory, and
+    // the threads recording events are only blocked while a batch is formatted
+    for (int begin = 0; ok && begin < count; begin += EXPORT_BATCH)
+    {
+        {
+            QMutexLocker locker(&eventsMutex);
+            // the events are only appended, unless the recording is restarted during the export
+            const int end = qMin(begin + EXPORT_BATCH, qMin(count, events.size()));
+            for (int i = begin; i < end; ++i)
+                appendEvent(&json, events.at(i), pid);
+        }
+        ok = file.write(json) == json.size();
+        json.clear();
+    }
+    json += "]}\n";
+
+    if (!ok || file.write(json) != json.size() || !file.commit())
+    {
+        LOG_ERR("Failed to write the trace " << INFO_OF(path));
+        return false;
+    }
+    return true;
+}
+} // namespace Core
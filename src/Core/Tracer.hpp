@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2019-2021 Ashar Khan <ashar786khan@gmail.com>
+ *
+ * This file is part of CP Editor.
+ *
+ * CP Editor is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * I will not be responsible if CP Editor behaves in unexpected way and
+ * causes your ratings to go down and or lose any important contest.
+ *
+ * Believe Software is "Software" and it isn't immune to bugs.
+ *
+ */
+
+/*
+ * The timeline of the compile/run/check pipelines, exported in the Chrome trace event format, so it can be opened in
+ * chrome://tracing or Perfetto.
+ * The processes are recorded as asynchronous spans, identified by the tab and the index of the test case, and the
+ * work done in the GUI thread is recorded as synchronous spans. Nothing is recorded unless tracing is enabled, and
+ * then a disabled tracer costs only a relaxed atomic load at each span.
+ * The names and the categories must be string literals, because only the pointers are kept until exported.
+ */
+
+#ifndef TRACER_HPP
+#define TRACER_HPP
+
+#include <QString>
+#include <atomic>
+
+namespace Core
+{
+class Tracer
+{
+  public:
+    /**
+     * @brief a synchronous span from the construction to the destruction, in the current thread
+     */
+    class Span
+    {
+      public:
+        Span(const char *category, const char *name, quint64 tab, int test = -1)
+            : category(category), name(name), tab(tab), test(test), active(isEnabled())
+        {
+            if (active)
+                record(category, name, 'B', tab, test);
+        }
+
+        ~Span()
+        {
+            if (active)
+                record(category, name, 'E', tab, test);
+        }
+
+        Span(const Span &) = delete;
+        Span &operator=(const Span &) = delete;
+
+      private:
+        const char *category;
+        const char *name;
+        quint64 tab;
+        int test;
+        bool active; // the end is recorded iff the beginning is recorded
+    };
+
+    static bool isEnabled()
+    {
+        return enabled.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief start or stop recording
+     * @note The events recorded before are discarded when the recording starts.
+     */
+    static void setEnabled(bool enable);
+
+    /**
+     * @brief begin an asynchronous span, it can end in another function, or even in another thread
+     * @param category the spans with the same category, tab and test are nested
+     * @param test the index of the test case, -1 if it's not for a test case
+     */
+    static void begin(const char *category, const char *name, quint64 tab, int test = -1)
+    {
+        if (isEnabled())
+            record(category, name, 'b', tab, test);
+    }
+
+    /**
+     * @brief end an asynchronous span started by begin() with the same arguments
+     */
+    static void end(const char *category, const char *name, quint64 tab, int test = -1)
+    {
+        if (isEnabled())
+            record(category, name, 'e', tab, test);
+    }
+
+    /**
+     * @brief write the recorded events to a file in the Chrome trace event format
+     * @returns whether the file is written
+     */
+    static bool exportTo(const QString &path);
+
+  private:
+    static void record(const char *category, const char *name, char phase, quint64 tab, int test);
+
+    static std::atomic<bool> enabled;
+};
+} // namespace Core
+
+#endif // TRACER_HPP
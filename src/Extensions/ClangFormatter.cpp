@@ -55,25 +55,30 @@ QString ClangFormatter::newSource(const QString &out) const
     return out.mid(out.indexOf('\n') + 1);
 }
 
-QTextCursor ClangFormatter::newCursor(const QString &out, const QStringList &args) const
+QStringList ClangFormatter::extraArgs(const QStringList &args) const
 {
-    auto cursor = editor()->textCursor();
-    cursor.setPosition(newCursorPos(out));
+    if (cursorPos() == anchorPos())
+        return {};
+
+    // change the `--cursor` argument and format again to get the position of the other end of the selection
+
+    QStringList newArgs;
 
-    if (cursorPos() != anchorPos())
-    {
-        // change the `--cursor` argument and format again to get the position of the other end of the selection
+    for (const auto &arg : qAsConst(args))
+        if (!arg.startsWith("--cursor"))
+            newArgs.append(arg);
+    newArgs.append(QString("--cursor=%1").arg(cursorPos()));
 
-        QStringList newArgs;
+    return newArgs;
+}
 
-        for (const auto &arg : qAsConst(args))
-            if (!arg.startsWith("--cursor"))
-                newArgs.append(arg);
-        newArgs.append(QString("--cursor=%1").arg(cursorPos()));
+QTextCursor ClangFormatter::newCursor(const QString &out, const QString &extraOut) const
+{
+    auto cursor = editor()->textCursor();
+    cursor.setPosition(newCursorPos(out));
 
-        auto res = runProcess(newArgs);
-        cursor.setPosition(newCursorPos(res), QTextCursor::KeepAnchor);
-    }
+    if (!extraOut.isNull())
+        cursor.setPosition(newCursorPos(extraOut), QTextCursor::KeepAnchor);
 
     return cursor;
 }
@@ -16,9 +16,8 @@
  */
 
 /*
- * The Formatter is used to format codes.
- * It runs synchronously, so the event loop is blocked while formatting.
- * The time limit for formatting is 2 seconds.
+ * The Formatter is used to format codes with clang-format.
+ * When a selection is formatted, clang-format runs twice to get the new positions of both ends of the selection.
  */
 
 #ifndef FORMATTER_HPP
@@ -47,7 +46,9 @@ class ClangFormatter : public CodeFormatter
 
     QString newSource(const QString &out) const override;
 
-    QTextCursor newCursor(const QString &out, const QStringList &args) const override;
+    QStringList extraArgs(const QStringList &args) const override;
+
+    QTextCursor newCursor(const QString &out, const QString &extraOut) const override;
 
   private:
     int newCursorPos(const QString &out) const;
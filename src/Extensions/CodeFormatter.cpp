@@ -22,7 +22,7 @@
 #include "Util/FileUtil.hpp"
 #include "third_party/QCodeEditor/include/QCodeEditor"
 #include <QProcess>
-#include <QTemporaryDir>
+#include <QTimer>
 
 namespace Extensions
 {
@@ -44,101 +44,206 @@ CodeFormatter::CodeFormatter(QCodeEditor *editor, const QString &lang, bool sele
     m_anchorCol = cursor.columnNumber();
 
     LOG_INFO(INFO_OF(m_cursorPos) << INFO_OF(m_cursorLine) << INFO_OF(m_anchorPos) << INFO_OF(m_anchorLine));
+
+    // the edits are tracked, so that checking whether the result is outdated doesn't compare the whole code
+    connect(editor->document(), &QTextDocument::contentsChanged, this, [this] { m_outdated = true; });
+}
+
+CodeFormatter::~CodeFormatter()
+{
+    stopProcess();
+    delete m_tmpDir;
 }
 
-void CodeFormatter::format() const
+void CodeFormatter::format()
 {
-    QStringList args = arguments() << QProcess::splitCommand(getSetting("Arguments").toString());
+    m_args = arguments() << QProcess::splitCommand(getSetting("Arguments").toString());
 
     if (formatSelectionOnly())
-        args.append(rangeArgs());
+        m_args.append(rangeArgs());
 
-    QTemporaryDir tmpDir;
-    if (!tmpDir.isValid())
+    m_tmpDir = new QTemporaryDir();
+    if (!m_tmpDir->isValid())
     {
         log->error(tr("Formatter"), tr("Failed to create temporary directory"));
+        finish(false);
         return;
     }
 
-    auto tmpPath = tmpDir.filePath(Util::fileNameWithSuffix("tmp", m_lang));
-    args.append(tmpPath);
-
-    if (!Util::saveFile(tmpPath, m_editor->toPlainText(), tr("Formatter"), true, log))
-        return;
-
-    if (!Util::saveFile(tmpDir.filePath(styleFileName()), getSetting("Style").toString(), tr("Formatter"), true, log))
-        return;
-
-    auto res = runProcess(args);
-    if (res.isEmpty())
-        return;
+    auto tmpPath = m_tmpDir->filePath(Util::fileNameWithSuffix("tmp", m_lang));
+    m_args.append(tmpPath);
 
-    auto source = newSource(res);
+    m_source = m_editor->toPlainText();
+    m_outdated = false;
 
-    if (source == m_editor->toPlainText())
+    if (!Util::saveFile(tmpPath, m_source, tr("Formatter"), true, log) ||
+        !Util::saveFile(m_tmpDir->filePath(styleFileName()), getSetting("Style").toString(), tr("Formatter"), true,
+                        log))
     {
-        if (m_logOnNoChange)
-            log->info(tr("Formatter"), tr("Formatting completed"));
+        finish(false);
         return;
     }
 
-    auto cursor = m_editor->textCursor();
-    cursor.select(QTextCursor::Document);
-    cursor.insertText(source);
+    runProcess(m_args, [this](const QString &out) {
+        auto args = extraArgs(m_args);
+        if (args.isEmpty())
+            apply(out, QString());
+        else
+            runProcess(args, [this, out](const QString &extraOut) { apply(out, extraOut); });
+    });
+}
 
-    m_editor->setTextCursor(newCursor(res, args));
+void CodeFormatter::cancel()
+{
+    LOG_INFO_IF(!m_finished, "Formatting cancelled");
+    m_finished = true;
+    stopProcess();
+}
 
-    log->info(tr("Formatter"), tr("Formatting completed"));
+bool CodeFormatter::isOutdated() const
+{
+    return m_outdated;
 }
 
-QString CodeFormatter::runProcess(const QStringList &args) const
+QStringList CodeFormatter::extraArgs(const QStringList & /*args*/) const
 {
-    QProcess formatProcess;
-    formatProcess.start(getSetting("Program").toString(), args);
-    LOG_INFO(INFO_OF(formatProcess.program()) << INFO_OF(formatProcess.arguments().join(' ')));
+    return {};
+}
 
-    bool finished = formatProcess.waitForFinished(2000); // blocks main Thread
-    if (!finished)
-    {
-        formatProcess.kill();
+void CodeFormatter::runProcess(const QStringList &args, const std::function<void(const QString &)> &callback)
+{
+    stopProcess();
+
+    m_process = new QProcess(this);
+    m_timer = new QTimer(this);
+    m_timer->setSingleShot(true);
+
+    connect(m_timer, &QTimer::timeout, this, [this] {
         log->error(tr("Formatter"),
                    tr("The format process didn't finish in 2 seconds. This is probably because the %1 program is not "
                       "found by CP Editor. You can set the path to the program at %2.")
                        .arg(settingKey())
                        .arg(SettingsManager::getPathText(settingKey() + "/Program")),
                    false);
-        return QString();
+        finish(false);
+    });
+
+    connect(m_process, &QProcess::errorOccurred, this, [this](QProcess::ProcessError error) {
+        if (error != QProcess::FailedToStart)
+            return;
+        LOG_WARN("Failed to start the format process");
+        log->error(tr("Formatter"),
+                   tr("Failed to start the %1 program. You can set the path to the program at %2.")
+                       .arg(settingKey())
+                       .arg(SettingsManager::getPathText(settingKey() + "/Program")),
+                   false);
+        finish(false);
+    });
+
+    connect(m_process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this,
+            [this, callback](int exitCode) {
+                m_timer->stop();
+
+                if (exitCode != 0)
+                {
+                    LOG_WARN(INFO_OF(exitCode));
+
+                    log->warn(tr("Formatter"), tr("The format command [%1 %2] finished with exit code %3.")
+                                                   .arg(m_process->program())
+                                                   .arg(m_process->arguments().join(' '))
+                                                   .arg(exitCode));
+                    auto stdOut = m_process->readAllStandardOutput();
+                    if (!stdOut.isEmpty())
+                        log->warn(tr("Formatter[stdout]"), stdOut);
+                    auto stdError = m_process->readAllStandardError();
+                    if (!stdError.isEmpty())
+                        log->error(tr("Formatter[stderr]"), stdError);
+                    finish(false);
+                    return;
+                }
+
+                QString out = m_process->readAllStandardOutput();
+
+                if (out.isEmpty())
+                {
+                    LOG_WARN("Output is empty");
+                    log->warn(tr("Formatter"),
+                              tr("The output of the format process is empty. Please ensure there is no in-place "
+                                 "modification option in the formatting arguments."));
+                    finish(false);
+                    return;
+                }
+
+                callback(out);
+            });
+
+    auto program = getSetting("Program").toString();
+    LOG_INFO(INFO_OF(program) << INFO_OF(args.join(' ')));
+
+    // the process may fail to start immediately, and then it's removed before start() returns
+    m_timer->start(2000);
+    m_process->start(program, args);
+}
+
+void CodeFormatter::apply(const QString &out, const QString &extraOut)
+{
+    if (isOutdated())
+    {
+        // the result is based on the old code, applying it would overwrite the changes made in the meantime
+        LOG_INFO("The code is changed while formatting, the result is discarded");
+        if (m_logOnNoChange)
+            log->warn(tr("Formatter"), tr("The code was changed while formatting, so the result is discarded."));
+        finish(false);
+        return;
     }
 
-    auto exitCode = formatProcess.exitCode();
+    auto source = newSource(out);
 
-    if (exitCode != 0)
+    if (source == m_source)
     {
-        LOG_WARN(INFO_OF(exitCode));
-
-        log->warn(tr("Formatter"), tr("The format command [%1 %2] finished with exit code %3.")
-                                       .arg(formatProcess.program())
-                                       .arg(formatProcess.arguments().join(' '))
-                                       .arg(exitCode));
-        auto stdOut = formatProcess.readAllStandardOutput();
-        if (!stdOut.isEmpty())
-            log->warn(tr("Formatter[stdout]"), stdOut);
-        auto stdError = formatProcess.readAllStandardError();
-        if (!stdError.isEmpty())
-            log->error(tr("Formatter[stderr]"), stdError);
-        return QString();
+        if (m_logOnNoChange)
+            log->info(tr("Formatter"), tr("Formatting completed"));
+        finish(false);
+        return;
     }
 
-    auto out = formatProcess.readAllStandardOutput();
+    auto cursor = m_editor->textCursor();
+    cursor.select(QTextCursor::Document);
+    cursor.insertText(source);
+
+    m_editor->setTextCursor(newCursor(out, extraOut));
+
+    log->info(tr("Formatter"), tr("Formatting completed"));
+    finish(true);
+}
 
-    if (out.isEmpty())
+void CodeFormatter::finish(bool applied)
+{
+    if (m_finished)
+        return;
+    m_finished = true;
+    stopProcess();
+    emit finished(applied);
+}
+
+void CodeFormatter::stopProcess()
+{
+    if (m_timer != nullptr)
     {
-        LOG_WARN("Output is empty");
-        log->warn(tr("Formatter"), tr("The output of the format process is empty. Please ensure there is no in-place "
-                                      "modification option in the formatting arguments."));
+        m_timer->stop();
+        m_timer->deleteLater();
+        m_timer = nullptr;
     }
 
-    return out;
+    if (m_process != nullptr)
+    {
+        // the signals of the process shouldn't call back into this formatter any more
+        m_process->disconnect(this);
+        if (m_process->state() != QProcess::NotRunning)
+            m_process->kill();
+        m_process->deleteLater();
+        m_process = nullptr;
+    }
 }
 
 bool CodeFormatter::formatSelectionOnly() const
@@ -15,14 +15,24 @@
  *
  */
 
+/*
+ * The base of the code formatters.
+ * The format process runs in the background and the result is applied when it finishes, only if the code is not changed
+ * in the meantime, otherwise the result is discarded. The format process is killed if it doesn't finish in 2 seconds.
+ */
+
 #ifndef CODEFORMATTER_HPP
 #define CODEFORMATTER_HPP
 
 #include <QObject>
+#include <QTemporaryDir>
+#include <functional>
 
 class MessageLogger;
 class QCodeEditor;
+class QProcess;
 class QTextCursor;
+class QTimer;
 
 namespace Extensions
 {
@@ -34,7 +44,37 @@ class CodeFormatter : public QObject
     explicit CodeFormatter(QCodeEditor *editor, const QString &lang, bool selectionOnly, bool logOnNoChange,
                            MessageLogger *log, QObject *parent = nullptr);
 
-    void format() const;
+    /**
+     * @note The running format process is killed.
+     */
+    ~CodeFormatter() override;
+
+    /**
+     * @brief start formatting the code
+     * @note finished() is emitted when it's done, even if it fails. It may be emitted before this function returns.
+     */
+    void format();
+
+    /**
+     * @brief stop formatting, the result is not applied and finished() is not emitted
+     */
+    void cancel();
+
+    /**
+     * @brief check whether the code is changed since format() is called, so that the result will be discarded
+     */
+    bool isOutdated() const;
+
+    /**
+     * @brief check whether only the selection is formatted
+     */
+    bool formatSelectionOnly() const;
+
+  signals:
+    /**
+     * @param applied whether the code is changed by the formatter
+     */
+    void finished(bool applied);
 
   protected:
     /**
@@ -65,26 +105,43 @@ class CodeFormatter : public QObject
      */
     virtual QString newSource(const QString &out) const = 0;
 
+    /**
+     * @brief the arguments of another format process run after the first one, whose stdout is passed to newCursor()
+     * @param args the arguments used when formatting
+     * @returns the arguments, or an empty list if there's no need to run the format process again
+     */
+    virtual QStringList extraArgs(const QStringList &args) const;
+
     /**
      * @brief the new text cursor after formatting
      * @param out the stdout of the format process
-     * @param args the arguments used when formatting
+     * @param extraOut the stdout of the extra format process, a null QString if it's not run, see extraArgs()
      */
-    virtual QTextCursor newCursor(const QString &out, const QStringList &args) const = 0;
+    virtual QTextCursor newCursor(const QString &out, const QString &extraOut) const = 0;
 
+  private:
     /**
-     * @brief run the format process and get the result
+     * @brief start the format process in the background
      * @param args the arguments of the format process
-     * @returns the stdout of the format process, or an empty QString if error occurred
+     * @param callback called with the stdout of the format process if it succeeds, otherwise finish(false) is called
      */
-    QString runProcess(const QStringList &args) const;
+    void runProcess(const QStringList &args, const std::function<void(const QString &)> &callback);
 
     /**
-     * @brief check whether only the selection is formatted
+     * @brief apply the result to the editor if the code is not changed since format() is called
      */
-    bool formatSelectionOnly() const;
+    void apply(const QString &out, const QString &extraOut);
+
+    /**
+     * @brief stop the format process and emit finished()
+     */
+    void finish(bool applied);
+
+    /**
+     * @brief kill the format process if it's running
+     */
+    void stopProcess();
 
-  private:
     /**
      * @brief get settingKey()/key
      */
@@ -97,6 +154,14 @@ class CodeFormatter : public QObject
     bool m_logOnNoChange;
     int m_cursorPos, m_cursorLine, m_cursorCol, m_anchorPos, m_anchorLine, m_anchorCol;
 
+    QString m_source;        // the code when format() is called
+    bool m_outdated = false; // whether the code is changed since format() is called
+    QStringList m_args;      // the arguments of the first format process
+    QTemporaryDir *m_tmpDir = nullptr;
+    QProcess *m_process = nullptr;
+    QTimer *m_timer = nullptr; // kills the format process when it's running for too long
+    bool m_finished = false;
+
   protected:
     QCodeEditor *editor() const
     {
@@ -24,46 +24,113 @@
 #include <QFileInfo>
 #include <QJsonArray>
 #include <QJsonDocument>
+#include <QAbstractItemView>
+#include <QCompleter>
+#include <QScrollBar>
+#include <QSet>
+#include <QStringListModel>
+#include <QTextBlock>
+#include <QTimer>
+#include <QUrl>
+#include <algorithm>
+#include <iterator>
+#include <tuple>
 
 namespace Extensions
 {
+namespace
+{
+// the whole text is sent instead when there are more pending changes than this
+const int MAX_PENDING_CHANGES = 1000;
+
+// the linting delay is twice the latency, so the server is idle for at least half of the time
+const int LINTING_DELAY_PER_LATENCY = 2;
+const int MAX_LINTING_DELAY = 10000;
+
+// the diagnostics published within this time are applied once, only the latest ones are used
+const int DIAGNOSTICS_DELAY = 100;
+
+// the least recently used document is closed when there are more open documents than this
+const int MAX_OPEN_DOCUMENTS = 8;
+
+// the completions arriving later than this are not shown, but they are kept for the following keystrokes
+const int MAX_COMPLETION_LATENCY = 300;
+
+bool isWordCharacter(QChar c)
+{
+    return c.isLetterOrNumber() || c == '_';
+}
+} // namespace
 
 LanguageServer::LanguageServer(QString const &lang)
 {
     LOG_INFO(INFO_OF(lang));
     this->language = lang;
-    if (shouldCreateClient())
-    {
-        createClient();
-        performConnection();
-    }
+
+    diagnosticsTimer = new QTimer(this);
+    diagnosticsTimer->setSingleShot(true);
+    diagnosticsTimer->setInterval(DIAGNOSTICS_DELAY);
+    connect(diagnosticsTimer, &QTimer::timeout, this, &LanguageServer::applyPendingDiagnostics);
+
+    // the server is started when the first document is opened
+    idleTimer = new QTimer(this);
+    idleTimer->setSingleShot(true);
+    connect(idleTimer, &QTimer::timeout, this, &LanguageServer::onIdleTimeout);
 }
 
 LanguageServer::~LanguageServer()
 {
-    if (lsp != nullptr)
-    {
-        LOG_INFO("Killing LSP");
-        lsp->shutdown();
-        lsp->exit();
-        delete lsp;
-    }
+    while (!documents.isEmpty())
+        closeDocument(documents.first(), false);
+
+    stopServer();
 }
 
 void LanguageServer::openDocument(QString const &path, QCodeEditor *editor, MessageLogger *log)
 {
-    if (isDocumentOpen())
+    auto *document = findDocument(editor);
+
+    if (document != nullptr && document->path != path)
     {
-        LOG_WARN("openDocument called without closing the previous document. Closing it now");
-        closeDocument();
+        LOG_INFO("The path of the document is changed " << INFO_OF(document->path) << INFO_OF(path));
+        closeDocument(document);
+        document = nullptr;
     }
 
-    m_editor = editor;
-    openFile = path;
-    logger = log;
+    if (document != nullptr)
+    {
+        // the server still has the document, its diagnostics are already shown
+        LOG_INFO("Reusing the open document " << INFO_OF(path));
+        document->logger = log;
+        documents.removeOne(document);
+        documents.prepend(document);
+        active = document;
+        attachCompleter(document);
+        return;
+    }
+
+    document = new Document();
+    document->path = path;
+    document->editor = editor;
+    document->logger = log;
+    documents.prepend(document);
+    active = document;
+
+    // the editor is destroyed with its tab, and its document can't be used any more
+    document->destroyedConnection =
+        connect(editor, &QObject::destroyed, this, [this, document] { closeDocument(document, false); });
+
+    idleTimer->stop();
+    if (lsp == nullptr && shouldCreateClient())
+        startServer();
 
     if (lsp == nullptr)
+    {
+        // only the active document is kept, so that it's opened when the server is started
+        while (documents.size() > 1)
+            closeDocument(documents.last());
         return;
+    }
 
     if (!isInitialized)
     {
@@ -71,99 +138,77 @@ void LanguageServer::openDocument(QString const &path, QCodeEditor *editor, Mess
         isInitialized = true;
     }
 
-    std::string uri = "file://" + path.toStdString();
-    std::string code = m_editor->toPlainText().toStdString();
-    std::string lang;
+    sendOpen(document);
+    attachCompleter(document);
 
-    if (language == "Java")
-        lang = "java";
-    else if (language == "Python")
-        lang = "python";
-    else
+    while (documents.size() > MAX_OPEN_DOCUMENTS)
     {
-        LOG_WARN_IF(language != "C++", "Unknown language " << language);
-        lang = "cpp";
+        LOG_INFO("Closing the least recently used document " << INFO_OF(documents.last()->path));
+        closeDocument(documents.last());
     }
-
-    lsp->didOpen(uri, code, lang);
 }
 
-void LanguageServer::closeDocument()
+void LanguageServer::closeDocument(QCodeEditor *editor)
 {
-    LOG_WARN_IF(!isDocumentOpen(), "Cannot close the document, No document was open");
-    if (!isDocumentOpen())
-        return;
-
-    std::string uri = "file://" + openFile.toStdString();
-    lsp->didClose(uri);
-
-    openFile = "";
-    logger = nullptr;
-    m_editor = nullptr;
+    auto *document = findDocument(editor);
+    if (document != nullptr)
+        closeDocument(document);
 }
 
 void LanguageServer::requestLinting()
 {
-    if (m_editor == nullptr || !isDocumentOpen())
+    if (!isDocumentOpen() || active->editor == nullptr)
         return;
 
-    std::vector<TextDocumentContentChangeEvent> changes;
-    TextDocumentContentChangeEvent e;
-    e.text = m_editor->toPlainText().toStdString();
-    changes.push_back(e);
-
-    std::string uri = "file://" + openFile.toStdString();
-    lsp->didChange(uri, changes, true);
+    if (sendChanges(active, true) && !lintingTimer.isValid())
+        lintingTimer.start();
 }
 
 bool LanguageServer::isDocumentOpen() const
 {
-    return !openFile.isEmpty() && lsp != nullptr;
+    return active != nullptr && lsp != nullptr;
+}
+
+int LanguageServer::lintingDelay(int minimum) const
+{
+    return qBound(minimum, lintingLatency * LINTING_DELAY_PER_LATENCY, qMax(minimum, MAX_LINTING_DELAY));
 }
 
 void LanguageServer::updateSettings()
 {
-    if (lsp != nullptr)
+    idleTimer->stop();
+    stopServer();
+
+    // the documents of the old server are closed, only the active one is opened again
+    QString path;
+    QPointer<QCodeEditor> editor;
+    QPointer<MessageLogger> log;
+    if (active != nullptr)
     {
-        LOG_INFO("Killing LSP");
-        lsp->shutdown();
-        lsp->exit();
-        delete lsp;
-        lsp = nullptr;
+        path = active->path;
+        editor = active->editor;
+        log = active->logger;
     }
+    while (!documents.isEmpty())
+        closeDocument(documents.first());
 
-    if (m_editor != nullptr)
-        m_editor->clearSquiggle();
-
-    if (shouldCreateClient())
+    // the server is started again with the new settings if it's still enabled
+    if (editor != nullptr)
     {
-        createClient();
-
-        performConnection();
-        initializeLSP(openFile);
-
-        LOG_INFO("Recreated Language server Process");
-        if (m_editor != nullptr)
-        {
-            auto *tmpEditor = m_editor;
-            auto tmpPath = openFile;
-            auto *tmpLog = logger;
-            if (isDocumentOpen())
-                closeDocument();
-            openDocument(tmpPath, tmpEditor, tmpLog);
-            LOG_INFO("Reopened document after restart");
-        }
+        openDocument(path, editor, log);
+        LOG_INFO("Reopened document after restart");
     }
 }
 
 void LanguageServer::updatePath(QString const &newPath)
 {
-    if (lsp == nullptr || (openFile == newPath))
+    if (lsp == nullptr || active == nullptr || active->path == newPath)
         return;
-    auto *tmpLogger = logger;
-    auto *tmpEditor = m_editor;
-    closeDocument();
-    openDocument(newPath, tmpEditor, tmpLogger);
+    auto *tmpLogger = active->logger.data();
+    auto *tmpEditor = active->editor.data();
+    closeDocument(active);
+    if (tmpEditor != nullptr)
+        openDocument(newPath, tmpEditor, tmpLogger);
 }
 
 // Private methods
@@ -179,6 +224,32 @@ void LanguageServer::createClient()
     auto program = SettingsManager::get("LSP/Path " + language).toString();
     auto args = QProcess::splitCommand(SettingsManager::get("LSP/Args " + language).toString().trimmed());
     lsp = new LSPClient(program, args);
+    syncKind = FullSync;
+    lintingLatency = 0;
+    completionSupported = false;
+    completionTriggers.clear();
+    completionRequest = CompletionRequest();
+}
+
+void LanguageServer::startServer()
+{
+    LOG_INFO("Starting LSP " << INFO_OF(language));
+    createClient();
+    performConnection();
+    isInitialized = false;
+}
+
+void LanguageServer::stopServer()
+{
+    if (lsp == nullptr)
+        return;
+
+    LOG_INFO("Killing LSP " << INFO_OF(language));
+    lsp->shutdown();
+    lsp->exit();
+    delete lsp;
+    lsp = nullptr;
+    isInitialized = false;
 }
 
 void LanguageServer::performConnection()
@@ -223,41 +294,594 @@ void LanguageServer::initializeLSP(QString const &filePath)
     option<DocumentUri> rootUri(uri);
     lsp->initialize(rootUri);
 }
+
+std::string LanguageServer::uriOf(const QString &path)
+{
+    return "file://" + path.toStdString();
+}
+
+LanguageServer::Document *LanguageServer::findDocument(QCodeEditor *editor) const
+{
+    for (auto *document : documents)
+    {
+        if (document->editor == editor)
+            return document;
+    }
+    return nullptr;
+}
+
+LanguageServer::Document *LanguageServer::findDocumentByUri(const QString &uri) const
+{
+    // the server may normalize the URI, e.g. encode the special characters, so the local files are also compared
+    const auto localFile = QFileInfo(QUrl(uri).toLocalFile());
+    for (auto *document : documents)
+    {
+        if (QString::fromStdString(uriOf(document->path)) == uri ||
+            (localFile.exists() && localFile == QFileInfo(document->path)))
+            return document;
+    }
+    return nullptr;
+}
+
+void LanguageServer::sendOpen(Document *document)
+{
+    std::string code = document->editor->toPlainText().toStdString();
+    std::string lang;
+
+    if (language == "Java")
+        lang = "java";
+    else if (language == "Python")
+        lang = "python";
+    else
+    {
+        LOG_WARN_IF(language != "C++", "Unknown language " << language);
+        lang = "cpp";
+    }
+
+    lsp->didOpen(uriOf(document->path), code, lang);
+
+    resetLines(document);
+    document->contentsChangeConnection =
+        connect(document->editor->document(), &QTextDocument::contentsChange, this,
+                [this, document](int position, int charsRemoved, int charsAdded) {
+                    onContentsChange(document, position, charsRemoved, charsAdded);
+                    if (document == active)
+                        updateCompletion(document, position, charsRemoved, charsAdded);
+                });
+}
+
+void LanguageServer::closeDocument(Document *document, bool clearSquiggles)
+{
+    LOG_INFO(INFO_OF(language) << INFO_OF(document->path));
+
+    documents.removeOne(document);
+    if (active == document)
+    {
+        active = nullptr;
+        lintingTimer.invalidate();
+    }
+
+    disconnect(document->contentsChangeConnection);
+    disconnect(document->destroyedConnection);
+
+    if (completionRequest.document == document)
+        cancelCompletion();
+
+    if (lsp != nullptr)
+        lsp->didClose(uriOf(document->path));
+
+    if (clearSquiggles && document->editor != nullptr)
+        document->editor->clearSquiggle();
+
+    // the server is kept for a while, in case a document of this language is opened again soon
+    const int idleDelay = SettingsManager::get("LSP/Idle Shutdown Delay " + language).toInt();
+    if (documents.isEmpty() && lsp != nullptr && idleDelay > 0)
+        idleTimer->start(idleDelay * 1000);
+
+    if (document->completer != nullptr)
+    {
+        if (document->editor != nullptr && document->editor->completer() == document->completer)
+            document->editor->setCompleter(nullptr);
+        delete document->completer;
+    }
+
+    delete document;
+}
+
+void LanguageServer::resetLines(Document *document)
+{
+    document->lines.clear();
+    document->pendingChanges.clear();
+    document->fullSyncNeeded = false;
+
+    if (document->editor == nullptr)
+        return;
+
+    auto *doc = document->editor->document();
+    document->lines.reserve(doc->blockCount());
+    for (auto block = doc->begin(); block.isValid(); block = block.next())
+    {
+        const auto text = block.text();
+        document->lines.push_back({text.length(), qHash(text)});
+    }
+}
+
+bool LanguageServer::sendChanges(Document *document, bool wantDiagnostics)
+{
+    if (syncKind == NoSync)
+    {
+        document->pendingChanges.clear();
+        return false;
+    }
+
+    std::vector<TextDocumentContentChangeEvent> changes;
+
+    if (document->fullSyncNeeded || (syncKind == FullSync && !document->pendingChanges.isEmpty()))
+    {
+        TextDocumentContentChangeEvent e;
+        e.text = document->editor->toPlainText().toStdString();
+        changes.push_back(e);
+        resetLines(document);
+    }
+    else
+    {
+        // the server applies the changes in order, each range is in the text after the previous changes
+        for (auto const &change : document->pendingChanges)
+        {
+            Range range;
+            range.start.line = change.startLine;
+            range.start.character = change.startColumn;
+            range.end.line = change.endLine;
+            range.end.character = change.endColumn;
+
+            TextDocumentContentChangeEvent e;
+            e.range = option<Range>(range);
+            e.text = change.text.toStdString();
+            changes.push_back(e);
+        }
+        document->pendingChanges.clear();
+    }
+
+    // the server already has the latest text, unless the changes sent for completion are not linted yet
+    if (changes.empty() && (!wantDiagnostics || !document->lintingNeeded))
+        return false;
+
+    lsp->didChange(uriOf(document->path), changes, wantDiagnostics);
+    document->lintingNeeded = !wantDiagnostics;
+    return true;
+}
+
+void LanguageServer::onContentsChange(Document *document, int position, int charsRemoved, int charsAdded)
+{
+    if (document->editor == nullptr || document->fullSyncNeeded)
+        return;
+
+    auto *doc = document->editor->document();
+
+    // the changes of the last block, e.g. setPlainText(), include the paragraph separator at the end of the document
+    const int overflow = position + charsAdded - (doc->characterCount() - 1);
+    if (overflow > 0)
+    {
+        charsAdded -= overflow;
+        charsRemoved -= overflow;
+    }
+
+    const auto startBlock = doc->findBlock(position);
+    if (!startBlock.isValid() || charsAdded < 0 || charsRemoved < 0 ||
+        document->pendingChanges.size() >= MAX_PENDING_CHANGES)
+    {
+        document->fullSyncNeeded = true;
+        document->pendingChanges.clear();
+        return;
+    }
+
+    const int startLine = startBlock.blockNumber();
+    const int startColumn = position - startBlock.position();
+
+    // find the end of the removed text in the lines before this change
+    int endLine = startLine;
+    int endColumn = startColumn;
+    int remaining = charsRemoved;
+    while (true)
+    {
+        if (endLine >= document->lines.size())
+        {
+            document->fullSyncNeeded = true;
+            document->pendingChanges.clear();
+            return;
+        }
+        const int rest = document->lines[endLine].length - endColumn;
+        if (remaining <= rest)
+        {
+            endColumn += remaining;
+            break;
+        }
+        remaining -= rest + 1; // the line break
+        ++endLine;
+        endColumn = 0;
+    }
+
+    const auto endBlock = doc->findBlock(position + charsAdded);
+
+    QVector<Line> newLines;
+    for (auto block = startBlock; block.isValid() && block.blockNumber() <= endBlock.blockNumber();
+         block = block.next())
+    {
+        const auto text = block.text();
+        newLines.push_back({text.length(), qHash(text)});
+    }
+
+    // the highlighter reports the changes of the formats as changes of the text, they are ignored
+    if (charsRemoved == charsAdded && endLine - startLine + 1 == newLines.size())
+    {
+        bool unchanged = true;
+        for (int i = 0; i < newLines.size() && unchanged; ++i)
+        {
+            const auto &line = document->lines[startLine + i];
+            unchanged = line.length == newLines[i].length && line.hash == newLines[i].hash;
+        }
+        if (unchanged)
+            return;
+    }
+
+    QTextCursor cursor(doc);
+    cursor.setPosition(position);
+    cursor.setPosition(position + charsAdded, QTextCursor::KeepAnchor);
+    auto text = cursor.selectedText();
+    text.replace(QChar::ParagraphSeparator, '\n');
+    text.replace(QChar::Nbsp, ' ');
+
+    document->pendingChanges.push_back({startLine, startColumn, endLine, endColumn, text});
+
+    if (endLine - startLine + 1 == newLines.size())
+        std::copy(newLines.begin(), newLines.end(), document->lines.begin() + startLine);
+    else
+        document->lines = document->lines.mid(0, startLine) + newLines + document->lines.mid(endLine + 1);
+}
+
+void LanguageServer::attachCompleter(Document *document)
+{
+    if (lsp == nullptr || document->editor == nullptr ||
+        !SettingsManager::get("LSP/Use Autocomplete " + language).toBool())
+        return;
+
+    if (document->completer == nullptr)
+    {
+        document->completer = new QCompleter(this);
+        document->completer->setModel(new QStringListModel(document->completer));
+        document->completer->setModelSorting(QCompleter::UnsortedModel);
+        document->completer->setCaseSensitivity(Qt::CaseInsensitive);
+        document->completer->setWrapAround(false);
+    }
+
+    // QCodeEditor filters the completions by the word under the cursor and shows them while typing
+    document->editor->setCompleter(document->completer);
+}
+
+bool LanguageServer::wordAt(QTextDocument *doc, int position, int &line, int &column, QString &prefix)
+{
+    const auto block = doc->findBlock(position);
+    if (!block.isValid())
+        return false;
+
+    const auto text = block.text();
+    const int cursor = position - block.position();
+    int start = cursor;
+    while (start > 0 && isWordCharacter(text[start - 1]))
+        --start;
+
+    line = block.blockNumber();
+    column = start;
+    prefix = text.mid(start, cursor - start);
+    return true;
+}
+
+void LanguageServer::updateCompletion(Document *document, int position, int charsRemoved, int charsAdded)
+{
+    // the highlighter reports the changes of the formats as replacements of the same length
+    if (document->completer == nullptr || !completionSupported || charsRemoved == charsAdded)
+        return;
+
+    auto *doc = document->editor->document();
+    int line = 0;
+    int column = 0;
+    QString prefix;
+    if (!wordAt(doc, position + charsAdded, line, column, prefix))
+        return;
+
+    const bool typed = charsRemoved == 0 && charsAdded == 1;
+
+    if (typed && completionTriggers.contains(doc->characterAt(position)))
+    {
+        requestCompletion(document, line, column, QString());
+        return;
+    }
+
+    auto covers = [&](int coveredLine, int coveredColumn, const QString &coveredPrefix) {
+        return !prefix.isEmpty() && line == coveredLine && column == coveredColumn && prefix.startsWith(coveredPrefix);
+    };
+
+    // the completions of a shorter prefix of the same word include the ones of this prefix, QCompleter filters them
+    if (!document->completionIncomplete &&
+        covers(document->completionLine, document->completionColumn, document->completionPrefix))
+        return;
+
+    // the request in flight for the same word is still useful
+    if (completionRequest.document == document &&
+        covers(completionRequest.line, completionRequest.column, completionRequest.prefix))
+        return;
+
+    document->completionLine = -1;
+
+    if (typed && !prefix.isEmpty())
+        requestCompletion(document, line, column, prefix);
+    else
+        cancelCompletion();
+}
+
+void LanguageServer::requestCompletion(Document *document, int line, int column, const QString &prefix)
+{
+    cancelCompletion();
+
+    // the server completes its own copy of the text, so it needs the latest changes, but they are linted later
+    sendChanges(document, false);
+
+    Position position;
+    position.line = line;
+    position.character = column + prefix.length();
+
+    completionRequest.id = QString::fromStdString(lsp->completion(uriOf(document->path), position));
+    completionRequest.document = document;
+    completionRequest.line = line;
+    completionRequest.column = column;
+    completionRequest.prefix = prefix;
+    completionRequest.timer.start();
+}
+
+void LanguageServer::cancelCompletion()
+{
+    if (completionRequest.id.isEmpty())
+        return;
+
+    if (lsp != nullptr)
+        lsp->sendNotification("$/cancelRequest", json{{"id", completionRequest.id.toStdString()}});
+
+    completionRequest = CompletionRequest();
+}
+
+void LanguageServer::applyCompletion(const QString &id, const QJsonValue &result)
+{
+    // the response of a cancelled request
+    if (!id.isEmpty() && id != completionRequest.id)
+        return;
+
+    const auto request = completionRequest;
+    completionRequest = CompletionRequest();
+
+    auto *document = request.document;
+    if (document == nullptr || document->editor == nullptr || document->completer == nullptr)
+        return;
+    auto *editor = document->editor.data();
+
+    // the user may have moved to another word while waiting
+    int line = 0;
+    int column = 0;
+    QString prefix;
+    if (!wordAt(editor->document(), editor->textCursor().position(), line, column, prefix) || line != request.line ||
+        column != request.column || !prefix.startsWith(request.prefix))
+        return;
+
+    // the result is either CompletionItem[] or CompletionList
+    const auto items = result.isArray() ? result.toArray() : result.toObject()["items"].toArray();
+
+    QVector<QPair<QString, QString>> completions; // the sort texts and the inserted texts
+    for (auto const &value : items)
+    {
+        const auto item = value.toObject();
+        const auto label = item["label"].toString().trimmed();
+        QString text;
+        if (item["insertTextFormat"].toInt() == 2) // snippets can't be expanded
+            text = item["filterText"].toString(label);
+        else if (item.contains("textEdit"))
+            text = item["textEdit"].toObject()["newText"].toString();
+        else
+            text = item["insertText"].toString(label);
+        if (!text.isEmpty())
+            completions.push_back({item["sortText"].toString(label), text});
+    }
+    std::stable_sort(completions.begin(), completions.end(),
+                     [](const QPair<QString, QString> &a, const QPair<QString, QString> &b) {
+                         return a.first < b.first;
+                     });
+
+    QStringList list;
+    QSet<QString> added;
+    for (auto const &completion : completions)
+    {
+        if (!added.contains(completion.second))
+        {
+            added.insert(completion.second);
+            list.push_back(completion.second);
+        }
+    }
+
+    qobject_cast<QStringListModel *>(document->completer->model())->setStringList(list);
+    document->completionLine = request.line;
+    document->completionColumn = request.column;
+    document->completionPrefix = request.prefix;
+    document->completionIncomplete = result.toObject()["isIncomplete"].toBool();
+
+    const auto latency = request.timer.elapsed();
+    LOG_INFO(INFO_OF(language) << INFO_OF(list.size()) << INFO_OF(latency));
+
+    if (latency > MAX_COMPLETION_LATENCY || document != active || !editor->hasFocus())
+        return;
+
+    auto *completer = document->completer;
+    completer->setCompletionPrefix(prefix);
+    if (completer->completionCount() == 0)
+    {
+        completer->popup()->hide();
+        return;
+    }
+    completer->popup()->setCurrentIndex(completer->completionModel()->index(0, 0));
+    auto rect = editor->cursorRect();
+    rect.setWidth(completer->popup()->sizeHintForColumn(0) +
+                  completer->popup()->verticalScrollBar()->sizeHint().width());
+    completer->complete(rect);
+}
+
+QString LanguageServer::responseIdOf(const QJsonObject &id, const QJsonObject &response)
+{
+    for (auto const &value : {response["id"], id["id"]})
+    {
+        if (value.isString())
+            return value.toString();
+        if (value.isDouble())
+            return QString::number(value.toInt());
+    }
+    return QString();
+}
+
 // ---------------------------- LSP SLOTS ------------------------
 
 void LanguageServer::onLSPServerNotificationArrived(QString const &method, QJsonObject const &param)
 {
-    if (method == "textDocument/publishDiagnostics" && m_editor != nullptr) // Linting
+    if (method == "textDocument/publishDiagnostics") // Linting
     {
-        m_editor->clearSquiggle();
-        QJsonArray doc = QJsonDocument::fromVariant(param.toVariantMap()).object()["diagnostics"].toArray();
-        for (auto e : doc)
+        auto *document = findDocumentByUri(param["uri"].toString());
+        if (document == nullptr)
         {
-            QString tooltip = e.toObject()["message"].toString();
-            QCodeEditor::SeverityLevel level = lspSeverity(e.toObject()["severity"].toInt());
+            LOG_INFO("Diagnostics of a closed document " << INFO_OF(param["uri"].toString()));
+            return;
+        }
 
-            auto beg = e.toObject()["range"].toObject()["start"].toObject();
-            auto end = e.toObject()["range"].toObject()["end"].toObject();
+        if (document == active && lintingTimer.isValid())
+        {
+            const int latency = int(lintingTimer.elapsed());
+            lintingLatency = lintingLatency == 0 ? latency : (lintingLatency * 3 + latency) / 4;
+            lintingTimer.invalidate();
+            LOG_INFO(INFO_OF(language) << INFO_OF(latency) << INFO_OF(lintingLatency));
+        }
 
-            QPair<int, int> start;
-            QPair<int, int> stop;
+        // an older version published after a newer one is out of date
+        const auto &pending = document->pendingDiagnostics;
+        if (param.contains("version") && pending.contains("version") &&
+            param["version"].toInt() < pending["version"].toInt())
+            return;
 
-            start.first = beg["line"].toInt() + 1;
-            start.second = beg["character"].toInt();
+        document->pendingDiagnostics = param;
+        if (!diagnosticsTimer->isActive())
+            diagnosticsTimer->start();
+    }
+}
 
-            stop.first = end["line"].toInt() + 1;
-            stop.second = end["character"].toInt();
+void LanguageServer::onIdleTimeout()
+{
+    if (!documents.isEmpty())
+        return;
 
-            m_editor->squiggle(level, start, stop,
-                               tooltip.remove(" (fix available)")); // We do not provide quick fix so remove this text.
-        }
+    LOG_INFO("No open documents " << INFO_OF(language));
+    stopServer();
+}
+
+void LanguageServer::applyPendingDiagnostics()
+{
+    for (auto *document : documents)
+    {
+        if (!document->pendingDiagnostics.isEmpty())
+            applyDiagnostics(document);
+    }
+}
+
+void LanguageServer::applyDiagnostics(Document *document)
+{
+    const auto pending = document->pendingDiagnostics;
+    document->pendingDiagnostics = QJsonObject();
+    if (document->editor == nullptr)
+        return;
+
+    QVector<Diagnostic> newDiagnostics;
+    for (auto const &value : pending["diagnostics"].toArray())
+    {
+        const auto object = value.toObject();
+        const auto range = object["range"].toObject();
+        const auto beg = range["start"].toObject();
+        const auto end = range["end"].toObject();
+
+        Diagnostic diagnostic;
+        diagnostic.level = lspSeverity(object["severity"].toInt());
+        diagnostic.start = {beg["line"].toInt() + 1, beg["character"].toInt()};
+        diagnostic.stop = {end["line"].toInt() + 1, end["character"].toInt()};
+        diagnostic.message = object["message"].toString();
+        diagnostic.message.remove(" (fix available)"); // We do not provide quick fix so remove this text.
+        newDiagnostics.push_back(diagnostic);
+    }
+
+    std::sort(newDiagnostics.begin(), newDiagnostics.end());
+    auto &diagnostics = document->diagnostics;
+    if (newDiagnostics == diagnostics)
+        return;
+
+    auto *editor = document->editor.data();
+
+    // QCodeEditor can't remove a single squiggle, so the squiggles are only added if none of them are removed
+    if (std::includes(newDiagnostics.begin(), newDiagnostics.end(), diagnostics.begin(), diagnostics.end()))
+    {
+        QVector<Diagnostic> added;
+        std::set_difference(newDiagnostics.begin(), newDiagnostics.end(), diagnostics.begin(), diagnostics.end(),
+                            std::back_inserter(added));
+        for (auto const &diagnostic : added)
+            editor->squiggle(diagnostic.level, diagnostic.start, diagnostic.stop, diagnostic.message);
+        LOG_INFO(INFO_OF(language) << INFO_OF(added.size()));
+    }
+    else
+    {
+        editor->clearSquiggle();
+        for (auto const &diagnostic : newDiagnostics)
+            editor->squiggle(diagnostic.level, diagnostic.start, diagnostic.stop, diagnostic.message);
+        LOG_INFO(INFO_OF(language) << INFO_OF(newDiagnostics.size()));
     }
+
+    diagnostics = newDiagnostics;
+}
+
+bool LanguageServer::Diagnostic::operator<(const Diagnostic &other) const
+{
+    return std::tie(start, stop, level, message) < std::tie(other.start, other.stop, other.level, other.message);
+}
+
+bool LanguageServer::Diagnostic::operator==(const Diagnostic &other) const
+{
+    return std::tie(start, stop, level, message) == std::tie(other.start, other.stop, other.level, other.message);
 }
 
 void LanguageServer::onLSPServerResponseArrived(QJsonObject const &method, // NOLINT: It can be made static.
                                                 QJsonObject const &param)
 {
     LOG_INFO("Response from Server has arrived");
+
+    const auto result = param.contains("result") ? param["result"] : QJsonValue(param);
+
+    // the result of initialize, textDocumentSync is either a TextDocumentSyncKind or TextDocumentSyncOptions
+    if (result.toObject().contains("capabilities"))
+    {
+        const auto capabilities = result.toObject()["capabilities"].toObject();
+        const auto sync = capabilities["textDocumentSync"];
+        const int kind = sync.isObject() ? sync.toObject()["change"].toInt(FullSync) : sync.toInt(FullSync);
+        syncKind = kind == NoSync || kind == IncrementalSync ? SyncKind(kind) : FullSync;
+
+        completionSupported = capabilities.contains("completionProvider");
+        completionTriggers.clear();
+        for (auto const &trigger : capabilities["completionProvider"].toObject()["triggerCharacters"].toArray())
+            completionTriggers += trigger.toString().right(1);
+
+        LOG_INFO(INFO_OF(language) << INFO_OF(syncKind) << BOOL_INFO_OF(completionSupported));
+    }
+    else if (!completionRequest.id.isEmpty() && (result.isArray() || result.toObject().contains("items")))
+    {
+        applyCompletion(responseIdOf(method, param), result);
+    }
 }
 
 void LanguageServer::onLSPServerRequestArrived(QString const &method, // NOLINT: It can be made static.
@@ -276,6 +900,8 @@ void LanguageServer::onLSPServerErrorArrived(QJsonObject const &id, QJsonObject
     LOG_ERR("ID is \n" << ID);
     LOG_ERR("ERR is \n" << ERR);
 
+    // the errors are shown in the message logger of the active tab
+    auto *logger = active == nullptr ? nullptr : active->logger.data();
     if (logger != nullptr)
         logger->error(tr("Language Server [%1]").arg(language),
                       tr("Language server sent an error. Please check log for details."));
@@ -285,6 +911,7 @@ void LanguageServer::onLSPServerProcessError(QProcess::ProcessError const &error
 {
     LOG_WARN_IF(error == QProcess::Crashed, "LSP Process errored out " << INFO_OF(error));
     LOG_ERR_IF(error != QProcess::Crashed, "LSP Process errored out " << INFO_OF(error));
+    auto *logger = active == nullptr ? nullptr : active->logger.data();
     if (logger == nullptr)
         return;
     switch (error)
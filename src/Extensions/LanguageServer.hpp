@@ -15,15 +15,30 @@
  *
  */
 
+/*
+ * The client of a language server for one language.
+ * The documents of the recently used tabs are kept open in the server, in the LRU order, so the server doesn't parse
+ * them again when switching between the tabs. The diagnostics are routed to the editors by the URIs. Only the active
+ * document, i.e. the one of the current tab, is synced and linted.
+ * Completions are requested when typing a word, and the request in flight is cancelled when it's no longer useful. The
+ * completions of a word are kept and filtered by QCompleter while typing the rest of the word, and the ones arriving
+ * too late are not shown, so typing never waits for the server.
+ * The server is started when the first document is opened, and stopped when no document has been open for a while.
+ */
+
 #ifndef LANGUAGE_SERVER_H
 #define LANGUAGE_SERVER_H
 
 #include <QCodeEditor>
+#include <QElapsedTimer>
 #include <QJsonObject>
+#include <QPointer>
 #include <QProcess>
 
 class MessageLogger;
 class LSPClient;
+class QCompleter;
+class QTimer;
 
 namespace Extensions
 {
@@ -35,13 +50,40 @@ class LanguageServer : public QObject
     explicit LanguageServer(QString const &lang);
     ~LanguageServer() override;
 
+    /**
+     * @brief make the document of an editor the active one, it's opened in the server if it's not open yet
+     * @note The least recently used document is closed if there are too many open documents.
+     */
     void openDocument(QString const &path, QCodeEditor *editor, MessageLogger *log);
-    void closeDocument();
+
+    /**
+     * @brief close the document of an editor if it's open, and clear its diagnostics
+     * @note The document of an editor is closed automatically when the editor is destroyed.
+     */
+    void closeDocument(QCodeEditor *editor);
+
+    /**
+     * @brief send the changes of the active document since the last request to the server, and ask it to lint the code
+     * @note The changes are sent as incremental edits if the server supports it, otherwise the whole code is sent.
+     */
     void requestLinting();
 
+    /**
+     * @returns whether there is an active document and the server is running
+     */
     bool isDocumentOpen() const;
 
+    /**
+     * @returns the delay before the next linting in milliseconds, it's adapted to the measured latency of the server
+     * @param minimum the minimum delay set by the user
+     */
+    int lintingDelay(int minimum) const;
+
     void updateSettings();
+
+    /**
+     * @brief change the path of the active document
+     */
     void updatePath(QString const &);
 
   private slots:
@@ -52,8 +94,84 @@ class LanguageServer : public QObject
     void onLSPServerProcessError(QProcess::ProcessError const &error);
     void onLSPServerProcessFinished(int exitCode, QProcess::ExitStatus status);
     void onLSPServerNewStderr(const QString &content);
+    void applyPendingDiagnostics();
+    void onIdleTimeout();
 
   private:
+    // the values of TextDocumentSyncKind in the protocol
+    enum SyncKind
+    {
+        NoSync = 0,
+        FullSync = 1,
+        IncrementalSync = 2
+    };
+
+    struct Line
+    {
+        int length; // without the line break
+        uint hash;  // to ignore the format changes, which are reported as changes of the text
+    };
+
+    struct Diagnostic
+    {
+        QCodeEditor::SeverityLevel level;
+        QPair<int, int> start, stop; // the 1-based line numbers and the 0-based columns
+        QString message;
+
+        bool operator<(const Diagnostic &other) const;
+        bool operator==(const Diagnostic &other) const;
+    };
+
+    struct Change
+    {
+        int startLine, startColumn, endLine, endColumn; // the replaced range in the text before this change
+        QString text;
+    };
+
+    struct Document
+    {
+        QString path;
+        QPointer<QCodeEditor> editor;
+        QPointer<MessageLogger> logger;
+
+        QVector<Line> lines;            // the lines of the text the server knows
+        QVector<Change> pendingChanges; // the changes not sent to the server yet
+        bool fullSyncNeeded = false;    // whether the changes can't be tracked, so the whole text should be sent
+        bool lintingNeeded = false;     // whether the last changes are sent without asking for diagnostics
+
+        QVector<Diagnostic> diagnostics; // the squiggles in the editor, sorted
+        QJsonObject pendingDiagnostics;  // the latest published diagnostics, not applied yet
+
+        // the completions of a word, they are requested again if the word is changed or the server asks to
+        QCompleter *completer = nullptr;   // nullptr if autocomplete is disabled
+        int completionLine = -1;           // the start of the word, -1 if there are no completions
+        int completionColumn = -1;         // the start of the word
+        QString completionPrefix;          // the prefix of the word when the completions were requested
+        bool completionIncomplete = false; // whether the server asks to request again when the prefix is changed
+
+        QMetaObject::Connection contentsChangeConnection;
+        QMetaObject::Connection destroyedConnection;
+    };
+
+    struct CompletionRequest
+    {
+        QString id; // empty if there's no request in flight
+        Document *document = nullptr;
+        int line = -1, column = -1; // the start of the word
+        QString prefix;
+        QElapsedTimer timer;
+    };
+
+    /**
+     * @brief create the client and launch the server, it's initialized when the first document is opened
+     */
+    void startServer();
+
+    /**
+     * @brief shut down the server, the open documents are not closed
+     */
+    void stopServer();
+
     void performConnection();
     void createClient();
     bool shouldCreateClient();
@@ -61,12 +179,74 @@ class LanguageServer : public QObject
     static QCodeEditor::SeverityLevel lspSeverity(int in);
     void initializeLSP(QString const &filePath);
 
-    QCodeEditor *m_editor = nullptr;
-    MessageLogger *logger = nullptr;
+    static std::string uriOf(const QString &path);
+    Document *findDocument(QCodeEditor *editor) const;
+    Document *findDocumentByUri(const QString &uri) const;
+
+    /**
+     * @brief send didOpen for a document and start tracking its changes
+     */
+    void sendOpen(Document *document);
+
+    /**
+     * @param clearSquiggles whether to clear the diagnostics in the editor, false if the editor is being destroyed
+     */
+    void closeDocument(Document *document, bool clearSquiggles = true);
+
+    /**
+     * @brief start tracking the changes of a document from its current text
+     */
+    static void resetLines(Document *document);
+
+    /**
+     * @brief send the pending changes of a document
+     * @returns whether anything is sent
+     */
+    bool sendChanges(Document *document, bool wantDiagnostics);
+
+    void onContentsChange(Document *document, int position, int charsRemoved, int charsAdded);
+    void applyDiagnostics(Document *document);
+
+    void attachCompleter(Document *document);
+
+    /**
+     * @brief find the part of the word before a position
+     * @param line the 0-based line number
+     * @param column the 0-based column of the start of the word
+     */
+    static bool wordAt(QTextDocument *doc, int position, int &line, int &column, QString &prefix);
+
+    /**
+     * @brief request, reuse or cancel the completions after a change of the active document
+     */
+    void updateCompletion(Document *document, int position, int charsRemoved, int charsAdded);
+    void requestCompletion(Document *document, int line, int column, const QString &prefix);
+    void cancelCompletion();
+    void applyCompletion(const QString &id, const QJsonValue &result);
+
+    /**
+     * @returns the ID of a response, empty if it's unknown
+     */
+    static QString responseIdOf(const QJsonObject &id, const QJsonObject &response);
+
     LSPClient *lsp = nullptr;
     bool isInitialized = false;
     QString language;
-    QString openFile;
+
+    QList<Document *> documents; // the documents open in the server, the most recently used first
+    Document *active = nullptr;  // the document of the current tab, it's also kept when the server is not running
+
+    SyncKind syncKind = FullSync; // the textDocumentSync kind of the server, full until the server tells it
+
+    QTimer *diagnosticsTimer = nullptr; // coalesces the bursts of published diagnostics
+    QTimer *idleTimer = nullptr;        // stops the server when no document has been open for a while
+
+    QElapsedTimer lintingTimer; // started when the server is asked to lint, until the diagnostics arrive
+    int lintingLatency = 0;     // the moving average of the linting latency in milliseconds, 0 if it's not measured
+
+    bool completionSupported = false; // whether the server provides completions
+    QString completionTriggers;       // the last characters of the trigger characters of the server
+    CompletionRequest completionRequest;
 };
 } // namespace Extensions
 
@@ -0,0 +1,549 @@
+/*
+ * Copyright (C) 2019-2021 Ashar Khan <ashar786khan@gmail.com>
+ *
+ * This file is part of CP Editor.
+ *
+ * CP Editor is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * I will not be responsible if CP Editor behaves in unexpected way and
+ * causes your ratings to go down and or lose any important contest.
+ *
+ * Believe Software is "Software" and it isn't immune to bugs.
+ *
+ */
+
+#include "Extensions/LexerHighlighter.hpp"
+#include "Core/EventLogger.hpp"
+#include <QCodeEditor>
+#include <QSet>
+#include <QSyntaxStyle>
+#include <QTextBlock>
+#include <QTimer>
+#include <algorithm>
+#include <limits>
+
+namespace Extensions
+{
+namespace
+{
+// the time to format lines in a run before the other lines are only lexed, and the time of each background pass
+const qint64 FOREGROUND_BUDGET = 10;
+const qint64 BACKGROUND_BUDGET = 8;
+
+const int NO_PENDING = std::numeric_limits<int>::max();
+
+const int KIND_BITS = 4;
+
+// the runs highlighting at least this number of lines are logged with their timings, e.g. when loading a file
+const int LOGGED_RUN_LINES = 1000;
+
+class BlockData : public QTextBlockUserData
+{
+  public:
+    bool isPending = false; // whether the line is only lexed, not formatted yet
+    QString delimiter;      // the delimiter of the raw string at the end of the line
+};
+
+int stateKind(int state)
+{
+    return state & ((1 << KIND_BITS) - 1);
+}
+
+bool isIdentifierStart(QChar c)
+{
+    return c.isLetter() || c == '_';
+}
+
+bool isIdentifierChar(QChar c)
+{
+    return c.isLetterOrNumber() || c == '_';
+}
+
+const QStringList CPP_KEYWORDS = {"alignas", "alignof", "and", "and_eq", "asm", "auto", "bitand", "bitor", "break",
+                                  "case", "catch", "class", "compl", "concept", "const", "consteval", "constexpr",
+                                  "constinit", "const_cast", "continue", "co_await", "co_return", "co_yield",
+                                  "decltype", "default", "delete", "do", "dynamic_cast", "else", "enum", "explicit",
+                                  "export", "extern", "false", "final", "for", "friend", "goto", "if", "inline",
+                                  "mutable", "namespace", "new", "noexcept", "not", "not_eq", "nullptr", "operator",
+                                  "or", "or_eq", "override", "private", "protected", "public", "register",
+                                  "reinterpret_cast", "requires", "return", "sizeof", "static", "static_assert",
+                                  "static_cast", "struct", "switch", "template", "this", "thread_local", "throw",
+                                  "true", "try", "typedef", "typeid", "typename", "union", "using", "virtual",
+                                  "volatile", "while", "xor", "xor_eq"};
+
+const QStringList CPP_PRIMITIVE_TYPES = {"bool", "char", "char8_t", "char16_t", "char32_t", "double", "float", "int",
+                                         "long", "short", "signed", "unsigned", "void", "wchar_t", "size_t", "int8_t",
+                                         "int16_t", "int32_t", "int64_t", "uint8_t", "uint16_t", "uint32_t", "uint64_t",
+                                         "__int128"};
+
+const QStringList JAVA_KEYWORDS = {"abstract", "assert", "break", "case", "catch", "class", "const", "continue",
+                                   "default", "do", "else", "enum", "extends", "false", "final", "finally", "for",
+                                   "goto", "if", "implements", "import", "instanceof", "interface", "native", "new",
+                                   "null", "package", "private", "protected", "public", "record", "return", "static",
+                                   "strictfp", "super", "switch", "synchronized", "this", "throw", "throws",
+                                   "transient", "true", "try", "var", "volatile", "while", "yield"};
+
+const QStringList JAVA_PRIMITIVE_TYPES = {"boolean", "byte", "char", "double", "float", "int", "long", "short", "void"};
+
+const QStringList PYTHON_KEYWORDS = {"False", "None", "True", "and", "as", "assert", "async", "await", "break", "case",
+                                     "class", "continue", "def", "del", "elif", "else", "except", "finally", "for",
+                                     "from", "global", "if", "import", "in", "is", "lambda", "match", "nonlocal", "not",
+                                     "or", "pass", "raise", "return", "try", "while", "with", "yield"};
+
+const QStringList PYTHON_PRIMITIVE_TYPES = {"abs", "bool", "dict", "enumerate", "float", "input", "int", "len", "list",
+                                            "map", "max", "min", "object", "open", "print", "range", "reversed", "self",
+                                            "set", "sorted", "str", "sum", "super", "tuple", "zip"};
+
+const QSet<QString> CPP_RAW_STRING_PREFIXES = {"R", "LR", "uR", "UR", "u8R"};
+const QSet<QString> CPP_STRING_PREFIXES = {"L", "u", "U", "u8"};
+const QString PYTHON_STRING_PREFIX_CHARS = "rRbBuUfF";
+} // namespace
+
+LexerHighlighter::LexerHighlighter(const QString &language, QCodeEditor *editor)
+    : QStyleSyntaxHighlighter(nullptr), isCpp(language != "Java" && language != "Python"), isJava(language == "Java"),
+      isPython(language == "Python"), editor(editor), scanBlockNumber(NO_PENDING)
+{
+    for (auto const &word : isPython ? PYTHON_KEYWORDS : isJava ? JAVA_KEYWORDS : CPP_KEYWORDS)
+        words[word] = Keyword;
+    for (auto const &word : isPython ? PYTHON_PRIMITIVE_TYPES : isJava ? JAVA_PRIMITIVE_TYPES : CPP_PRIMITIVE_TYPES)
+        words[word] = PrimitiveType;
+
+    // the names after these keywords are the names of the definitions
+    definitions = {{"class", Type}, {"struct", Type}, {"enum", Type}, {"interface", Type}, {"def", Function}};
+
+    pendingTimer = new QTimer(this);
+    pendingTimer->setSingleShot(true);
+    pendingTimer->setInterval(0);
+    connect(pendingTimer, &QTimer::timeout, this, &LexerHighlighter::formatPendingBlocks);
+}
+
+bool LexerHighlighter::hasPendingLines() const
+{
+    return scanBlockNumber != NO_PENDING;
+}
+
+void LexerHighlighter::highlightBlock(const QString &text)
+{
+    startRun();
+
+    // the lines highlighted after the budget are only lexed, so a large paste doesn't freeze the editor
+    const bool format = isFormattingPending || runTimer.elapsed() < FOREGROUND_BUDGET;
+
+    int state = qMax(previousBlockState(), 0);
+    QString delimiter;
+    if (stateKind(state) == RawString)
+    {
+        if (auto *previous = static_cast<BlockData *>(currentBlock().previous().userData()))
+            delimiter = previous->delimiter;
+    }
+
+    state = lex(text, state, delimiter, format);
+    setCurrentBlockState(state);
+    ++runLines;
+    if (!format)
+        ++runLexedLines;
+
+    auto *data = static_cast<BlockData *>(currentBlockUserData());
+    if (data == nullptr && (!format || !delimiter.isEmpty()))
+    {
+        data = new BlockData();
+        setCurrentBlockUserData(data);
+    }
+    if (data != nullptr)
+    {
+        data->isPending = !format;
+        data->delimiter = delimiter;
+    }
+
+    if (!format || scanBlockNumber != NO_PENDING)
+    {
+        // the pending lines after an edit are after the edited line, even if some lines before them are removed
+        scanBlockNumber = qMin(scanBlockNumber, currentBlock().blockNumber());
+        if (!pendingTimer->isActive())
+            pendingTimer->start();
+    }
+}
+
+int LexerHighlighter::lex(const QString &text, int state, QString &delimiter, bool format)
+{
+    const int length = text.length();
+    const QChar *s = text.constData();
+    int i = 0;
+
+    auto mark = [&](int start, int end, Token token) {
+        if (format && token != Text && end > start)
+            setFormat(start, end - start, formats[token]);
+    };
+
+    auto rawState = [&delimiter] { return RawString | int((qHash(delimiter) & 0x7FFFFFF) << KIND_BITS); };
+
+    // the index after the closing quote, or -1 if the line ends in the string
+    auto skipString = [&](int from, QChar quote, bool &continued) {
+        for (int j = from; j < length; ++j)
+        {
+            if (s[j] == '\\')
+            {
+                if (j + 1 == length)
+                    continued = true;
+                ++j;
+            }
+            else if (s[j] == quote)
+            {
+                return j + 1;
+            }
+        }
+        return -1;
+    };
+
+    // the index after the closing triple quotes, or -1 if the line ends in the string
+    auto skipTripleQuotes = [&](int from, QChar quote) {
+        for (int j = from; j + 2 < length; ++j)
+        {
+            if (s[j] == '\\')
+                ++j;
+            else if (s[j] == quote && s[j + 1] == quote && s[j + 2] == quote)
+                return j + 3;
+        }
+        return -1;
+    };
+
+    // lex a string or a character literal starting at start, the opening quote is at quote
+    // returns the state if the line ends in the string, otherwise -1
+    auto lexString = [&](int start, int quote) {
+        const QChar q = s[quote];
+        if ((isPython || (isJava && q == '"')) && quote + 2 < length && s[quote + 1] == q && s[quote + 2] == q)
+        {
+            const int end = skipTripleQuotes(quote + 3, q);
+            if (end == -1)
+            {
+                mark(start, length, String);
+                return int(q == '"' ? TripleDoubleQuote : TripleSingleQuote);
+            }
+            mark(start, end, String);
+            i = end;
+            return -1;
+        }
+        bool continued = false;
+        const int end = skipString(quote + 1, q, continued);
+        if (end == -1)
+        {
+            mark(start, length, String);
+            return int(isCpp && q == '"' && continued ? ContinuedString : Normal);
+        }
+        mark(start, end, String);
+        i = end;
+        return -1;
+    };
+
+    // continue the string or the comment at the end of the previous line
+    switch (stateKind(state))
+    {
+    case BlockComment: {
+        const int end = text.indexOf("*/");
+        if (end == -1)
+        {
+            mark(0, length, Comment);
+            return BlockComment;
+        }
+        mark(0, end + 2, Comment);
+        i = end + 2;
+        break;
+    }
+    case ContinuedString: {
+        bool continued = false;
+        const int end = skipString(0, '"', continued);
+        if (end == -1)
+        {
+            mark(0, length, String);
+            return continued ? ContinuedString : Normal;
+        }
+        mark(0, end, String);
+        i = end;
+        break;
+    }
+    case RawString: {
+        const int end = text.indexOf(')' + delimiter + '"');
+        if (end == -1)
+        {
+            mark(0, length, String);
+            return rawState();
+        }
+        i = end + delimiter.length() + 2;
+        mark(0, i, String);
+        delimiter.clear();
+        break;
+    }
+    case TripleSingleQuote:
+    case TripleDoubleQuote: {
+        const int end = skipTripleQuotes(0, stateKind(state) == TripleSingleQuote ? '\'' : '"');
+        if (end == -1)
+        {
+            mark(0, length, String);
+            return state;
+        }
+        mark(0, end, String);
+        i = end;
+        break;
+    }
+    default:
+        break;
+    }
+
+    bool isFirstToken = true;
+    Token nameToken = Text; // the token of the next identifier if it's the name of a definition
+
+    while (i < length)
+    {
+        const QChar c = s[i];
+        if (c.isSpace())
+        {
+            ++i;
+            continue;
+        }
+
+        const bool isFirst = isFirstToken;
+        isFirstToken = false;
+        const Token definitionName = nameToken;
+        nameToken = Text;
+
+        if ((!isPython && c == '/' && i + 1 < length && s[i + 1] == '/') || (isPython && c == '#'))
+        {
+            mark(i, length, Comment);
+            return Normal;
+        }
+
+        if (!isPython && c == '/' && i + 1 < length && s[i + 1] == '*')
+        {
+            const int end = text.indexOf("*/", i + 2);
+            if (end == -1)
+            {
+                mark(i, length, Comment);
+                return BlockComment;
+            }
+            mark(i, end + 2, Comment);
+            i = end + 2;
+            continue;
+        }
+
+        if (isCpp && c == '#' && isFirst)
+        {
+            int start = i + 1;
+            while (start < length && s[start].isSpace())
+                ++start;
+            int end = start;
+            while (end < length && isIdentifierChar(s[end]))
+                ++end;
+            mark(i, end, Preprocessor);
+            i = end;
+
+            if (text.midRef(start, end - start) == "include")
+            {
+                while (i < length && s[i].isSpace())
+                    ++i;
+                const int close = i < length && s[i] == '<' ? text.indexOf('>', i) : -1;
+                if (close != -1)
+                {
+                    mark(i, close + 1, String);
+                    i = close + 1;
+                }
+            }
+            continue;
+        }
+
+        if (!isCpp && c == '@' && i + 1 < length && isIdentifierStart(s[i + 1]))
+        {
+            // decorators in Python and annotations in Java
+            int end = i + 1;
+            while (end < length && (isIdentifierChar(s[end]) || s[end] == '.'))
+                ++end;
+            mark(i, end, Preprocessor);
+            i = end;
+            continue;
+        }
+
+        if (c == '"' || c == '\'')
+        {
+            const int result = lexString(i, i);
+            if (result != -1)
+                return result;
+            continue;
+        }
+
+        if (c.isDigit() || (c == '.' && i + 1 < length && s[i + 1].isDigit()))
+        {
+            const bool isHex = c == '0' && i + 1 < length && (s[i + 1] == 'x' || s[i + 1] == 'X');
+            int end = i + 1;
+            while (end < length)
+            {
+                const QChar d = s[end];
+                const QChar previous = s[end - 1];
+                if (isIdentifierChar(d) || d == '.')
+                    ++end;
+                else if (isCpp && d == '\'' && end + 1 < length && s[end + 1].isLetterOrNumber())
+                    ++end; // digit separators
+                else if ((d == '+' || d == '-') &&
+                         (isHex ? (previous == 'p' || previous == 'P') : (previous == 'e' || previous == 'E')))
+                    ++end; // exponents
+                else
+                    break;
+            }
+            mark(i, end, Number);
+            i = end;
+            continue;
+        }
+
+        if (isIdentifierStart(c))
+        {
+            int end = i + 1;
+            while (end < length && isIdentifierChar(s[end]))
+                ++end;
+            const auto word = QString::fromRawData(s + i, end - i);
+
+            if (end < length && (s[end] == '"' || s[end] == '\''))
+            {
+                // the prefixes of strings, e.g. u8"", R"()", f'', rb''
+                if (isCpp && s[end] == '"' && CPP_RAW_STRING_PREFIXES.contains(word))
+                {
+                    const int open = text.indexOf('(', end + 1);
+                    if (open != -1)
+                    {
+                        delimiter = text.mid(end + 1, open - end - 1);
+                        const int close = text.indexOf(')' + delimiter + '"', open + 1);
+                        if (close == -1)
+                        {
+                            mark(i, length, String);
+                            return rawState();
+                        }
+                        mark(i, close + delimiter.length() + 2, String);
+                        i = close + delimiter.length() + 2;
+                        delimiter.clear();
+                        continue;
+                    }
+                }
+                if ((isCpp && CPP_STRING_PREFIXES.contains(word)) ||
+                    (isPython && word.length() <= 2 && std::all_of(word.begin(), word.end(), [](QChar ch) {
+                         return PYTHON_STRING_PREFIX_CHARS.contains(ch);
+                     })))
+                {
+                    const int result = lexString(i, end);
+                    if (result != -1)
+                        return result;
+                    continue;
+                }
+            }
+
+            const auto it = words.constFind(word);
+            if (it != words.constEnd())
+            {
+                mark(i, end, it.value());
+                nameToken = definitions.value(word, Text);
+            }
+            else if (definitionName != Text)
+            {
+                mark(i, end, definitionName);
+            }
+            else
+            {
+                int next = end;
+                while (next < length && s[next].isSpace())
+                    ++next;
+                if (next < length && s[next] == '(')
+                    mark(i, end, Function);
+            }
+            i = end;
+            continue;
+        }
+
+        ++i;
+    }
+
+    return Normal;
+}
+
+void LexerHighlighter::startRun()
+{
+    if (runTimer.isValid())
+        return;
+
+    runTimer.start();
+    runLines = runLexedLines = 0;
+
+    if (syntaxStyle() != nullptr)
+    {
+        static const char *const names[TokenCount] = {"Text",    "Keyword",      "PrimitiveType", "Number", "String",
+                                                      "Comment", "Preprocessor", "Function",      "Type"};
+        for (int i = 0; i < TokenCount; ++i)
+            formats[i] = syntaxStyle()->getFormat(names[i]);
+    }
+
+    // the run ends when the control returns to the event loop
+    QTimer::singleShot(0, this, [this] {
+        if (runLines >= LOGGED_RUN_LINES)
+        {
+            LOG_INFO("Highlighted a run " << INFO_OF(runLines) << INFO_OF(runLexedLines)
+                                          << INFO_OF(runTimer.elapsed()));
+            if (runLexedLines > 0)
+            {
+                pendingElapsed.start();
+                pendingLines = runLexedLines;
+            }
+        }
+        runTimer.invalidate();
+    });
+}
+
+void LexerHighlighter::formatPendingBlocks()
+{
+    if (document() == nullptr || scanBlockNumber == NO_PENDING)
+        return;
+
+    QElapsedTimer timer;
+    timer.start();
+    isFormattingPending = true;
+
+    if (editor != nullptr)
+    {
+        const auto rect = editor->viewport()->rect();
+        const int last = editor->cursorForPosition(rect.bottomRight()).blockNumber();
+        for (auto block = editor->cursorForPosition(rect.topLeft()).block();
+             block.isValid() && block.blockNumber() <= last; block = block.next())
+        {
+            formatIfPending(block);
+        }
+    }
+
+    auto block = document()->findBlockByNumber(scanBlockNumber);
+    while (block.isValid() && timer.elapsed() < BACKGROUND_BUDGET)
+    {
+        formatIfPending(block);
+        block = block.next();
+    }
+
+    isFormattingPending = false;
+
+    if (block.isValid())
+    {
+        scanBlockNumber = block.blockNumber();
+        pendingTimer->start();
+    }
+    else
+    {
+        scanBlockNumber = NO_PENDING;
+        if (pendingElapsed.isValid())
+        {
+            LOG_INFO("Formatted the pending lines " << INFO_OF(pendingLines) << INFO_OF(pendingElapsed.elapsed()));
+            pendingElapsed.invalidate();
+        }
+    }
+}
+
+void LexerHighlighter::formatIfPending(const QTextBlock &block)
+{
+    auto *data = static_cast<BlockData *>(block.userData());
+    if (data != nullptr && data->isPending)
+        rehighlightBlock(block);
+}
+} // namespace Extensions
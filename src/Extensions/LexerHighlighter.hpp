@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2019-2021 Ashar Khan <ashar786khan@gmail.com>
+ *
+ * This file is part of CP Editor.
+ *
+ * CP Editor is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * I will not be responsible if CP Editor behaves in unexpected way and
+ * causes your ratings to go down and or lose any important contest.
+ *
+ * Believe Software is "Software" and it isn't immune to bugs.
+ *
+ */
+
+/*
+ * The syntax highlighter of C++, Java and Python, a state machine lexer scanning each line once.
+ * The state at the end of a line is saved as the block state, so after an edit, QSyntaxHighlighter only highlights
+ * the changed lines and the following lines until the state at the end of a line is the same as before.
+ * When a lot of lines are highlighted at once, e.g. when loading or pasting a large file, the lines after a time
+ * budget are only lexed to get their states, and they are formatted later in the background, the visible ones first.
+ */
+
+#ifndef LEXERHIGHLIGHTER_HPP
+#define LEXERHIGHLIGHTER_HPP
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QPointer>
+#include <QStyleSyntaxHighlighter>
+#include <QTextCharFormat>
+
+class QCodeEditor;
+class QTextBlock;
+class QTimer;
+
+namespace Extensions
+{
+class LexerHighlighter : public QStyleSyntaxHighlighter
+{
+    Q_OBJECT
+
+  public:
+    /**
+     * @param language "C++", "Java" or "Python", other languages are highlighted as C++
+     * @param editor the editor showing the document, its visible lines are formatted first in the background
+     */
+    explicit LexerHighlighter(const QString &language, QCodeEditor *editor);
+
+    /**
+     * @brief whether there are lines which are only lexed and not formatted yet
+     */
+    bool hasPendingLines() const;
+
+  protected:
+    void highlightBlock(const QString &text) override;
+
+  private:
+    enum Token
+    {
+        Text,
+        Keyword,
+        PrimitiveType,
+        Number,
+        String,
+        Comment,
+        Preprocessor,
+        Function,
+        Type,
+        TokenCount
+    };
+
+    // the state at the end of a line, the lower 4 bits are the kind
+    // for RawString, the other bits are the hash of the delimiter, so that the following lines are highlighted again
+    // when the delimiter changes, while the delimiter itself is saved in the block data to find the end of the string
+    enum StateKind
+    {
+        Normal,
+        BlockComment,      // in /* */
+        ContinuedString,   // in a C++ string ending with a backslash
+        RawString,         // in a C++ raw string
+        TripleSingleQuote, // in a Python ''' string
+        TripleDoubleQuote, // in a Python """ string or a Java text block
+    };
+
+    /**
+     * @brief lex a line and format it
+     * @param text the text of the line
+     * @param state the state at the end of the previous line
+     * @param delimiter the delimiter of the raw string at the end of the previous line, updated for this line
+     * @param format whether to format the line, otherwise it's only lexed
+     * @returns the state at the end of the line
+     */
+    int lex(const QString &text, int state, QString &delimiter, bool format);
+
+    /**
+     * @brief start the time budget if this is the first line highlighted since the control returned to the event loop
+     */
+    void startRun();
+
+    /**
+     * @brief format some lines which are only lexed, in a limited time
+     */
+    void formatPendingBlocks();
+
+    void formatIfPending(const QTextBlock &block);
+
+    bool isCpp, isJava, isPython;
+    QPointer<QCodeEditor> editor;
+    QHash<QString, Token> words;       // the keywords and the primitive types
+    QHash<QString, Token> definitions; // the keywords followed by the names of definitions, e.g. class, def
+
+    QTextCharFormat formats[TokenCount]; // updated when a run starts, in case the style is changed
+    QElapsedTimer runTimer;              // valid while highlighting lines in a run
+    bool isFormattingPending = false;    // whether the lines are formatted by formatPendingBlocks()
+    int scanBlockNumber;                 // there's no pending line before this line
+    QTimer *pendingTimer = nullptr;      // calls formatPendingBlocks() while there are pending lines
+
+    // the timings of the runs with a lot of lines are logged, e.g. when loading a large file
+    int runLines = 0;             // the number of lines highlighted in the current run
+    int runLexedLines = 0;        // the number of lines only lexed in the current run
+    int pendingLines = 0;         // the number of lines only lexed in the last logged run
+    QElapsedTimer pendingElapsed; // valid from the end of the last logged run until its lines are all formatted
+};
+} // namespace Extensions
+
+#endif // LEXERHIGHLIGHTER_HPP
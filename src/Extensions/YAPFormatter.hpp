@@ -41,7 +41,7 @@ class YAPFormatter : public CodeFormatter
 
     QString newSource(const QString &out) const override;
 
-    QTextCursor newCursor(const QString &out, const QStringList & /*args*/) const override;
+    QTextCursor newCursor(const QString &out, const QString & /*extraOut*/) const override;
 };
 
 } // namespace Extensions
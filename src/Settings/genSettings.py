@@ -116,11 +116,13 @@ def addDefaultPaths(obj):
         ("Open Contest", "${contest}", "contest, file, testcase, checker"),
         ("Load Single Test Case", "${testcase}", "testcase"),
         ("Add Pairs Of Test Cases", "${testcase}", "testcase"),
+        ("Import Test Cases", "${testcase}", "testcase"),
         ("Save Test Case To A File", "${testcase}", "testcase"),
         ("Custom Checker", "${checker}", "checker"),
         ("Export And Import Settings", "${settings}", "settings"),
         ("Export And Load Session", "${session}", "session"),
         ("Extract And Load Snippets", "${snippets}", "snippets"),
+        ("Export Performance Trace", "${file}", ""),
     ]
 
     for action in actions:
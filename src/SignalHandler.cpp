@@ -20,18 +20,16 @@
  */
 
 #include "SignalHandler.hpp"
+#include "Core/EventLogger.hpp"
 #include <cassert>
-
-#ifndef _WIN32
-
 #include <csignal>
 
-#else
+#ifdef _WIN32
 
 #include <set>
 #include <windows.h>
 
-#endif //!_WIN32
+#endif //_WIN32
 
 // There can be only ONE SignalHandler per process
 SignalHandler *g_handler = nullptr;
@@ -51,6 +49,16 @@ int POSIX_logicalToPhysical(int signal);
 
 #endif //_WIN32
 
+// The crash signals are always handled, the logs not written yet are dumped before the default action
+const int CRASH_SIGNALS[] = {SIGSEGV, SIGABRT, SIGFPE, SIGILL};
+
+void crashHandleFunc(int signal)
+{
+    Core::Log::dumpPendingLogs(signal);
+    std::signal(signal, SIG_DFL);
+    std::raise(signal);
+}
+
 SignalHandler::SignalHandler(int mask) : _mask(mask)
 {
     assert(g_handler == nullptr);
@@ -77,10 +85,16 @@ SignalHandler::SignalHandler(int mask) : _mask(mask)
 #endif //_WIN32
         }
     }
+
+    for (int sig : CRASH_SIGNALS)
+        std::signal(sig, crashHandleFunc);
 }
 
 SignalHandler::~SignalHandler()
 {
+    for (int sig : CRASH_SIGNALS)
+        std::signal(sig, SIG_DFL);
+
 #ifdef _WIN32
     SetConsoleCtrlHandler(WIN32_handleFunc, FALSE);
 #else
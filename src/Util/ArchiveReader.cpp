@@ -0,0 +1,373 @@
+/*
+ * Copyright (C) 2019-2021 Ashar Khan <ashar786khan@gmail.com>
+ *
+ * This file is part of CP Editor.
+ *
+ * CP Editor is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * I will not be responsible if CP Editor behaves in unexpected way and
+ * causes your ratings to go down and or lose any important contest.
+ *
+ * Believe Software is "Software" and it isn't immune to bugs.
+ *
+ */
+
+#include "Util/ArchiveReader.hpp"
+#include <QCoreApplication>
+#include <zlib.h>
+
+namespace Util
+{
+namespace
+{
+const qint64 CHUNK_SIZE = 1 << 16;
+
+const quint32 ZIP_LOCAL_HEADER = 0x04034b50;
+const quint32 ZIP_CENTRAL_HEADER = 0x02014b50;
+const quint32 ZIP_END_OF_CENTRAL_DIRECTORY = 0x06054b50;
+const int ZIP_END_OF_CENTRAL_DIRECTORY_SIZE = 22;
+const int ZIP_MAX_COMMENT_SIZE = 65535;
+const int TAR_BLOCK_SIZE = 512;
+
+quint16 readLE16(const QByteArray &data, int pos)
+{
+    return quint16(uchar(data[pos]) | uchar(data[pos + 1]) << 8);
+}
+
+quint32 readLE32(const QByteArray &data, int pos)
+{
+    return quint32(readLE16(data, pos)) | quint32(readLE16(data, pos + 2)) << 16;
+}
+
+QString tarString(const QByteArray &header, int pos, int size)
+{
+    auto field = header.mid(pos, size);
+    const int end = field.indexOf('\0');
+    return QString::fromUtf8(end == -1 ? field : field.left(end));
+}
+
+// numbers in tar headers are octal, or base-256 if the highest bit is set, -1 if it's invalid
+qint64 tarNumber(const QByteArray &header, int pos, int size)
+{
+    qint64 value = 0;
+    if (uchar(header[pos]) & 0x80)
+    {
+        value = uchar(header[pos]) & 0x7F;
+        for (int i = 1; i < size; ++i)
+            value = value << 8 | uchar(header[pos + i]);
+        return value;
+    }
+    for (int i = 0; i < size; ++i)
+    {
+        const char c = header[pos + i];
+        if (c >= '0' && c <= '7')
+            value = value * 8 + (c - '0');
+        else if (c != ' ' && c != '\0')
+            return -1;
+    }
+    return value;
+}
+
+bool isTarHeader(const QByteArray &header)
+{
+    if (header.size() < TAR_BLOCK_SIZE)
+        return false;
+    // the checksum is computed with the checksum field filled with spaces
+    qint64 sum = 0;
+    for (int i = 0; i < TAR_BLOCK_SIZE; ++i)
+        sum += (i >= 148 && i < 156) ? ' ' : uchar(header[i]);
+    return tarNumber(header, 148, 8) == sum;
+}
+
+/*
+ * Decodes a raw DEFLATE stream (RFC 1951) read from the source, and sends the output to the sink in chunks.
+ * Returns false if the stream is invalid or truncated, or if the sink returns false.
+ */
+bool inflateRaw(const std::function<qint64(char *data, qint64 maxSize)> &source, const ArchiveReader::Sink &sink)
+{
+    z_stream stream{};
+    // a negative window size means there is no zlib header or trailer, as in zip entries
+    if (inflateInit2(&stream, -MAX_WBITS) != Z_OK)
+        return false;
+
+    QByteArray input(int(CHUNK_SIZE), Qt::Uninitialized);
+    QByteArray output(int(CHUNK_SIZE), Qt::Uninitialized);
+    int status = Z_OK;
+    while (status != Z_STREAM_END)
+    {
+        const auto inputSize = source(input.data(), input.size());
+        if (inputSize <= 0)
+            break; // the stream is truncated
+        stream.next_in = reinterpret_cast<Bytef *>(input.data());
+        stream.avail_in = uInt(inputSize);
+        do
+        {
+            stream.next_out = reinterpret_cast<Bytef *>(output.data());
+            stream.avail_out = uInt(output.size());
+            status = inflate(&stream, Z_NO_FLUSH);
+            if (status != Z_OK && status != Z_STREAM_END && status != Z_BUF_ERROR)
+            {
+                inflateEnd(&stream);
+                return false;
+            }
+            const auto outputSize = output.size() - qint64(stream.avail_out);
+            if (outputSize > 0 && !sink(output.constData(), outputSize))
+            {
+                inflateEnd(&stream);
+                return false;
+            }
+        } while (status != Z_STREAM_END && stream.avail_out == 0);
+    }
+
+    inflateEnd(&stream);
+    return status == Z_STREAM_END;
+}
+
+} // namespace
+
+ArchiveReader::ArchiveReader(const QString &path) : file(path)
+{
+}
+
+bool ArchiveReader::open()
+{
+    entryList.clear();
+
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        error = QCoreApplication::translate("Util::ArchiveReader", "Failed to open [%1]. Do I have read permission?")
+                    .arg(file.fileName());
+        return false;
+    }
+
+    const auto header = file.peek(TAR_BLOCK_SIZE);
+    if (header.startsWith("PK"))
+    {
+        isZip = true;
+        return readZipEntries();
+    }
+    if (isTarHeader(header))
+    {
+        isZip = false;
+        return readTarEntries();
+    }
+
+    error = QCoreApplication::translate("Util::ArchiveReader", "[%1] is not a zip or tar archive.")
+                .arg(file.fileName());
+    return false;
+}
+
+QVector<ArchiveReader::Entry> ArchiveReader::entries() const
+{
+    return entryList;
+}
+
+bool ArchiveReader::extract(const Entry &entry, const Sink &sink)
+{
+    return isZip ? extractZipEntry(entry, sink) : extractTarEntry(entry, sink);
+}
+
+QString ArchiveReader::errorString() const
+{
+    return error;
+}
+
+bool ArchiveReader::readZipEntries()
+{
+    // the end of central directory record is at the end of the file, followed by a comment
+    const qint64 tailSize = qMin(file.size(), qint64(ZIP_END_OF_CENTRAL_DIRECTORY_SIZE + ZIP_MAX_COMMENT_SIZE));
+    file.seek(file.size() - tailSize);
+    const auto tail = file.read(tailSize);
+    int end = tail.size() - ZIP_END_OF_CENTRAL_DIRECTORY_SIZE;
+    while (end >= 0 && readLE32(tail, end) != ZIP_END_OF_CENTRAL_DIRECTORY)
+        --end;
+    if (end < 0)
+    {
+        error = QCoreApplication::translate("Util::ArchiveReader", "[%1] is not a valid zip archive.")
+                    .arg(file.fileName());
+        return false;
+    }
+
+    const int count = readLE16(tail, end + 10);
+    const quint32 directorySize = readLE32(tail, end + 12);
+    const quint32 directoryOffset = readLE32(tail, end + 16);
+    if (count == 0xFFFF || directoryOffset == 0xFFFFFFFFU)
+    {
+        error = QCoreApplication::translate("Util::ArchiveReader", "[%1] is a ZIP64 archive, which is not supported.")
+                    .arg(file.fileName());
+        return false;
+    }
+
+    file.seek(directoryOffset);
+    const auto directory = file.read(directorySize);
+    int pos = 0;
+    for (int i = 0; i < count; ++i)
+    {
+        if (pos + 46 > directory.size() || readLE32(directory, pos) != ZIP_CENTRAL_HEADER)
+        {
+            error = QCoreApplication::translate("Util::ArchiveReader", "[%1] is corrupted.").arg(file.fileName());
+            return false;
+        }
+        Entry entry;
+        entry.method = readLE16(directory, pos + 10);
+        entry.crc = readLE32(directory, pos + 16);
+        entry.packedSize = readLE32(directory, pos + 20);
+        entry.size = readLE32(directory, pos + 24);
+        entry.offset = readLE32(directory, pos + 42);
+        const int nameSize = readLE16(directory, pos + 28);
+        entry.path = QString::fromUtf8(directory.mid(pos + 46, nameSize));
+        pos += 46 + nameSize + readLE16(directory, pos + 30) + readLE16(directory, pos + 32);
+        // directories end with '/', encrypted entries are listed and fail when they are extracted
+        if (!entry.path.endsWith('/'))
+            entryList.push_back(entry);
+    }
+    return true;
+}
+
+bool ArchiveReader::readTarEntries()
+{
+    QString longPath; // the path in the previous GNU long name or pax header
+    for (qint64 pos = 0; pos + TAR_BLOCK_SIZE <= file.size();)
+    {
+        file.seek(pos);
+        const auto header = file.read(TAR_BLOCK_SIZE);
+        if (header.count('\0') == TAR_BLOCK_SIZE)
+            break; // the end of the archive
+        const qint64 size = tarNumber(header, 124, 12);
+        if (!isTarHeader(header) || size < 0)
+        {
+            error = QCoreApplication::translate("Util::ArchiveReader", "[%1] is corrupted.").arg(file.fileName());
+            return false;
+        }
+
+        const char type = header[156];
+        const qint64 dataPos = pos + TAR_BLOCK_SIZE;
+        pos = dataPos + (size + TAR_BLOCK_SIZE - 1) / TAR_BLOCK_SIZE * TAR_BLOCK_SIZE;
+
+        if (type == 'L')
+        {
+            file.seek(dataPos);
+            longPath = tarString(file.read(size), 0, int(size));
+            continue;
+        }
+        if (type == 'x')
+        {
+            // pax records are "<length> <key>=<value>\n"
+            file.seek(dataPos);
+            for (auto const &record : file.read(size).split('\n'))
+            {
+                const int keyStart = record.indexOf(' ') + 1;
+                if (record.mid(keyStart).startsWith("path="))
+                    longPath = QString::fromUtf8(record.mid(keyStart + 5));
+            }
+            continue;
+        }
+
+        if (type == '0' || type == '\0' || type == '7')
+        {
+            Entry entry;
+            entry.path = tarString(header, 0, 100);
+            const auto prefix = tarString(header, 345, 155);
+            if (header.mid(257, 5) == "ustar" && !prefix.isEmpty())
+                entry.path = prefix + '/' + entry.path;
+            if (!longPath.isEmpty())
+                entry.path = longPath;
+            entry.offset = dataPos;
+            entry.size = entry.packedSize = size;
+            entryList.push_back(entry);
+        }
+        longPath.clear();
+    }
+    return true;
+}
+
+bool ArchiveReader::extractZipEntry(const Entry &entry, const Sink &sink)
+{
+    file.seek(entry.offset);
+    const auto header = file.read(30);
+    if (header.size() < 30 || readLE32(header, 0) != ZIP_LOCAL_HEADER)
+    {
+        error = QCoreApplication::translate("Util::ArchiveReader", "[%1] is corrupted.").arg(file.fileName());
+        return false;
+    }
+    if (readLE16(header, 6) & 1)
+    {
+        error = QCoreApplication::translate("Util::ArchiveReader", "[%1] in [%2] is encrypted.")
+                    .arg(entry.path, file.fileName());
+        return false;
+    }
+    file.seek(entry.offset + 30 + readLE16(header, 26) + readLE16(header, 28));
+
+    qint64 remaining = entry.packedSize;
+    auto source = [this, &remaining](char *data, qint64 maxSize) {
+        const auto size = file.read(data, qMin(maxSize, remaining));
+        if (size > 0)
+            remaining -= size;
+        return size;
+    };
+
+    quint32 crc = 0;
+    qint64 size = 0;
+    bool stopped = false;
+    auto checkedSink = [&](const char *data, qint64 chunkSize) {
+        crc = quint32(crc32(crc, reinterpret_cast<const Bytef *>(data), uInt(chunkSize)));
+        size += chunkSize;
+        stopped = !sink(data, chunkSize);
+        return !stopped;
+    };
+
+    bool ok = false;
+    if (entry.method == 0)
+    {
+        QByteArray buffer(int(CHUNK_SIZE), Qt::Uninitialized);
+        qint64 chunkSize = 0;
+        ok = true;
+        while (ok && remaining > 0 && (chunkSize = source(buffer.data(), buffer.size())) > 0)
+            ok = checkedSink(buffer.constData(), chunkSize);
+    }
+    else if (entry.method == 8)
+    {
+        ok = inflateRaw(source, checkedSink);
+    }
+    else
+    {
+        error = QCoreApplication::translate("Util::ArchiveReader",
+                                            "[%1] in [%2] is compressed by an unsupported method.")
+                    .arg(entry.path, file.fileName());
+        return false;
+    }
+
+    if (stopped)
+        return false;
+    if (!ok || crc != entry.crc || size != entry.size)
+    {
+        error = QCoreApplication::translate("Util::ArchiveReader", "[%1] in [%2] is corrupted.")
+                    .arg(entry.path, file.fileName());
+        return false;
+    }
+    return true;
+}
+
+bool ArchiveReader::extractTarEntry(const Entry &entry, const Sink &sink)
+{
+    file.seek(entry.offset);
+    QByteArray buffer(int(CHUNK_SIZE), Qt::Uninitialized);
+    for (qint64 remaining = entry.size; remaining > 0;)
+    {
+        const auto size = file.read(buffer.data(), qMin(remaining, CHUNK_SIZE));
+        if (size <= 0)
+        {
+            error = QCoreApplication::translate("Util::ArchiveReader", "[%1] in [%2] is corrupted.")
+                        .arg(entry.path, file.fileName());
+            return false;
+        }
+        if (!sink(buffer.constData(), size))
+            return false;
+        remaining -= size;
+    }
+    return true;
+}
+} // namespace Util
@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2019-2021 Ashar Khan <ashar786khan@gmail.com>
+ *
+ * This file is part of CP Editor.
+ *
+ * CP Editor is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * I will not be responsible if CP Editor behaves in unexpected way and
+ * causes your ratings to go down and or lose any important contest.
+ *
+ * Believe Software is "Software" and it isn't immune to bugs.
+ *
+ */
+
+/*
+ * A reader of zip and tar archives.
+ * The list of the entries is read without reading their contents, and an entry is extracted in chunks, so an archive
+ * of any size can be read with little memory. Zip entries can be stored or deflated, they are inflated by zlib.
+ * It doesn't log or show messages, so it can be used in worker threads.
+ */
+
+#ifndef ARCHIVEREADER_HPP
+#define ARCHIVEREADER_HPP
+
+#include <QFile>
+#include <QVector>
+#include <functional>
+
+namespace Util
+{
+class ArchiveReader
+{
+  public:
+    struct Entry
+    {
+        QString path;            // the path in the archive, separated by '/'
+        qint64 size = 0;         // the size after extraction
+        qint64 offset = 0;       // the offset of the local header in a zip, or of the data in a tar
+        qint64 packedSize = 0;   // the size in the archive
+        int method = 0;          // the compression method of a zip entry, 0 for stored and 8 for deflated
+        quint32 crc = 0;         // the CRC-32 of a zip entry
+    };
+
+    /**
+     * @brief called with each extracted chunk, return false to stop the extraction
+     */
+    using Sink = std::function<bool(const char *data, qint64 size)>;
+
+    explicit ArchiveReader(const QString &path);
+
+    /**
+     * @brief open the archive and read the list of the entries
+     * @returns whether it's a valid zip or tar archive
+     */
+    bool open();
+
+    /**
+     * @returns the regular files in the archive, in the order they are stored
+     */
+    QVector<Entry> entries() const;
+
+    /**
+     * @brief extract an entry
+     * @param entry one of entries()
+     * @param sink the function that receives the content
+     * @returns true if the whole entry is extracted, false if it fails or the sink stops it
+     */
+    bool extract(const Entry &entry, const Sink &sink);
+
+    /**
+     * @returns the reason of the last failure
+     */
+    QString errorString() const;
+
+  private:
+    bool readZipEntries();
+    bool readTarEntries();
+    bool extractZipEntry(const Entry &entry, const Sink &sink);
+    bool extractTarEntry(const Entry &entry, const Sink &sink);
+
+    QFile file;
+    bool isZip = false;
+    QVector<Entry> entryList;
+    QString error;
+};
+} // namespace Util
+
+#endif // ARCHIVEREADER_HPP
@@ -20,15 +20,24 @@
 #include "Core/MessageLogger.hpp"
 #include "generated/SettingsHelper.hpp"
 #include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDateTime>
 #include <QDesktopServices>
 #include <QDir>
 #include <QFile>
 #include <QFileInfo>
+#include <QHash>
 #include <QProcess>
 #include <QSaveFile>
 #include <QStandardPaths>
 #include <QUrl>
 
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
 namespace Util
 {
 QString fileNameFilter(bool cpp, bool java, bool python)
@@ -154,6 +163,50 @@ QString readFile(const QString &path, const QString &head, MessageLogger *log, b
     return content;
 }
 
+bool syncFile(QFileDevice &file)
+{
+    if (!file.flush())
+        return false;
+#ifdef Q_OS_WIN
+    return _commit(file.handle()) == 0;
+#else
+    return fsync(file.handle()) == 0;
+#endif
+}
+
+QByteArray textFingerprint(const QString &text)
+{
+    return QCryptographicHash::hash(
+        QByteArray::fromRawData(reinterpret_cast<const char *>(text.constData()), text.size() * int(sizeof(QChar))),
+        QCryptographicHash::Sha1);
+}
+
+QByteArray fileFingerprint(const QString &path)
+{
+    struct CachedFingerprint
+    {
+        QDateTime lastModified;
+        qint64 size;
+        QByteArray fingerprint;
+    };
+    static QHash<QString, CachedFingerprint> cache;
+
+    const QFileInfo info(path);
+    if (!info.isFile())
+        return QByteArray();
+
+    auto it = cache.find(path);
+    if (it != cache.end() && it->lastModified == info.lastModified() && it->size == info.size())
+        return it->fingerprint;
+
+    const auto content = readFile(path);
+    if (content.isNull())
+        return QByteArray();
+    const auto fingerprint = textFingerprint(content);
+    cache[path] = {info.lastModified(), info.size(), fingerprint};
+    return fingerprint;
+}
+
 QString configFilePath(QString path)
 {
     return path.replace("$APPCONFIG", QStandardPaths::writableLocation(QStandardPaths::AppConfigLocation))
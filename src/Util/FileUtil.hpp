@@ -21,6 +21,7 @@
 #include <QStringList>
 
 class MessageLogger;
+class QFileDevice;
 
 namespace Util
 {
@@ -53,6 +54,25 @@ bool saveFile(const QString &path, const QString &content, const QString &head =
 QString readFile(const QString &path, const QString &head = "Read File", MessageLogger *log = nullptr,
                  bool notExistWarning = false);
 
+/**
+ * @brief flush a file and make sure its content is written to the disk
+ * @returns whether it succeeded
+ */
+bool syncFile(QFileDevice &file);
+
+/**
+ * @brief get the fingerprint of a text
+ * @returns a hash of the text, the same texts have the same fingerprints, and different texts have different ones
+ */
+QByteArray textFingerprint(const QString &text);
+
+/**
+ * @brief get the fingerprint of the content of a file, as textFingerprint(readFile(path))
+ * @returns the fingerprint, or an empty QByteArray if failed to read the file
+ * @note The fingerprint is cached until the file is modified, so this is cheap for e.g. the templates.
+ */
+QByteArray fileFingerprint(const QString &path);
+
 /**
  * @brief get the path of a configuration file
  * @param path the original path
@@ -18,16 +18,14 @@
 #include "Util/QCodeEditorUtil.hpp"
 #include "Core/EventLogger.hpp"
 #include "Extensions/EditorTheme.hpp"
+#include "Extensions/LexerHighlighter.hpp"
 #include "Settings/SettingsManager.hpp"
 #include "generated/SettingsHelper.hpp"
-#include <QCXXHighlighter>
 #include <QCodeEditor>
-#include <QJavaHighlighter>
-#include <QPythonHighlighter>
 
 namespace Util
 {
-void applySettingsToEditor(QCodeEditor *editor, const QString &language)
+void applySettingsToEditor(QCodeEditor *editor, const QString &language, bool highlight)
 {
     LOG_INFO("Applying settings to QCodeEditor");
 
@@ -57,21 +55,7 @@ void applySettingsToEditor(QCodeEditor *editor, const QString &language)
     if (language.isEmpty())
         return;
 
-    if (language == "Python")
-    {
-        editor->setHighlighter(new QPythonHighlighter);
-        editor->setCompleter(nullptr);
-    }
-    else if (language == "Java")
-    {
-        editor->setHighlighter(new QJavaHighlighter);
-        editor->setCompleter(nullptr);
-    }
-    else
-    {
-        editor->setHighlighter(new QCXXHighlighter);
-        editor->setCompleter(nullptr);
-    }
+    editor->setHighlighter(highlight ? new Extensions::LexerHighlighter(language, editor) : nullptr);
 
     QVector<QCodeEditor::Parenthesis> parentheses;
 
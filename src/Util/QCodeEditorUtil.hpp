@@ -23,7 +23,11 @@ class QString;
 
 namespace Util
 {
-void applySettingsToEditor(QCodeEditor *editor, const QString &language);
+/**
+ * @brief apply the settings of the code editor and the language to an editor
+ * @param highlight whether to highlight the code, it's disabled for large files
+ */
+void applySettingsToEditor(QCodeEditor *editor, const QString &language, bool highlight = true);
 } // namespace Util
 
 #endif // QCODEEDITORUTIL_HPP
@@ -17,17 +17,202 @@
 
 #include "Widgets/DiffViewer.hpp"
 #include "Core/EventLogger.hpp"
-#include "Core/MessageLogger.hpp"
-#include "third_party/diff_match_patch/diff_match_patch.h"
 #include <QHBoxLayout>
 #include <QLabel>
+#include <QPaintEvent>
+#include <QPainter>
 #include <QScrollBar>
-#include <QTextEdit>
+#include <QStatusBar>
+#include <QThread>
 #include <QVBoxLayout>
 #include <generated/SettingsHelper.hpp>
 
 namespace Widgets
 {
+DiffPane::DiffPane(Core::DiffResult::Side side, QWidget *parent)
+    : QAbstractScrollArea(parent), side(side), rangesCache(1000)
+{
+    setFont(SettingsHelper::getTestCasesFont());
+    setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOn);
+    setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOn);
+    viewport()->setAutoFillBackground(false);
+}
+
+void DiffPane::setDiff(const std::shared_ptr<const Core::DiffResult> &result)
+{
+    diff = result;
+    rangesCache.clear();
+    updateScrollBars();
+    verticalScrollBar()->setValue(0);
+    horizontalScrollBar()->setValue(0);
+    viewport()->update();
+}
+
+void DiffPane::scrollToRow(int row)
+{
+    verticalScrollBar()->setValue(row);
+}
+
+void DiffPane::paintEvent(QPaintEvent *event)
+{
+    QPainter painter(viewport());
+    painter.fillRect(event->rect(), Qt::white);
+
+    if (!diff)
+        return;
+
+    const int height = rowHeight();
+    const int width = charWidth();
+    const int gutter = gutterWidth();
+    const int ascent = fontMetrics().ascent();
+    const int firstRow = verticalScrollBar()->value();
+    const int lastRow = qMin(diff->rowCount, firstRow + viewport()->height() / height + 2);
+    const int xOffset = horizontalScrollBar()->value();
+    const int firstColumn = xOffset / width;
+    const int columns = (viewport()->width() - gutter) / width + 2;
+    const bool showEOLN = SettingsHelper::isDisplayEOLNInDiff();
+    const QColor lineColor(side == Core::DiffResult::Left ? "#fdd" : "#dfd");
+    const QColor charColor(side == Core::DiffResult::Left ? "#f88" : "#8f8");
+
+    painter.setClipRect(gutter, 0, viewport()->width() - gutter, viewport()->height());
+
+    for (int row = firstRow; row < lastRow; ++row)
+    {
+        const int top = (row - firstRow) * height;
+        const int line = diff->lineOfRow(side, row);
+        const QRect rowRect(gutter, top, viewport()->width() - gutter, height);
+
+        if (line < 0)
+        {
+            painter.fillRect(rowRect, QColor("#eee"));
+            continue;
+        }
+
+        const QStringRef text = diff->line(side, line);
+        const int textX = gutter - xOffset;
+
+        if (diff->isChangedRow(row))
+        {
+            painter.fillRect(rowRect, lineColor);
+            for (auto const &range : changedRanges(row))
+            {
+                const int start = qMax(range.first, firstColumn);
+                const int end = qMin(range.first + range.second, firstColumn + columns);
+                if (start < end)
+                    painter.fillRect(textX + start * width, top, (end - start) * width, height, charColor);
+            }
+        }
+
+        if (firstColumn < text.size())
+        {
+            auto visible = text.mid(firstColumn, columns).toString();
+            visible.replace('\t', ' ');
+            painter.setPen(Qt::black);
+            painter.drawText(textX + firstColumn * width, top + ascent, visible);
+        }
+
+        if (showEOLN && diff->hasNewline(side, line))
+        {
+            painter.setPen(Qt::gray);
+            painter.drawText(textX + text.size() * width, top + ascent, QString(QChar(0x00B6)));
+        }
+    }
+
+    painter.setClipping(false);
+    painter.fillRect(0, 0, gutter, viewport()->height(), QColor("#f5f5f5"));
+    painter.setPen(Qt::gray);
+    for (int row = firstRow; row < lastRow; ++row)
+    {
+        const int line = diff->lineOfRow(side, row);
+        if (line >= 0)
+            painter.drawText(QRect(0, (row - firstRow) * height, gutter - width / 2, height),
+                             Qt::AlignRight | Qt::AlignVCenter, QString::number(line + 1));
+    }
+}
+
+void DiffPane::resizeEvent(QResizeEvent *event)
+{
+    QAbstractScrollArea::resizeEvent(event);
+    updateScrollBars();
+}
+
+void DiffPane::changeEvent(QEvent *event)
+{
+    QAbstractScrollArea::changeEvent(event);
+    if (event->type() == QEvent::FontChange)
+        updateScrollBars();
+}
+
+void DiffPane::scrollContentsBy(int /*dx*/, int /*dy*/)
+{
+    // the scroll bars are in rows and pixels, so the whole viewport is repainted instead of being scrolled
+    viewport()->update();
+}
+
+void DiffPane::updateScrollBars()
+{
+    const int pageRows = qMax(1, viewport()->height() / rowHeight());
+    const int rows = diff ? diff->rowCount : 0;
+    const int maxLineLength = diff ? diff->maxLineLength : 0;
+
+    verticalScrollBar()->setRange(0, qMax(0, rows - pageRows));
+    verticalScrollBar()->setPageStep(pageRows);
+    verticalScrollBar()->setSingleStep(1);
+
+    horizontalScrollBar()->setRange(
+        0, qMax(0, gutterWidth() + (maxLineLength + 2) * charWidth() - viewport()->width()));
+    horizontalScrollBar()->setPageStep(viewport()->width());
+    horizontalScrollBar()->setSingleStep(charWidth());
+}
+
+int DiffPane::rowHeight() const
+{
+    return qMax(1, fontMetrics().lineSpacing());
+}
+
+int DiffPane::charWidth() const
+{
+    return qMax(1, fontMetrics().horizontalAdvance(QLatin1Char('0')));
+}
+
+int DiffPane::gutterWidth() const
+{
+    // use the line count of both sides, so that the columns of the two panes are aligned
+    const int lines =
+        diff ? qMax(diff->lineCount(Core::DiffResult::Left), diff->lineCount(Core::DiffResult::Right)) : 0;
+    return (QString::number(lines).length() + 2) * charWidth();
+}
+
+const QVector<Core::DiffEngine::Range> &DiffPane::changedRanges(int row)
+{
+    if (auto *cached = rangesCache.object(row))
+        return *cached;
+
+    auto *ranges = new QVector<Core::DiffEngine::Range>();
+    const int leftLine = diff->lineOfRow(Core::DiffResult::Left, row);
+    const int rightLine = diff->lineOfRow(Core::DiffResult::Right, row);
+
+    if (leftLine >= 0 && rightLine >= 0)
+    {
+        QVector<Core::DiffEngine::Range> other;
+        const auto left = diff->line(Core::DiffResult::Left, leftLine).toString();
+        const auto right = diff->line(Core::DiffResult::Right, rightLine).toString();
+        if (side == Core::DiffResult::Left)
+            Core::DiffEngine::refine(left, right, ranges, &other);
+        else
+            Core::DiffEngine::refine(left, right, &other, ranges);
+    }
+    else
+    {
+        const int line = side == Core::DiffResult::Left ? leftLine : rightLine;
+        if (line >= 0 && !diff->line(side, line).isEmpty())
+            ranges->push_back({0, diff->line(side, line).size()});
+    }
+
+    rangesCache.insert(row, ranges);
+    return *ranges;
+}
+
 DiffViewer::DiffViewer(QWidget *parent) : QMainWindow(parent)
 {
     auto *widget = new QWidget(this);
@@ -40,86 +225,106 @@ DiffViewer::DiffViewer(QWidget *parent) : QMainWindow(parent)
     auto *leftLayout = new QVBoxLayout();
     outputLabel = new QLabel(tr("Output"), widget);
     leftLayout->addWidget(outputLabel);
-    outputEdit = new QTextEdit(widget);
-    outputEdit->setReadOnly(true);
-    outputEdit->setWordWrapMode(QTextOption::NoWrap);
-    leftLayout->addWidget(outputEdit);
+    outputPane = new DiffPane(Core::DiffResult::Left, widget);
+    leftLayout->addWidget(outputPane);
     layout->addLayout(leftLayout);
 
     auto *rightLayout = new QVBoxLayout();
     expectedLabel = new QLabel(tr("Expected"), widget);
     rightLayout->addWidget(expectedLabel);
-    expectedEdit = new QTextEdit(widget);
-    expectedEdit->setReadOnly(true);
-    expectedEdit->setWordWrapMode(QTextOption::NoWrap);
-    rightLayout->addWidget(expectedEdit);
+    expectedPane = new DiffPane(Core::DiffResult::Right, widget);
+    rightLayout->addWidget(expectedPane);
     layout->addLayout(rightLayout);
 
-    connect(expectedEdit->horizontalScrollBar(), &QScrollBar::valueChanged, outputEdit->horizontalScrollBar(),
+    connect(expectedPane->horizontalScrollBar(), &QScrollBar::valueChanged, outputPane->horizontalScrollBar(),
             &QScrollBar::setValue);
-    connect(outputEdit->horizontalScrollBar(), &QScrollBar::valueChanged, expectedEdit->horizontalScrollBar(),
+    connect(outputPane->horizontalScrollBar(), &QScrollBar::valueChanged, expectedPane->horizontalScrollBar(),
             &QScrollBar::setValue);
-    connect(expectedEdit->verticalScrollBar(), &QScrollBar::valueChanged, outputEdit->verticalScrollBar(),
+    connect(expectedPane->verticalScrollBar(), &QScrollBar::valueChanged, outputPane->verticalScrollBar(),
             &QScrollBar::setValue);
-    connect(outputEdit->verticalScrollBar(), &QScrollBar::valueChanged, expectedEdit->verticalScrollBar(),
+    connect(outputPane->verticalScrollBar(), &QScrollBar::valueChanged, expectedPane->verticalScrollBar(),
             &QScrollBar::setValue);
 }
 
+DiffViewer::~DiffViewer()
+{
+    // the worker uses the cancellation flag of this viewer, so it must stop first
+    if (worker != nullptr)
+    {
+        cancelled = true;
+        worker->wait();
+    }
+}
+
 void DiffViewer::setText(const QString &output, const QString &expected)
 {
-    if (output.length() <= SettingsHelper::getHTMLDiffViewerLengthLimit() &&
-        expected.length() <= SettingsHelper::getHTMLDiffViewerLengthLimit())
+    LOG_INFO("Computing the diff of " << INFO_OF(output.length()) << ", " << INFO_OF(expected.length()));
+
+    statusBar()->showMessage(tr("Comparing..."));
+
+    pendingOutput = output;
+    pendingExpected = expected;
+    hasPendingRequest = true;
+
+    if (worker != nullptr)
+    {
+        LOG_INFO("Cancelling the previous diff");
+        cancelled = true; // the new diff starts when the worker finishes
+        return;
+    }
+
+    startDiff();
+}
+
+void DiffViewer::startDiff()
+{
+    const auto output = pendingOutput;
+    const auto expected = pendingExpected;
+    pendingOutput.clear();
+    pendingExpected.clear();
+    hasPendingRequest = false;
+    cancelled = false;
+
+    auto result = std::make_shared<Core::DiffResult>();
+    worker = QThread::create(
+        [this, result, output, expected] { *result = Core::DiffEngine::diff(output, expected, &cancelled); });
+    worker->setParent(this);
+    connect(worker, &QThread::finished, this, [this, result] { onDiffFinished(result); });
+    worker->start(QThread::LowPriority);
+}
+
+void DiffViewer::onDiffFinished(const std::shared_ptr<const Core::DiffResult> &result)
+{
+    worker->deleteLater();
+    worker = nullptr;
+
+    // the result is cancelled or outdated
+    if (hasPendingRequest)
     {
-        LOG_INFO("Diff viewer is using HTML Text");
-        diff_match_patch differ;
-        differ.Diff_EditCost = 10;
-        const auto nonNullOutput = output.isNull() ? "" : output;
-        const auto nonNullExpected = expected.isNull() ? "" : expected;
-        auto diffs = differ.diff_main(nonNullOutput, nonNullExpected);
-        differ.diff_cleanupEfficiency(diffs);
-
-        QString outputHTML;
-        QString expectedHTML;
-        outputHTML = expectedHTML = "<body style='background-color: white; color: black;'>";
-        for (auto const &diff : diffs)
-        {
-            QString text = diff.text.toHtmlEscaped().replace(" ", "&nbsp;");
-            if (SettingsHelper::isDisplayEOLNInDiff())
-                text.replace("\n", "&para;<br>");
-            else
-                text.replace("\n", "<br>");
-            switch (diff.operation)
-            {
-            case INSERT:
-                expectedHTML += QString("<ins style=\"background:#8f8;\">") + text + QString("</ins>");
-                break;
-            case DELETE:
-                outputHTML += "<s style=\"background:#f88;\">" + text + "</s>";
-                break;
-            case EQUAL:
-                outputHTML += "<span>" + text + "</span>";
-                expectedHTML += "<span>" + text + "</span>";
-                break;
-            }
-        }
-        outputHTML += "</body>";
-        expectedHTML += "</body>";
-        outputEdit->setHtml(outputHTML);
-        expectedEdit->setHtml(expectedHTML);
+        startDiff();
+        return;
     }
-    else
+
+    LOG_INFO(INFO_OF(result->rowCount) << ", " << INFO_OF(result->changedHunkCount));
+
+    outputPane->setDiff(result);
+    expectedPane->setDiff(result);
+
+    if (result->changedHunkCount == 0)
     {
-        LOG_INFO("Diff viewer is using Plain Text");
-        emit toLongForHtml();
-        outputEdit->setPlainText(output);
-        expectedEdit->setPlainText(expected);
+        statusBar()->showMessage(tr("No differences"));
+        return;
     }
 
-    auto resetScrollBar = [](QScrollBar *scrollBar) { scrollBar->setValue(scrollBar->minimum()); };
+    statusBar()->showMessage(tr("%n changed block(s)", "", result->changedHunkCount));
 
-    resetScrollBar(outputEdit->horizontalScrollBar());
-    resetScrollBar(outputEdit->verticalScrollBar());
-    resetScrollBar(expectedEdit->horizontalScrollBar());
-    resetScrollBar(outputEdit->verticalScrollBar());
+    for (auto const &hunk : result->hunks)
+    {
+        if (hunk.changed)
+        {
+            outputPane->scrollToRow(qMax(0, hunk.rowStart - 3));
+            break;
+        }
+    }
 }
 } // namespace Widgets
@@ -18,29 +18,85 @@
 #ifndef DIFFVIEWER_HPP
 #define DIFFVIEWER_HPP
 
+#include "Core/DiffEngine.hpp"
+#include <QAbstractScrollArea>
+#include <QCache>
 #include <QMainWindow>
+#include <atomic>
+#include <memory>
 
-class QHBoxLayout;
-class QVBoxLayout;
 class QLabel;
-class QTextEdit;
+class QThread;
 
 namespace Widgets
 {
+/**
+ * A read-only view of one side of a diff.
+ * Only the visible rows are painted, so the cost of scrolling doesn't depend on the size of the texts.
+ * The character-level differences are computed when a changed row is painted for the first time.
+ */
+class DiffPane : public QAbstractScrollArea
+{
+    Q_OBJECT
+
+  public:
+    explicit DiffPane(Core::DiffResult::Side side, QWidget *parent = nullptr);
+
+    /**
+     * @brief show a new diff result
+     * @param result the result to show, shared with the other side
+     */
+    void setDiff(const std::shared_ptr<const Core::DiffResult> &result);
+
+    /**
+     * @brief scroll so that the given row is near the top of the view
+     */
+    void scrollToRow(int row);
+
+  protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void changeEvent(QEvent *event) override;
+    void scrollContentsBy(int dx, int dy) override;
+
+  private:
+    void updateScrollBars();
+    int rowHeight() const;
+    int charWidth() const;
+    int gutterWidth() const;
+    const QVector<Core::DiffEngine::Range> &changedRanges(int row);
+
+    Core::DiffResult::Side side;
+    std::shared_ptr<const Core::DiffResult> diff;
+    QCache<int, QVector<Core::DiffEngine::Range>> rangesCache; // the changed characters of the painted rows
+};
+
 class DiffViewer : public QMainWindow
 {
     Q_OBJECT
 
   public:
     explicit DiffViewer(QWidget *parent = nullptr);
-    void setText(const QString &output, const QString &expected);
+    ~DiffViewer() override;
 
-  signals:
-    void toLongForHtml();
+    /**
+     * @brief compare the output with the expected output
+     * @note The diff is computed in a worker thread, the view is updated when it's done. If the previous diff is still
+     *       being computed, it's cancelled, and this one starts after it stops.
+     */
+    void setText(const QString &output, const QString &expected);
 
   private:
+    void startDiff();
+    void onDiffFinished(const std::shared_ptr<const Core::DiffResult> &result);
+
     QLabel *outputLabel = nullptr, *expectedLabel = nullptr;
-    QTextEdit *outputEdit = nullptr, *expectedEdit = nullptr;
+    DiffPane *outputPane = nullptr, *expectedPane = nullptr;
+
+    QThread *worker = nullptr;              // the thread computing the diff, at most one at a time
+    std::atomic<bool> cancelled{false};     // checked by the worker, set when its result is no longer needed
+    QString pendingOutput, pendingExpected; // the texts of the request waiting for the worker
+    bool hasPendingRequest = false;         // whether there's a request waiting for the worker
 };
 } // namespace Widgets
 #endif // DIFFVIEWER_HPP
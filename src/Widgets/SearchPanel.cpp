@@ -0,0 +1,192 @@
+/*
+ * Copyright (C) 2019-2021 Ashar Khan <ashar786khan@gmail.com>
+ *
+ * This file is part of CP Editor.
+ *
+ * CP Editor is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * I will not be responsible if CP Editor behaves in unexpected way and
+ * causes your ratings to go down and or lose any important contest.
+ *
+ * Believe Software is "Software" and it isn't immune to bugs.
+ *
+ */
+
+#include "Widgets/SearchPanel.hpp"
+#include "Core/EventLogger.hpp"
+#include <QCheckBox>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QLineEdit>
+#include <QTimer>
+#include <QTreeWidget>
+#include <QVBoxLayout>
+
+namespace Widgets
+{
+namespace
+{
+const int SEARCH_DELAY = 150; // milliseconds after the last keystroke
+
+enum Role
+{
+    KeyRole = Qt::UserRole,
+    LineRole,
+    ColumnRole,
+    LengthRole
+};
+} // namespace
+
+SearchPanel::SearchPanel(Core::SearchIndex *index, QWidget *parent) : QDockWidget(parent), index(index)
+{
+    setObjectName("SearchPanel");
+    setWindowTitle(tr("Search In Workspace"));
+
+    auto *widget = new QWidget();
+    auto *mainLayout = new QVBoxLayout(widget);
+    setWidget(widget);
+
+    auto *queryLayout = new QHBoxLayout();
+    mainLayout->addLayout(queryLayout);
+
+    queryEdit = new QLineEdit();
+    queryEdit->setPlaceholderText(tr("Search in the open tabs, the contest directory and the recent files"));
+    queryEdit->setClearButtonEnabled(true);
+    queryLayout->addWidget(queryEdit);
+
+    regexCheckBox = new QCheckBox(tr("Regex"));
+    queryLayout->addWidget(regexCheckBox);
+
+    caseSensitiveCheckBox = new QCheckBox(tr("Case Sensitive"));
+    queryLayout->addWidget(caseSensitiveCheckBox);
+
+    statusLabel = new QLabel();
+    mainLayout->addWidget(statusLabel);
+
+    resultTree = new QTreeWidget();
+    resultTree->setHeaderHidden(true);
+    resultTree->setUniformRowHeights(true);
+    mainLayout->addWidget(resultTree);
+
+    searchTimer = new QTimer(this);
+    searchTimer->setSingleShot(true);
+    searchTimer->setInterval(SEARCH_DELAY);
+
+    connect(searchTimer, &QTimer::timeout, this, &SearchPanel::search);
+    connect(queryEdit, &QLineEdit::textChanged, searchTimer, qOverload<>(&QTimer::start));
+    connect(queryEdit, &QLineEdit::returnPressed, this, &SearchPanel::search);
+    connect(regexCheckBox, &QCheckBox::toggled, this, &SearchPanel::search);
+    connect(caseSensitiveCheckBox, &QCheckBox::toggled, this, &SearchPanel::search);
+    connect(resultTree, &QTreeWidget::itemActivated, this, &SearchPanel::onItemActivated);
+    connect(index, &Core::SearchIndex::searchFinished, this, &SearchPanel::onSearchFinished);
+    connect(index, &Core::SearchIndex::indexUpdated, this, &SearchPanel::onIndexUpdated);
+}
+
+void SearchPanel::showPanel(const QString &text)
+{
+    show();
+    raise();
+    if (!text.isEmpty())
+        queryEdit->setText(text);
+    queryEdit->setFocus();
+    queryEdit->selectAll();
+    search();
+}
+
+void SearchPanel::search()
+{
+    searchTimer->stop();
+
+    const auto query = queryEdit->text();
+    if (query.isEmpty())
+    {
+        currentSearch = -1;
+        resultTree->clear();
+        statusLabel->clear();
+        return;
+    }
+
+    currentSearch = index->search(query, regexCheckBox->isChecked(), caseSensitiveCheckBox->isChecked());
+}
+
+void SearchPanel::onSearchFinished(const Core::SearchIndex::Result &result)
+{
+    if (result.id != currentSearch)
+        return;
+
+    if (!result.error.isEmpty())
+    {
+        resultTree->clear();
+        statusLabel->setText(tr("Invalid regular expression: %1").arg(result.error));
+        return;
+    }
+
+    resultTree->setUpdatesEnabled(false);
+    resultTree->clear();
+
+    QTreeWidgetItem *documentItem = nullptr;
+    int documents = 0;
+    int matchesInDocument = 0;
+
+    auto finishDocument = [&] {
+        if (documentItem != nullptr)
+            documentItem->setText(0, QString("%1 (%2)").arg(documentItem->text(0)).arg(matchesInDocument));
+    };
+
+    for (auto const &match : result.matches)
+    {
+        if (documentItem == nullptr || documentItem->data(0, KeyRole).toString() != match.key)
+        {
+            finishDocument();
+            documentItem = new QTreeWidgetItem(resultTree, {match.title});
+            documentItem->setData(0, KeyRole, match.key);
+            documentItem->setToolTip(0, match.title);
+            matchesInDocument = 0;
+            ++documents;
+        }
+
+        auto *item =
+            new QTreeWidgetItem(documentItem, {QString("%1: %2").arg(match.line + 1).arg(match.lineText.trimmed())});
+        item->setData(0, KeyRole, match.key);
+        item->setData(0, LineRole, match.line);
+        item->setData(0, ColumnRole, match.column);
+        item->setData(0, LengthRole, match.length);
+        ++matchesInDocument;
+    }
+    finishDocument();
+
+    resultTree->expandAll();
+    resultTree->setUpdatesEnabled(true);
+
+    auto status = tr("%1 matches in %2 documents. %3 of %4 documents are searched in %5 ms.")
+                      .arg(result.matches.size())
+                      .arg(documents)
+                      .arg(result.searchedDocuments)
+                      .arg(result.totalDocuments)
+                      .arg(result.elapsed);
+    if (result.truncated)
+        status += ' ' + tr("Only the first %1 matches are shown.").arg(result.matches.size());
+    statusLabel->setText(status);
+}
+
+void SearchPanel::onIndexUpdated()
+{
+    // search again for the changed documents, unless the user is browsing the results
+    if (isVisible() && !queryEdit->text().isEmpty() && !resultTree->hasFocus())
+        searchTimer->start();
+}
+
+void SearchPanel::onItemActivated(QTreeWidgetItem *item)
+{
+    if (item == nullptr || item->parent() == nullptr)
+        return;
+
+    const auto key = item->data(0, KeyRole).toString();
+    const int line = item->data(0, LineRole).toInt();
+    LOG_INFO(INFO_OF(key) << INFO_OF(line));
+    emit matchActivated(key, line, item->data(0, ColumnRole).toInt(), item->data(0, LengthRole).toInt());
+}
+} // namespace Widgets
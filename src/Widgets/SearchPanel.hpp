@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2019-2021 Ashar Khan <ashar786khan@gmail.com>
+ *
+ * This file is part of CP Editor.
+ *
+ * CP Editor is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * I will not be responsible if CP Editor behaves in unexpected way and
+ * causes your ratings to go down and or lose any important contest.
+ *
+ * Believe Software is "Software" and it isn't immune to bugs.
+ *
+ */
+
+/*
+ * The dock for searching in the workspace with Core::SearchIndex.
+ * The query is searched while typing, and the matches are grouped by the documents. Activating a match asks the
+ * AppWindow to open the document and select the matched text.
+ */
+
+#ifndef SEARCHPANEL_HPP
+#define SEARCHPANEL_HPP
+
+#include "Core/SearchIndex.hpp"
+#include <QDockWidget>
+
+class QCheckBox;
+class QLabel;
+class QLineEdit;
+class QTimer;
+class QTreeWidget;
+class QTreeWidgetItem;
+
+namespace Widgets
+{
+class SearchPanel : public QDockWidget
+{
+    Q_OBJECT
+
+  public:
+    explicit SearchPanel(Core::SearchIndex *index, QWidget *parent = nullptr);
+
+    /**
+     * @brief show the panel and focus on the query
+     * @param text the new query, the query is not changed if it's empty
+     */
+    void showPanel(const QString &text);
+
+  signals:
+    /**
+     * @param key the key of the document, see Core::SearchIndex::setBuffer()
+     * @param line the 0-based line number of the match
+     * @param column the 0-based column of the match in the line
+     * @param length the length of the matched text
+     */
+    void matchActivated(const QString &key, int line, int column, int length);
+
+  private slots:
+    void search();
+
+    void onSearchFinished(const Core::SearchIndex::Result &result);
+
+    void onIndexUpdated();
+
+    void onItemActivated(QTreeWidgetItem *item);
+
+  private:
+    Core::SearchIndex *index = nullptr;
+    QLineEdit *queryEdit = nullptr;
+    QCheckBox *regexCheckBox = nullptr;
+    QCheckBox *caseSensitiveCheckBox = nullptr;
+    QLabel *statusLabel = nullptr;
+    QTreeWidget *resultTree = nullptr;
+    QTimer *searchTimer = nullptr; // delays the search while typing
+    int currentSearch = -1;        // the ID of the latest search, the results of the earlier ones are ignored
+};
+} // namespace Widgets
+
+#endif // SEARCHPANEL_HPP
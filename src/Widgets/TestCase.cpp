@@ -18,22 +18,21 @@
 #include "Widgets/TestCase.hpp"
 #include "Core/EventLogger.hpp"
 #include "Core/MessageLogger.hpp"
-#include "Util/Util.hpp"
-#include "Widgets/DiffViewer.hpp"
 #include "Widgets/TestCaseEdit.hpp"
 #include <QCheckBox>
 #include <QHBoxLayout>
 #include <QLabel>
 #include <QMenu>
 #include <QMessageBox>
+#include <QProgressBar>
 #include <QPushButton>
 #include <QSplitter>
 #include <QVBoxLayout>
-#include <generated/SettingsHelper.hpp>
 
 namespace Widgets
 {
-TestCase::TestCase(int index, MessageLogger *logger, QWidget *parent, const QString &in, const QString &exp)
+TestCase::TestCase(int index, MessageLogger *logger, QWidget *parent, const Core::TestData &in, const QString &out,
+                   const Core::TestData &exp)
     : QWidget(parent), log(logger), id(0)
 {
     LOG_INFO("Testcase " << index << " is being created");
@@ -52,13 +51,15 @@ TestCase::TestCase(int index, MessageLogger *logger, QWidget *parent, const QStr
     inputLabel = new QLabel(tr("Input"), this);
     outputLabel = new QLabel(tr("Output"), this);
     expectedLabel = new QLabel(tr("Expected"), this);
+    mismatchLabel = new QLabel(this);
+    cachedLabel = new QLabel(tr("Cached"), this);
+    timeBar = new QProgressBar(this);
     runButton = new QPushButton(tr("Run"), this);
     diffButton = new QPushButton("**", this);
     delButton = new QPushButton(tr("Del"), this);
     inputEdit = new TestCaseEdit(TestCaseEdit::Input, index, log, in, this);
-    outputEdit = new TestCaseEdit(TestCaseEdit::Output, index, log, QString(), this);
+    outputEdit = new TestCaseEdit(TestCaseEdit::Output, index, log, Core::TestData(out), this);
     expectedEdit = new TestCaseEdit(TestCaseEdit::Expected, index, log, exp, this);
-    diffViewer = new DiffViewer(this);
 
     setID(index);
 
@@ -71,6 +72,9 @@ TestCase::TestCase(int index, MessageLogger *logger, QWidget *parent, const QStr
     inputUpLayout->addWidget(runButton);
     outputUpLayout->addWidget(outputLabel);
     outputUpLayout->addWidget(diffButton);
+    outputUpLayout->addWidget(cachedLabel);
+    outputUpLayout->addWidget(timeBar);
+    outputUpLayout->addWidget(mismatchLabel);
     expectedUpLayout->addWidget(expectedLabel);
     expectedUpLayout->addWidget(delButton);
     inputLayout->addLayout(inputUpLayout);
@@ -90,6 +94,18 @@ TestCase::TestCase(int index, MessageLogger *logger, QWidget *parent, const QStr
 
     splitter->setChildrenCollapsible(false);
 
+    mismatchLabel->setTextFormat(Qt::RichText);
+    mismatchLabel->setTextInteractionFlags(Qt::LinksAccessibleByMouse);
+    mismatchLabel->hide();
+
+    cachedLabel->setToolTip(tr("The program, the input, the expected output and the checker are unchanged since a "
+                               "previous run, so its output and verdict are reused without running again"));
+    cachedLabel->hide();
+
+    timeBar->setToolTip(tr("Time used / Time limit"));
+    timeBar->setMaximumWidth(150);
+    timeBar->hide();
+
     runButton->setToolTip(tr("Test on a single testcase"));
     diffButton->setToolTip(tr("Open the Diff Viewer"));
 
@@ -97,41 +113,64 @@ TestCase::TestCase(int index, MessageLogger *logger, QWidget *parent, const QStr
     connect(runButton, &QPushButton::clicked, this, &TestCase::onRunButtonClicked);
     connect(diffButton, &QPushButton::clicked, this, &TestCase::onDiffButtonClicked);
     connect(delButton, &QPushButton::clicked, this, &TestCase::onDelButtonClicked);
-    connect(diffViewer, &DiffViewer::toLongForHtml, this, &TestCase::onToLongForHtml);
+    connect(mismatchLabel, &QLabel::linkActivated, this, &TestCase::onMismatchLinkActivated);
     connect(expectedEdit, &TestCaseEdit::requestCopyOutputToExpected, this,
             [this] { expectedEdit->modifyText(output()); });
+
+    for (auto *edit : {inputEdit, outputEdit, expectedEdit})
+        connect(edit, &TestCaseEdit::blockCountChanged, this, [this] { emit heightChanged(id); });
+    for (auto *edit : {inputEdit, expectedEdit})
+        connect(edit, &TestCaseEdit::textChanged, this, [this] { emit edited(id); });
 }
 
-void TestCase::setInput(const QString &text)
+void TestCase::setInput(const Core::TestData &data)
 {
-    inputEdit->modifyText(text);
+    inputEdit->setData(data);
 }
 
 void TestCase::setOutput(const QString &text)
 {
     outputEdit->modifyText(text);
-    outputEdit->startAnimation();
+}
 
-    if (!diffViewer->isHidden())
-        diffViewer->setText(text, expected());
+void TestCase::setOutputTail(const QString &text)
+{
+    outputEdit->showTail(text);
 }
 
-void TestCase::setExpected(const QString &text)
+void TestCase::setRunningTime(qint64 timeUsed, int timeLimit)
 {
-    expectedEdit->modifyText(text);
+    if (timeUsed < 0 || timeLimit <= 0)
+    {
+        timeBar->hide();
+        return;
+    }
+    timeBar->setRange(0, timeLimit);
+    timeBar->setValue(int(qMin<qint64>(timeUsed, timeLimit)));
+    timeBar->setFormat(tr("%1 / %2 ms").arg(timeUsed).arg(timeLimit));
+    timeBar->show();
+}
+
+void TestCase::setExpected(const Core::TestData &data)
+{
+    expectedEdit->setData(data);
 }
 
 void TestCase::clearOutput()
 {
     outputEdit->modifyText(QString());
     currentVerdict = UNKNOWN;
+    mismatch = Core::Mismatch();
+    mismatchLabel->hide();
+    cachedLabel->hide();
+    timeBar->hide();
     diffButton->setStyleSheet("");
     diffButton->setText("**");
 }
 
-QString TestCase::input() const
+Core::TestData TestCase::input() const
 {
-    return inputEdit->getText();
+    return inputEdit->getData();
 }
 
 QString TestCase::output() const
@@ -139,9 +178,9 @@ QString TestCase::output() const
     return outputEdit->getText();
 }
 
-QString TestCase::expected() const
+Core::TestData TestCase::expected() const
 {
-    return expectedEdit->getText();
+    return expectedEdit->getData();
 }
 
 bool TestCase::isEmpty() const
@@ -164,6 +203,9 @@ void TestCase::setVerdict(Verdict verdict)
 
     LOG_INFO("Changed verdict to " << INFO_OF(verdict));
 
+    if (currentVerdict != WA)
+        mismatchLabel->hide();
+
     switch (currentVerdict)
     {
     case UNKNOWN:
@@ -192,11 +234,51 @@ void TestCase::setVerdict(Verdict verdict)
     }
 }
 
+void TestCase::setCached(bool cached)
+{
+    cachedLabel->setVisible(cached);
+}
+
 TestCase::Verdict TestCase::verdict() const
 {
     return currentVerdict;
 }
 
+void TestCase::setMismatch(const Core::Mismatch &mismatch)
+{
+    this->mismatch = mismatch;
+
+    if (!mismatch.found)
+    {
+        mismatchLabel->hide();
+        return;
+    }
+
+    LOG_INFO(INFO_OF(id) << INFO_OF(mismatch.outputLine) << INFO_OF(mismatch.outputColumn)
+                         << INFO_OF(mismatch.tokenIndex));
+
+    auto describe = [](const QString &token, bool ended) {
+        if (token.isEmpty())
+            return ended ? tr("EOF") : tr("blank");
+        return QString("\"%1\"").arg(token.length() > 16 ? token.left(13) + "..." : token).toHtmlEscaped();
+    };
+
+    mismatchLabel->setText(QString("<a href=\"#\">%1</a>")
+                               .arg(tr("Line %1:%2, expected %3, found %4")
+                                        .arg(mismatch.outputLine + 1)
+                                        .arg(mismatch.outputColumn + 1)
+                                        .arg(describe(mismatch.expectedToken, mismatch.expectedEnded))
+                                        .arg(describe(mismatch.outputToken, mismatch.outputEnded))));
+    mismatchLabel->setToolTip(
+        QString("<p>%1</p><p>%2</p><pre>%3</pre><p>%4</p><pre>%5</pre>")
+            .arg(tr("The first difference is at token #%1. Click to scroll to it.").arg(mismatch.tokenIndex + 1))
+            .arg(tr("Output:"))
+            .arg(mismatch.outputContext.toHtmlEscaped())
+            .arg(tr("Expected:"))
+            .arg(mismatch.expectedContext.toHtmlEscaped()));
+    mismatchLabel->show();
+}
+
 void TestCase::setChecked(bool checked)
 {
     checkBox->setChecked(checked);
@@ -214,13 +296,6 @@ void TestCase::setTestCaseEditFont(const QFont &font)
     expectedEdit->setFont(font);
 }
 
-void TestCase::updateHeight()
-{
-    inputEdit->startAnimation();
-    outputEdit->startAnimation();
-    expectedEdit->startAnimation();
-}
-
 QList<int> TestCase::splitterSizes() const
 {
     return splitter->sizes();
@@ -231,6 +306,17 @@ void TestCase::restoreSplitterSizes(const QList<int> &sizes)
     splitter->setSizes(sizes);
 }
 
+int TestCase::chromeHeight() const
+{
+    const auto margins = mainLayout->contentsMargins();
+    return margins.top() + margins.bottom() + inputUpLayout->sizeHint().height() + qMax(0, inputLayout->spacing());
+}
+
+int TestCase::editHeight() const
+{
+    return qMax(inputEdit->preferredHeight(), qMax(outputEdit->preferredHeight(), expectedEdit->preferredHeight()));
+}
+
 void TestCase::onCheckBoxToggled(bool checked)
 {
     if (checked)
@@ -245,6 +331,8 @@ void TestCase::onCheckBoxToggled(bool checked)
         outputEdit->hide();
         expectedEdit->hide();
     }
+    emit checkedChanged(id, checked);
+    emit heightChanged(id);
 }
 
 void TestCase::onRunButtonClicked()
@@ -257,8 +345,14 @@ void TestCase::onRunButtonClicked()
 void TestCase::onDiffButtonClicked()
 {
     LOG_INFO("Diff button clicked for " << INFO_OF(id));
-    diffViewer->setText(output(), expected());
-    Util::showWidgetOnTop(diffViewer);
+    emit requestDiff(id);
+}
+
+void TestCase::onMismatchLinkActivated()
+{
+    LOG_INFO("Mismatch link clicked for " << INFO_OF(id));
+    outputEdit->scrollToPosition(mismatch.outputLine, mismatch.outputColumn);
+    expectedEdit->scrollToPosition(mismatch.expectedLine, mismatch.expectedColumn);
 }
 
 void TestCase::onDelButtonClicked()
@@ -266,25 +360,15 @@ void TestCase::onDelButtonClicked()
     LOG_INFO("Del button clicked for " << INFO_OF(id));
     if (isEmpty())
     {
-        emit deleted(this);
+        emit requestDelete(id);
     }
     else
     {
         auto res = QMessageBox::question(this, tr("Delete Testcase"),
                                          tr("Are you sure you want to delete test case #%1?").arg(id + 1));
         if (res == QMessageBox::Yes)
-            emit deleted(this);
+            emit requestDelete(id);
     }
 }
 
-void TestCase::onToLongForHtml()
-{
-    log->warn(tr("Diff Viewer[%1]").arg(id + 1),
-              tr("The output/expected contains more than %1 characters, HTML diff viewer is disabled. You can change "
-                 "the length limit at %2.")
-                  .arg(SettingsHelper::getHTMLDiffViewerLengthLimit())
-                  .arg(SettingsHelper::pathOfHTMLDiffViewerLengthLimit()),
-              false);
-}
-
 } // namespace Widgets
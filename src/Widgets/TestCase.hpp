@@ -18,6 +18,8 @@
 #ifndef TESTCASE_HPP
 #define TESTCASE_HPP
 
+#include "Core/OutputComparator.hpp"
+#include "Core/TestData.hpp"
 #include <QWidget>
 
 class MessageLogger;
@@ -25,13 +27,13 @@ class QCheckBox;
 class QHBoxLayout;
 class QLabel;
 class QMenu;
+class QProgressBar;
 class QPushButton;
 class QSplitter;
 class QVBoxLayout;
 
 namespace Widgets
 {
-class DiffViewer;
 class TestCaseEdit;
 
 class TestCase : public QWidget
@@ -48,36 +50,68 @@ class TestCase : public QWidget
         UNKNOWN
     };
 
-    explicit TestCase(int index, MessageLogger *logger, QWidget *parent = nullptr, const QString &in = QString(),
-                      const QString &exp = QString());
-    void setInput(const QString &text);
+    explicit TestCase(int index, MessageLogger *logger, QWidget *parent = nullptr,
+                      const Core::TestData &in = Core::TestData(), const QString &out = QString(),
+                      const Core::TestData &exp = Core::TestData());
+    void setInput(const Core::TestData &data);
     void setOutput(const QString &text);
-    void setExpected(const QString &text);
+
+    /**
+     * @brief show the output of a running program, see TestCaseEdit::showTail
+     */
+    void setOutputTail(const QString &text);
+
+    /**
+     * @brief show how long the program has been running
+     * @param timeUsed the time used in milliseconds, or -1 to hide it when the program is not running
+     * @param timeLimit the time limit in milliseconds
+     */
+    void setRunningTime(qint64 timeUsed, int timeLimit);
+    void setExpected(const Core::TestData &data);
     void clearOutput();
-    QString input() const;
+    Core::TestData input() const;
     QString output() const;
-    QString expected() const;
+    Core::TestData expected() const;
     bool isEmpty() const;
     void setID(int index);
     void setVerdict(Verdict verdict);
     Verdict verdict() const;
+    void setMismatch(const Core::Mismatch &mismatch);
+
+    /**
+     * @brief mark whether the output and the verdict are reused from a previous run
+     */
+    void setCached(bool cached);
     void setChecked(bool checked);
     bool isChecked() const;
     void setTestCaseEditFont(const QFont &font);
-    void updateHeight();
     QList<int> splitterSizes() const;
     void restoreSplitterSizes(const QList<int> &sizes);
 
+    /**
+     * @returns the height of the test case without the editors, i.e. the height when it's unchecked
+     */
+    int chromeHeight() const;
+
+    /**
+     * @returns the height of the editors to show the current texts
+     */
+    int editHeight() const;
+
   signals:
-    void deleted(TestCase *widget);
+    void requestDelete(int index);
     void requestRun(int index);
+    void requestDiff(int index);
+    void checkedChanged(int index, bool checked);
+    void heightChanged(int index);
+    void edited(int index); // the input or the expected output is edited
 
   private slots:
     void onCheckBoxToggled(bool checked);
     void onRunButtonClicked();
     void onDiffButtonClicked();
     void onDelButtonClicked();
-    void onToLongForHtml();
+    void onMismatchLinkActivated();
 
   private:
     QHBoxLayout *mainLayout = nullptr, *inputUpLayout = nullptr, *outputUpLayout = nullptr, *expectedUpLayout = nullptr;
@@ -85,12 +119,14 @@ class TestCase : public QWidget
     QWidget *inputWidget = nullptr, *outputWidget = nullptr, *expectedWidget = nullptr;
     QVBoxLayout *inputLayout = nullptr, *outputLayout = nullptr, *expectedLayout = nullptr;
     QCheckBox *checkBox = nullptr;
-    QLabel *inputLabel = nullptr, *outputLabel = nullptr, *expectedLabel = nullptr;
+    QLabel *inputLabel = nullptr, *outputLabel = nullptr, *expectedLabel = nullptr, *mismatchLabel = nullptr,
+        *cachedLabel = nullptr;
     QPushButton *runButton = nullptr, *diffButton = nullptr, *delButton = nullptr;
+    QProgressBar *timeBar = nullptr; // the time used by the running program
     TestCaseEdit *inputEdit = nullptr, *outputEdit = nullptr, *expectedEdit = nullptr;
-    DiffViewer *diffViewer = nullptr;
     MessageLogger *log;
     Verdict currentVerdict = UNKNOWN;
+    Core::Mismatch mismatch; // the first difference of the current output, shown when the verdict is WA
     int id;
 };
 } // namespace Widgets
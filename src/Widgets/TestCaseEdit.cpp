@@ -19,40 +19,27 @@
 #include "Core/EventLogger.hpp"
 #include "Core/MessageLogger.hpp"
 #include "Settings/DefaultPathManager.hpp"
-#include "Util/FileUtil.hpp"
 #include <QApplication>
 #include <QInputDialog>
 #include <QMenu>
 #include <QMimeData>
-#include <QPropertyAnimation>
+#include <QScrollBar>
 #include <QStyle>
 #include <generated/SettingsHelper.hpp>
 
 namespace Widgets
 {
-TestCaseEdit::TestCaseEdit(Role role, int id, MessageLogger *logger, const QString &text, QWidget *parent)
+TestCaseEdit::TestCaseEdit(Role role, int id, MessageLogger *logger, const Core::TestData &data, QWidget *parent)
     : QPlainTextEdit(parent), log(logger), role(role), id(id)
 {
     setFont(SettingsHelper::getTestCasesFont());
     setWordWrapMode(QTextOption::NoWrap);
-    modifyText(text, false);
+    connect(document(), &QTextDocument::contentsChanged, this, [this] { dataChanged = true; });
+    setData(data, false);
 
-    animation = new QPropertyAnimation(this, "minimumHeight", this);
-
-    switch (role)
-    {
-    case Input:
-    case Expected:
-        connect(this, &TestCaseEdit::textChanged, this, &TestCaseEdit::startAnimation);
-        break;
-    case Output:
+    if (role == Output)
         setReadOnly(true);
-        break;
-    default:
-        Q_UNREACHABLE();
-    }
 
-    startAnimation();
     setContextMenuPolicy(Qt::CustomContextMenu);
     connect(this, &TestCaseEdit::customContextMenuRequested, this, &TestCaseEdit::onCustomContextMenuRequested);
 }
@@ -89,37 +76,55 @@ void TestCaseEdit::dropEvent(QDropEvent *event)
 
 void TestCaseEdit::modifyText(const QString &text, bool keepHistory)
 {
-    this->text = text;
+    // outputs are only kept for a run, so they are not stored in files
+    setData(role == Output ? Core::TestData(text) : Core::TestData::fromString(text), keepHistory);
+}
 
-    const int limit = role == Output ? SettingsHelper::getOutputDisplayLengthLimit()
-                                     : SettingsHelper::getDisplayTestCaseLengthLimit();
+void TestCaseEdit::setData(const Core::TestData &data, bool keepHistory)
+{
+    this->data = data;
+    currentPage = 0;
+
+    const int limit = displayLimit();
 
     QString displayText;
 
-    if (text.length() <= limit)
+    if (data.size() <= limit)
     {
-        displayText = text;
+        displayText = data.toString();
         if (role != Output)
             setReadOnly(false);
+        setToolTip(QString());
     }
     else
     {
-        LOG_INFO("Too long: " << INFO_OF(role) << INFO_OF(id) << INFO_OF(text.length()));
+        LOG_INFO("Too long: " << INFO_OF(role) << INFO_OF(id) << INFO_OF(data.size()));
 
         setReadOnly(true);
 
-        displayText = text.left(limit) + "...";
+        if (keepHistory)
+        {
+            const QString name = role == Input ? tr("Input") : (role == Output ? tr("Output") : tr("Expected"));
+            const QString setLimitPlace = role == Output ? SettingsHelper::pathOfOutputDisplayLengthLimit()
+                                                         : SettingsHelper::pathOfDisplayTestCaseLengthLimit();
+
+            log->warn(QString("%1[%2]").arg(name).arg(id + 1),
+                      tr("The test case is longer than %1 characters, so it's shown in pages and the test case editor "
+                         "is read-only. You can turn the pages in the context menu, or set the length limit at %2.")
+                          .arg(limit)
+                          .arg(setLimitPlace),
+                      false);
+        }
 
-        const QString name = role == Input ? tr("Input") : (role == Output ? tr("Output") : tr("Expected"));
-        const QString setLimitPlace = role == Output ? SettingsHelper::pathOfOutputDisplayLengthLimit()
-                                                     : SettingsHelper::pathOfDisplayTestCaseLengthLimit();
+        if (!keepHistory)
+        {
+            showPage(0);
+            dataChanged = false;
+            return;
+        }
 
-        log->warn(QString("%1[%2]").arg(name).arg(id + 1),
-                  tr("Only the first %1 characters are shown. Now the test case editor is read-only. You can set "
-                     "the length limit at %2.")
-                      .arg(limit)
-                      .arg(setLimitPlace),
-                  false);
+        displayText = data.page(0, limit) + "...";
+        setToolTip(tr("Page %1 of %2").arg(1).arg(pageCount()));
     }
 
     if (keepHistory)
@@ -132,26 +137,70 @@ void TestCaseEdit::modifyText(const QString &text, bool keepHistory)
     {
         setPlainText(displayText);
     }
+    dataChanged = false;
+}
+
+void TestCaseEdit::showTail(const QString &text)
+{
+    data = Core::TestData(text);
+    currentPage = 0;
+    setToolTip(QString());
+    setPlainText(text);
+    dataChanged = false;
+    verticalScrollBar()->setValue(verticalScrollBar()->maximum());
 }
 
 QString TestCaseEdit::getText()
 {
-    if (!isReadOnly())
-        text = toPlainText();
-    return text;
+    return getData().toString();
 }
 
-void TestCaseEdit::startAnimation()
+Core::TestData TestCaseEdit::getData()
 {
-    int newHeight = qMin(fontMetrics().boundingRect("f").height() * (document()->lineCount() + 2),
-                         SettingsHelper::getTestCaseMaximumHeight());
-    if (newHeight != minimumHeight())
+    // the text is only converted after it's edited, so that the data and its hash are reused
+    if (dataChanged && !isReadOnly())
+        data = Core::TestData::fromString(toPlainText());
+    dataChanged = false;
+    return data;
+}
+
+void TestCaseEdit::scrollToPosition(int line, int column)
+{
+    int pageLine = line;
+    int pageColumn = column;
+    if (pageCount() > 1)
     {
-        animation->stop();
-        animation->setStartValue(minimumHeight());
-        animation->setEndValue(newHeight);
-        animation->start();
+        const int page = data.findInPages(line, column, displayLimit(), &pageLine, &pageColumn);
+        if (page != currentPage)
+            showPage(page);
+        if (currentPage > 0 && pageLine == 0)
+            pageColumn += 3; // the "..." at the start of the page
     }
+    auto block = document()->findBlockByNumber(pageLine);
+    if (!block.isValid())
+    {
+        LOG_INFO("The position is not displayed: " << INFO_OF(line) << INFO_OF(column));
+        return;
+    }
+    QTextCursor cursor(block);
+    cursor.setPosition(block.position() + qMin(pageColumn, block.length() - 1));
+    setTextCursor(cursor);
+    centerCursor();
+}
+
+int TestCaseEdit::lineHeight(const QFont &font)
+{
+    return QFontMetrics(font).boundingRect("f").height();
+}
+
+int TestCaseEdit::preferredHeight(int lineHeight, int lineCount)
+{
+    return qMin(lineHeight * (lineCount + 2), SettingsHelper::getTestCaseMaximumHeight());
+}
+
+int TestCaseEdit::preferredHeight() const
+{
+    return preferredHeight(lineHeight(font()), document()->lineCount());
 }
 
 void TestCaseEdit::onCustomContextMenuRequested(const QPoint &pos)
@@ -165,9 +214,19 @@ void TestCaseEdit::onCustomContextMenuRequested(const QPoint &pos)
         QString fileName =
             DefaultPathManager::getSaveFileName("Save Test Case To A File", this, tr("Save test case to file"));
         if (!fileName.isEmpty())
-            Util::saveFile(fileName, getText(), tr("Save test case to file"), true, log);
+            getData().save(fileName, tr("Save test case to file"), true, log);
     });
 
+    if (pageCount() > 1)
+    {
+        menu->addAction(QApplication::style()->standardIcon(QStyle::SP_ArrowBack), tr("Previous Page"),
+                        [this] { showPage(currentPage - 1); })
+            ->setEnabled(currentPage > 0);
+        menu->addAction(QApplication::style()->standardIcon(QStyle::SP_ArrowForward), tr("Next Page"),
+                        [this] { showPage(currentPage + 1); })
+            ->setEnabled(currentPage + 1 < pageCount());
+    }
+
     if (role != Output)
     {
         menu->addAction(QApplication::style()->standardIcon(QStyle::SP_DialogOpenButton), tr("Load From File"), [this] {
@@ -176,14 +235,17 @@ void TestCaseEdit::onCustomContextMenuRequested(const QPoint &pos)
             if (!res.isEmpty())
                 loadFromFile(res);
         });
-        menu->addAction(
-            QApplication::style()->standardIcon(QStyle::SP_TitleBarMaxButton), tr("Edit in Bigger Window"), [this] {
+        if (!isReadOnly())
+        {
+            auto icon = QApplication::style()->standardIcon(QStyle::SP_TitleBarMaxButton);
+            menu->addAction(icon, tr("Edit in Bigger Window"), [this] {
                 LOG_INFO("Opening for edit in big window");
                 bool ok = false;
                 auto res = QInputDialog::getMultiLineText(this, tr("Edit Testcase"), QString(), getText(), &ok);
                 if (ok)
                     modifyText(res);
             });
+        }
     }
 
     if (role == Expected)
@@ -200,8 +262,31 @@ void TestCaseEdit::onCustomContextMenuRequested(const QPoint &pos)
 
 void TestCaseEdit::loadFromFile(const QString &path)
 {
-    auto content = Util::readFile(path, "Load Testcase From File", log);
+    auto content = Core::TestData::fromFile(path, "Load Testcase From File", log);
     if (!content.isNull())
-        modifyText(content);
+        setData(content);
+}
+
+int TestCaseEdit::displayLimit() const
+{
+    return role == Output ? SettingsHelper::getOutputDisplayLengthLimit()
+                          : SettingsHelper::getDisplayTestCaseLengthLimit();
+}
+
+int TestCaseEdit::pageCount() const
+{
+    return data.size() > displayLimit() ? data.pageCount(displayLimit()) : 1;
+}
+
+void TestCaseEdit::showPage(int page)
+{
+    const int pages = pageCount();
+    currentPage = qBound(0, page, pages - 1);
+    LOG_INFO(INFO_OF(id) << INFO_OF(currentPage) << INFO_OF(pages));
+    setPlainText(QString("%1%2%3")
+                     .arg(currentPage > 0 ? "..." : "")
+                     .arg(data.page(currentPage, displayLimit()))
+                     .arg(currentPage + 1 < pages ? "..." : ""));
+    setToolTip(tr("Page %1 of %2").arg(currentPage + 1).arg(pages));
 }
 } // namespace Widgets
@@ -18,10 +18,10 @@
 #ifndef TESTCASEEDIT_HPP
 #define TESTCASEEDIT_HPP
 
+#include "Core/TestData.hpp"
 #include <QPlainTextEdit>
 
 class MessageLogger;
-class QPropertyAnimation;
 
 namespace Widgets
 {
@@ -37,16 +37,49 @@ class TestCaseEdit : public QPlainTextEdit
         Expected
     };
 
-    explicit TestCaseEdit(Role role, int id, MessageLogger *logger, const QString &text = QString(),
+    explicit TestCaseEdit(Role role, int id, MessageLogger *logger, const Core::TestData &data = Core::TestData(),
                           QWidget *parent = nullptr);
     void dragEnterEvent(QDragEnterEvent *event) override;
     void dragMoveEvent(QDragMoveEvent *event) override;
     void dropEvent(QDropEvent *event) override;
+
     void modifyText(const QString &text, bool keepHistory = true);
+
+    /**
+     * @brief set the data of the editor
+     * @param data the new data, it's shown in pages if it's too long
+     * @param keepHistory whether the change can be undone, it's false when the editor is being created, in which case
+     *        no warning is shown for a long text, because editors are recreated when they are scrolled into view
+     */
+    void setData(const Core::TestData &data, bool keepHistory = true);
+
+    /**
+     * @brief show the end of the output of a running program, scrolled to the bottom
+     * @note It's only for the output editor, and there's no history, because the text is replaced frequently.
+     */
+    void showTail(const QString &text);
+
+    /**
+     * @note This decodes the whole data, use getData() if possible.
+     */
     QString getText();
+    Core::TestData getData();
+    void scrollToPosition(int line, int column);
+
+    /**
+     * @returns the height of a line in an editor with the given font, used to compute the preferred heights
+     */
+    static int lineHeight(const QFont &font);
+
+    /**
+     * @returns the height of an editor to show the given number of lines with the given line height
+     */
+    static int preferredHeight(int lineHeight, int lineCount);
 
-  public slots:
-    void startAnimation();
+    /**
+     * @returns the height to show the current text of the editor
+     */
+    int preferredHeight() const;
 
   private slots:
     void onCustomContextMenuRequested(const QPoint &);
@@ -56,11 +89,15 @@ class TestCaseEdit : public QPlainTextEdit
 
   private:
     void loadFromFile(const QString &path);
+    int displayLimit() const;
+    int pageCount() const;
+    void showPage(int page);
 
   private:
-    QPropertyAnimation *animation;
     MessageLogger *log;
-    QString text;
+    Core::TestData data;
+    int currentPage = 0;      // the page shown when the data is too long
+    bool dataChanged = false; // whether the text is edited after the data is set or read
     Role role;
     int id;
 };
@@ -18,10 +18,16 @@
 #include "Widgets/TestCases.hpp"
 #include "Core/EventLogger.hpp"
 #include "Core/MessageLogger.hpp"
+#include "Core/TestCaseFiles.hpp"
 #include "Core/TestCasesCopyPaster.hpp"
+#include "Core/TestCasesImporter.hpp"
+#include "Core/Tracer.hpp"
 #include "Settings/DefaultPathManager.hpp"
-#include "Util/FileUtil.hpp"
+#include "Util/Util.hpp"
+#include "Widgets/DiffViewer.hpp"
 #include "Widgets/TestCase.hpp"
+#include "Widgets/TestCasesModel.hpp"
+#include "Widgets/TestCasesView.hpp"
 #include "generated/SettingsHelper.hpp"
 #include <QComboBox>
 #include <QFileInfo>
@@ -29,17 +35,14 @@
 #include <QLabel>
 #include <QMenu>
 #include <QMessageBox>
+#include <QProgressDialog>
 #include <QPushButton>
-#include <QScrollArea>
-#include <QSet>
 #include <QVBoxLayout>
 
 #define VALIDATE_INDEX(x) validateIndex(x, __func__)
 
 namespace Widgets
 {
-const int TestCases::MAX_NUMBER_OF_TESTCASES;
-
 TestCases::TestCases(MessageLogger *logger, QWidget *parent) : QWidget(parent), log(logger)
 {
     mainLayout = new QVBoxLayout(this);
@@ -52,9 +55,9 @@ TestCases::TestCases(MessageLogger *logger, QWidget *parent) : QWidget(parent),
     moreButton = new QPushButton(tr("More"));
     addCheckerButton = new QPushButton(tr("Add Checker"));
     checkerComboBox = new QComboBox();
-    scrollArea = new QScrollArea();
-    scrollAreaWidget = new QWidget();
-    scrollAreaLayout = new QVBoxLayout(scrollAreaWidget);
+    model = new TestCasesModel(this);
+    view = new TestCasesView(model, log);
+    files = new Core::TestCaseFiles(log, this);
 
     titleLayout->addWidget(label);
     titleLayout->addWidget(verdicts);
@@ -63,11 +66,9 @@ TestCases::TestCases(MessageLogger *logger, QWidget *parent) : QWidget(parent),
     checkerLayout->addWidget(checkerLabel);
     checkerLayout->addWidget(checkerComboBox);
     checkerLayout->addWidget(addCheckerButton);
-    scrollArea->setWidgetResizable(true);
-    scrollArea->setWidget(scrollAreaWidget);
     mainLayout->addLayout(titleLayout);
     mainLayout->addLayout(checkerLayout);
-    mainLayout->addWidget(scrollArea);
+    mainLayout->addWidget(view);
 
     verdicts->setToolTip(tr("Unaccepted / Accepted / Total"));
     addCheckerButton->setToolTip(tr("Add a custom testlib checker"));
@@ -81,100 +82,50 @@ TestCases::TestCases(MessageLogger *logger, QWidget *parent) : QWidget(parent),
             DefaultPathManager::getOpenFileNames("Add Pairs Of Test Cases", this, tr("Choose Testcase Files"));
         LOG_INFO(paths.join(", "));
         if (!paths.isEmpty())
-        {
-            QVariantList rules = SettingsHelper::getTestcasesMatchingRules();
-            QSet<QString> remain;
-            for (auto const &path : paths)
-                remain.insert(QFileInfo(path).fileName());
-            // load pairs
-            for (auto const &rule : rules)
-            {
-                QRegularExpression inputRegex("^" + rule.toStringList().front() + "$");
-                QString answerReplace(rule.toStringList().back());
-                for (auto const &path : paths)
-                {
-                    auto inputFile = QFileInfo(path).fileName();
-                    if (!remain.contains(inputFile))
-                        continue;
-                    if (!inputRegex.match(inputFile).hasMatch())
-                        continue;
-                    auto answerFile = inputFile;
-                    answerFile.replace(inputRegex, answerReplace);
-                    if (!remain.contains(answerFile))
-                        continue;
-                    remain.remove(inputFile);
-                    remain.remove(answerFile);
-                    auto answerPath = QFileInfo(path).dir().filePath(answerFile);
-                    auto input = loadTestCaseFromFile(path, tr("Testcases"));
-                    auto answer = loadTestCaseFromFile(answerPath, tr("Testcases"));
-                    if (!input.isNull() && !answer.isNull())
-                    {
-                        addTestCase(input, answer);
-                        log->info(tr("Load Testcases"),
-                                  tr("A pair of testcases [%1] and [%2] is loaded").arg(path).arg(answerPath));
-                    }
-                }
-            }
-            // load single input
-            for (auto const &rule : rules)
-            {
-                QRegularExpression inputRegex("^" + rule.toStringList().front() + "$");
-                for (auto const &path : paths)
-                {
-                    auto inputFile = QFileInfo(path).fileName();
-                    if (!remain.contains(inputFile))
-                        continue;
-                    if (!inputRegex.match(inputFile).hasMatch())
-                        continue;
-                    remain.remove(inputFile);
-                    auto input = loadTestCaseFromFile(path, tr("Testcases"));
-                    if (!input.isNull())
-                    {
-                        addTestCase(input, QString());
-                        log->info(tr("Load Testcases"), tr("An input [%1] is loaded").arg(path));
-                    }
-                }
-            }
-            if (!remain.isEmpty())
-            {
-                QStringList remainPaths;
-                for (auto const &path : remain)
-                    remainPaths.push_back(QString("[%1]").arg(path));
-                log->warn(tr("Load Testcases"),
-                          tr("The following files are not loaded because they are not matched:%1. You can set the "
-                             "matching rules at %2.")
-                              .arg(remainPaths.join(", "))
-                              .arg(SettingsHelper::pathOfTestcasesMatchingRules()),
-                          false);
-            }
-        }
+            importTestCases(paths);
+    });
+
+    moreMenu->addAction(tr("Import Testcases From Archive"), [this] {
+        QString path = DefaultPathManager::getOpenFileName("Import Test Cases", this, tr("Choose Testcase Archive"),
+                                                           tr("Archives") + " (*.zip *.tar)");
+        LOG_INFO(INFO_OF(path));
+        if (!path.isEmpty())
+            importTestCases({path});
+    });
+
+    moreMenu->addAction(tr("Import Testcases From Directory"), [this] {
+        QString path =
+            DefaultPathManager::getExistingDirectory("Import Test Cases", this, tr("Choose Testcase Directory"));
+        LOG_INFO(INFO_OF(path));
+        if (!path.isEmpty())
+            importTestCases({path});
     });
 
     //: Here "Check" means to check the checkbox
     moreMenu->addAction(tr("Check All"), [this] {
         LOG_INFO("Check All");
-        for (auto *t : testcases)
-            t->setChecked(true);
+        for (int i = 0; i < count(); ++i)
+            setChecked(i, true);
     });
 
     moreMenu->addAction(tr("Uncheck All"), [this] {
         LOG_INFO("Uncheck All");
-        for (auto *t : testcases)
-            t->setChecked(false);
+        for (int i = 0; i < count(); ++i)
+            setChecked(i, false);
     });
 
     moreMenu->addAction(tr("Uncheck Accepted"), [this] {
         LOG_INFO("Uncheck Accepted");
-        for (auto *t : testcases)
-            if (t->verdict() == TestCase::AC)
-                t->setChecked(false);
+        for (int i = 0; i < count(); ++i)
+            if (model->verdict(i) == TestCase::AC)
+                setChecked(i, false);
     });
 
     //: This action checks the checkboxes which were not checked, and unchecks the ones which were checked
     moreMenu->addAction(tr("Invert"), [this] {
         LOG_INFO("Invert");
-        for (auto *t : testcases)
-            t->setChecked(t->isChecked() ^ 1);
+        for (int i = 0; i < count(); ++i)
+            setChecked(i, isChecked(i) ^ 1);
     });
 
     moreMenu->addAction(tr("Delete All"), [this] {
@@ -183,23 +134,12 @@ TestCases::TestCases(MessageLogger *logger, QWidget *parent) : QWidget(parent),
         if (res != QMessageBox::Yes)
             return;
 
-        for (int i = 0; i < count(); ++i)
-        {
-            onChildDeleted(testcases[i]);
-            --i;
-        }
+        clear();
     });
 
     moreMenu->addAction(tr("Delete Empty"), [this] {
         LOG_INFO("Delete Empty");
-        for (int i = 0; i < count(); ++i)
-        {
-            if (testcases[i]->isEmpty())
-            {
-                onChildDeleted(testcases[i]);
-                --i;
-            }
-        }
+        removeTestCases([this](int index) { return inputData(index).isEmpty() && expectedData(index).isEmpty(); });
     });
 
     moreMenu->addAction(tr("Delete Checked"), [this] {
@@ -210,14 +150,7 @@ TestCases::TestCases(MessageLogger *logger, QWidget *parent) : QWidget(parent),
         if (res != QMessageBox::Yes)
             return;
 
-        for (int i = 0; i < count(); ++i)
-        {
-            if (isChecked(i))
-            {
-                onChildDeleted(testcases[i]);
-                --i;
-            }
-        }
+        removeTestCases([this](int index) { return isChecked(index); });
     });
 
     moreMenu->addAction(tr("Copy Test Cases"), [this] {
@@ -263,94 +196,160 @@ TestCases::TestCases(MessageLogger *logger, QWidget *parent) : QWidget(parent),
     connect(checkerComboBox, qOverload<int>(&QComboBox::currentIndexChanged), this, &TestCases::checkerChanged);
     connect(addButton, &QPushButton::clicked, this, &TestCases::on_addButton_clicked);
     connect(addCheckerButton, &QPushButton::clicked, this, &TestCases::on_addCheckerButton_clicked);
+    connect(view, &TestCasesView::requestRun, this, &TestCases::requestRun);
+    connect(view, &TestCasesView::requestDelete, this, &TestCases::onDeleteRequested);
+    connect(view, &TestCasesView::requestDiff, this, &TestCases::onDiffRequested);
+
+    connect(view, &TestCasesView::edited, this, &TestCases::changed);
+    connect(model, &TestCasesModel::rowsInserted, this, &TestCases::changed);
+    connect(model, &TestCasesModel::rowsRemoved, this, &TestCases::changed);
+    connect(model, &TestCasesModel::modelReset, this, &TestCases::changed);
+    connect(model, &TestCasesModel::dataChanged, this,
+            [this](const QModelIndex &, const QModelIndex &, const QVector<int> &roles) {
+                // the outputs and the verdicts are not saved in the session
+                for (int role : {int(TestCasesModel::InputRole), int(TestCasesModel::ExpectedRole),
+                                 int(Qt::CheckStateRole)})
+                {
+                    if (roles.contains(role))
+                    {
+                        emit changed();
+                        return;
+                    }
+                }
+            });
+    connect(checkerComboBox, qOverload<int>(&QComboBox::currentIndexChanged), this, &TestCases::changed);
 }
 
 void TestCases::setInput(int index, const QString &input)
+{
+    setInput(index, Core::TestData::fromString(input));
+}
+
+void TestCases::setInput(int index, const Core::TestData &input)
 {
     if (VALIDATE_INDEX(index))
-        testcases[index]->setInput(input);
+    {
+        if (auto *widget = view->widget(index))
+            widget->setInput(input);
+        model->setInput(index, input);
+    }
 }
 
 void TestCases::setOutput(int index, const QString &output)
 {
     if (VALIDATE_INDEX(index))
-        testcases[index]->setOutput(output);
+    {
+        Core::Tracer::Span span("ui", "Set Output", traceTab, index);
+        setRunningTime(index, -1, 0);
+        if (auto *widget = view->widget(index))
+            widget->setOutput(output);
+        model->setOutput(index, output);
+        if (diffViewer && diffViewerIndex == index && !diffViewer->isHidden())
+            diffViewer->setText(output, expected(index));
+    }
 }
 
 void TestCases::setExpected(int index, const QString &expected)
 {
-    if (VALIDATE_INDEX(index))
-        testcases[index]->setExpected(expected);
+    setExpected(index, Core::TestData::fromString(expected));
 }
 
-void TestCases::addTestCase(const QString &input, const QString &expected)
+void TestCases::setExpected(int index, const Core::TestData &expected)
 {
-    if (count() >= MAX_NUMBER_OF_TESTCASES)
-    {
-        LOG_WARN("Max testcase limit reached");
-        QMessageBox::warning(this, tr("Add Test Case"),
-                             tr("There are already %1 test cases, you can't add more.").arg(count()));
-    }
-    else
+    if (VALIDATE_INDEX(index))
     {
-        LOG_INFO("New testcase added");
-        auto *testcase = new TestCase(count(), log, this, input, expected);
-        connect(testcase, &TestCase::deleted, this, &TestCases::onChildDeleted);
-        connect(testcase, &TestCase::requestRun, this, &TestCases::requestRun);
-        testcases.push_back(testcase);
-        scrollAreaLayout->addWidget(testcase);
-        updateVerdicts();
+        if (auto *widget = view->widget(index))
+            widget->setExpected(expected);
+        model->setExpected(index, expected);
     }
 }
 
+void TestCases::addTestCase(const QString &input, const QString &expected)
+{
+    addTestCase(Core::TestData::fromString(input), Core::TestData::fromString(expected));
+}
+
+void TestCases::addTestCase(const Core::TestData &input, const Core::TestData &expected)
+{
+    LOG_INFO("New testcase added");
+    model->insertTestCases(count(), {input}, {expected});
+    updateVerdicts();
+}
+
 void TestCases::clearOutput()
 {
     for (int i = 0; i < count(); ++i)
-        testcases[i]->clearOutput();
+    {
+        if (auto *widget = view->widget(i))
+            widget->clearOutput();
+    }
+    model->clearOutputs();
     updateVerdicts();
 }
 
 void TestCases::clear()
 {
-    while (count() > 0)
-        onChildDeleted(testcases.front());
+    removeTestCases([](int) { return true; });
 }
 
 QString TestCases::input(int index) const
 {
-    return VALIDATE_INDEX(index) ? testcases[index]->input() : QString();
+    return inputData(index).toString();
 }
 
 QString TestCases::output(int index) const
 {
-    return VALIDATE_INDEX(index) ? testcases[index]->output() : QString();
+    if (!VALIDATE_INDEX(index))
+        return QString();
+    if (auto *widget = view->widget(index))
+        return widget->output();
+    return model->output(index);
 }
 
 QString TestCases::expected(int index) const
 {
-    return VALIDATE_INDEX(index) ? testcases[index]->expected() : QString();
+    return expectedData(index).toString();
 }
 
-void TestCases::loadStatus(const QStringList &inputList, const QStringList &expectedList)
+Core::TestData TestCases::inputData(int index) const
+{
+    if (!VALIDATE_INDEX(index))
+        return Core::TestData();
+    if (auto *widget = view->widget(index))
+        return widget->input();
+    return model->input(index);
+}
+
+Core::TestData TestCases::expectedData(int index) const
+{
+    if (!VALIDATE_INDEX(index))
+        return Core::TestData();
+    if (auto *widget = view->widget(index))
+        return widget->expected();
+    return model->expected(index);
+}
+
+void TestCases::loadStatus(const QList<Core::TestData> &inputList, const QList<Core::TestData> &expectedList)
 {
     clear();
-    for (int i = 0; i < inputList.length() && i < expectedList.length(); ++i)
-        addTestCase(inputList[i], expectedList[i]);
+    const int number = qMin(inputList.length(), expectedList.length());
+    model->insertTestCases(0, inputList.mid(0, number), expectedList.mid(0, number));
+    updateVerdicts();
 }
 
-QStringList TestCases::inputs() const
+QList<Core::TestData> TestCases::inputs() const
 {
-    QStringList res;
+    QList<Core::TestData> res;
     for (int i = 0; i < count(); ++i)
-        res.append(testcases[i]->input());
+        res.append(inputData(i));
     return res;
 }
 
-QStringList TestCases::expecteds() const
+QList<Core::TestData> TestCases::expecteds() const
 {
-    QStringList res;
+    QList<Core::TestData> res;
     for (int i = 0; i < count(); ++i)
-        res.append(testcases[i]->expected());
+        res.append(expectedData(i));
     return res;
 }
 
@@ -358,70 +357,93 @@ void TestCases::loadFromSavedFiles(const QString &filePath)
 {
     clear();
 
-    for (int i = MAX_NUMBER_OF_TESTCASES - 1; i >= 0; --i)
-    {
-        auto inputPath = inputFilePath(filePath, i);
-        auto answerPath = answerFilePath(filePath, i);
-        if (QFile::exists(inputPath) || QFile::exists(answerPath))
-        {
-            for (int j = 0; j <= i; ++j)
-            {
-                addTestCase(loadTestCaseFromFile(inputFilePath(filePath, j), tr("Input #%1").arg(j + 1)),
-                            loadTestCaseFromFile(answerFilePath(filePath, j), tr("Expected #%1").arg(j + 1)));
-            }
-            break;
-        }
-    }
+    QList<Core::TestData> inputList, expectedList;
+    files->load(filePath, inputList, expectedList);
+    model->insertTestCases(0, inputList, expectedList);
 
     if (count() == 0)
         addTestCase();
+
+    updateVerdicts();
 }
 
 void TestCases::saveToFiles(const QString &filePath, bool safe)
 {
-    for (int i = 0; i < count(); ++i)
-    {
-        if (!input(i).isEmpty())
-            Util::saveFile(inputFilePath(filePath, i), input(i), tr("Save Input #%1").arg(i + 1), safe, log, true);
-        if (!expected(i).isEmpty())
-            Util::saveFile(answerFilePath(filePath, i), expected(i), tr("Save Expected #%1").arg(i + 1), safe, log,
-                           true);
-    }
-    for (int i = count(); i < MAX_NUMBER_OF_TESTCASES; ++i)
-    {
-        auto inputPath = inputFilePath(filePath, i);
-        auto answerPath = answerFilePath(filePath, i);
-        if (QFile::exists(inputPath))
-            QFile::remove(inputPath);
-        if (QFile::exists(answerPath))
-            QFile::remove(answerPath);
-    }
+    files->save(filePath, inputs(), expecteds(), safe);
+}
+
+Core::TestData TestCases::loadTestCaseFromFile(const QString &path, const QString &head)
+{
+    return Core::TestData::fromFile(path, tr("Load %1").arg(head), log, true);
 }
 
-QString TestCases::loadTestCaseFromFile(const QString &path, const QString &head)
+void TestCases::importTestCases(const QStringList &paths)
 {
-    return Util::readFile(path, tr("Load %1").arg(head), log, true);
+    auto *importer = new Core::TestCasesImporter(paths, SettingsHelper::getTestcasesMatchingRules(), this);
+
+    auto *progress = new QProgressDialog(tr("Importing test cases..."), tr("Cancel"), 0, 100, this);
+    progress->setWindowTitle(tr("Import Testcases"));
+    progress->setWindowModality(Qt::WindowModal);
+    progress->setMinimumDuration(500);
+    progress->setAutoClose(false);
+    progress->setAutoReset(false);
+    connect(progress, &QProgressDialog::canceled, importer, &Core::TestCasesImporter::cancel);
+    connect(importer, &Core::TestCasesImporter::progressChanged, progress, &QProgressDialog::setValue);
+
+    connect(importer, &Core::TestCasesImporter::finished, this, [this, importer, progress] {
+        progress->deleteLater();
+        importer->deleteLater();
+
+        if (importer->isCanceled())
+            return;
+        if (!importer->errorString().isEmpty())
+        {
+            log->error(tr("Load Testcases"), importer->errorString());
+            return;
+        }
+
+        const auto inputList = importer->inputs();
+        model->insertTestCases(count(), inputList, importer->expecteds());
+        updateVerdicts();
+        log->info(tr("Load Testcases"), tr("%n test case(s) loaded", "", inputList.size()));
+
+        if (importer->unmatchedCount() > 0)
+        {
+            QStringList unmatched;
+            for (auto const &path : importer->unmatchedFiles())
+                unmatched.push_back(QString("[%1]").arg(path));
+            if (importer->unmatchedCount() > unmatched.size())
+                unmatched.push_back(tr("and %n more", "", importer->unmatchedCount() - unmatched.size()));
+            log->warn(tr("Load Testcases"),
+                      tr("The following files are not loaded because they are not matched:%1. You can set the "
+                         "matching rules at %2.")
+                          .arg(unmatched.join(", "))
+                          .arg(SettingsHelper::pathOfTestcasesMatchingRules()),
+                      false);
+        }
+    });
+
+    importer->start();
 }
 
 void TestCases::setTestCaseEditFont(const QFont &font)
 {
-    for (auto *t : testcases)
-        t->setTestCaseEditFont(font);
+    view->setTestCaseEditFont(font);
 }
 
 void TestCases::updateHeights()
 {
-    for (auto *t : testcases)
-        t->updateHeight();
+    view->updateHeights();
 }
 
 QVariantList TestCases::splitterStates() const
 {
     QVariantList states;
-    for (auto *t : testcases)
+    for (int i = 0; i < count(); ++i)
     {
+        auto *widget = view->widget(i);
         QVariantList tmp;
-        for (auto size : t->splitterSizes())
+        for (auto size : widget ? widget->splitterSizes() : model->splitterSizes(i))
             tmp.push_back(size);
         states.push_back(tmp);
     }
@@ -435,18 +457,20 @@ void TestCases::restoreSplitterStates(const QVariantList &states)
         QList<int> sizes;
         for (auto const &var : states[i].toList())
             sizes.push_back(var.toInt());
-        testcases[i]->restoreSplitterSizes(sizes);
+        model->setSplitterSizes(i, sizes);
+        if (auto *widget = view->widget(i))
+            widget->restoreSplitterSizes(sizes);
     }
 }
 
-int TestCases::id(TestCase *testcase) const
+void TestCases::setTraceTab(quint64 tab)
 {
-    return testcases.indexOf(testcase);
+    traceTab = tab;
 }
 
 int TestCases::count() const
 {
-    return testcases.count();
+    return model->rowCount();
 }
 
 void TestCases::setCheckerIndex(int index)
@@ -465,6 +489,7 @@ int TestCases::checkerIndex() const
 void TestCases::addCustomCheckers(const QStringList &list)
 {
     checkerComboBox->addItems(list);
+    emit changed();
 }
 
 QStringList TestCases::customCheckers() const
@@ -508,22 +533,78 @@ Core::Checker::CheckerType TestCases::checkerType() const
 void TestCases::setChecked(int index, bool checked)
 {
     if (VALIDATE_INDEX(index))
-        testcases[index]->setChecked(checked);
+    {
+        if (auto *widget = view->widget(index))
+            widget->setChecked(checked);
+        model->setChecked(index, checked);
+    }
 }
 
 bool TestCases::isChecked(int index) const
 {
-    return VALIDATE_INDEX(index) ? testcases[index]->isChecked() : false;
+    return VALIDATE_INDEX(index) ? model->isChecked(index) : false;
 }
 
 void TestCases::setVerdict(int index, TestCase::Verdict verdict)
 {
     if (VALIDATE_INDEX(index))
     {
-        testcases[index]->setVerdict(verdict);
+        Core::Tracer::Span span("ui", "Set Verdict", traceTab, index);
+        if (auto *widget = view->widget(index))
+            widget->setVerdict(verdict);
+        model->setVerdict(index, verdict);
         updateVerdicts();
         if (verdict == TestCase::AC && SettingsHelper::isAutoUncheckAcceptedTestcases())
-            testcases[index]->setChecked(false);
+            setChecked(index, false);
+    }
+}
+
+void TestCases::setMismatch(int index, const Core::Mismatch &mismatch)
+{
+    if (VALIDATE_INDEX(index))
+    {
+        if (auto *widget = view->widget(index))
+            widget->setMismatch(mismatch);
+        model->setMismatch(index, mismatch);
+    }
+}
+
+void TestCases::setCached(int index, bool cached)
+{
+    if (VALIDATE_INDEX(index))
+    {
+        if (auto *widget = view->widget(index))
+            widget->setCached(cached);
+        model->setCached(index, cached);
+    }
+}
+
+void TestCases::setOutputTail(int index, const QString &tail)
+{
+    if (VALIDATE_INDEX(index))
+    {
+        if (auto *widget = view->widget(index))
+            widget->setOutputTail(tail);
+        model->setOutput(index, tail);
+    }
+}
+
+void TestCases::setRunningTime(int index, qint64 timeUsed, int timeLimit)
+{
+    if (VALIDATE_INDEX(index))
+    {
+        if (auto *widget = view->widget(index))
+            widget->setRunningTime(timeUsed, timeLimit);
+        model->setRunningTime(index, timeUsed, timeLimit);
+    }
+}
+
+void TestCases::clearRunningTimes()
+{
+    for (int i = 0; i < count(); ++i)
+    {
+        if (model->runningTime(i) >= 0)
+            setRunningTime(i, -1, 0);
     }
 }
 
@@ -544,15 +625,21 @@ void TestCases::on_addCheckerButton_clicked()
     }
 }
 
-void TestCases::onChildDeleted(TestCase *widget)
+void TestCases::onDeleteRequested(int index)
 {
-    testcases.removeOne(widget);
-    widget->hide();
-    scrollAreaLayout->removeWidget(widget);
-    delete widget;
-    for (int i = 0; i < count(); ++i)
-        testcases[i]->setID(i);
-    updateVerdicts();
+    removeTestCases([index](int i) { return i == index; });
+}
+
+void TestCases::onDiffRequested(int index)
+{
+    if (!VALIDATE_INDEX(index))
+        return;
+    if (!diffViewer)
+        diffViewer = new DiffViewer(this);
+    diffViewerIndex = index;
+    diffViewer->setWindowTitle(tr("Diff Viewer #%1").arg(index + 1));
+    diffViewer->setText(output(index), expected(index));
+    Util::showWidgetOnTop(diffViewer);
 }
 
 bool TestCases::validateIndex(int index, const QString &funcName) const
@@ -563,51 +650,42 @@ bool TestCases::validateIndex(int index, const QString &funcName) const
     return false;
 }
 
-void TestCases::updateVerdicts()
+void TestCases::removeTestCases(const std::function<bool(int)> &predicate)
 {
-    int accepted = 0;
-    int unaccepted = 0;
-    for (auto *t : testcases)
+    // remove the consecutive test cases together, from the end so that the indices of the rest are not changed
+    for (int last = count() - 1; last >= 0; --last)
     {
-        switch (t->verdict())
+        if (!predicate(last))
+            continue;
+        int first = last;
+        while (first > 0 && predicate(first - 1))
+            --first;
+
+        if (diffViewerIndex >= first && diffViewerIndex <= last)
         {
-        case TestCase::AC:
-            ++accepted;
-            break;
-        case TestCase::WA:
-        case TestCase::TLE:
-        case TestCase::RE:
-            ++unaccepted;
-            break;
-        case TestCase::UNKNOWN:
-            break;
-        default:
-            Q_UNREACHABLE();
-            break;
+            diffViewer->hide();
+            diffViewerIndex = -1;
         }
+        else if (diffViewerIndex > last)
+        {
+            diffViewerIndex -= last - first + 1;
+        }
+
+        model->removeTestCases(first, last - first + 1);
+        last = first;
     }
+    updateVerdicts();
+}
+
+void TestCases::updateVerdicts()
+{
+    const int accepted = model->verdictCount(TestCase::AC);
+    const int unaccepted =
+        model->verdictCount(TestCase::WA) + model->verdictCount(TestCase::TLE) + model->verdictCount(TestCase::RE);
     verdicts->setText(QString(R"(<span style="color:red">%1</span> / <span style="color:green">%2</span> / %3)")
                           .arg(unaccepted)
                           .arg(accepted)
                           .arg(count()));
 }
 
-QString TestCases::inputFilePath(const QString &filePath, int index)
-{
-    return testCaseFilePath(SettingsHelper::getInputFileSavePath(), filePath, index);
-}
-
-QString TestCases::answerFilePath(const QString &filePath, int index)
-{
-    return testCaseFilePath(SettingsHelper::getAnswerFileSavePath(), filePath, index);
-}
-
-QString TestCases::testCaseFilePath(QString rule, const QString &filePath, int index)
-{
-    QFileInfo fileInfo(filePath);
-    return fileInfo.dir().filePath(rule.replace("${filename}", fileInfo.fileName())
-                                       .replace("${basename}", fileInfo.completeBaseName())
-                                       .replace("${0-index}", QString::number(index))
-                                       .replace("${1-index}", QString::number(index + 1)));
-}
 } // namespace Widgets
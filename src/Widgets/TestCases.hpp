@@ -19,7 +19,9 @@
 #define TESTCASES_HPP
 
 #include "Core/Checker.hpp"
+#include "Core/TestData.hpp"
 #include <QWidget>
+#include <functional>
 
 class MessageLogger;
 class QComboBox;
@@ -27,12 +29,19 @@ class QHBoxLayout;
 class QLabel;
 class QMenu;
 class QPushButton;
-class QScrollArea;
 class QVBoxLayout;
 
+namespace Core
+{
+class TestCaseFiles;
+}
+
 namespace Widgets
 {
+class DiffViewer;
 class TestCase;
+class TestCasesModel;
+class TestCasesView;
 
 class TestCases : public QWidget
 {
@@ -41,25 +50,33 @@ class TestCases : public QWidget
   public:
     explicit TestCases(MessageLogger *logger, QWidget *parent = nullptr);
 
+    /**
+     * @note These decode the whole test case, use inputData() and expectedData() for large test cases.
+     */
     QString input(int index) const;
     QString output(int index) const;
     QString expected(int index) const;
 
+    Core::TestData inputData(int index) const;
+    Core::TestData expectedData(int index) const;
+
     void setInput(int index, const QString &input);
+    void setInput(int index, const Core::TestData &input);
     void setOutput(int index, const QString &output);
     void setExpected(int index, const QString &expected);
+    void setExpected(int index, const Core::TestData &expected);
 
-    void loadStatus(const QStringList &inputList, const QStringList &expectedList);
+    void loadStatus(const QList<Core::TestData> &inputList, const QList<Core::TestData> &expectedList);
 
-    QStringList inputs() const;
-    QStringList expecteds() const;
+    QList<Core::TestData> inputs() const;
+    QList<Core::TestData> expecteds() const;
 
     void addTestCase(const QString &input = QString(), const QString &expected = QString());
+    void addTestCase(const Core::TestData &input, const Core::TestData &expected);
 
     void clearOutput();
     void clear();
 
-    int id(TestCase *testcase) const;
     int count() const;
 
     void setCheckerIndex(int index);
@@ -75,7 +92,7 @@ class TestCases : public QWidget
     void loadFromSavedFiles(const QString &filePath);
     void saveToFiles(const QString &filePath, bool safe);
 
-    QString loadTestCaseFromFile(const QString &path, const QString &head);
+    Core::TestData loadTestCaseFromFile(const QString &path, const QString &head);
 
     void setTestCaseEditFont(const QFont &font);
 
@@ -84,37 +101,66 @@ class TestCases : public QWidget
     QVariantList splitterStates() const;
     void restoreSplitterStates(const QVariantList &states);
 
+    /**
+     * @brief set the tab in which the updates of the results are shown in the trace, see Core::Tracer
+     */
+    void setTraceTab(quint64 tab);
+
   public slots:
     void setVerdict(int index, TestCase::Verdict verdict);
+    void setMismatch(int index, const Core::Mismatch &mismatch);
+    void setCached(int index, bool cached);
+
+    /**
+     * @brief show the output of a running program, it's replaced by setOutput() when the program finishes
+     */
+    void setOutputTail(int index, const QString &tail);
+
+    /**
+     * @brief show how long the program has been running on a test case
+     * @param timeUsed the time used in milliseconds, or -1 to hide it
+     */
+    void setRunningTime(int index, qint64 timeUsed, int timeLimit);
+
+    /**
+     * @brief hide the running times of all test cases, e.g. when the programs are killed
+     */
+    void clearRunningTimes();
 
   signals:
     void checkerChanged();
     void requestRun(int index);
 
+    /**
+     * @brief the test cases, whether they are checked or the checkers are changed, i.e. the data in the session
+     */
+    void changed();
+
   private slots:
     void on_addButton_clicked();
     void on_addCheckerButton_clicked();
-    void onChildDeleted(TestCase *widget);
+    void onDeleteRequested(int index);
+    void onDiffRequested(int index);
 
   private:
     bool validateIndex(int index, const QString &funcName) const;
+    void removeTestCases(const std::function<bool(int)> &predicate);
+    void importTestCases(const QStringList &paths);
     void updateVerdicts();
-    static QString inputFilePath(const QString &filePath, int index);
-    static QString answerFilePath(const QString &filePath, int index);
-    static QString testCaseFilePath(QString rule, const QString &filePath, int index);
-
-    static const int MAX_NUMBER_OF_TESTCASES = 100;
-    QVBoxLayout *mainLayout = nullptr, *scrollAreaLayout = nullptr;
+    QVBoxLayout *mainLayout = nullptr;
     QHBoxLayout *titleLayout = nullptr, *checkerLayout = nullptr;
     QPushButton *addButton = nullptr, *moreButton = nullptr, *addCheckerButton = nullptr;
     QMenu *moreMenu = nullptr;
     QComboBox *checkerComboBox = nullptr;
-    QScrollArea *scrollArea = nullptr;
-    QWidget *scrollAreaWidget = nullptr;
     QLabel *label = nullptr, *verdicts = nullptr, *checkerLabel = nullptr;
-    QList<TestCase *> testcases;
+    TestCasesModel *model = nullptr;
+    TestCasesView *view = nullptr;
+    Core::TestCaseFiles *files = nullptr;
+    DiffViewer *diffViewer = nullptr; // created when it's opened for the first time
+    int diffViewerIndex = -1;         // the test case shown in the diff viewer
     MessageLogger *log;
     bool choosingChecker = false;
+    quint64 traceTab = 0;
 };
 } // namespace Widgets
 #endif // TESTCASES_HPP
@@ -0,0 +1,271 @@
+/*
+ * Copyright (C) 2019-2021 Ashar Khan <ashar786khan@gmail.com>
+ *
+ * This file is part of CP Editor.
+ *
+ * CP Editor is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * I will not be responsible if CP Editor behaves in unexpected way and
+ * causes your ratings to go down and or lose any important contest.
+ *
+ * Believe Software is "Software" and it isn't immune to bugs.
+ *
+ */
+
+#include "Widgets/TestCasesModel.hpp"
+#include <algorithm>
+
+namespace Widgets
+{
+namespace
+{
+// the heights of the editors are limited, so there's no need to count all lines of a long text
+const int MAX_COUNTED_LINES = 1000;
+} // namespace
+
+TestCasesModel::TestCasesModel(QObject *parent) : QAbstractListModel(parent)
+{
+}
+
+int TestCasesModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : items.size();
+}
+
+QVariant TestCasesModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= items.size())
+        return QVariant();
+
+    auto const &item = items[index.row()];
+
+    switch (role)
+    {
+    case Qt::DisplayRole:
+        return tr("Test Case #%1").arg(index.row() + 1);
+    case Qt::CheckStateRole:
+        return item.checked ? Qt::Checked : Qt::Unchecked;
+    case InputRole:
+        return item.input.toString();
+    case OutputRole:
+        return item.output;
+    case ExpectedRole:
+        return item.expected.toString();
+    case VerdictRole:
+        return item.verdict;
+    default:
+        return QVariant();
+    }
+}
+
+bool TestCasesModel::setData(const QModelIndex &index, const QVariant &value, int role)
+{
+    if (!index.isValid() || index.row() >= items.size())
+        return false;
+
+    switch (role)
+    {
+    case Qt::CheckStateRole:
+        setChecked(index.row(), value.toInt() == Qt::Checked);
+        return true;
+    case InputRole:
+        setInput(index.row(), Core::TestData::fromString(value.toString()));
+        return true;
+    case ExpectedRole:
+        setExpected(index.row(), Core::TestData::fromString(value.toString()));
+        return true;
+    default:
+        return false;
+    }
+}
+
+Qt::ItemFlags TestCasesModel::flags(const QModelIndex &index) const
+{
+    if (!index.isValid())
+        return Qt::NoItemFlags;
+    return Qt::ItemIsEnabled | Qt::ItemIsUserCheckable | Qt::ItemIsEditable;
+}
+
+void TestCasesModel::insertTestCases(int row, const QList<Core::TestData> &inputs,
+                                     const QList<Core::TestData> &expecteds)
+{
+    Q_ASSERT(inputs.size() == expecteds.size());
+
+    if (inputs.isEmpty())
+        return;
+
+    beginInsertRows(QModelIndex(), row, row + inputs.size() - 1);
+    items.insert(row, inputs.size(), Item());
+    for (int i = 0; i < inputs.size(); ++i)
+    {
+        auto &item = items[row + i];
+        item.input = inputs[i];
+        item.expected = expecteds[i];
+        item.inputLines = item.input.lineCount(MAX_COUNTED_LINES);
+        item.expectedLines = item.expected.lineCount(MAX_COUNTED_LINES);
+    }
+    verdictCounts[TestCase::UNKNOWN] += inputs.size();
+    endInsertRows();
+}
+
+void TestCasesModel::removeTestCases(int row, int count)
+{
+    if (count <= 0)
+        return;
+
+    beginRemoveRows(QModelIndex(), row, row + count - 1);
+    for (int i = row; i < row + count; ++i)
+        --verdictCounts[items[i].verdict];
+    items.remove(row, count);
+    endRemoveRows();
+}
+
+Core::TestData TestCasesModel::input(int row) const
+{
+    return items[row].input;
+}
+
+QString TestCasesModel::output(int row) const
+{
+    return items[row].output;
+}
+
+Core::TestData TestCasesModel::expected(int row) const
+{
+    return items[row].expected;
+}
+
+void TestCasesModel::setInput(int row, const Core::TestData &data)
+{
+    items[row].input = data;
+    items[row].inputLines = data.lineCount(MAX_COUNTED_LINES);
+    emitRowChanged(row, {InputRole});
+}
+
+void TestCasesModel::setOutput(int row, const QString &text)
+{
+    items[row].output = text;
+    items[row].outputLines = Core::TestData(text).lineCount(MAX_COUNTED_LINES);
+    emitRowChanged(row, {OutputRole});
+}
+
+void TestCasesModel::setExpected(int row, const Core::TestData &data)
+{
+    items[row].expected = data;
+    items[row].expectedLines = data.lineCount(MAX_COUNTED_LINES);
+    emitRowChanged(row, {ExpectedRole});
+}
+
+TestCase::Verdict TestCasesModel::verdict(int row) const
+{
+    return items[row].verdict;
+}
+
+void TestCasesModel::setVerdict(int row, TestCase::Verdict verdict)
+{
+    auto &item = items[row];
+    --verdictCounts[item.verdict];
+    ++verdictCounts[verdict];
+    item.verdict = verdict;
+    if (verdict != TestCase::WA)
+        item.mismatch = Core::Mismatch();
+    emitRowChanged(row, {VerdictRole});
+}
+
+Core::Mismatch TestCasesModel::mismatch(int row) const
+{
+    return items[row].mismatch;
+}
+
+void TestCasesModel::setMismatch(int row, const Core::Mismatch &mismatch)
+{
+    items[row].mismatch = mismatch;
+}
+
+bool TestCasesModel::isCached(int row) const
+{
+    return items[row].cached;
+}
+
+void TestCasesModel::setCached(int row, bool cached)
+{
+    items[row].cached = cached;
+}
+
+qint64 TestCasesModel::runningTime(int row) const
+{
+    return items[row].runningTime;
+}
+
+int TestCasesModel::runningTimeLimit(int row) const
+{
+    return items[row].runningTimeLimit;
+}
+
+void TestCasesModel::setRunningTime(int row, qint64 timeUsed, int timeLimit)
+{
+    items[row].runningTime = timeUsed;
+    items[row].runningTimeLimit = timeLimit;
+}
+
+void TestCasesModel::clearOutputs()
+{
+    if (items.isEmpty())
+        return;
+
+    for (auto &item : items)
+    {
+        item.output.clear();
+        item.outputLines = 1;
+        item.verdict = TestCase::UNKNOWN;
+        item.mismatch = Core::Mismatch();
+        item.cached = false;
+        item.runningTime = -1;
+    }
+    std::fill(std::begin(verdictCounts), std::end(verdictCounts), 0);
+    verdictCounts[TestCase::UNKNOWN] = items.size();
+    emit dataChanged(index(0), index(items.size() - 1), {OutputRole, VerdictRole});
+}
+
+bool TestCasesModel::isChecked(int row) const
+{
+    return items[row].checked;
+}
+
+void TestCasesModel::setChecked(int row, bool checked)
+{
+    if (items[row].checked == checked)
+        return;
+    items[row].checked = checked;
+    emitRowChanged(row, {Qt::CheckStateRole});
+}
+
+QList<int> TestCasesModel::splitterSizes(int row) const
+{
+    return items[row].splitterSizes;
+}
+
+void TestCasesModel::setSplitterSizes(int row, const QList<int> &sizes)
+{
+    items[row].splitterSizes = sizes;
+}
+
+int TestCasesModel::lineCount(int row) const
+{
+    auto const &item = items[row];
+    return qMax(item.inputLines, qMax(item.outputLines, item.expectedLines));
+}
+
+int TestCasesModel::verdictCount(TestCase::Verdict verdict) const
+{
+    return verdictCounts[verdict];
+}
+
+void TestCasesModel::emitRowChanged(int row, const QVector<int> &roles)
+{
+    emit dataChanged(index(row), index(row), roles);
+}
+} // namespace Widgets
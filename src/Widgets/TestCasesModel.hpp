@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2019-2021 Ashar Khan <ashar786khan@gmail.com>
+ *
+ * This file is part of CP Editor.
+ *
+ * CP Editor is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * I will not be responsible if CP Editor behaves in unexpected way and
+ * causes your ratings to go down and or lose any important contest.
+ *
+ * Believe Software is "Software" and it isn't immune to bugs.
+ *
+ */
+
+/*
+ * The model of the test cases in a tab.
+ * It holds the data of all test cases, while the view only creates TestCase widgets for the visible rows.
+ * When a row has a widget, the widget may hold newer data than the model, the data is written back to the model
+ * when the widget is released. Use Widgets::TestCases to access the up-to-date data.
+ */
+
+#ifndef TESTCASESMODEL_HPP
+#define TESTCASESMODEL_HPP
+
+#include "Widgets/TestCase.hpp"
+#include <QAbstractListModel>
+
+namespace Widgets
+{
+class TestCasesModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+  public:
+    enum Roles
+    {
+        InputRole = Qt::UserRole + 1,
+        OutputRole,
+        ExpectedRole,
+        VerdictRole
+    };
+
+    explicit TestCasesModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    bool setData(const QModelIndex &index, const QVariant &value, int role = Qt::EditRole) override;
+    Qt::ItemFlags flags(const QModelIndex &index) const override;
+
+    /**
+     * @brief insert test cases
+     * @param row the row to insert before, rowCount() to append
+     * @param inputs the inputs of the new test cases
+     * @param expecteds the expected outputs of the new test cases, it should have the same size as inputs
+     */
+    void insertTestCases(int row, const QList<Core::TestData> &inputs, const QList<Core::TestData> &expecteds);
+
+    /**
+     * @brief remove the test cases in [row, row + count)
+     */
+    void removeTestCases(int row, int count);
+
+    Core::TestData input(int row) const;
+    QString output(int row) const;
+    Core::TestData expected(int row) const;
+    void setInput(int row, const Core::TestData &data);
+    void setOutput(int row, const QString &text);
+    void setExpected(int row, const Core::TestData &data);
+
+    TestCase::Verdict verdict(int row) const;
+    void setVerdict(int row, TestCase::Verdict verdict);
+    Core::Mismatch mismatch(int row) const;
+    void setMismatch(int row, const Core::Mismatch &mismatch);
+    bool isCached(int row) const;
+    void setCached(int row, bool cached);
+
+    /**
+     * @returns the time used by the running program in milliseconds, or -1 if it's not running
+     */
+    qint64 runningTime(int row) const;
+    int runningTimeLimit(int row) const;
+    void setRunningTime(int row, qint64 timeUsed, int timeLimit);
+
+    /**
+     * @brief clear the outputs, the verdicts, the mismatches, the cached marks and the running times of all test cases
+     */
+    void clearOutputs();
+
+    bool isChecked(int row) const;
+    void setChecked(int row, bool checked);
+
+    QList<int> splitterSizes(int row) const;
+    void setSplitterSizes(int row, const QList<int> &sizes);
+
+    /**
+     * @returns the max number of lines in the input, the output and the expected output, used to estimate the height
+     * @note Lines are only counted up to a limit, which is more than enough for the height of a row.
+     */
+    int lineCount(int row) const;
+
+    /**
+     * @returns the number of test cases with the given verdict
+     */
+    int verdictCount(TestCase::Verdict verdict) const;
+
+  private:
+    struct Item
+    {
+        Core::TestData input, expected;
+        QString output;
+        TestCase::Verdict verdict = TestCase::UNKNOWN;
+        Core::Mismatch mismatch;
+        bool cached = false; // whether the output and the verdict are reused from a previous run
+        qint64 runningTime = -1;
+        int runningTimeLimit = 0;
+        bool checked = true;
+        QList<int> splitterSizes;
+        int inputLines = 1, outputLines = 1, expectedLines = 1;
+    };
+
+    void emitRowChanged(int row, const QVector<int> &roles);
+
+    QVector<Item> items;
+    int verdictCounts[TestCase::UNKNOWN + 1] = {};
+};
+} // namespace Widgets
+
+#endif // TESTCASESMODEL_HPP
@@ -0,0 +1,343 @@
+/*
+ * Copyright (C) 2019-2021 Ashar Khan <ashar786khan@gmail.com>
+ *
+ * This file is part of CP Editor.
+ *
+ * CP Editor is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * I will not be responsible if CP Editor behaves in unexpected way and
+ * causes your ratings to go down and or lose any important contest.
+ *
+ * Believe Software is "Software" and it isn't immune to bugs.
+ *
+ */
+
+#include "Widgets/TestCasesView.hpp"
+#include "Core/EventLogger.hpp"
+#include "Widgets/TestCase.hpp"
+#include "Widgets/TestCaseEdit.hpp"
+#include "Widgets/TestCasesModel.hpp"
+#include <QApplication>
+#include <QScrollBar>
+#include <generated/SettingsHelper.hpp>
+
+namespace Widgets
+{
+namespace
+{
+// creating a widget may change the heights of the rows, the layout is repeated at most this many times
+const int MAX_LAYOUT_PASSES = 3;
+} // namespace
+
+TestCasesView::TestCasesView(TestCasesModel *model, MessageLogger *logger, QWidget *parent)
+    : QAbstractScrollArea(parent), model(model), log(logger), editFont(SettingsHelper::getTestCasesFont())
+{
+    // an estimation before any widget is created
+    chromeHeight = fontMetrics().height() * 2 + 12;
+    editLineHeight = TestCaseEdit::lineHeight(editFont);
+
+    setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+    setFrameShape(QFrame::NoFrame);
+
+    connect(model, &TestCasesModel::rowsInserted, this, &TestCasesView::onRowsInserted);
+    connect(model, &TestCasesModel::rowsRemoved, this, &TestCasesView::onRowsRemoved);
+    connect(model, &TestCasesModel::dataChanged, this, &TestCasesView::onDataChanged);
+    connect(model, &TestCasesModel::modelReset, this, &TestCasesView::onModelReset);
+
+    rebuildHeights();
+}
+
+TestCase *TestCasesView::widget(int row) const
+{
+    return widgets.value(row, nullptr);
+}
+
+void TestCasesView::setTestCaseEditFont(const QFont &font)
+{
+    editFont = font;
+    editLineHeight = TestCaseEdit::lineHeight(font);
+    for (auto *widget : widgets)
+        widget->setTestCaseEditFont(font);
+    updateHeights();
+}
+
+void TestCasesView::updateHeights()
+{
+    rebuildHeights();
+    layoutWidgets();
+}
+
+void TestCasesView::scrollToRow(int row)
+{
+    verticalScrollBar()->setValue(offsetOf(row));
+}
+
+void TestCasesView::resizeEvent(QResizeEvent *event)
+{
+    QAbstractScrollArea::resizeEvent(event);
+    layoutWidgets();
+}
+
+void TestCasesView::scrollContentsBy(int /*dx*/, int /*dy*/)
+{
+    layoutWidgets();
+}
+
+void TestCasesView::onRowsInserted(const QModelIndex & /*parent*/, int first, int last)
+{
+    shiftWidgets(first, last - first + 1);
+    heights.insert(first, last - first + 1, 0);
+    for (int row = first; row <= last; ++row)
+        heights[row] = rowHeight(row);
+    rebuildTree(first);
+    layoutWidgets();
+}
+
+void TestCasesView::onRowsRemoved(const QModelIndex & /*parent*/, int first, int last)
+{
+    for (int row = first; row <= last; ++row)
+    {
+        if (auto *widget = widgets.take(row))
+        {
+            // the widget may be the sender of the request to remove it
+            widget->hide();
+            widget->deleteLater();
+        }
+    }
+    shiftWidgets(last + 1, first - last - 1);
+    heights.remove(first, last - first + 1);
+    rebuildTree(first);
+    layoutWidgets();
+}
+
+void TestCasesView::onDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight)
+{
+    for (int row = topLeft.row(); row <= bottomRight.row(); ++row)
+        setHeight(row, rowHeight(row));
+    layoutWidgets();
+}
+
+void TestCasesView::onModelReset()
+{
+    for (auto *widget : widgets)
+    {
+        widget->hide();
+        widget->deleteLater();
+    }
+    widgets.clear();
+    rebuildHeights();
+    layoutWidgets();
+}
+
+void TestCasesView::onWidgetHeightChanged(int row)
+{
+    setHeight(row, rowHeight(row));
+    layoutWidgets();
+}
+
+int TestCasesView::rowHeight(int row) const
+{
+    if (auto *widget = widgets.value(row, nullptr))
+        return widget->chromeHeight() + (widget->isChecked() ? widget->editHeight() : 0);
+    if (!model->isChecked(row))
+        return chromeHeight;
+    return chromeHeight + TestCaseEdit::preferredHeight(editLineHeight, model->lineCount(row));
+}
+
+void TestCasesView::rebuildHeights()
+{
+    heights.resize(model->rowCount());
+    for (int row = 0; row < heights.size(); ++row)
+        heights[row] = rowHeight(row);
+    tree.clear();
+    rebuildTree(0);
+}
+
+// rebuild the nodes of the tree covering the given row or the rows after it, from the heights
+void TestCasesView::rebuildTree(int row)
+{
+    // the nodes before the row only cover the rows before it, so they are still valid
+    const int rows = heights.size();
+    tree.resize(rows + 1);
+    QVector<int> offsets(rows - row + 1); // offsets[i - row] is the offset of row i
+    offsets[0] = offsetOf(row);
+    for (int i = row + 1; i <= rows; ++i)
+    {
+        offsets[i - row] = offsets[i - row - 1] + heights[i - 1];
+        // the node i covers the rows in [start, i), only O(log n) of them start before the given row
+        const int start = i - (i & -i);
+        tree[i] = offsets[i - row] - (start >= row ? offsets[start - row] : offsetOf(start));
+    }
+}
+
+void TestCasesView::setHeight(int row, int height)
+{
+    const int delta = height - heights[row];
+    if (delta == 0)
+        return;
+    heights[row] = height;
+    for (int i = row + 1; i < tree.size(); i += i & -i)
+        tree[i] += delta;
+}
+
+int TestCasesView::offsetOf(int row) const
+{
+    int offset = 0;
+    for (int i = row; i > 0; i -= i & -i)
+        offset += tree[i];
+    return offset;
+}
+
+int TestCasesView::rowAt(int y) const
+{
+    // find the number of rows that end before or at y, which is the row containing y
+    const int rows = tree.size() - 1;
+    int step = 1;
+    while (step * 2 <= rows)
+        step *= 2;
+    int row = 0;
+    for (; step > 0; step /= 2)
+    {
+        if (row + step <= rows && tree[row + step] <= y)
+        {
+            row += step;
+            y -= tree[row];
+        }
+    }
+    return row;
+}
+
+void TestCasesView::updateScrollBar()
+{
+    const int total = offsetOf(heights.size());
+    verticalScrollBar()->setRange(0, qMax(0, total - viewport()->height()));
+    verticalScrollBar()->setPageStep(viewport()->height());
+    verticalScrollBar()->setSingleStep(qMax(1, editLineHeight * 3));
+}
+
+void TestCasesView::layoutWidgets()
+{
+    if (layoutInProgress)
+        return;
+    layoutInProgress = true;
+
+    const int rows = model->rowCount();
+    int first = -1, last = -1;
+
+    for (int pass = 0; pass < MAX_LAYOUT_PASSES; ++pass)
+    {
+        updateScrollBar();
+        const int top = verticalScrollBar()->value();
+        first = qMin(rowAt(top), rows - 1);
+        last = qMin(rowAt(top + viewport()->height()), rows - 1);
+
+        bool created = false;
+        for (int row = qMax(first, 0); row <= last; ++row)
+        {
+            if (!widgets.contains(row))
+            {
+                createWidget(row);
+                created = true;
+            }
+        }
+        if (!created)
+            break;
+    }
+
+    // keep one row out of the view at each side, so that scrolling by a small step doesn't recreate widgets
+    QList<int> outdated;
+    for (auto it = widgets.cbegin(); it != widgets.cend(); ++it)
+    {
+        if (it.key() < first - 1 || it.key() > last + 1)
+            outdated.push_back(it.key());
+    }
+    for (int row : outdated)
+        releaseWidget(row);
+
+    updateScrollBar();
+    const int top = verticalScrollBar()->value();
+    for (auto it = widgets.cbegin(); it != widgets.cend(); ++it)
+    {
+        it.value()->setGeometry(0, offsetOf(it.key()) - top, viewport()->width(), heights[it.key()]);
+        it.value()->show();
+    }
+
+    layoutInProgress = false;
+}
+
+void TestCasesView::createWidget(int row)
+{
+    auto *widget = new TestCase(row, log, viewport(), model->input(row), model->output(row), model->expected(row));
+    widget->setTestCaseEditFont(editFont);
+    widget->setVerdict(model->verdict(row));
+    if (model->verdict(row) == TestCase::WA)
+        widget->setMismatch(model->mismatch(row));
+    widget->setCached(model->isCached(row));
+    widget->setRunningTime(model->runningTime(row), model->runningTimeLimit(row));
+    widget->setChecked(model->isChecked(row));
+    const auto sizes = model->splitterSizes(row);
+    if (!sizes.isEmpty())
+        widget->restoreSplitterSizes(sizes);
+
+    connect(widget, &TestCase::requestRun, this, &TestCasesView::requestRun);
+    connect(widget, &TestCase::requestDelete, this, &TestCasesView::requestDelete);
+    connect(widget, &TestCase::requestDiff, this, &TestCasesView::requestDiff);
+    connect(widget, &TestCase::edited, this, &TestCasesView::edited);
+    connect(widget, &TestCase::checkedChanged, model, &TestCasesModel::setChecked);
+    connect(widget, &TestCase::heightChanged, this, &TestCasesView::onWidgetHeightChanged);
+
+    widgets[row] = widget;
+
+    const int widgetChromeHeight = widget->chromeHeight();
+    if (widgetChromeHeight != chromeHeight)
+    {
+        LOG_INFO("Height without editors changed from " << chromeHeight << " to " << widgetChromeHeight);
+        chromeHeight = widgetChromeHeight;
+        rebuildHeights();
+    }
+    else
+    {
+        setHeight(row, rowHeight(row));
+    }
+}
+
+void TestCasesView::releaseWidget(int row)
+{
+    auto *widget = widgets.value(row, nullptr);
+    if (widget == nullptr || widget->isAncestorOf(QApplication::focusWidget()))
+        return; // keep the widget being edited, it's released after it loses the focus and the view is scrolled
+
+    widgets.remove(row);
+
+    const auto input = widget->input();
+    if (input != model->input(row))
+        model->setInput(row, input);
+    const auto expected = widget->expected();
+    if (expected != model->expected(row))
+        model->setExpected(row, expected);
+    model->setSplitterSizes(row, widget->splitterSizes());
+
+    widget->hide();
+    widget->deleteLater();
+    setHeight(row, rowHeight(row));
+}
+
+void TestCasesView::shiftWidgets(int first, int delta)
+{
+    QMap<int, TestCase *> shifted;
+    for (auto it = widgets.cbegin(); it != widgets.cend(); ++it)
+    {
+        int row = it.key();
+        if (row >= first)
+        {
+            row += delta;
+            it.value()->setID(row);
+        }
+        shifted.insert(row, it.value());
+    }
+    widgets = shifted;
+}
+} // namespace Widgets
@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2019-2021 Ashar Khan <ashar786khan@gmail.com>
+ *
+ * This file is part of CP Editor.
+ *
+ * CP Editor is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * I will not be responsible if CP Editor behaves in unexpected way and
+ * causes your ratings to go down and or lose any important contest.
+ *
+ * Believe Software is "Software" and it isn't immune to bugs.
+ *
+ */
+
+/*
+ * A virtualized list of test cases.
+ * TestCase widgets are only created for the rows in the view, and they are released when they are scrolled out of the
+ * view, so the number of widgets doesn't depend on the number of test cases.
+ * The heights of the rows are kept in a Fenwick tree, so scrolling and resizing a row take O(log n) time. Inserting
+ * or removing rows only updates the tree after them, so appending test cases doesn't touch the existing rows.
+ */
+
+#ifndef TESTCASESVIEW_HPP
+#define TESTCASESVIEW_HPP
+
+#include <QAbstractScrollArea>
+#include <QMap>
+
+class MessageLogger;
+
+namespace Widgets
+{
+class TestCase;
+class TestCasesModel;
+
+class TestCasesView : public QAbstractScrollArea
+{
+    Q_OBJECT
+
+  public:
+    explicit TestCasesView(TestCasesModel *model, MessageLogger *logger, QWidget *parent = nullptr);
+
+    /**
+     * @returns the widget of the given row, or nullptr if the row is not in the view
+     * @note The widget holds the latest data of the row, which may not have been written back to the model yet.
+     */
+    TestCase *widget(int row) const;
+
+    void setTestCaseEditFont(const QFont &font);
+
+    /**
+     * @brief recompute the heights of all rows, used when the settings of the heights are changed
+     */
+    void updateHeights();
+
+    /**
+     * @brief scroll so that the given row is at the top of the view
+     */
+    void scrollToRow(int row);
+
+  signals:
+    void requestRun(int row);
+    void requestDelete(int row);
+    void requestDiff(int row);
+    void edited(int row);
+
+  protected:
+    void resizeEvent(QResizeEvent *event) override;
+    void scrollContentsBy(int dx, int dy) override;
+
+  private slots:
+    void onRowsInserted(const QModelIndex &parent, int first, int last);
+    void onRowsRemoved(const QModelIndex &parent, int first, int last);
+    void onDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight);
+    void onModelReset();
+    void onWidgetHeightChanged(int row);
+
+  private:
+    int rowHeight(int row) const;
+    void rebuildHeights();
+    void rebuildTree(int row);
+    void setHeight(int row, int height);
+    int offsetOf(int row) const;
+    int rowAt(int y) const;
+    void updateScrollBar();
+    void layoutWidgets();
+    void createWidget(int row);
+    void releaseWidget(int row);
+    void shiftWidgets(int first, int delta);
+
+    TestCasesModel *model;
+    MessageLogger *log;
+    QMap<int, TestCase *> widgets; // the widgets of the rows in the view, keyed by the row
+    QVector<int> heights;          // the height of each row
+    QVector<int> tree;             // the Fenwick tree of the heights, 1-based
+    QFont editFont;
+    int editLineHeight;            // the line height of editFont
+    int chromeHeight;              // the height of a row without the editors, measured on the created widgets
+    bool layoutInProgress = false; // layoutWidgets() may be re-entered when a new widget changes the heights
+};
+} // namespace Widgets
+
+#endif // TESTCASESVIEW_HPP
@@ -20,8 +20,10 @@
 #include "Core/Compiler.hpp"
 #include "Core/EventLogger.hpp"
 #include "Core/MessageLogger.hpp"
+#include "Core/SearchIndex.hpp"
 #include "Core/SessionManager.hpp"
 #include "Core/StyleManager.hpp"
+#include "Core/Tracer.hpp"
 #include "Core/Translator.hpp"
 #include "Extensions/CFTool.hpp"
 #include "Extensions/CompanionServer.hpp"
@@ -34,6 +36,7 @@
 #include "Telemetry/UpdateChecker.hpp"
 #include "Util/FileUtil.hpp"
 #include "Util/Util.hpp"
+#include "Widgets/SearchPanel.hpp"
 #include "Widgets/SupportUsDialog.hpp"
 #include "application.hpp"
 #include "generated/SettingsHelper.hpp"
@@ -51,6 +54,7 @@
 #include <QShortcut>
 #include <QSplitter>
 #include <QTabBar>
+#include <QTextBlock>
 #include <QTimer>
 #include <QUrl>
 #include <findreplacedialog.h>
@@ -68,6 +72,9 @@ AppWindow::AppWindow(bool noHotExit, QWidget *parent) : QMainWindow(parent), ui(
     ui->actionSwapLineDown->setShortcut({"Ctrl+Meta+Down"});
 #endif
 
+    // the tracing can be enabled by the command line option
+    ui->actionRecordTrace->setChecked(Core::Tracer::isEnabled());
+
     auto *separator = ui->menuFile->insertSeparator(ui->actionSave); // used to insert openRecentFilesMenu
     auto *openRecentFilesMenu = new QMenu(tr("Open Recent Files"), ui->menuFile);
     ui->menuFile->insertMenu(separator, openRecentFilesMenu);
@@ -274,6 +281,8 @@ void AppWindow::setConnections()
     connect(lspTimerCpp, &QTimer::timeout, this, &AppWindow::onLSPTimerElapsedCpp);
     connect(lspTimerJava, &QTimer::timeout, this, &AppWindow::onLSPTimerElapsedJava);
     connect(lspTimerPython, &QTimer::timeout, this, &AppWindow::onLSPTimerElapsedPython);
+    connect(backgroundLoadTimer, &QTimer::timeout, this, &AppWindow::loadNextTabInBackground);
+    connect(searchBufferTimer, &QTimer::timeout, this, &AppWindow::updateSearchBuffers);
 
     connect(preferencesWindow, &PreferencesWindow::settingsApplied, this, &AppWindow::onSettingsApplied);
 
@@ -291,6 +300,12 @@ void AppWindow::allocate()
     lspTimerCpp = new QTimer();
     lspTimerJava = new QTimer();
     lspTimerPython = new QTimer();
+    backgroundLoadTimer = new QTimer(this);
+    backgroundLoadTimer->setSingleShot(true);
+    backgroundLoadTimer->setInterval(1000);
+    searchBufferTimer = new QTimer(this);
+    searchBufferTimer->setSingleShot(true);
+    searchBufferTimer->setInterval(500);
     updateChecker = new Telemetry::UpdateChecker();
     preferencesWindow = new PreferencesWindow(this);
 
@@ -416,7 +431,7 @@ void AppWindow::saveSettings()
     // findReplaceDialog->writeSettings(*SettingsHelper::settings()); FIX IT!!!
 }
 
-void AppWindow::openTab(MainWindow *window, MainWindow *after)
+void AppWindow::openTab(MainWindow *window, MainWindow *after, bool makeCurrent)
 {
     connect(window, &MainWindow::confirmTriggered, this, &AppWindow::onConfirmTriggered);
     connect(window, &MainWindow::editorFileChanged, this, &AppWindow::onEditorFileChanged);
@@ -429,18 +444,29 @@ void AppWindow::openTab(MainWindow *window, MainWindow *after)
     connect(window, &MainWindow::compileOrRunTriggered, this, &AppWindow::onCompileOrRunTriggered);
     connect(window, &MainWindow::fileSaved, this, &AppWindow::onFileSaved);
 
-    ui->tabWidget->setCurrentIndex(
+    int index =
         ui->tabWidget->insertTab(after ? ui->tabWidget->indexOf(after) + 1 : ui->tabWidget->currentIndex() + 1, window,
-                                 window->getTabTitle(false, true)));
+                                 window->getTabTitle(false, true));
+
+    if (makeCurrent)
+    {
+        ui->tabWidget->setCurrentIndex(index);
+        window->getEditor()->setFocus();
+    }
+    else
+    {
+        backgroundLoadTimer->start();
+    }
 
-    window->getEditor()->setFocus();
     onEditorFileChanged();
 }
 
-void AppWindow::openTab(const MainWindow::EditorStatus &status, bool duplicate, MainWindow *after)
+MainWindow *AppWindow::openTab(const MainWindow::EditorStatus &status, bool duplicate, MainWindow *after,
+                               bool makeCurrent)
 {
-    auto *newWindow = new MainWindow(status, duplicate, getNewUntitledIndex(), this);
-    openTab(newWindow, after);
+    auto *newWindow = new MainWindow(status, duplicate, getNewUntitledIndex(), this, !makeCurrent);
+    openTab(newWindow, after, makeCurrent);
+    return newWindow;
 }
 
 void AppWindow::openTabs(const QStringList &paths)
@@ -457,15 +483,20 @@ void AppWindow::openTabs(const QStringList &paths)
     auto oldSize = size();
     setUpdatesEnabled(false);
 
+    // the tabs are opened as placeholders, and only the last one is loaded when it becomes the current tab
+    auto *last = currentWindow();
     for (int i = 0; i < length; ++i)
     {
         if (progress.wasCanceled())
             break;
         progress.setValue(i);
-        openTab(paths[i]);
-        progress.setLabelText(currentWindow()->getTabTitle(true, false));
+        last = openTab(paths[i], last, false);
+        progress.setLabelText(last->getTabTitle(true, false));
     }
 
+    if (last != nullptr)
+        ui->tabWidget->setCurrentWidget(last);
+
     setUpdatesEnabled(true);
     repaint();
     resize(oldSize);
@@ -473,6 +504,24 @@ void AppWindow::openTabs(const QStringList &paths)
     progress.setValue(length);
 }
 
+void AppWindow::loadNextTabInBackground()
+{
+    if (!SettingsHelper::isLoadTabsInBackground())
+        return;
+
+    for (int t = 0; t < ui->tabWidget->count(); ++t)
+    {
+        auto *window = windowAt(t);
+        if (!window->isMaterialized())
+        {
+            LOG_INFO("Loading tab in background " << INFO_OF(t));
+            window->materialize();
+            backgroundLoadTimer->start(); // the remaining tabs are loaded later, so the UI is not blocked for long
+            return;
+        }
+    }
+}
+
 void AppWindow::openPaths(const QStringList &paths, bool cpp, bool java, bool python, int depth)
 {
     LOG_INFO("Open Path with arguments " << BOOL_INFO_OF(cpp) << BOOL_INFO_OF(java) << BOOL_INFO_OF(python)
@@ -861,12 +910,10 @@ void AppWindow::onTabChanged(int index)
         findReplaceDialog->setTextEdit(nullptr);
         setWindowTitle(tr("CP Editor: An editor specially designed for competitive programming"));
 
-        if (cppServer->isDocumentOpen())
-            cppServer->closeDocument();
-        if (pythonServer->isDocumentOpen())
-            pythonServer->closeDocument();
-        if (javaServer->isDocumentOpen())
-            javaServer->closeDocument();
+        // the documents in the language servers are closed when their editors are destroyed
+        lspTimerCpp->stop();
+        lspTimerJava->stop();
+        lspTimerPython->stop();
 
         return;
     }
@@ -876,8 +923,12 @@ void AppWindow::onTabChanged(int index)
 
     auto *tmp = windowAt(index);
 
+    tmp->materialize();
     reAttachLanguageServer(tmp);
 
+    if (searchIndex != nullptr)
+        searchBufferTimer->start();
+
     findReplaceDialog->setTextEdit(tmp->getEditor());
 
     setWindowTitle(tmp->getCompleteTitle() + " - CP Editor");
@@ -942,6 +993,13 @@ void AppWindow::onEditorFileChanged()
 
         setWindowTitle(currentWindow()->getCompleteTitle() + " - CP Editor");
     }
+
+    // the tabs may be opened, closed or saved to other paths
+    if (searchIndex != nullptr)
+    {
+        updateSearchFiles();
+        searchBufferTimer->start();
+    }
 }
 
 void AppWindow::onEditorTextChanged(MainWindow *window)
@@ -957,6 +1015,16 @@ void AppWindow::onEditorTextChanged(MainWindow *window)
             title += " *";
         ui->tabWidget->setTabText(index, title);
 
+        // the placeholder tabs are only loaded in the background while the user is not typing
+        if (backgroundLoadTimer->isActive())
+            backgroundLoadTimer->start();
+
+        if (searchIndex != nullptr)
+        {
+            changedSearchBuffers.insert(window);
+            searchBufferTimer->start();
+        }
+
         if (window == currentWindow())
         {
             if (window->getLanguage() == "C++")
@@ -1001,6 +1069,7 @@ void AppWindow::onLSPTimerElapsedCpp()
         cppServer->requestLinting();
 
     lspTimerCpp->stop();
+    lspTimerCpp->setInterval(cppServer->lintingDelay(SettingsHelper::getLSPDelayCpp()));
 }
 
 void AppWindow::onLSPTimerElapsedJava()
@@ -1013,6 +1082,7 @@ void AppWindow::onLSPTimerElapsedJava()
         javaServer->requestLinting();
 
     lspTimerJava->stop();
+    lspTimerJava->setInterval(javaServer->lintingDelay(SettingsHelper::getLSPDelayJava()));
 }
 
 void AppWindow::onLSPTimerElapsedPython()
@@ -1025,6 +1095,7 @@ void AppWindow::onLSPTimerElapsedPython()
         pythonServer->requestLinting();
 
     lspTimerPython->stop();
+    lspTimerPython->setInterval(pythonServer->lintingDelay(SettingsHelper::getLSPDelayPython()));
 }
 
 void AppWindow::onSettingsApplied(const QString &pagePath)
@@ -1164,9 +1235,9 @@ void AppWindow::onRightSplitterMoved()
     SettingsHelper::setRightSplitterSize(splitter->saveState());
 }
 
-void AppWindow::openTab(const QString &path, MainWindow *after)
+MainWindow *AppWindow::openTab(const QString &path, MainWindow *after, bool makeCurrent)
 {
-    LOG_INFO("OpenTab Path is " << path);
+    LOG_INFO("OpenTab Path is " << path << BOOL_INFO_OF(makeCurrent));
     if (!path.isEmpty())
     {
         auto fileInfo = QFileInfo(path);
@@ -1175,13 +1246,14 @@ void AppWindow::openTab(const QString &path, MainWindow *after)
             auto tPath = qobject_cast<MainWindow *>(ui->tabWidget->widget(t))->getFilePath();
             if (path == tPath || (fileInfo.exists() && fileInfo == QFileInfo(tPath)))
             {
-                ui->tabWidget->setCurrentIndex(t);
-                return;
+                if (makeCurrent)
+                    ui->tabWidget->setCurrentIndex(t);
+                return windowAt(t);
             }
         }
     }
 
-    auto *newWindow = new MainWindow(path, getNewUntitledIndex(), this);
+    auto *newWindow = new MainWindow(path, getNewUntitledIndex(), this, !makeCurrent);
 
     QString lang = SettingsHelper::getDefaultLanguage();
 
@@ -1196,7 +1268,8 @@ void AppWindow::openTab(const QString &path, MainWindow *after)
 
     newWindow->setLanguage(lang);
 
-    openTab(newWindow, after);
+    openTab(newWindow, after, makeCurrent);
+    return newWindow;
 }
 
 /************************* ACTIONS ************************/
@@ -1223,6 +1296,12 @@ void AppWindow::on_actionRun_triggered()
         currentWindow()->runOnly();
 }
 
+void AppWindow::on_actionRunWithoutCache_triggered()
+{
+    if (currentWindow() != nullptr)
+        currentWindow()->runOnly(false);
+}
+
 void AppWindow::on_actionFindReplace_triggered()
 {
     auto *tmp = currentWindow();
@@ -1230,6 +1309,23 @@ void AppWindow::on_actionFindReplace_triggered()
         findReplaceDialog->showDialog(tmp->getEditor()->textCursor().selectedText());
 }
 
+void AppWindow::on_actionSearchInWorkspace_triggered()
+{
+    if (searchIndex == nullptr)
+    {
+        LOG_INFO("Creating the search index");
+        searchIndex = new Core::SearchIndex(this);
+        searchPanel = new Widgets::SearchPanel(searchIndex, this);
+        addDockWidget(Qt::BottomDockWidgetArea, searchPanel);
+        connect(searchPanel, &Widgets::SearchPanel::matchActivated, this, &AppWindow::onSearchMatchActivated);
+        updateSearchFiles();
+        updateSearchBuffers();
+    }
+
+    auto *tmp = currentWindow();
+    searchPanel->showPanel(tmp != nullptr ? tmp->getEditor()->textCursor().selectedText() : QString());
+}
+
 void AppWindow::on_actionFormatCode_triggered()
 {
     if (currentWindow() != nullptr)
@@ -1445,7 +1541,10 @@ void AppWindow::onTabContextMenuRequested(const QPoint &pos)
 
         tabMenu->addSeparator();
 
-        tabMenu->addAction(tr("Duplicate Tab"), [window, this] { openTab(window->toStatus(), true, window); });
+        tabMenu->addAction(tr("Duplicate Tab"), [window, this] {
+            window->materialize();
+            openTab(window->toStatus(), true, window);
+        });
 
         tabMenu->addSeparator();
 
@@ -1527,36 +1626,46 @@ MainWindow *AppWindow::currentWindow()
 
 void AppWindow::reAttachLanguageServer(MainWindow *window)
 {
-    window->getEditor()->clearSquiggle();
     lspTimerCpp->stop();
     lspTimerJava->stop();
     lspTimerPython->stop();
 
-    if (cppServer->isDocumentOpen())
-        cppServer->closeDocument();
-    if (javaServer->isDocumentOpen())
-        javaServer->closeDocument();
-    if (pythonServer->isDocumentOpen())
-        pythonServer->closeDocument();
+    Extensions::LanguageServer *languageServer = nullptr;
+    QTimer *lspTimer = nullptr;
 
-    if (window->getLanguage() == "C++")
+    // sending a large file to the language server is too slow
+    if (!window->isLargeFile())
     {
-        cppServer->openDocument(window->filePathOrTmpPath(), window->getEditor(), window->getLogger());
-        cppServer->requestLinting();
-        lspTimerCpp->start();
-    }
-    else if (window->getLanguage() == "Java")
-    {
-        javaServer->openDocument(window->filePathOrTmpPath(), window->getEditor(), window->getLogger());
-        javaServer->requestLinting();
-        lspTimerJava->start();
+        if (window->getLanguage() == "C++")
+        {
+            languageServer = cppServer;
+            lspTimer = lspTimerCpp;
+        }
+        else if (window->getLanguage() == "Java")
+        {
+            languageServer = javaServer;
+            lspTimer = lspTimerJava;
+        }
+        else if (window->getLanguage() == "Python")
+        {
+            languageServer = pythonServer;
+            lspTimer = lspTimerPython;
+        }
     }
-    else if (window->getLanguage() == "Python")
+
+    // the other documents are kept open, so their diagnostics are shown at once when switching back to them
+    for (auto *otherServer : {cppServer, javaServer, pythonServer})
     {
-        pythonServer->openDocument(window->filePathOrTmpPath(), window->getEditor(), window->getLogger());
-        pythonServer->requestLinting();
-        lspTimerPython->start();
+        if (otherServer != languageServer)
+            otherServer->closeDocument(window->getEditor());
     }
+
+    if (languageServer == nullptr)
+        return;
+
+    languageServer->openDocument(window->filePathOrTmpPath(), window->getEditor(), window->getLogger());
+    languageServer->requestLinting();
+    lspTimer->start();
 }
 
 MainWindow *AppWindow::windowAt(int index)
@@ -1583,6 +1692,19 @@ void AppWindow::on_actionClearLogs_triggered()
     }
 }
 
+void AppWindow::on_actionRecordTrace_toggled(bool checked) // NOLINT: Method can be made static
+{
+    Core::Tracer::setEnabled(checked);
+}
+
+void AppWindow::on_actionExportTrace_triggered()
+{
+    auto path = DefaultPathManager::getSaveFileName("Export Performance Trace", this, tr("Export Performance Trace"),
+                                                    tr("Chrome Trace File") + " (*.json)");
+    if (!path.isEmpty() && !Core::Tracer::exportTo(path))
+        QMessageBox::warning(this, tr("Export Performance Trace"), tr("Failed to export the trace to [%1]").arg(path));
+}
+
 void AppWindow::showOnTop()
 {
     Util::showWidgetOnTop(this);
@@ -1610,6 +1732,94 @@ void AppWindow::onFileSaved(MainWindow *window)
     triggerWakaTime(window, true);
 }
 
+void AppWindow::onSearchMatchActivated(const QString &key, int line, int column, int length)
+{
+    MainWindow *window = nullptr;
+    for (auto it = searchBufferKeys.constBegin(); it != searchBufferKeys.constEnd(); ++it)
+    {
+        if (it.value() == key && ui->tabWidget->indexOf(it.key()) != -1)
+        {
+            window = it.key();
+            ui->tabWidget->setCurrentWidget(window);
+            break;
+        }
+    }
+
+    if (window == nullptr)
+    {
+        if (!QFileInfo(key).isFile())
+        {
+            LOG_WARN("The document of the match is closed or removed " << INFO_OF(key));
+            return;
+        }
+        window = openTab(key);
+    }
+
+    auto *editor = window->getEditor();
+    const auto block = editor->document()->findBlockByNumber(line);
+    if (!block.isValid())
+        return;
+
+    // the document may be changed after the search, so the selection is kept in the line
+    const int lineEnd = block.position() + block.length() - 1;
+    QTextCursor cursor(block);
+    cursor.setPosition(qMin(block.position() + column, lineEnd));
+    cursor.setPosition(qMin(cursor.position() + length, lineEnd), QTextCursor::KeepAnchor);
+    editor->setTextCursor(cursor);
+    editor->setFocus();
+}
+
+void AppWindow::updateSearchFiles()
+{
+    auto files = SettingsHelper::getRecentFiles();
+    for (int i = 0; i < ui->tabWidget->count(); ++i)
+    {
+        if (!windowAt(i)->isUntitled())
+            files.push_back(windowAt(i)->getFilePath());
+    }
+    searchIndex->setFiles({DefaultPathManager::defaultPathForAction("Open Contest")}, files);
+}
+
+void AppWindow::updateSearchBuffers()
+{
+    if (searchIndex == nullptr)
+        return;
+
+    QHash<MainWindow *, QString> keys;
+    for (int i = 0; i < ui->tabWidget->count(); ++i)
+    {
+        auto *window = windowAt(i);
+        // the files of the placeholders are indexed instead, they are not changed until they are loaded
+        if (window->isMaterialized())
+        {
+            keys.insert(window, window->isUntitled() ? QString("untitled:%1").arg(window->getSessionId())
+                                                     : QFileInfo(window->getFilePath()).absoluteFilePath());
+        }
+    }
+
+    // the pointers of the closed tabs are only compared, they are never dereferenced
+    for (auto it = searchBufferKeys.constBegin(); it != searchBufferKeys.constEnd(); ++it)
+    {
+        if (keys.value(it.key()) != it.value())
+        {
+            searchIndex->removeBuffer(it.value());
+            changedSearchBuffers.insert(it.key());
+        }
+    }
+
+    for (auto it = keys.constBegin(); it != keys.constEnd(); ++it)
+    {
+        if (!searchBufferKeys.contains(it.key()) || changedSearchBuffers.contains(it.key()))
+        {
+            auto *window = it.key();
+            searchIndex->setBuffer(it.value(), window->getTabTitle(true, false), window->getEditor()->toPlainText());
+        }
+    }
+
+    searchBufferKeys = keys;
+    changedSearchBuffers.clear();
+}
+
 void AppWindow::triggerWakaTime(MainWindow *window, bool isWrite)
 {
     if (window && wakaTime)
@@ -20,7 +20,9 @@
 
 #include "Widgets/ContestDialog.hpp"
 #include "mainwindow.hpp"
+#include <QHash>
 #include <QMainWindow>
+#include <QSet>
 #include <QSystemTrayIcon>
 
 class FindReplaceDialog;
@@ -51,7 +53,13 @@ class UpdateChecker;
 
 namespace Core
 {
+class SearchIndex;
 class SessionManager;
+} // namespace Core
+
+namespace Widgets
+{
+class SearchPanel;
 }
 
 class AppWindow : public QMainWindow
@@ -134,8 +142,12 @@ class AppWindow : public QMainWindow
 
     void on_actionRun_triggered();
 
+    void on_actionRunWithoutCache_triggered();
+
     void on_actionFindReplace_triggered();
 
+    void on_actionSearchInWorkspace_triggered();
+
     void on_actionFormatCode_triggered();
 
     void on_actionRunDetached_triggered();
@@ -172,6 +184,10 @@ class AppWindow : public QMainWindow
 
     void on_actionClearLogs_triggered();
 
+    void on_actionRecordTrace_toggled(bool checked);
+
+    void on_actionExportTrace_triggered();
+
     // Non-UI Slots
 
     void onTrayIconActivated(QSystemTrayIcon::ActivationReason reason);
@@ -210,10 +226,21 @@ class AppWindow : public QMainWindow
 
     void onViewModeToggle();
 
-    void openTab(const QString &path, MainWindow *after = nullptr);
+    /**
+     * @param makeCurrent whether to switch to the new tab, otherwise it's created as a placeholder
+     * @returns the new tab, or the existing tab of the same file
+     */
+    MainWindow *openTab(const QString &path, MainWindow *after = nullptr, bool makeCurrent = true);
 
     void onFileSaved(MainWindow *window);
 
+    void onSearchMatchActivated(const QString &key, int line, int column, int length);
+
+    /**
+     * @brief send the texts of the changed tabs to the search index, and remove the closed tabs from it
+     */
+    void updateSearchBuffers();
+
   private:
     Ui::AppWindow *ui;
     MessageLogger *activeLogger = nullptr;
@@ -223,6 +250,7 @@ class AppWindow : public QMainWindow
     QTimer *lspTimerCpp = nullptr;
     QTimer *lspTimerPython = nullptr;
     QTimer *lspTimerJava = nullptr;
+    QTimer *backgroundLoadTimer = nullptr; // materializes the placeholder tabs one by one while idle
 
     QMetaObject::Connection activeSplitterMoveConnection;
     QMetaObject::Connection activeRightSplitterMoveConnection;
@@ -230,6 +258,13 @@ class AppWindow : public QMainWindow
     PreferencesWindow *preferencesWindow = nullptr;
     Extensions::CompanionServer *server = nullptr;
     FindReplaceDialog *findReplaceDialog = nullptr;
+
+    Core::SearchIndex *searchIndex = nullptr;      // created when the search panel is shown for the first time
+    Widgets::SearchPanel *searchPanel = nullptr;
+    QTimer *searchBufferTimer = nullptr;           // coalesces the changes of the tabs sent to the search index
+    QHash<MainWindow *, QString> searchBufferKeys; // the keys of the tabs in the search index
+    QSet<MainWindow *> changedSearchBuffers;       // the tabs changed since they are sent to the search index
+
     QSystemTrayIcon *trayIcon = nullptr;
     QMenu *trayIconMenu = nullptr;
     QMenu *tabMenu = nullptr;
@@ -250,9 +285,11 @@ class AppWindow : public QMainWindow
     QVector<QShortcut *> hotkeyObjects;
     void maybeSetHotkeys();
     bool closeTab(int index);
-    void openTab(MainWindow *window, MainWindow *after = nullptr);
-    void openTab(const MainWindow::EditorStatus &status, bool duplicate = false, MainWindow *after = nullptr);
+    void openTab(MainWindow *window, MainWindow *after = nullptr, bool makeCurrent = true);
+    MainWindow *openTab(const MainWindow::EditorStatus &status, bool duplicate = false, MainWindow *after = nullptr,
+                        bool makeCurrent = true);
     void openTabs(const QStringList &paths);
+    void loadNextTabInBackground();
     void openPaths(const QStringList &paths, bool cpp = true, bool java = true, bool python = true, int depth = -1);
     QStringList openFolder(const QString &path, bool cpp, bool java, bool python, int depth);
     void openContest(Widgets::ContestDialog::ContestData const &data);
@@ -260,6 +297,7 @@ class AppWindow : public QMainWindow
     int getNewUntitledIndex();
     void reAttachLanguageServer(MainWindow *window);
     void triggerWakaTime(MainWindow *window, bool isWrite = false);
+    void updateSearchFiles();
 
     MainWindow *currentWindow();
     MainWindow *windowAt(int index);
@@ -16,6 +16,7 @@
  */
 
 #include "Core/EventLogger.hpp"
+#include "Core/Tracer.hpp"
 #include "Core/Translator.hpp"
 #include "Settings/SettingsInfo.hpp"
 #include "SignalHandler.hpp"
@@ -132,6 +133,9 @@ int main(int argc, char *argv[])
          {"java", "Open Java files in given directories. / Use Java for open contests."},
          {"python", "Open Python files in given directories. / Use Python for open contests."},
          {"verbose", "Dump all logs to stderr of the application. (use only for debug purpose)"},
+         {"log-level", "The minimum level of the logs, one of info, warn, error and wtf. (info by default)", "level",
+          "info"},
+         {"trace", "Record the compile/run/check pipelines and write them to a Chrome trace file on exit.", "path"},
          {"no-hot-exit", "Do not load hot exit in this session. You won't be able to load the last session again."}});
     parser.setOptionsAfterPositionalArgumentsMode(QCommandLineParser::ParseAsOptions);
     parser.setSingleDashWordOptionMode(QCommandLineParser::ParseAsLongOptions);
@@ -146,9 +150,32 @@ int main(int argc, char *argv[])
     bool noHotExit = parser.isSet("no-hot-exit");
     bool shouldDumpTostderr = parser.isSet("verbose");
 
+    const QStringList logLevels = {"info", "warn", "error", "wtf"};
+    const int logLevel = logLevels.indexOf(parser.value("log-level").toLower());
+    if (logLevel != -1)
+        Core::Log::setMinimumLevel(Core::Log::Level(logLevel));
+
     auto instance = app.instanceId();
     Core::Log::init(instance, shouldDumpTostderr);
+
+    // it's destroyed after the windows on every return from main()
+    struct LogShutdown
+    {
+        ~LogShutdown()
+        {
+            Core::Log::shutdown();
+        }
+    } logShutdown;
     LOG_INFO(INFO_OF(instance));
+    LOG_WARN_IF(logLevel == -1, "Unknown log level " << parser.value("log-level"));
+
+    if (parser.isSet("trace"))
+    {
+        const auto tracePath = QDir::current().filePath(parser.value("trace"));
+        LOG_INFO(INFO_OF(tracePath));
+        Core::Tracer::setEnabled(true);
+        QObject::connect(&app, &QCoreApplication::aboutToQuit, [tracePath] { Core::Tracer::exportTo(tracePath); });
+    }
 
     SettingsInfo::updateSettingInfo(); // generate an English version, so that we can use SettingsHelper
     SettingsManager::init();
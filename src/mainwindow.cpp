@@ -20,8 +20,12 @@
 #include "Core/Checker.hpp"
 #include "Core/Compiler.hpp"
 #include "Core/EventLogger.hpp"
+#include "Core/FileWriter.hpp"
 #include "Core/MessageLogger.hpp"
+#include "Core/RunResultCache.hpp"
+#include "Core/RunScheduler.hpp"
 #include "Core/Runner.hpp"
+#include "Core/Tracer.hpp"
 #include "Extensions/CFTool.hpp"
 #include "Extensions/ClangFormatter.hpp"
 #include "Extensions/CompanionServer.hpp"
@@ -45,53 +49,74 @@
 #include <QScrollBar>
 #include <QTemporaryDir>
 #include <QTextBlock>
+#include <QTextCodec>
+#include <QThread>
 #include <QTimer>
+#include <memory>
 
 #include "../ui/ui_mainwindow.h"
 
 static const int MAX_NUMBER_OF_RECENT_FILES = 20;
 
+// the size of each chunk appended to the editor when loading a large file
+static const qint64 LARGE_FILE_CHUNK_SIZE = 256 * 1024;
+
+// the undo history of a large file is cleared when more than this number of characters are changed in it
+static const qint64 LARGE_FILE_UNDO_CHARACTERS = 16 * 1024 * 1024;
+
 // ***************************** RAII  ****************************
 
-MainWindow::MainWindow(int index, AppWindow *parent)
+MainWindow::MainWindow(int index, AppWindow *parent, bool lazy)
     : QMainWindow(parent), ui(new Ui::MainWindow), editor(nullptr), appWindow(parent), untitledIndex(index),
-      fileWatcher(new QFileSystemWatcher(this)), reloading(false), killingProcesses(false),
+      materialized(!lazy), fileWatcher(new QFileSystemWatcher(this)), reloading(false), killingProcesses(false),
       autoSaveTimer(new QTimer(this))
 {
-    LOG_INFO(INFO_OF(index));
-
-    ui->setupUi(this);
+    LOG_INFO(INFO_OF(index) << BOOL_INFO_OF(lazy));
 
-    log = new MessageLogger(appWindow->getPreferencesWindow(), this);
-    ui->messageLoggerLayout->addWidget(log);
+    static quint64 lastSessionId = 0;
+    sessionId = ++lastSessionId;
 
-    testcases = new Widgets::TestCases(log, this);
-    ui->testCasesLayout->addWidget(testcases);
-    connect(testcases, &Widgets::TestCases::checkerChanged, this, &MainWindow::updateChecker);
-    connect(testcases, &Widgets::TestCases::requestRun, this, &MainWindow::runTestCase);
-
-    setEditor();
-    setStopwatch();
-    connect(fileWatcher, &QFileSystemWatcher::fileChanged, this, &MainWindow::onFileWatcherChanged);
-    connect(
-        autoSaveTimer, &QTimer::timeout, autoSaveTimer, [this] { saveFile(AutoSave, tr("Auto Save"), false); },
-        Qt::DirectConnection);
-    applySettings("");
-    QTimer::singleShot(0, [this] { setLanguage(language); }); // See issue #187 for more information
+    if (!lazy)
+        setupWidgets();
 }
 
-MainWindow::MainWindow(const QString &fileOpen, int index, AppWindow *parent) : MainWindow(index, parent)
+MainWindow::MainWindow(const QString &fileOpen, int index, AppWindow *parent, bool lazy)
+    : MainWindow(index, parent, lazy)
 {
     LOG_INFO(INFO_OF(fileOpen));
+    if (lazy)
+    {
+        // only the path is kept, the file is read in materialize()
+        setFilePath(fileOpen, false);
+        return;
+    }
     loadFile(fileOpen);
     if (testcases->count() == 0)
         testcases->addTestCase();
 }
 
-MainWindow::MainWindow(const EditorStatus &status, bool duplicate, int index, AppWindow *parent)
-    : MainWindow(index, parent)
+MainWindow::MainWindow(const EditorStatus &status, bool duplicate, int index, AppWindow *parent, bool lazy)
+    : MainWindow(index, parent, lazy)
 {
     LOG_INFO(INFO_OF(duplicate));
+    if (lazy)
+    {
+        // a placeholder of a file is still a placeholder of the file, which is read in materialize()
+        if (!status.loadFromFile)
+            pendingStatus = new EditorStatus(status);
+        if (!duplicate)
+        {
+            untitledIndex = status.untitledIndex;
+            filePath = status.filePath;
+        }
+        problemURL = status.problemURL;
+        if (status.isLanguageSet)
+            setLanguage(status.language);
+        customCompileCommand = status.customCompileCommand;
+        customTimeLimit = status.customTimeLimit;
+        pendingTextChanged = !status.loadFromFile && isStatusTextChanged(status, isUntitled(), language);
+        return;
+    }
     loadStatus(status, duplicate);
 }
 
@@ -99,8 +124,11 @@ MainWindow::~MainWindow()
 {
     killProcesses();
 
+    delete pendingStatus;
     delete cftool;
     delete tmpDir;
+    delete runResults;
+    delete runScheduler;
 
     delete ui;
     delete autoSaveTimer;
@@ -111,6 +139,93 @@ MainWindow::~MainWindow()
     delete stopwatch;
 }
 
+void MainWindow::materialize()
+{
+    if (materialized)
+        return;
+
+    LOG_INFO("Materializing " << INFO_OF(filePath));
+    materialized = true;
+    ++statusRevision; // the status of a placeholder of a file doesn't have the content
+
+    // these are cleared so that they are applied to the widgets when they are set again
+    const auto lang = language;
+    const auto url = problemURL;
+    language.clear();
+    isLanguageSet = false;
+    problemURL.clear();
+
+    setupWidgets();
+
+    if (pendingStatus != nullptr)
+    {
+        auto status = *pendingStatus;
+        delete pendingStatus;
+        pendingStatus = nullptr;
+        // these might be changed since the placeholder is created
+        status.untitledIndex = untitledIndex;
+        status.filePath = filePath;
+        status.problemURL = url;
+        status.customCompileCommand = customCompileCommand;
+        status.customTimeLimit = customTimeLimit;
+        loadStatus(status);
+    }
+    else
+    {
+        const auto path = filePath;
+        filePath.clear();
+        loadFile(path);
+        if (testcases->count() == 0)
+            testcases->addTestCase();
+        if (!lang.isEmpty())
+            setLanguage(lang);
+        if (!url.isEmpty())
+            setProblemURL(url);
+    }
+}
+
+bool MainWindow::isMaterialized() const
+{
+    return materialized;
+}
+
+quint64 MainWindow::getSessionId() const
+{
+    return sessionId;
+}
+
+quint64 MainWindow::getStatusRevision() const
+{
+    return statusRevision;
+}
+
+void MainWindow::setupWidgets()
+{
+    ui->setupUi(this);
+
+    log = new MessageLogger(appWindow->getPreferencesWindow(), this);
+    ui->messageLoggerLayout->addWidget(log);
+
+    testcases = new Widgets::TestCases(log, this);
+    testcases->setTraceTab(sessionId);
+    ui->testCasesLayout->addWidget(testcases);
+    runResults = new Core::RunResultCache();
+    runScheduler = new Core::RunScheduler();
+    connect(testcases, &Widgets::TestCases::checkerChanged, this, &MainWindow::updateChecker);
+    connect(testcases, &Widgets::TestCases::requestRun, this, &MainWindow::runTestCase);
+    connect(testcases, &Widgets::TestCases::changed, this, [this] { ++statusRevision; });
+
+    setEditor();
+    setStopwatch();
+    connect(fileWatcher, &QFileSystemWatcher::fileChanged, this, &MainWindow::onFileWatcherChanged);
+    connect(&Core::FileWriter::instance(), &Core::FileWriter::fileWritten, this, &MainWindow::onFileWritten);
+    connect(
+        autoSaveTimer, &QTimer::timeout, autoSaveTimer, [this] { saveFile(AutoSave, tr("Auto Save"), false); },
+        Qt::DirectConnection);
+    applySettings("");
+    QTimer::singleShot(0, this, [this] { setLanguage(language); }); // See issue #187 for more information
+}
+
 void MainWindow::setEditor()
 {
     editor = new QCodeEditor();
@@ -121,10 +236,20 @@ void MainWindow::setEditor()
 
     connect(editor, &QCodeEditor::textChanged, this, &MainWindow::onTextChanged);
     connect(editor, &QCodeEditor::fontChanged, this, &MainWindow::onEditorFontChanged);
+    connect(editor->document(), &QTextDocument::contentsChange, this, [this](int /*unused*/, int removed, int added) {
+        // setPlainText() disables the undo history while replacing the text, so it's not counted
+        if (largeFile && editor->document()->isUndoRedoEnabled())
+            largeFileUndoCharacters += removed + added;
+    });
+    // queued, so that the undo history is not cleared while the document is adding the command
+    connect(editor->document(), &QTextDocument::undoCommandAdded, this, &MainWindow::trimLargeFileUndoHistory,
+            Qt::QueuedConnection);
     // cursorPositionChanged() does not imply selectionChanged() if you press Left with
     // a selection (and the cursor is at the begin of the selection)
     connect(editor, &QCodeEditor::cursorPositionChanged, this, &MainWindow::updateCursorInfo);
     connect(editor, &QCodeEditor::selectionChanged, this, &MainWindow::updateCursorInfo);
+    for (auto *scrollBar : {editor->horizontalScrollBar(), editor->verticalScrollBar()})
+        connect(scrollBar, &QScrollBar::valueChanged, this, [this] { ++statusRevision; });
 }
 
 void MainWindow::setStopwatch()
@@ -136,12 +261,16 @@ void MainWindow::setStopwatch()
 
 void MainWindow::compile()
 {
+    if (warnIfLoading(tr("Compiler")))
+        return;
+
     if (SettingsHelper::isSaveFileOnCompilation())
         saveFile(IgnoreUntitled, tr("Compiler"), true);
 
     killProcesses();
 
     compiler = new Core::Compiler();
+    compiler->setTraceContext(sessionId, "compile");
 
     auto path = tmpPath();
     if (path.isEmpty())
@@ -167,12 +296,16 @@ void MainWindow::compile()
     compiler->start(path, filePath, compileCommand(), language);
 }
 
-void MainWindow::run()
+void MainWindow::run(bool useCache)
 {
+    if (warnIfLoading(tr("Runner")))
+        return;
+
     if (SettingsHelper::isSaveFileOnExecution())
         saveFile(IgnoreUntitled, tr("Runner"), true);
 
-    LOG_INFO("Requesting run of testcases");
+    Core::Tracer::Span span("ui", "Schedule Runs", sessionId);
+    LOG_INFO("Requesting run of testcases, " << BOOL_INFO_OF(useCache));
     killProcesses();
     testcases->clearOutput();
 
@@ -184,20 +317,107 @@ void MainWindow::run()
 
     checker->clearTasks();
 
+    const auto programKey = runProgramKey();
+    useCache = useCache && SettingsHelper::isReuseUnchangedRunResults();
+    int cachedCount = 0;
+    bool cachedFailure = false;
+    QList<Core::RunScheduler::Run> runs;
+
     for (int i = 0; i < testcases->count(); ++i)
     {
-        if ((!testcases->input(i).trimmed().isEmpty() || SettingsHelper::isRunOnEmptyTestcase()) &&
-            testcases->isChecked(i))
+        const auto input = testcases->inputData(i);
+        if ((!input.isBlank() || SettingsHelper::isRunOnEmptyTestcase()) && testcases->isChecked(i))
         {
-            run(i);
+            const auto testKey = Core::RunScheduler::testKey(input, testcases->expectedData(i));
+            const auto key = programKey.isEmpty() ? QString() : Core::RunResultCache::key(programKey, testKey);
+            Core::RunResultCache::Result result;
+            if (useCache && !key.isEmpty() && runResults->find(key, result))
+            {
+                testcases->setOutput(i, result.output);
+                testcases->setVerdict(i, result.verdict);
+                if (result.verdict == Widgets::TestCase::WA && result.mismatch.found)
+                    testcases->setMismatch(i, result.mismatch);
+                testcases->setCached(i, true);
+                if (!result.error.trimmed().isEmpty())
+                    log->error(getRunnerHead(i) + tr("/stderr"), result.error);
+                ++cachedCount;
+                cachedFailure = cachedFailure || Core::RunScheduler::isFailure(result.verdict);
+            }
+            else
+            {
+                runs.push_back({i, testKey, key});
+            }
         }
     }
 
-    if (runner.empty())
+    LOG_INFO(INFO_OF(programKey) << INFO_OF(cachedCount) << INFO_OF(runs.size()));
+
+    if (cachedCount > 0)
+    {
+        log->info(tr("Runner"),
+                  tr("The results of %n unchanged test case(s) are reused. Use \"Run Without Cache\" to run them "
+                     "again.",
+                     "", cachedCount));
+    }
+    else if (runs.isEmpty())
+    {
         log->warn(tr("Runner"), tr("All inputs are empty, nothing to run"));
+    }
+
+    if (cachedFailure && SettingsHelper::isFailFast() && !runs.isEmpty())
+    {
+        log->info(tr("Runner"),
+                  tr("A test case has failed, the other %n test case(s) are not run because of Fail Fast.", "",
+                     runs.size()));
+        return;
+    }
+
+    runScheduler->schedule(runs);
+    startQueuedRuns();
 }
 
-void MainWindow::run(int index)
+void MainWindow::startQueuedRuns()
+{
+    // more processes than the cores only make each of them slower, and the time limits are less accurate
+    const int maxRunning = qMax(1, QThread::idealThreadCount());
+    while (runningCount < maxRunning && runScheduler->hasPending())
+    {
+        const auto next = runScheduler->takeNext();
+        run(next.index, next.cacheKey);
+    }
+}
+
+void MainWindow::onRunFailed(int index)
+{
+    if (!SettingsHelper::isFailFast())
+        return;
+
+    const int canceledCount = runScheduler->pendingCount() + runningCount;
+    if (canceledCount == 0)
+        return;
+
+    LOG_INFO(INFO_OF(index) << INFO_OF(canceledCount));
+
+    runScheduler->clearPending();
+    for (auto *t : runner)
+    {
+        // the runners are disconnected, so they are killed silently, and their results are not cached
+        if (t->isRunning())
+            runResults->discardRun(t->index());
+        t->disconnect();
+        t->deleteLater();
+    }
+    runner.clear();
+    runningCount = 0;
+    testcases->clearRunningTimes();
+
+    log->info(tr("Runner"),
+              tr("Test case #%1 has failed, the other %n test case(s) are canceled because of Fail Fast.", "",
+                 canceledCount)
+                  .arg(index + 1));
+}
+
+void MainWindow::run(int index, const QString &cacheKey)
 {
     if (index < 0 || index >= testcases->count())
     {
@@ -206,20 +426,39 @@ void MainWindow::run(int index)
     }
 
     auto *tmp = new Core::Runner(index);
+    tmp->setTraceContext(sessionId, "run");
     connect(tmp, &Core::Runner::runStarted, this, &MainWindow::onRunStarted);
     connect(tmp, &Core::Runner::runFinished, this, &MainWindow::onRunFinished);
     connect(tmp, &Core::Runner::failedToStartRun, this, &MainWindow::onFailedToStartRun);
     connect(tmp, &Core::Runner::runOutputLimitExceeded, this, &MainWindow::onRunOutputLimitExceeded);
     connect(tmp, &Core::Runner::runKilled, this, &MainWindow::onRunKilled);
+    connect(tmp, &Core::Runner::runOutputUpdated, testcases, &Widgets::TestCases::setOutputTail);
+    connect(tmp, &Core::Runner::runTimeUpdated, testcases, &Widgets::TestCases::setRunningTime);
+    runResults->startRun(index, cacheKey);
+    ++runningCount;
     tmp->run(tmpPath(), filePath, language, SettingsManager::get(QString("%1/Run Command").arg(language)).toString(),
-             SettingsManager::get(QString("%1/Run Arguments").arg(language)).toString(), testcases->input(index),
+             SettingsManager::get(QString("%1/Run Arguments").arg(language)).toString(), testcases->inputData(index),
              timeLimit());
     runner.push_back(tmp);
 }
 
+QString MainWindow::runProgramKey()
+{
+    const auto path = tmpPath();
+    if (path.isEmpty())
+        return QString();
+    return Core::RunResultCache::programKey(
+        path, filePath, language,
+        SettingsManager::get(QString("%1/Run Command").arg(language)).toString() + ' ' +
+            SettingsManager::get(QString("%1/Run Arguments").arg(language)).toString(),
+        checker->identity(), timeLimit());
+}
+
 void MainWindow::runTestCase(int index)
 {
     LOG_INFO(INFO_OF(index));
+    if (warnIfLoading(tr("Runner")))
+        return;
     killProcesses();
     testcases->clearOutput();
     log->clear();
@@ -230,7 +469,12 @@ void MainWindow::runTestCase(int index)
         return;
     }
 
-    run(index);
+    // a single test case is always run, but its result can be reused later
+    const auto programKey = runProgramKey();
+    const auto testKey = Core::RunScheduler::testKey(testcases->inputData(index), testcases->expectedData(index));
+    const auto cacheKey = programKey.isEmpty() ? QString() : Core::RunResultCache::key(programKey, testKey);
+    runScheduler->schedule({{index, testKey, cacheKey}});
+    startQueuedRuns();
 }
 
 void MainWindow::loadTests()
@@ -336,8 +580,9 @@ QString MainWindow::getTabTitle(bool complete, bool star, int removeLength)
     return tabTitle;
 }
 
-QCodeEditor *MainWindow::getEditor() const
+QCodeEditor *MainWindow::getEditor()
 {
+    materialize();
     return editor;
 }
 
@@ -357,6 +602,7 @@ void MainWindow::setFilePath(QString path, bool updateBinder)
         return;
     }
     filePath = path;
+    ++statusRevision;
     if (updateBinder)
         FileProblemBinder::set(path, problemURL);
     if (!isUntitled())
@@ -380,8 +626,9 @@ void MainWindow::setProblemURL(const QString &url)
     if (problemURL == url)
         return;
     problemURL = url;
+    ++statusRevision;
     FileProblemBinder::set(filePath, url);
-    if (problemURL.contains("codeforces.com"))
+    if (materialized && problemURL.contains("codeforces.com"))
         setCFToolUI();
     emit editorFileChanged();
 }
@@ -389,6 +636,7 @@ void MainWindow::setProblemURL(const QString &url)
 void MainWindow::setUntitledIndex(int index)
 {
     untitledIndex = index;
+    ++statusRevision;
 }
 
 #define FROMSTATUS(x) x = status.value(#x)
@@ -412,9 +660,12 @@ MainWindow::EditorStatus::EditorStatus(const QMap<QString, QVariant> &status)
     FROMSTATUS_DEFAULT(customTimeLimit, -1).toInt();
     FROMSTATUS(input).toStringList();
     FROMSTATUS(expected).toStringList();
+    FROMSTATUS(inputFiles).toStringList();
+    FROMSTATUS(expectedFiles).toStringList();
     FROMSTATUS(customCheckers).toStringList();
     FROMSTATUS(testcasesIsShow).toList();
     FROMSTATUS(testCaseSplitterStates).toList();
+    FROMSTATUS(loadFromFile).toBool();
 }
 #undef FROMSTATUS
 
@@ -439,17 +690,64 @@ QMap<QString, QVariant> MainWindow::EditorStatus::toMap() const
     TOSTATUS(customTimeLimit);
     TOSTATUS(input);
     TOSTATUS(expected);
+    TOSTATUS(inputFiles);
+    TOSTATUS(expectedFiles);
     TOSTATUS(customCheckers);
     TOSTATUS(testcasesIsShow);
     TOSTATUS(testCaseSplitterStates);
+    TOSTATUS(loadFromFile);
     return status;
 }
 #undef TOSTATUS
 
-MainWindow::EditorStatus MainWindow::toStatus() const
+void MainWindow::EditorStatus::embedTestData()
+{
+    auto embed = [](QStringList &texts, QStringList &files) {
+        for (int i = 0; i < texts.size() && i < files.size(); ++i)
+        {
+            // a missing file is kept, so it's reported when the session is loaded
+            if (!files[i].isEmpty() && QFile::exists(files[i]))
+            {
+                texts[i] = Core::TestData::fromFile(files[i]).toString();
+                files[i].clear();
+            }
+        }
+    };
+    embed(input, inputFiles);
+    embed(expected, expectedFiles);
+}
+
+MainWindow::EditorStatus MainWindow::toStatus()
 {
+    if (pendingStatus != nullptr)
+    {
+        auto status = *pendingStatus;
+        status.isLanguageSet = isLanguageSet;
+        status.filePath = filePath;
+        status.problemURL = problemURL;
+        status.language = language;
+        status.untitledIndex = untitledIndex;
+        status.customCompileCommand = customCompileCommand;
+        status.customTimeLimit = customTimeLimit;
+        return status;
+    }
+
     EditorStatus status;
 
+    // the text and the test cases of a placeholder of a file are not loaded yet, they are loaded when it's restored
+    if (!materialized)
+    {
+        status.loadFromFile = true;
+        status.isLanguageSet = isLanguageSet;
+        status.filePath = filePath;
+        status.problemURL = problemURL;
+        status.language = language;
+        status.untitledIndex = untitledIndex;
+        status.customCompileCommand = customCompileCommand;
+        status.customTimeLimit = customTimeLimit;
+        return status;
+    }
+
     status.isLanguageSet = isLanguageSet;
     status.filePath = filePath;
     status.problemURL = problemURL;
@@ -464,8 +762,16 @@ MainWindow::EditorStatus MainWindow::toStatus() const
     status.horizontalScrollBarValue = editor->horizontalScrollBar()->value();
     status.verticalScrollbarValue = editor->verticalScrollBar()->value();
     status.customTimeLimit = customTimeLimit;
-    status.input = testcases->inputs();
-    status.expected = testcases->expecteds();
+    // large test cases are stored by the paths to their files, so that they are not copied into the status
+    auto storeTestData = [](const QList<Core::TestData> &list, QStringList &texts, QStringList &files) {
+        for (auto const &data : list)
+        {
+            texts.push_back(data.isMapped() ? QString() : data.toString());
+            files.push_back(data.filePath());
+        }
+    };
+    storeTestData(testcases->inputs(), status.input, status.inputFiles);
+    storeTestData(testcases->expecteds(), status.expected, status.expectedFiles);
     for (int i = 0; i < testcases->count(); ++i)
         status.testcasesIsShow.push_back(testcases->isChecked(i));
     status.testCaseSplitterStates = testcases->splitterStates();
@@ -476,6 +782,23 @@ MainWindow::EditorStatus MainWindow::toStatus() const
 void MainWindow::loadStatus(const EditorStatus &status, bool duplicate)
 {
     LOG_INFO("Requesting loadStatus");
+    materialize();
+    if (status.loadFromFile)
+    {
+        // the tab was a placeholder of a file when the status was saved
+        if (!duplicate)
+            untitledIndex = status.untitledIndex;
+        loadFile(status.filePath);
+        if (testcases->count() == 0)
+            testcases->addTestCase();
+        if (status.isLanguageSet)
+            setLanguage(status.language);
+        customCompileCommand = status.customCompileCommand; // this must be after setLanguage
+        customTimeLimit = status.customTimeLimit;
+        if (!status.problemURL.isEmpty())
+            setProblemURL(status.problemURL);
+        return;
+    }
     setProblemURL(status.problemURL);
     if (status.isLanguageSet)
         setLanguage(status.language);
@@ -488,7 +811,9 @@ void MainWindow::loadStatus(const EditorStatus &status, bool duplicate)
     testcases->addCustomCheckers(status.customCheckers);
     testcases->setCheckerIndex(status.checkerIndex);
     savedText = status.savedText;
+    setLargeFileMode(status.editorText.size() > SettingsHelper::getLargeFileSize());
     editor->setPlainText(status.editorText);
+    editor->document()->setModified(isStatusTextChanged(status, isUntitled(), language));
     auto cursor = editor->textCursor();
     cursor.setPosition(status.editorAnchor);
     cursor.setPosition(status.editorCursor, QTextCursor::KeepAnchor);
@@ -496,7 +821,30 @@ void MainWindow::loadStatus(const EditorStatus &status, bool duplicate)
     editor->horizontalScrollBar()->setValue(status.horizontalScrollBarValue);
     editor->verticalScrollBar()->setValue(status.verticalScrollbarValue);
     customTimeLimit = status.customTimeLimit;
-    testcases->loadStatus(status.input, status.expected);
+    auto loadTestData = [this](const QStringList &texts, const QStringList &files, const QString &kind) {
+        QList<Core::TestData> list;
+        for (int i = 0; i < texts.size(); ++i)
+        {
+            if (i < files.size() && !files[i].isEmpty())
+            {
+                if (QFile::exists(files[i]))
+                {
+                    list.push_back(Core::TestData::fromFile(files[i], tr("Load Test Case"), log));
+                    continue;
+                }
+                LOG_ERR("The stored test data is missing " << INFO_OF(i) << INFO_OF(files[i]));
+                log->error(tr("Load Test Case"),
+                           tr("The stored %1 of test case #%2 is missing [%3], it's restored as an empty one.")
+                               .arg(kind)
+                               .arg(i + 1)
+                               .arg(files[i]));
+            }
+            list.push_back(Core::TestData(texts[i]));
+        }
+        return list;
+    };
+    testcases->loadStatus(loadTestData(status.input, status.inputFiles, tr("input")),
+                          loadTestData(status.expected, status.expectedFiles, tr("expected output")));
     for (int i = 0; i < status.testcasesIsShow.count() && i < testcases->count(); ++i)
         testcases->setChecked(i, status.testcasesIsShow[i].toBool());
     testcases->restoreSplitterStates(status.testCaseSplitterStates);
@@ -505,6 +853,7 @@ void MainWindow::loadStatus(const EditorStatus &status, bool duplicate)
 void MainWindow::applyCompanion(const Extensions::CompanionData &data)
 {
     LOG_INFO("Requesting apply from companion");
+    materialize();
 
     if (isUntitled() && !isTextChanged())
     {
@@ -563,6 +912,8 @@ void MainWindow::applyCompanion(const Extensions::CompanionData &data)
         auto cursor = editor->textCursor();
         int cursorPos = cursor.position(); // keep Template Cursor Position
         editor->setPlainText(finalComments + editor->toPlainText());
+        editor->document()->setModified(!finalComments.isEmpty());
+        emit editorTextChanged(this);
         cursor.setPosition(cursorPos + finalComments.length());
         editor->setTextCursor(cursor);
     }
@@ -582,6 +933,9 @@ void MainWindow::applySettings(const QString &pagePath)
 {
     LOG_INFO(INFO_OF(pagePath));
 
+    if (!materialized)
+        return; // all settings are applied when it's materialized
+
     auto pageChanged = [this, pagePath](const QString &page) {
         if (!appWindow->getPreferencesWindow()->pathExists(page))
             LOG_DEV("Unknown path: " << page);
@@ -602,7 +956,7 @@ void MainWindow::applySettings(const QString &pagePath)
 
     if (pageChanged("Code Edit") || pagePath.startsWith("Appearance/") ||
         pageChanged(QString("Language/%1/%1 Parentheses").arg(language)))
-        Util::applySettingsToEditor(editor, language);
+        Util::applySettingsToEditor(editor, language, !largeFile);
 
     if (!isLanguageSet && pageChanged("Language/General"))
     {
@@ -646,12 +1000,14 @@ void MainWindow::applySettings(const QString &pagePath)
 bool MainWindow::save(bool force, const QString &head, bool safe)
 {
     LOG_INFO("Save " << BOOL_INFO_OF(force) << INFO_OF(head) << BOOL_INFO_OF(safe));
+    materialize();
     return saveFile(force ? AlwaysSave : IgnoreUntitled, head, safe);
 }
 
 void MainWindow::saveAs()
 {
     LOG_INFO("Save as clicked");
+    materialize();
     saveFile(SaveAs, tr("Save as"), true);
 }
 
@@ -676,23 +1032,26 @@ void MainWindow::on_run_clicked()
 void MainWindow::compileOnly()
 {
     LOG_INFO("Requesting Compile Only");
+    materialize();
     emit compileOrRunTriggered();
     afterCompile = Nothing;
     log->clear();
     compile();
 }
 
-void MainWindow::runOnly()
+void MainWindow::runOnly(bool useCache)
 {
-    LOG_INFO("Requesting Run only");
+    LOG_INFO("Requesting Run only, " << BOOL_INFO_OF(useCache));
+    materialize();
     emit compileOrRunTriggered();
     log->clear();
-    run();
+    run(useCache);
 }
 
 void MainWindow::compileAndRun()
 {
     LOG_INFO("Requested Compile and Run");
+    materialize();
     emit compileOrRunTriggered();
     afterCompile = Run;
     log->clear();
@@ -702,10 +1061,28 @@ void MainWindow::compileAndRun()
 void MainWindow::formatSource(bool selectionOnly, bool logOnNoChange)
 {
     LOG_INFO("Requested code format");
+    materialize();
+
+    if (formatter != nullptr)
+    {
+        // the running formatter gives the same result if it's formatting the same code in the same way
+        if (!selectionOnly && !formatter->formatSelectionOnly() && !formatter->isOutdated())
+        {
+            LOG_INFO("Coalesced with the running formatter");
+            return;
+        }
+        formatter->cancel();
+        formatter->deleteLater();
+        formatter = nullptr;
+    }
+
     if (language == "Python")
-        Extensions::YAPFormatter(editor, language, selectionOnly, logOnNoChange, log, this).format();
+        formatter = new Extensions::YAPFormatter(editor, language, selectionOnly, logOnNoChange, log, this);
     else
-        Extensions::ClangFormatter(editor, language, selectionOnly, logOnNoChange, log, this).format();
+        formatter = new Extensions::ClangFormatter(editor, language, selectionOnly, logOnNoChange, log, this);
+
+    connect(formatter, &Extensions::CodeFormatter::finished, this, &MainWindow::onFormatFinished);
+    formatter->format();
 }
 
 void MainWindow::setLanguage(const QString &lang)
@@ -716,26 +1093,30 @@ void MainWindow::setLanguage(const QString &lang)
         LOG_INFO("Language not changed");
         return;
     }
-    if (!QFile::exists(filePath))
+    if (!materialized)
     {
-        QString templateContent;
-        if (!language.isEmpty())
-            templateContent = Util::readFile(SettingsManager::get(QString("%1/Template Path").arg(language)).toString(),
-                                             tr("Open %1 Template").arg(language), log);
-        if (templateContent == editor->toPlainText())
-        {
-            language = lang;
-            loadFile(filePath);
-        }
+        // the language is applied to the widgets in materialize()
+        language = lang;
+        if (language != "Python" && language != "Java")
+            language = "C++";
+        isLanguageSet = true;
+        return;
+    }
+    if (!QFile::exists(filePath) && !isTextChanged())
+    {
+        // the template of the old language is not modified, replace it with the template of the new language
+        language = lang;
+        loadFile(filePath);
     }
     language = lang;
     if (language != "Python" && language != "Java")
         language = "C++";
-    Util::applySettingsToEditor(editor, language);
+    Util::applySettingsToEditor(editor, language, !largeFile);
     customCompileCommand.clear();
     ui->changeLanguageButton->setText(language);
     updateCompileAndRunButtons();
     isLanguageSet = true;
+    ++statusRevision;
     emit editorLanguageChanged(this);
 }
 
@@ -746,16 +1127,19 @@ QString MainWindow::getLanguage()
 
 MessageLogger *MainWindow::getLogger()
 {
+    materialize();
     return log;
 }
 
 void MainWindow::insertText(const QString &text)
 {
+    materialize();
     editor->insertPlainText(text);
 }
 
 void MainWindow::setViewMode(const QString &mode)
 {
+    materialize();
     if (mode == "code")
     {
         ui->leftWidget->show();
@@ -777,6 +1161,7 @@ void MainWindow::setViewMode(const QString &mode)
 void MainWindow::detachedExecution()
 {
     LOG_INFO("Executing in detached mode");
+    materialize();
     afterCompile = RunDetached;
     log->clear();
     compile();
@@ -786,6 +1171,9 @@ void MainWindow::killProcesses()
 {
     LOG_INFO("Killing all processes");
 
+    if (!materialized)
+        return; // there are no processes before the widgets are created
+
     if (killingProcesses) // prevent deleting the same pointer multiple times
     {
         LOG_INFO("Already killing processes");
@@ -805,6 +1193,9 @@ void MainWindow::killProcesses()
         delete t;
     }
     runner.clear();
+    runningCount = 0;
+    runScheduler->clearPending();
+    runResults->cancelRuns();
 
     if (detachedRunner != nullptr)
     {
@@ -830,6 +1221,8 @@ void MainWindow::setText(const QString &text, bool keep)
     }
     else
         editor->setPlainText(text);
+    editor->document()->setModified(false);
+    emit editorTextChanged(this); // make sure that the tab title is updated
 }
 
 void MainWindow::updateWatcher()
@@ -846,6 +1239,9 @@ void MainWindow::loadFile(const QString &loadPath)
 {
     LOG_INFO(INFO_OF(loadPath));
 
+    // don't read a file while it's being written
+    Core::FileWriter::instance().waitForDone();
+
     auto path = loadPath;
 
     bool samePath = !isUntitled() && filePath == path;
@@ -866,34 +1262,30 @@ void MainWindow::loadFile(const QString &loadPath)
         }
         else
         {
+            setLargeFileMode(false);
             setText("");
             return;
         }
     }
 
+    if (!isUntitled() && SettingsHelper::isRestoreOldProblemUrl() && FileProblemBinder::containsFile(filePath))
+        setProblemURL(FileProblemBinder::getProblemForFile(filePath));
+
+    // check the size before reading, a large file is loaded gradually instead of being read at once
+    if (!isTemplate && QFileInfo(path).size() > SettingsHelper::getLargeFileSize())
+    {
+        loadLargeFile(path);
+        loadTests();
+        return;
+    }
+
     auto content = Util::readFile(path, tr("Open File"), log);
 
     if (content.isNull())
         return;
 
+    setLargeFileMode(false);
     savedText = content;
-    if (content.length() > SettingsHelper::getOpenFileLengthLimit())
-    {
-        log->error(tr("Open File"),
-                   tr("The file [%1] contains more than %2 characters, so it's not opened. You can change the "
-                      "open file length limit at %3.")
-                       .arg(path)
-                       .arg(SettingsHelper::getOpenFileLengthLimit())
-                       .arg(SettingsHelper::pathOfOpenFileLengthLimit()),
-                   false);
-        setText("");
-        setFilePath("");
-        return;
-    }
-
-    if (!isUntitled() && SettingsHelper::isRestoreOldProblemUrl() && FileProblemBinder::containsFile(filePath))
-        setProblemURL(FileProblemBinder::getProblemForFile(filePath));
-
     setText(content, samePath);
 
     if (isTemplate)
@@ -921,14 +1313,136 @@ void MainWindow::loadFile(const QString &loadPath)
     loadTests();
 }
 
+void MainWindow::loadLargeFile(const QString &path)
+{
+    auto *file = new QFile(path);
+    if (!file->open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        log->error(tr("Open File"), tr("Failed to open [%1]. Do I have read permission?").arg(path));
+        LOG_ERR("Failed to open [" << path << "]");
+        delete file;
+        return;
+    }
+
+    LOG_INFO(INFO_OF(path) << INFO_OF(file->size()));
+
+    setLargeFileMode(true);
+    setText("");
+    // the text is appended to the editor, it's not edited until it's loaded, and the chunks are not undoable
+    editor->setReadOnly(true);
+    editor->document()->setUndoRedoEnabled(false);
+
+    log->info(tr("Open File"),
+              tr("The file [%1] is larger than %2 bytes, so it's opened in large file mode. Syntax highlighting, the "
+                 "language server and formatting on save are disabled, and the undo history is cleared when it "
+                 "becomes too large. You can change the size at %3.")
+                  .arg(path)
+                  .arg(SettingsHelper::getLargeFileSize())
+                  .arg(SettingsHelper::pathOfLargeFileSize()));
+
+    auto decoder = std::shared_ptr<QTextDecoder>(QTextCodec::codecForName("UTF-8")->makeDecoder());
+    auto content = std::make_shared<QString>();
+
+    largeFileLoader = new QTimer(this);
+    file->setParent(largeFileLoader);
+
+    connect(largeFileLoader, &QTimer::timeout, this, [this, file, decoder, content] {
+        // a chunk is appended in each event loop iteration, so the editor responds while loading
+        const auto bytes = file->read(LARGE_FILE_CHUNK_SIZE);
+        if (!bytes.isEmpty())
+        {
+            const auto chunk = decoder->toUnicode(bytes);
+            QTextCursor cursor(editor->document());
+            cursor.movePosition(QTextCursor::End);
+            cursor.insertText(chunk);
+            content->append(chunk);
+        }
+
+        if (!bytes.isEmpty() && !file->atEnd())
+            return;
+
+        if (file->error() != QFileDevice::NoError)
+        {
+            log->error(tr("Open File"), tr("Failed to read [%1]: %2").arg(file->fileName(), file->errorString()));
+            LOG_ERR("Failed to read the large file " << INFO_OF(file->errorString()));
+        }
+
+        largeFileLoader->stop();
+        largeFileLoader->deleteLater();
+        largeFileLoader = nullptr;
+
+        savedText = *content;
+        editor->setReadOnly(false);
+        editor->document()->setUndoRedoEnabled(true);
+        editor->moveCursor(QTextCursor::Start);
+        editor->document()->setModified(false);
+        emit editorTextChanged(this);
+
+        LOG_INFO("Large file loaded " << INFO_OF(savedText.length()));
+    });
+
+    largeFileLoader->start(0);
+}
+
+void MainWindow::setLargeFileMode(bool enabled)
+{
+    if (largeFileLoader != nullptr)
+    {
+        LOG_INFO("Stop loading the large file");
+        largeFileLoader->stop();
+        largeFileLoader->deleteLater();
+        largeFileLoader = nullptr;
+        editor->setReadOnly(false);
+        editor->document()->setUndoRedoEnabled(true);
+    }
+
+    if (enabled == largeFile)
+        return;
+
+    LOG_INFO(BOOL_INFO_OF(enabled));
+    largeFile = enabled;
+    largeFileUndoCharacters = 0;
+    Util::applySettingsToEditor(editor, language, !largeFile);
+    emit editorLanguageChanged(this); // attach or detach the language server
+}
+
+void MainWindow::trimLargeFileUndoHistory()
+{
+    if (!largeFile || largeFileUndoCharacters <= LARGE_FILE_UNDO_CHARACTERS)
+        return;
+
+    // QTextDocument can't remove only the oldest steps, so the whole undo history is removed
+    LOG_INFO("Clearing the undo history of the large file " << INFO_OF(largeFileUndoCharacters)
+                                                            << INFO_OF(editor->document()->availableUndoSteps()));
+    editor->document()->clearUndoRedoStacks();
+    largeFileUndoCharacters = 0;
+}
+
+bool MainWindow::warnIfLoading(const QString &head)
+{
+    if (largeFileLoader == nullptr)
+        return false;
+    log->warn(head, tr("The file is still being loaded, please wait until it's loaded."));
+    return true;
+}
+
 bool MainWindow::saveFile(SaveMode mode, const QString &head, bool safe)
 {
     LOG_INFO(INFO_OF(mode) << INFO_OF(head) << BOOL_INFO_OF(safe));
+    Core::Tracer::Span span("ui", "Save", sessionId);
+
+    if (largeFileLoader != nullptr)
+    {
+        log->warn(head, tr("The file is not saved because it's still being loaded."));
+        return false;
+    }
 
-    if ((mode != AutoSave && SettingsHelper::isFormatOnManualSave()) ||
-        (mode == AutoSave && SettingsHelper::isFormatOnAutoSave()))
+    if (!largeFile && ((mode != AutoSave && mode != FormattedSave && SettingsHelper::isFormatOnManualSave()) ||
+                       (mode == AutoSave && SettingsHelper::isFormatOnAutoSave())))
     {
+        // the current code is saved without waiting for the formatter, and saved again if it's changed by the formatter
         formatSource(false, false);
+        saveAfterFormatting = formatter != nullptr;
     }
 
     if (mode == SaveAs || (isUntitled() && mode == AlwaysSave))
@@ -994,10 +1508,12 @@ bool MainWindow::saveFile(SaveMode mode, const QString &head, bool safe)
         if (newFilePath.isEmpty())
             return beforeReturn(false);
 
-        if (!Util::saveFile(newFilePath, editor->toPlainText(), head, safe, log, true))
+        // it's written by Core::FileWriter after the pending writes to the same path
+        if (!Core::FileWriter::instance().write(newFilePath, editor->toPlainText(), head, safe, log, true).get())
             return beforeReturn(false);
 
         savedText = editor->toPlainText();
+        editor->document()->setModified(false);
 
         setFilePath(newFilePath);
 
@@ -1017,10 +1533,14 @@ bool MainWindow::saveFile(SaveMode mode, const QString &head, bool safe)
     }
     else if (!isUntitled())
     {
-        if (!Util::saveFile(filePath, editor->toPlainText(), head, safe, log, true))
+        const auto text = editor->toPlainText();
+        auto written = Core::FileWriter::instance().write(filePath, text, head, safe, log, true);
+        // a save requested by the user waits for the result, the other saves are written behind, see onFileWritten()
+        if (mode == AlwaysSave && !written.get())
             return false;
 
-        savedText = editor->toPlainText();
+        savedText = text;
+        editor->document()->setModified(false);
     }
     else
     {
@@ -1038,6 +1558,9 @@ bool MainWindow::saveFile(SaveMode mode, const QString &head, bool safe)
 
 QString MainWindow::tmpPath()
 {
+    materialize();
+    if (warnIfLoading(tr("Temp File")))
+        return QString();
     bool created = false;
     if (tmpDir == nullptr || !tmpDir->isValid() || !QDir(tmpDir->path()).exists())
     {
@@ -1064,8 +1587,16 @@ QString MainWindow::tmpPath()
         return "";
     }
     QString path = tmpDir->filePath(name);
-    if (!Util::saveFile(path, editor->toPlainText(), tr("Temp File"), false, log))
-        return QString();
+    // the file is written only when the code is changed, because this is called for every test case in a run
+    if (created || path != tmpFilePath || tmpFileRevision != textRevision || !QFile::exists(path))
+    {
+        // the compiler or the runner reads it right after this, so it waits for the write
+        Core::Tracer::Span span("ui", "Write Temp File", sessionId);
+        if (!Core::FileWriter::instance().write(path, editor->toPlainText(), tr("Temp File"), false, log).get())
+            return QString();
+        tmpFilePath = path;
+        tmpFileRevision = textRevision;
+    }
     if (created && isUntitled())
         emit requestUpdateLanguageServerFilePath(this, path);
     return path;
@@ -1083,7 +1614,10 @@ void MainWindow::updateCompileCommand()
         QInputDialog::getText(this, tr("Set Compile Command"), tr("Custom compile command for this tab:"),
                               QLineEdit::Normal, compileCommand(), &ok);
     if (ok)
+    {
         customCompileCommand = command;
+        ++statusRevision;
+    }
 }
 
 void MainWindow::updateTimeLimit()
@@ -1092,25 +1626,36 @@ void MainWindow::updateTimeLimit()
     const int limit = QInputDialog::getInt(this, tr("Set Time Limit"), tr("Custom time limit for this tab: (ms)"),
                                            timeLimit(), 1, 3600000, 1000, &ok);
     if (ok)
+    {
         customTimeLimit = limit;
+        ++statusRevision;
+    }
 }
 
-bool MainWindow::isTextChanged() const
+bool MainWindow::isLargeFile() const
 {
-    if (isUntitled())
-    {
-        auto content = Util::readFile(SettingsManager::get(QString("%1/Template Path").arg(language)).toString(),
-                                      tr("Read %1 Template").arg(language), log);
-        if (content.isNull())
-            return !editor->toPlainText().isEmpty();
-        return editor->toPlainText() != content;
-    }
-    auto content = Util::readFile(filePath);
+    return largeFile;
+}
 
-    if (content.isNull())
-        return true;
+bool MainWindow::isTextChanged() const
+{
+    if (!materialized)
+        return pendingTextChanged;
+    // the document is marked as unmodified when it's loaded or saved, and undoing back to that state also restores
+    // the mark, so this doesn't need to compare the text with the file
+    return editor->document()->isModified();
+}
 
-    return editor->toPlainText() != content;
+bool MainWindow::isStatusTextChanged(const EditorStatus &status, bool untitled, const QString &lang)
+{
+    if (!untitled)
+        return status.editorText != status.savedText;
+    // an untitled tab is changed if it's not the template, the template is not read again if it's not modified
+    auto templateFingerprint =
+        Util::fileFingerprint(SettingsManager::get(QString("%1/Template Path").arg(lang)).toString());
+    if (templateFingerprint.isEmpty())
+        templateFingerprint = Util::textFingerprint(QString());
+    return Util::textFingerprint(status.editorText) != templateFingerprint;
 }
 
 bool MainWindow::closeConfirm()
@@ -1125,7 +1670,7 @@ bool MainWindow::closeConfirm()
             tr("Save changes to [%1] before closing?").arg(isUntitled() ? tr("New File") : getFileName()),
             QMessageBox::Save | QMessageBox::Discard | QMessageBox::Cancel, QMessageBox::Cancel);
         if (res == QMessageBox::Save)
-            confirmed = saveFile(AlwaysSave, tr("Save"), true);
+            confirmed = save(true, tr("Save"));
         else if (res == QMessageBox::Discard)
             confirmed = true;
     }
@@ -1162,50 +1707,63 @@ void MainWindow::onFileWatcherChanged(const QString &path)
 {
     LOG_INFO(INFO_OF(path));
 
-    emit editorTextChanged(this);
+    auto fileText = Util::readFile(path);
 
-    auto currentText = editor->toPlainText();
+    if (fileText.isNull())
+    {
+        // the file is removed or can't be read, so the text in the editor is not saved anywhere
+        editor->document()->setModified(true);
+        emit editorTextChanged(this);
+        return;
+    }
 
-    auto fileText = Util::readFile(path);
+    if (fileText == savedText)
+        return;
 
-    if (!fileText.isNull())
+    if (fileText == editor->toPlainText())
     {
-        if (fileText == savedText)
-            return;
+        savedText = fileText;
+        editor->document()->setModified(false);
+        emit editorTextChanged(this);
+        return;
+    }
 
-        if (fileText == currentText)
-        {
-            savedText = fileText;
-            return;
-        }
+    if (!isTextChanged() && SettingsHelper::isAutoLoadExternalChangesIfNoUnsavedModification())
+    {
+        loadFile(path);
+        emit editorTextChanged(this);
+        return;
+    }
 
-        if (savedText == currentText && SettingsHelper::isAutoLoadExternalChangesIfNoUnsavedModification())
-        {
-            loadFile(path);
-            return;
-        }
+    // the text in the editor is different from the file now
+    editor->document()->setModified(true);
+    emit editorTextChanged(this);
 
-        if (!reloading && SettingsHelper::isAskForLoadingExternalChanges())
-        {
-            reloading = true;
+    if (!reloading && SettingsHelper::isAskForLoadingExternalChanges())
+    {
+        reloading = true;
 
-            emit confirmTriggered(this);
-            auto reload = QMessageBox::question(
-                this, tr("Reload"), tr("[%1]\n\nhas been changed on disk.\nDo you want to reload it?").arg(filePath));
+        emit confirmTriggered(this);
+        auto reload = QMessageBox::question(
+            this, tr("Reload"), tr("[%1]\n\nhas been changed on disk.\nDo you want to reload it?").arg(filePath));
 
-            reloading = false;
+        reloading = false;
 
-            if (reload == QMessageBox::StandardButton::Yes)
-            {
-                loadFile(path);
-                return;
-            }
+        if (reload == QMessageBox::StandardButton::Yes)
+        {
+            loadFile(path);
+            emit editorTextChanged(this);
         }
     }
 }
 
 void MainWindow::onTextChanged()
 {
+    // the undo history of a large file can be cleared, so the document can't tell if the text is the saved one
+    if (largeFile && largeFileLoader == nullptr)
+        editor->document()->setModified(true);
+    ++textRevision;
+    ++statusRevision;
     if (SettingsHelper::isAutoSave() && SettingsHelper::getAutoSaveIntervalType() != "Without modification" &&
         (!autoSaveTimer->isActive() || SettingsHelper::getAutoSaveIntervalType() == "After the last modification"))
     {
@@ -1214,6 +1772,38 @@ void MainWindow::onTextChanged()
     emit editorTextChanged(this);
 }
 
+void MainWindow::onFileWritten(const QString &path, bool ok)
+{
+    if (path != filePath)
+        return;
+
+    if (ok)
+    {
+        // a safe write replaces the file by a new one, so the new one should be watched
+        fileWatcher->removePath(filePath);
+        fileWatcher->addPath(filePath);
+    }
+    else
+    {
+        LOG_WARN("Failed to write the file in the background");
+        editor->document()->setModified(true);
+        emit editorTextChanged(this);
+    }
+}
+
+void MainWindow::onFormatFinished(bool applied)
+{
+    LOG_INFO(BOOL_INFO_OF(applied) << BOOL_INFO_OF(saveAfterFormatting));
+    formatter->deleteLater();
+    formatter = nullptr;
+    if (saveAfterFormatting)
+    {
+        saveAfterFormatting = false;
+        if (applied)
+            saveFile(FormattedSave, tr("Formatter"), true);
+    }
+}
+
 void MainWindow::onEditorFontChanged(const QFont &newFont)
 {
     SettingsHelper::setEditorFont(newFont);
@@ -1222,6 +1812,7 @@ void MainWindow::onEditorFontChanged(const QFont &newFont)
 
 void MainWindow::updateCursorInfo()
 {
+    ++statusRevision;
     auto cursor = editor->textCursor();
     auto selection = cursor.selectedText();
     QString info;
@@ -1263,17 +1854,29 @@ void MainWindow::updateChecker()
         checker = new Core::Checker(testcases->checkerText(), log, this);
     else
         checker = new Core::Checker(testcases->checkerType(), log, this);
+    checker->setTraceTab(sessionId);
     connect(checker, &Core::Checker::checkFinished, testcases, &Widgets::TestCases::setVerdict);
+    connect(checker, &Core::Checker::firstMismatchFound, testcases, &Widgets::TestCases::setMismatch);
+    connect(checker, &Core::Checker::checkFinished, this, [this](int index, Widgets::TestCase::Verdict verdict) {
+        runResults->finishRun(index, verdict);
+        runScheduler->recordVerdict(index, verdict);
+        if (verdict == Widgets::TestCase::WA)
+            onRunFailed(index);
+    });
+    connect(checker, &Core::Checker::firstMismatchFound, this,
+            [this](int index, const Core::Mismatch &mismatch) { runResults->setMismatch(index, mismatch); });
     checker->prepare();
 }
 
 QSplitter *MainWindow::getSplitter()
 {
+    materialize();
     return ui->splitter;
 }
 
 QSplitter *MainWindow::getRightSplitter()
 {
+    materialize();
     return ui->rightSplitter;
 }
 
@@ -1324,7 +1927,7 @@ void MainWindow::hideEvent(QHideEvent *event)
         return;
     }
 
-    if (SettingsHelper::isToggleStopwatchOnTabSwitch() && stopwatch->isRunning())
+    if (materialized && SettingsHelper::isToggleStopwatchOnTabSwitch() && stopwatch->isRunning())
         stopwatch->pause();
 
     QWidget::hideEvent(event);
@@ -1338,6 +1941,8 @@ void MainWindow::showEvent(QShowEvent *event)
         return;
     }
 
+    materialize(); // a placeholder is materialized when its tab is activated
+
     if (SettingsHelper::isToggleStopwatchOnTabSwitch() && !stopwatch->isRunning())
         stopwatch->start();
 
@@ -1353,6 +1958,8 @@ void MainWindow::onCompilationStarted()
 
 void MainWindow::onCompilationFinished(const QString &warning)
 {
+    Core::Tracer::Span span("ui", "Compilation Finished", sessionId);
+
     if (language != "Python")
     {
         log->info(tr("Compiler"), tr("Compilation has finished"));
@@ -1433,26 +2040,35 @@ void MainWindow::onRunStarted(int index)
 void MainWindow::onRunFinished(int index, const QString &out, const QString &err, int exitCode, qint64 timeUsed,
                                bool tle)
 {
+    Core::Tracer::Span span("ui", "Run Finished", sessionId, index);
     auto head = getRunnerHead(index);
 
+    runningCount = qMax(0, runningCount - 1);
+    runResults->setExecutionResult(index, out, err, exitCode, timeUsed, tle);
+    runScheduler->recordTime(index, timeUsed);
+
     if (exitCode == 0)
     {
         log->info(head, tr("Execution for test case #%1 has finished in %2ms").arg(index + 1).arg(timeUsed));
 
-        if ((!out.isEmpty() && !testcases->expected(index).isEmpty()) ||
+        if ((!out.isEmpty() && !testcases->expectedData(index).isEmpty()) ||
             (SettingsHelper::isCheckOnTestcasesWithEmptyOutput() && exitCode == 0))
-            checker->reqeustCheck(index, testcases->input(index), out, testcases->expected(index));
+            checker->reqeustCheck(index, testcases->inputData(index), out, testcases->expectedData(index));
+        else
+        {
+            runResults->finishRun(index, Widgets::TestCase::UNKNOWN);
+            runScheduler->recordVerdict(index, Widgets::TestCase::UNKNOWN);
+        }
     }
 
     else
     {
+        const auto verdict = tle ? Widgets::TestCase::TLE : Widgets::TestCase::RE;
         if (tle)
-        {
             log->warn(head, tr("Time Limit Exceeded"));
-            testcases->setVerdict(index, Widgets::TestCase::TLE);
-        }
-        else
-            testcases->setVerdict(index, Widgets::TestCase::RE);
+        testcases->setVerdict(index, verdict);
+        runResults->finishRun(index, verdict);
+        runScheduler->recordVerdict(index, verdict);
 
         log->error(head, tr("Execution for test case #%1 has finished with non-zero exitcode %2 in %3ms")
                              .arg(index + 1)
@@ -1463,15 +2079,29 @@ void MainWindow::onRunFinished(int index, const QString &out, const QString &err
     if (!err.trimmed().isEmpty())
         log->error(head + tr("/stderr"), err);
     testcases->setOutput(index, out);
+
+    if (exitCode != 0)
+        onRunFailed(index);
+    startQueuedRuns();
 }
 
 void MainWindow::onFailedToStartRun(int index, const QString &error)
 {
     log->error(getRunnerHead(index), error, false);
+
+    if (index != -1)
+    {
+        runResults->discardRun(index);
+        runningCount = qMax(0, runningCount - 1);
+        // this may be emitted in run(), so the next run is started after it returns
+        QMetaObject::invokeMethod(this, &MainWindow::startQueuedRuns, Qt::QueuedConnection);
+    }
 }
 
 void MainWindow::onRunOutputLimitExceeded(int index, const QString &type)
 {
+    // the process is killed, so its verdict is not reused
+    runResults->discardRun(index);
     log->warn(
         getRunnerHead(index),
         tr("The %1 of the process running on the testcase #%2 contains more than %3 characters, which is longer "
@@ -1485,6 +2115,11 @@ void MainWindow::onRunOutputLimitExceeded(int index, const QString &type)
 
 void MainWindow::onRunKilled(int index)
 {
+    if (index != -1)
+    {
+        runResults->discardRun(index);
+        testcases->setRunningTime(index, -1, 0);
+    }
     log->error(getRunnerHead(index),
                tr("%1 has been killed")
                    .arg(index == -1 ? tr("Detached runner") : tr("Runner for testcase #%1").arg(index + 1)));
@@ -38,12 +38,15 @@ namespace Core
 {
 class Checker;
 class Compiler;
+class RunResultCache;
+class RunScheduler;
 class Runner;
 } // namespace Core
 
 namespace Extensions
 {
 class CFTool;
+class CodeFormatter;
 struct CompanionData;
 } // namespace Extensions
 
@@ -65,34 +68,66 @@ class MainWindow : public QMainWindow
         int editorCursor{}, editorAnchor{}, horizontalScrollBarValue{}, verticalScrollbarValue{}, untitledIndex{},
             checkerIndex{}, customTimeLimit{};
         QStringList input, expected, customCheckers;
+        QStringList inputFiles, expectedFiles; // the stored files of large test cases, empty for inline test cases
         QVariantList testcasesIsShow; // This can't be renamed to "isChecked" because that's not compatible
         QVariantList testCaseSplitterStates;
+        bool loadFromFile{}; // the tab is a placeholder of a file, it's loaded from the file instead of this status
 
         EditorStatus() = default;
 
         explicit EditorStatus(const QMap<QString, QVariant> &status);
 
         QMap<QString, QVariant> toMap() const;
+
+        /**
+         * @brief replace the stored files of the large test cases by their texts, e.g. when exporting the session
+         * @note The stored files are local to this machine, the exported session should not refer to them.
+         */
+        void embedTestData();
     };
 
-    explicit MainWindow(int index, AppWindow *parent);
-    explicit MainWindow(const QString &fileOpen, int index, AppWindow *parent);
-    explicit MainWindow(const EditorStatus &status, bool duplicate, int index, AppWindow *parent);
+    /**
+     * @param lazy whether to create a placeholder, which only keeps the file path or the status, and creates the
+     * editor, the test cases and the other widgets when it's shown or materialize() is called
+     */
+    explicit MainWindow(const QString &fileOpen, int index, AppWindow *parent, bool lazy = false);
+    explicit MainWindow(const EditorStatus &status, bool duplicate, int index, AppWindow *parent, bool lazy = false);
     ~MainWindow() override;
 
+    /**
+     * @brief create the widgets of a placeholder and load the file or the status into them
+     * @note This does nothing if the window is already materialized.
+     */
+    void materialize();
+    bool isMaterialized() const;
+
+    /**
+     * @returns the ID of this tab in the saved session, it's unique in this process
+     */
+    quint64 getSessionId() const;
+
+    /**
+     * @returns a number that is increased when the status of this tab is changed, see toStatus()
+     */
+    quint64 getStatusRevision() const;
+
     int getUntitledIndex() const;
     QString getFileName() const;
     QString getFilePath() const;
     QString getProblemURL() const;
     QString getCompleteTitle() const;
     QString getTabTitle(bool complete, bool star, int removeLength = 0);
-    QCodeEditor *getEditor() const;
+    QCodeEditor *getEditor();
     bool isUntitled() const;
 
     void setProblemURL(const QString &url);
     void setUntitledIndex(int index);
 
-    EditorStatus toStatus() const;
+    /**
+     * @note A placeholder of a file is not materialized, the returned status only has the path and the settings of
+     * the tab, and it's loaded from the file when it's restored. Call materialize() first to get the content.
+     */
+    EditorStatus toStatus();
     void loadStatus(const EditorStatus &status, bool duplicate = false);
 
     bool save(bool force, const QString &head, bool safe = true);
@@ -101,10 +136,20 @@ class MainWindow : public QMainWindow
     bool isTextChanged() const;
     bool closeConfirm();
 
+    /**
+     * @returns whether the file is opened in large file mode, where it's not highlighted or sent to the language server
+     */
+    bool isLargeFile() const;
+
     void killProcesses();
     void detachedExecution();
     void compileOnly();
-    void runOnly();
+
+    /**
+     * @brief run all checked test cases
+     * @param useCache whether to reuse the results of the unchanged test cases
+     */
+    void runOnly(bool useCache = true);
     void compileAndRun();
     void formatSource(bool selectionOnly, bool logOnNoChange);
 
@@ -154,6 +199,8 @@ class MainWindow : public QMainWindow
     void onFileWatcherChanged(const QString &);
     void onEditorFontChanged(const QFont &newFont);
     void onTextChanged();
+    void onFileWritten(const QString &path, bool ok);
+    void onFormatFinished(bool applied);
     void updateCursorInfo();
     void updateChecker();
     void runTestCase(int index);
@@ -187,6 +234,7 @@ class MainWindow : public QMainWindow
         AutoSave,       // basically the same as IgnoreUntitled, only different in auto-format
         AlwaysSave,     // save to filePath if it's not empty, otherwise ask for new path
         SaveAs,         // ask for new path no matter filePath is empty or not
+        FormattedSave,  // the same as IgnoreUntitled, but the code is not formatted, used to save the formatted code
     };
     enum AfterCompile
     {
@@ -204,8 +252,16 @@ class MainWindow : public QMainWindow
     QVector<Core::Runner *> runner;
     Core::Checker *checker = nullptr;
     Core::Runner *detachedRunner = nullptr;
+    Core::RunResultCache *runResults = nullptr;
+    Core::RunScheduler *runScheduler = nullptr;
+    int runningCount = 0; // the number of the test cases being run, the others wait in runScheduler
     QTemporaryDir *tmpDir = nullptr;
+    QString tmpFilePath;         // the temporary file written last time by tmpPath()
+    quint64 tmpFileRevision = 0; // the textRevision when tmpFilePath was written
+    quint64 textRevision = 0;    // increased on every change of the text, it never goes back on undo
     AfterCompile afterCompile = Nothing;
+    Extensions::CodeFormatter *formatter = nullptr; // the running formatter, a new one replaces it
+    bool saveAfterFormatting = false;               // whether the code is saved if the running formatter changes it
 
     MessageLogger *log = nullptr;
 
@@ -218,6 +274,16 @@ class MainWindow : public QMainWindow
     QString cftoolPath;
     QFileSystemWatcher *fileWatcher;
 
+    bool largeFile = false;
+    QTimer *largeFileLoader = nullptr;  // appends the chunks of the large file being loaded, null if it's loaded
+    qint64 largeFileUndoCharacters = 0; // the characters changed since the undo history of the large file was cleared
+
+    bool materialized = true;
+    quint64 sessionId;
+    quint64 statusRevision = 0;
+    EditorStatus *pendingStatus = nullptr; // the status to load in materialize(), the file is loaded if it's null
+    bool pendingTextChanged = false;       // isTextChanged() of a placeholder
+
     std::atomic<bool> reloading;
     std::atomic<bool> killingProcesses;
 
@@ -232,17 +298,51 @@ class MainWindow : public QMainWindow
     int customTimeLimit = -1;     // the custom time limit for this tab, -1 represents for the same as settings
     QString customCompileCommand; // the custom compile command for this tab, empty represents for the same as settings
 
+    explicit MainWindow(int index, AppWindow *parent, bool lazy);
+    void setupWidgets();
     void setEditor();
     void compile();
-    void run();
-    void run(int index);
+    void run(bool useCache = true);
+    void run(int index, const QString &cacheKey = QString());
+    QString runProgramKey();
+    void startQueuedRuns();
+
+    /**
+     * @brief cancel the other test cases if Fail Fast is enabled
+     * @param index the test case that gets WA, TLE or RE
+     */
+    void onRunFailed(int index);
     void loadTests();
     void saveTests(bool safe);
     void setCFToolUI();
     void setFilePath(QString path, bool updateBinder = true);
     void setText(const QString &text, bool keep = false);
+
+    /**
+     * @returns whether the editor text in a status is different from the saved text, or from the template of *lang*
+     * if it's untitled
+     */
+    static bool isStatusTextChanged(const EditorStatus &status, bool untitled, const QString &lang);
     void updateWatcher();
     void loadFile(const QString &loadPath);
+    /**
+     * @brief load a file in large file mode, it's appended to the editor chunk by chunk in the background
+     */
+    void loadLargeFile(const QString &path);
+    /**
+     * @brief turn large file mode on or off, and stop loading the large file if it's being loaded
+     */
+    void setLargeFileMode(bool enabled);
+    /**
+     * @brief clear the undo history of the large file if too many characters are changed since it was cleared
+     * @note A single step of a large file, e.g. replacing the whole text, can take a lot of memory.
+     */
+    void trimLargeFileUndoHistory();
+    /**
+     * @returns whether the large file is still being loaded, a warning is shown if it is
+     * @note The half-loaded code should not be compiled, run or submitted.
+     */
+    bool warnIfLoading(const QString &head);
     bool saveFile(SaveMode mode, const QString &head, bool safe);
     void performCompileAndRunDiagonistics();
     static QString getRunnerHead(int index);
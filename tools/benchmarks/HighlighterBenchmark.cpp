@@ -0,0 +1,204 @@
+/*
+ * Copyright (C) 2019-2021 Ashar Khan <ashar786khan@gmail.com>
+ *
+ * This file is part of CP Editor.
+ *
+ * CP Editor is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * I will not be responsible if CP Editor behaves in unexpected way and
+ * causes your ratings to go down and or lose any important contest.
+ *
+ * Believe Software is "Software" and it isn't immune to bugs.
+ *
+ */
+
+/*
+ * Compares the highlighting time of Extensions::LexerHighlighter with the regex QCXXHighlighter of QCodeEditor on a
+ * generated C++ file, it's built with -D BUILD_BENCHMARKS=On.
+ * Usage: QT_QPA_PLATFORM=offscreen highlighter-benchmark [number of lines, 50000 by default]
+ * The logs of the highlighter are printed into stderr instead of being written to the log file.
+ */
+
+#include "Core/EventLogger.hpp"
+#include "Extensions/LexerHighlighter.hpp"
+#include <QApplication>
+#include <QCXXHighlighter>
+#include <QCodeEditor>
+#include <QElapsedTimer>
+#include <QTextBlock>
+#include <QTextCursor>
+#include <cstdio>
+#include <functional>
+
+namespace Core
+{
+// a logger printing into stderr, so that the benchmark doesn't depend on the settings and the log files
+std::atomic<int> Log::minimumLevel{Log::Info};
+
+struct Log::Message::Buffer
+{
+    QString text;
+    QTextStream stream{&text};
+};
+
+Log::Message::Message(Level level, const Site *site) : level(level), site(site), time(0), ownBuffer(new Buffer())
+{
+    buffer = ownBuffer.get();
+}
+
+Log::Message::~Message()
+{
+    buffer->stream.flush();
+    std::fprintf(stderr, "[%s:%d] %s\n", site->function, site->line, buffer->text.toUtf8().constData());
+}
+
+QTextStream &Log::Message::out()
+{
+    return buffer->stream;
+}
+} // namespace Core
+
+namespace
+{
+const int KEYSTROKES = 200;
+
+// a block of code with comments, strings, raw strings, numbers and preprocessor lines, %1 makes the names unique
+const QString CODE_BLOCK = R"(#include <bits/stdc++.h>
+#define REP%1(i, n) for (int i = 0; i < (n); ++i)
+
+/*
+ * A segment tree, %1
+ */
+template <typename T> struct SegmentTree%1
+{
+    std::vector<T> tree;
+    explicit SegmentTree%1(int n) : tree(2 * n, T(0x3f3f3f3f)) {}
+
+    // the minimum in [l, r)
+    T query(int l, int r) const
+    {
+        T result = T(1e18);
+        for (l += size(), r += size(); l < r; l >>= 1, r >>= 1)
+        {
+            if (l & 1) result = std::min(result, tree[l++]);
+            if (r & 1) result = std::min(result, tree[--r]);
+        }
+        return result;
+    }
+    int size() const { return int(tree.size()) / 2; }
+};
+
+const char *message%1 = "answer: %d\n", *raw%1 = R"x(a "raw" string)x";
+)";
+
+QString generateCode(int lines)
+{
+    QString code;
+    int count = 0;
+    for (int i = 0; count < lines; ++i)
+    {
+        code += CODE_BLOCK.arg(i);
+        count += CODE_BLOCK.count('\n');
+    }
+    return code;
+}
+
+struct Result
+{
+    qint64 load = 0;         // the time until setPlainText() returns
+    qint64 loadTotal = 0;    // the time until all lines are formatted
+    double keystroke = 0;    // the average time of typing a character in the middle of the file
+    qint64 maxKeystroke = 0; // the maximum time of typing a character in the middle of the file
+    qint64 openComment = 0;  // the time until typing "/*" at the beginning of the file returns
+    qint64 closeComment = 0; // the time until removing the "/*" returns
+};
+
+// process the events until the highlighter has no pending lines
+void waitForHighlighter(const std::function<bool()> &hasPendingLines)
+{
+    do
+    {
+        QApplication::processEvents();
+    } while (hasPendingLines());
+}
+
+Result run(QStyleSyntaxHighlighter *highlighter, const std::function<bool()> &hasPendingLines, QCodeEditor *editor,
+           const QString &code)
+{
+    Result result;
+    editor->clear();
+    editor->setHighlighter(highlighter);
+    QApplication::processEvents();
+
+    QElapsedTimer timer;
+    timer.start();
+    editor->setPlainText(code);
+    result.load = timer.elapsed();
+    waitForHighlighter(hasPendingLines);
+    result.loadTotal = timer.elapsed();
+
+    QTextCursor cursor(editor->document()->findBlockByNumber(editor->document()->blockCount() / 2));
+    qint64 sum = 0, maximum = 0;
+    for (int i = 0; i < KEYSTROKES; ++i)
+    {
+        QElapsedTimer keystroke;
+        keystroke.start();
+        cursor.insertText("x");
+        const auto elapsed = keystroke.nsecsElapsed();
+        sum += elapsed;
+        maximum = qMax(maximum, elapsed);
+        waitForHighlighter(hasPendingLines);
+    }
+    result.keystroke = double(sum) / KEYSTROKES / 1e6;
+    result.maxKeystroke = maximum / 1000000;
+
+    // this changes the state of all lines
+    cursor.setPosition(0);
+    timer.restart();
+    cursor.insertText("/*");
+    result.openComment = timer.elapsed();
+    waitForHighlighter(hasPendingLines);
+
+    cursor.setPosition(0);
+    cursor.setPosition(2, QTextCursor::KeepAnchor);
+    timer.restart();
+    cursor.removeSelectedText();
+    result.closeComment = timer.elapsed();
+    waitForHighlighter(hasPendingLines);
+
+    editor->setHighlighter(nullptr);
+    return result;
+}
+
+void print(const char *name, const Result &result)
+{
+    std::printf("%-16s %10lld %14lld %17.3f %17lld %15lld %16lld\n", name, result.load, result.loadTotal,
+                result.keystroke, result.maxKeystroke, result.openComment, result.closeComment);
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QApplication app(argc, argv);
+
+    const int lines = argc > 1 ? QString(argv[1]).toInt() : 50000;
+    const auto code = generateCode(lines);
+
+    QCodeEditor editor;
+    editor.resize(800, 600);
+    editor.show();
+
+    const auto regex = run(new QCXXHighlighter(), [] { return false; }, &editor, code);
+    auto *lexer = new Extensions::LexerHighlighter("C++", &editor);
+    const auto lexed = run(lexer, [lexer] { return lexer->hasPendingLines(); }, &editor, code);
+
+    std::printf("%d lines, times in milliseconds\n", editor.document()->blockCount());
+    std::printf("%-16s %10s %14s %17s %17s %15s %16s\n", "", "load", "load (total)", "keystroke (avg)",
+                "keystroke (max)", "open comment", "close comment");
+    print("QCXXHighlighter", regex);
+    print("LexerHighlighter", lexed);
+    return 0;
+}